@@ -1,5 +1,6 @@
 #include "src/anim-atlas.hpp"
 #include "loader/loader.hpp"
+#include <iterator>
 #include <mg/ImageData.h>
 #include <mg/ImageView.h>
 #include <benchmark/benchmark.h>
@@ -19,7 +20,30 @@ void Bitmask(benchmark::State& state)
         anim_atlas::make_bitmask_(img, bitmask);
 }
 
+void Bitmask_kernel(benchmark::State& state)
+{
+    constexpr const char* names[] = { "scalar", "sse2", "avx2", "neon", };
+    static_assert(std::size(names) == (size_t)bitmask_kernel::COUNT);
+    const auto kernel = (bitmask_kernel)state.range(0);
+    state.SetLabel(names[state.range(0)]);
+    if (!anim_atlas::has_bitmask_kernel(kernel))
+    {
+        state.SkipWithError("not supported on this CPU");
+        return;
+    }
+
+    auto img = loader.texture(loader.SCENERY_PATH, "door-close"_s);
+    auto bitmask = anim_atlas::make_bitmask(img);
+
+    for (int i = 0; i < 3; i++)
+        anim_atlas::make_bitmask_(img, bitmask, kernel);
+    for (auto _ : state)
+        anim_atlas::make_bitmask_(img, bitmask, kernel);
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)img.data().size());
+}
+
 BENCHMARK(Bitmask)->Unit(benchmark::kMicrosecond);
+BENCHMARK(Bitmask_kernel)->DenseRange(0, (int)bitmask_kernel::COUNT - 1)->Unit(benchmark::kMicrosecond);
 
 } // namespace
 
@@ -0,0 +1,38 @@
+#include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/tile-image.hpp"
+#include "loader/loader.hpp"
+#include <benchmark/benchmark.h>
+
+namespace floormat {
+
+namespace {
+
+// the editor collects every frame; with a large world loaded, all but a
+// handful of chunks are left as they were.
+void World_Collect(benchmark::State& st)
+{
+    const auto nchunks = (int)st.range(0);
+    const bool force = st.range(1);
+    const auto floor = tile_image_proto{ loader.ground_atlas("texel"), 0 };
+
+    auto w = world();
+    constexpr int row = 256;
+    for (int i = 0; i < nchunks; i++)
+        w[chunk_coords_{(int16_t)(i % row), (int16_t)(i / row), 0}][0].ground() = floor;
+    w.collect(true, true);
+
+    const auto garbage = chunk_coords_{-1, -1, 0};
+    for (auto _ : st)
+    {
+        (void)w[garbage];
+        w.collect(force, true);
+    }
+    st.counters["chunks"] = (double)w.size();
+}
+
+BENCHMARK(World_Collect)->ArgsProduct({{1 << 10, 1 << 13, 1 << 16}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+} // namespace floormat
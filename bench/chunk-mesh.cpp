@@ -0,0 +1,80 @@
+#include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/chunk-mesh-builder.hpp"
+#include "src/tile-image.hpp"
+#include "src/hole.hpp"
+#include "src/scenery.hpp"
+#include "src/scenery-proto.hpp"
+#include "loader/loader.hpp"
+#include "compat/borrowed-ptr.inl"
+#include <benchmark/benchmark.h>
+#include <cr/GrowableArray.h>
+
+namespace floormat {
+
+namespace {
+
+// every chunk on screen gone stale at once, like after loading a map or
+// switching z-levels. walls on most tiles, some of them cut by holes.
+void Chunk_Mesh_Build(benchmark::State& st)
+{
+    const auto thread_count = (uint32_t)st.range(0);
+    constexpr int16_t size = 8;
+    const auto floor = tile_image_proto{ loader.ground_atlas("texel"), 0 };
+    const auto wall = wall_image_proto{ loader.wall_atlas("test1"), 0 };
+    const auto& table = loader.scenery("table0");
+
+    auto w = world();
+    Array<chunk_coords_> coords;
+    for (int16_t y = 0; y < size; y++)
+        for (int16_t x = 0; x < size; x++)
+        {
+            const auto ch = chunk_coords_{x, y, 0};
+            auto& c = w[ch];
+            for (auto k = 0u; k < TILE_COUNT; k++)
+            {
+                c[k].ground() = floor;
+                c[k].wall_north() = wall;
+                if (k % 2)
+                    c[k].wall_west() = wall;
+            }
+            for (uint8_t i = 0; i < 4; i++)
+            {
+                auto h = w.make_object<hole>(w.make_id(), global_coords{ch, {(uint8_t)(i * 4 + 2), 8}}, hole_proto{});
+                h->set_bbox({}, {}, {96, 48}, pass_mode::pass);
+                (void)w.make_scenery(w.make_id(), {ch, {(uint8_t)(i * 4 + 1), 4}}, scenery_proto(table));
+            }
+            c.ensure_passability();
+            arrayAppend(coords, ch);
+        }
+
+    chunk_mesh_builder builder{thread_count};
+    for (auto _ : st)
+    {
+        st.PauseTiming();
+        for (auto ch : coords)
+        {
+            auto& c = *w.at(ch);
+            c.mark_ground_modified();
+            c.mark_walls_modified();
+            c.mark_scenery_modified();
+            c.ensure_passability();
+        }
+        st.ResumeTiming();
+        builder.build(w, coords);
+    }
+    st.counters["chunks"] = (double)builder.stats().built;
+    size_t mesh_bytes = 0;
+    for (auto ch : coords)
+    {
+        const auto& c = *w.at(ch);
+        mesh_bytes += c.ground_static_mesh.memory_usage() + c.wall_static_mesh.memory_usage() + c.scenery_static_mesh.memory_usage();
+    }
+    st.counters["mesh_bytes_per_chunk"] = (double)mesh_bytes / (double)coords.size();
+}
+
+BENCHMARK(Chunk_Mesh_Build)->Arg(0)->Arg(1)->Arg(3)->Arg(7)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
+
+} // namespace floormat
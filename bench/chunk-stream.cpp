@@ -0,0 +1,163 @@
+#include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/chunk-store.hpp"
+#include "src/chunk-stream.hpp"
+#include "src/chunk-prefetch.hpp"
+#include "src/grid.hpp"
+#include "src/point.inl"
+#include "src/tile-image.hpp"
+#include "src/scenery.hpp"
+#include "src/scenery-proto.hpp"
+#include "src/timer.hpp"
+#include "src/nanosecond.inl"
+#include "loader/loader.hpp"
+#include "compat/array-size.hpp"
+#include <benchmark/benchmark.h>
+#include <cr/Path.h>
+#include <cr/Pointer.h>
+
+namespace floormat {
+
+namespace {
+
+void fill_chunk(world& w, chunk_coords_ ch, uint32_t nobjects)
+{
+    auto& c = w[ch];
+    const auto floor = tile_image_proto{ loader.ground_atlas("texel"), 0 };
+    for (auto k = 0u; k < TILE_COUNT; k++)
+        c[k].ground() = floor;
+    const auto table = loader.scenery("table0");
+    for (auto i = 0u; i < nobjects; i++)
+        (void)w.make_scenery<false>(w.make_id(), {ch, local_coords{(size_t)(i % TILE_COUNT)}}, scenery_proto(table));
+    c.sort_objects();
+}
+
+// one round trip through the store per iteration, the same as walking back
+// into a chunk that was paged out
+void Chunk_Page_In(benchmark::State& st)
+{
+    const auto nobjects = (uint32_t)st.range(0);
+    auto w = world();
+    constexpr auto ch = chunk_coords_{};
+    fill_chunk(w, ch, nobjects);
+
+    for (auto _ : st)
+    {
+        if (!w.page_out(*w.at(ch)))
+            st.SkipWithError("chunk is pinned");
+        benchmark::DoNotOptimize(w.at(ch));
+    }
+
+    const auto& s = w.chunk_store().stats();
+    st.counters["page_in_us"] = s.page_ins ? Time::to_milliseconds(s.page_in_total) * 1e3 / (double)s.page_ins : 0;
+    st.counters["page_in_max_us"] = Time::to_milliseconds(s.page_in_max) * 1e3;
+    st.counters["chunk_bytes"] = (double)w.at(ch)->memory_usage();
+    st.counters["record_bytes"] = (double)w.serialize_chunk(*w.at(ch)).size();
+}
+
+BENCHMARK(Chunk_Page_In)->Arg(0)->Arg(16)->Arg(128)->Unit(benchmark::kMicrosecond);
+
+// a camera moving across a 64x64 world, one chunk per update, with memory
+// capped at 256 chunks
+void Chunk_Streamer(benchmark::State& st)
+{
+    constexpr int16_t size = 64;
+    auto w = world();
+    for (int16_t y = 0; y < size; y++)
+        for (int16_t x = 0; x < size; x++)
+            fill_chunk(w, {x, y, 0}, 4);
+
+    chunk_streamer s{{ .radius = 4, .max_resident = 256, .max_page_ins = 32, .max_page_outs = 64, }};
+    int16_t x = 0;
+    for (auto _ : st)
+    {
+        const chunk_coords_ keep[] = {{x, size/2, 0}};
+        s.update(w, keep);
+        x = (int16_t)((x + 1) % size);
+    }
+
+    const auto& stats = s.stats();
+    st.counters["resident"] = stats.resident;
+    st.counters["paged_out"] = stats.paged_out;
+    st.counters["resident_kb"] = (double)stats.resident_bytes / 1024;
+    st.counters["store_kb"] = (double)stats.store_bytes / 1024;
+    st.counters["page_in_us"] = Time::to_milliseconds(stats.page_in_avg) * 1e3;
+}
+
+BENCHMARK(Chunk_Streamer)->Unit(benchmark::kMicrosecond);
+
+// a recorded camera path in chunks, with a few turns to throw the prediction off
+constexpr Vector2 replay_path[] = {
+    {2, 2}, {29, 2}, {29, 16}, {10, 16}, {10, 29}, {29, 29}, {2, 29}, {2, 2},
+};
+
+// Replays the path at 60 updates per second, about as fast as the editor
+// scrolls, looking at the 3x3 chunks around the camera. Most of the map stays
+// paged out to a store on disk. Arg(0) loads on demand, Arg(1) prefetches.
+void Chunk_Prefetch_Replay(benchmark::State& st)
+{
+    const bool prefetch = st.range(0) != 0;
+    constexpr int16_t size = 32;
+    constexpr auto dt = 16*Millisecond;
+    constexpr float chunks_per_second = 3;
+
+    auto w = world();
+    w.set_chunk_store(Pointer<chunk_store>{InPlaceInit, Path::join(loader.TEMP_PATH, "bench/chunk-prefetch"_s)});
+    for (int16_t y = 0; y < size; y++)
+        for (int16_t x = 0; x < size; x++)
+            fill_chunk(w, {x, y, 0}, 4);
+
+    chunk_streamer s{{ .radius = 1, .max_resident = 128, .max_page_ins = 32, .max_page_outs = 64, }};
+    chunk_prefetcher p{{}, 1};
+    Ns frame_total{}, frame_max{};
+    uint64_t frames = 0;
+
+    for (auto _ : st)
+    {
+        for (auto i = 0uz; i + 1 < array_size(replay_path); i++)
+        {
+            const auto from = replay_path[i], to = replay_path[i+1];
+            const auto steps = (uint32_t)Math::ceil((to - from).length() / chunks_per_second / Time::to_seconds(dt));
+            for (auto k = 0u; k < steps; k++)
+            {
+                const auto t0 = Time::now();
+                const auto pos = Math::lerp(from, to, (float)k / (float)steps);
+                const point tracked[] = { point{Vector3i{Vector2i{pos * (float)chunk_size_xy}, 0}} };
+                const auto center = tracked[0].chunk3();
+                chunk_coords_ visible[9];
+                auto n = 0u;
+                for (int16_t dy = -1; dy <= 1; dy++)
+                    for (int16_t dx = -1; dx <= 1; dx++)
+                        visible[n++] = {(int16_t)(center.x + dx), (int16_t)(center.y + dy), 0};
+
+                if (prefetch)
+                    p.update(w, visible, tracked, dt);
+                s.update(w, visible);
+                for (auto ch : visible)
+                    benchmark::DoNotOptimize(w.at(ch));
+
+                const auto frame = Time::now() - t0;
+                frame_total += frame;
+                if (frame > frame_max)
+                    frame_max = frame;
+                frames++;
+            }
+        }
+    }
+    p.finish(w);
+
+    const auto& stats = p.stats();
+    st.counters["frame_us"] = frames ? Time::to_milliseconds(frame_total / frames) * 1e3 : 0;
+    st.counters["frame_max_us"] = Time::to_milliseconds(frame_max) * 1e3;
+    st.counters["hits"] = (double)stats.hits;
+    st.counters["misses"] = (double)stats.misses;
+    st.counters["wasted"] = (double)stats.wasted;
+    st.counters["cancelled"] = (double)stats.cancelled;
+    st.counters["faults"] = (double)w.chunk_store().stats().faults;
+}
+
+BENCHMARK(Chunk_Prefetch_Replay)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace floormat
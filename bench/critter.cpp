@@ -326,6 +326,32 @@ void Critter_move(benchmark::State& st)
 
 BENCHMARK(Critter_move)->Unit(benchmark::kMicrosecond);
 
+void Critter_move_toward(benchmark::State& st)
+{
+    const auto mode = st.range(0) ? critter::move_mode::analytic : critter::move_mode::per_step;
+    const auto W = wall_image_proto{ loader.wall_atlas("empty"), 0 };
+    const auto from = point{{-1,-1,0}, {2,2}, {}}, dest = point{{1,1,0}, {12,4}, {}};
+
+    auto w = world();
+    w[{1,1,0}][{12,6}].wall_north() = W;
+    mark_all_modified(w);
+    object_id id = 0;
+    auto npc = w.ensure_player_character(id, make_proto(1));
+    auto index = npc->index();
+
+    for (auto _ : st)
+    {
+        npc->teleport_to(index, from, rotation_COUNT);
+        for (auto i = 0u; i < 1000 && npc->position() != dest; i++)
+        {
+            auto dt = Millisecond * 100.0;
+            (void)npc->move_toward(index, dt, dest, mode);
+        }
+    }
+}
+
+BENCHMARK(Critter_move_toward)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
 } // namespace
 
 } // namespace floormat
@@ -1,5 +1,6 @@
 #include "src/search-result.hpp"
 #include "src/search-astar.hpp"
+#include "src/search-dstar.hpp"
 #include "src/grid-pass.hpp"
 #include "src/point.hpp"
 #include "src/world.hpp"
@@ -17,6 +18,7 @@ void Dijkstra(benchmark::State& state)
     (void)loader.wall_atlas_list();
     auto w = world();
     auto A = astar();
+    A.set_frontier_policy((astar::frontier_policy)state.range(0));
 
     constexpr auto wcx = 1, wcy = 1, wtx = 8, wty = 8, wox = 0, woy = 0;
     constexpr auto max_dist = (uint32_t)(Vector2i(Math::abs(wcx)+1, Math::abs(wcy)+1)*TILE_MAX_DIM*iTILE_SIZE2).length();
@@ -73,8 +75,153 @@ void Dijkstra(benchmark::State& state)
         run.operator()<0>();
 }
 
+// no obstacles, so the frontier grows as wide as it can
+void Dijkstra_Open_Field(benchmark::State& state)
+{
+    constexpr auto from = point{{-2, -2, 0}, {1, 1}, {}};
+    constexpr auto to = point{{2, 2, 0}, {14, 14}, {}};
+    constexpr auto max_dist = (uint32_t)(Vector2i(6, 6)*TILE_MAX_DIM*iTILE_SIZE2).length();
+
+    auto w = world();
+    auto A = astar();
+    A.set_frontier_policy((astar::frontier_policy)state.range(0));
+    for (int16_t j = -3; j <= 3; j++)
+        for (int16_t i = -3; i <= 3; i++)
+            (void)w[{i, j, 0}];
+
+    auto run = [&] {
+        return A.Dijkstra(w, from, to, max_dist, {16, 16}, Search::without_critters());
+    };
+
+    fm_assert(run().is_found());
+    for (auto _ : state)
+        run();
+}
+
+// same search as Dijkstra_Open_Field, cut into slices of range(0) expansions
+void Dijkstra_Sliced(benchmark::State& state)
+{
+    constexpr auto from = point{{-2, -2, 0}, {1, 1}, {}};
+    constexpr auto to = point{{2, 2, 0}, {14, 14}, {}};
+    constexpr auto max_dist = (uint32_t)(Vector2i(6, 6)*TILE_MAX_DIM*iTILE_SIZE2).length();
+    const auto budget = astar::slice_budget{ .max_expansions = (uint32_t)state.range(0) };
+
+    auto w = world();
+    auto A = astar();
+    for (int16_t j = -3; j <= 3; j++)
+        for (int16_t i = -3; i <= 3; i++)
+            (void)w[{i, j, 0}];
+
+    auto run = [&] {
+        A.begin(w, from, to, max_dist, {16, 16}, Search::without_critters());
+        while (A.resume(w, budget) == astar::search_status::running)
+            (void)0;
+        return A.take_result();
+    };
+
+    fm_assert(run().is_found());
+    for (auto _ : state)
+        run();
+    state.counters["slices"] = A.slice_count();
+}
+
+// many short queries per frame, where wiping the window used to dominate
+void Dijkstra_Short(benchmark::State& state)
+{
+    constexpr auto queries_per_frame = 64;
+    constexpr auto max_dist = (uint32_t)(Vector2i(2, 2)*TILE_MAX_DIM*iTILE_SIZE2).length();
+
+    auto w = world();
+    auto A = astar();
+    for (int16_t j = -1; j <= 1; j++)
+        for (int16_t i = -1; i <= 1; i++)
+            (void)w[{i, j, 0}];
+
+    auto run = [&](int k) {
+        const auto from = point{{0, 0, 0}, {k % 12, k / 12 % 12}, {}};
+        const auto to = point{{0, 0, 0}, {k % 12 + 3, k / 12 % 12 + 2}, {}};
+        return A.Dijkstra(w, from, to, max_dist, {16, 16}, Search::without_critters());
+    };
+
+    fm_assert(run(0).is_found());
+    for (auto _ : state)
+        for (int k = 0; k < queries_per_frame; k++)
+            run(k);
+    state.SetItemsProcessed(state.iterations() * queries_per_frame);
+}
+
+struct replan_scene
+{
+    static constexpr auto from = point{{0, 0, 0}, {2, 8}, {}};
+    static constexpr auto to = point{{1, 0, 0}, {8, 8}, {}};
+    static constexpr auto max_dist = (uint32_t)(TILE_MAX_DIM*iTILE_SIZE2*3).length();
+    static constexpr auto own_size = Vector2ui{16, 16};
+
+    world w;
+    wall_image_proto wall;
+    bool blocked = false;
+
+    replan_scene()
+    {
+        (void)loader.wall_atlas_list();
+        wall = {loader.wall_atlas("empty", loader_policy::warn), 0};
+        for (int16_t j = -1; j <= 1; j++)
+            for (int16_t i = -1; i <= 2; i++)
+                (void)w[{i, j, 0}];
+    }
+
+    // a wall across the straight route that the path has to go around
+    void toggle_obstacle()
+    {
+        blocked = !blocked;
+        auto& c = w[chunk_coords_{0, 0, 0}];
+        for (int y = 5; y <= 11; y++)
+            c[{14, y}].wall_west() = blocked ? wall : wall_image_proto{};
+        c.mark_passability_modified();
+        c.ensure_passability();
+    }
+};
+
+void Dijkstra_Replan_Full(benchmark::State& state)
+{
+    auto S = replan_scene{};
+    auto A = astar();
+    auto run = [&] {
+        S.toggle_obstacle();
+        return A.Dijkstra(S.w, S.from, S.to, S.max_dist, S.own_size, Search::without_critters());
+    };
+    for (int i = 0; i < 4; i++)
+        fm_assert(run().is_found());
+    for (auto _ : state)
+        run();
+}
+
+void Dijkstra_Replan_Incremental(benchmark::State& state)
+{
+    auto S = replan_scene{};
+    auto D = dstar_lite{};
+    D.reset(S.w, S.from, S.to, S.max_dist, S.own_size, Search::without_critters());
+    fm_assert(D.plan(S.w).is_found());
+    auto run = [&] {
+        S.toggle_obstacle();
+        (void)D.sync(S.w);
+        return D.plan(S.w);
+    };
+    for (int i = 0; i < 4; i++)
+        fm_assert(run().is_found());
+    for (auto _ : state)
+        run();
+}
+
 } // namespace
 
-BENCHMARK(Dijkstra)->Unit(benchmark::kMillisecond);
+BENCHMARK(Dijkstra)->Unit(benchmark::kMillisecond)
+    ->ArgName("frontier")->Arg((int)astar::frontier_policy::binary_heap)->Arg((int)astar::frontier_policy::bucket_queue);
+BENCHMARK(Dijkstra_Open_Field)->Unit(benchmark::kMillisecond)
+    ->ArgName("frontier")->Arg((int)astar::frontier_policy::binary_heap)->Arg((int)astar::frontier_policy::bucket_queue);
+BENCHMARK(Dijkstra_Sliced)->Unit(benchmark::kMillisecond)->ArgName("expansions")->Arg(256)->Arg(4096);
+BENCHMARK(Dijkstra_Short)->Unit(benchmark::kMicrosecond);
+BENCHMARK(Dijkstra_Replan_Full)->Unit(benchmark::kMicrosecond);
+BENCHMARK(Dijkstra_Replan_Incremental)->Unit(benchmark::kMicrosecond);
 
 } // namespace floormat
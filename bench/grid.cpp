@@ -1,10 +1,15 @@
 #include "src/grid-pass.hpp"
+#include "src/grid-cover.hpp"
+#include "src/grid-fov.hpp"
+#include "src/raycast.hpp"
+#include "src/point.hpp"
 #include "src/world.hpp"
 #include "src/chunk.hpp"
 #include "src/tile-defs.hpp"
 #include "loader/loader.hpp"
 #include "compat/function2.hpp"
 #include <benchmark/benchmark.h>
+#include <cr/GrowableArray.h>
 
 namespace floormat {
 
@@ -120,6 +125,82 @@ void Grid_Build(benchmark::State& state)
 
 BENCHMARK(Grid_Build)->Arg(16)->Arg(8)->Unit(benchmark::kMillisecond);
 
+struct fov_scene
+{
+    static constexpr uint32_t radius = 32;
+    static constexpr auto coord = chunk_coords_{0, 0, 0};
+    static constexpr auto origin = point{coord, {8, 8}, {}};
+
+    world w;
+
+    fov_scene()
+    {
+        auto floor = tile_image_proto { loader.ground_atlas("texel"), 0 };
+        auto wall = wall_image_proto{ loader.wall_atlas("empty"), 0 };
+        for (int16_t j = -1; j <= 1; j++)
+            for (int16_t i = -1; i <= 1; i++)
+            {
+                auto& c = w[{i, j, 0}];
+                for (auto y = 0u; y < TILE_MAX_DIM; y++)
+                    for (auto x = 0u; x < TILE_MAX_DIM; x++)
+                        c[{x, y}].ground() = floor;
+            }
+        auto& c = w[coord];
+        for (uint8_t k : { 4, 5, 11, 12 })
+        {
+            c[{k, 5}].wall_north() = wall;
+            c[{5, k}].wall_west() = wall;
+        }
+        for (int16_t j = -1; j <= 1; j++)
+            for (int16_t i = -1; i <= 1; i++)
+                rebuild(w[{i, j, 0}]);
+    }
+};
+
+void Grid_Fov(benchmark::State& state)
+{
+    const bool cached = state.range(0);
+    auto S = fov_scene{};
+    auto cache = Fov::Cache{};
+    (void)cache.compute(S.w, S.origin, S.radius);
+
+    for (auto _ : state)
+    {
+        if (!cached)
+            cache.clear();
+        benchmark::DoNotOptimize(cache.compute(S.w, S.origin, S.radius).visible_count());
+    }
+}
+
+// one ray per cell of the same disc, which is what per-target checks cost
+void Grid_Fov_Raycasts(benchmark::State& state)
+{
+    constexpr auto r = (int32_t)fov_scene::radius, div = 8, per_tile = tile_size_xy / div;
+    auto S = fov_scene{};
+    auto& pool = S.w.cover_pass_pool();
+
+    Array<point> targets;
+    const auto A = Fov::cell_of(S.origin, div);
+    for (auto dy = -r; dy <= r; dy++)
+        for (auto dx = -r; dx <= r; dx++)
+        {
+            if (dx*dx + dy*dy > r*r)
+                continue;
+            const auto cell = A + Vector2i{dx, dy};
+            const auto tile = cell / per_tile;
+            const auto offset = (cell - tile * per_tile) * div + Vector2i{div/2 - tile_size_xy/2};
+            arrayAppend(targets, point{fov_scene::coord, local_coords{tile.x(), tile.y()}, Vector2b(offset)});
+        }
+
+    for (auto _ : state)
+        for (const auto& to : targets)
+            benchmark::DoNotOptimize(raycast(S.w, S.origin, to, 0, pool, Cover::shoot_through_pred()).success);
+    state.SetItemsProcessed(state.iterations() * (int64_t)targets.size());
+}
+
+BENCHMARK(Grid_Fov)->ArgName("cached")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(Grid_Fov_Raycasts)->Unit(benchmark::kMicrosecond);
+
 } // namespace
 
 } // namespace floormat
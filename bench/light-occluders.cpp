@@ -0,0 +1,158 @@
+#include "src/light-occluders.hpp"
+#include "src/light-index.hpp"
+#include "src/light.hpp"
+#include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/chunk-iter.hpp"
+#include "src/object.hpp"
+#include "src/tile-image.hpp"
+#include "src/ground-atlas.hpp"
+#include "src/wall-atlas.hpp"
+#include "src/scenery.hpp"
+#include "src/scenery-proto.hpp"
+#include "loader/loader.hpp"
+#include "compat/borrowed-ptr.inl"
+#include <benchmark/benchmark.h>
+#include <cr/GrowableArray.h>
+
+namespace floormat {
+
+namespace {
+
+// the 4x4 chunks lightmap_shader looks at: rooms of 4x4 tiles, a blocked
+// pillar and a few tables in each chunk
+Array<chunk*> make_chunks(world& w)
+{
+    constexpr int16_t size = 4;
+    const auto floor = tile_image_proto{ loader.ground_atlas("tiles"), 0 };
+    const auto pillar = tile_image_proto{ loader.ground_atlas("texel"), 0 };
+    const auto wall = wall_image_proto{ loader.wall_atlas("test1"), 0 };
+    const auto& table = loader.scenery("table0");
+
+    Array<chunk*> chunks;
+    for (int16_t y = 0; y < size; y++)
+        for (int16_t x = 0; x < size; x++)
+        {
+            const auto ch = chunk_coords_{x, y, 0};
+            auto& c = w[ch];
+            for (uint8_t j = 0; j < TILE_MAX_DIM; j++)
+                for (uint8_t i = 0; i < TILE_MAX_DIM; i++)
+                {
+                    auto t = c[{i, j}];
+                    t.ground() = i >= 6 && i < 9 && j >= 6 && j < 9 ? pillar : floor;
+                    if (j % 4 == 0 && i % 4 != 2) // doorways
+                        t.wall_north() = wall;
+                    if (i % 4 == 0 && j % 4 != 2)
+                        t.wall_west() = wall;
+                }
+            for (uint8_t i = 0; i < 4; i++)
+                (void)w.make_scenery(w.make_id(), {ch, {(uint8_t)(i * 4 + 1), 13}}, scenery_proto(table));
+            c.mark_modified();
+            c.ensure_passability();
+            arrayAppend(chunks, &c);
+        }
+    return chunks;
+}
+
+// what the old per-tile walk emitted, four segments per blocker
+size_t count_unmerged(const chunk& c)
+{
+    size_t count = 0;
+    for (auto i = 0u; i < TILE_COUNT; i++)
+    {
+        const auto* g = c.ground_atlas_at(i);
+        count += g && g->pass_mode() == pass_mode::blocked;
+        for (auto k = 0u; k < 2; k++)
+        {
+            const auto* w = c.wall_atlas_at(i*2 + k);
+            count += w && w->info().passability == pass_mode::blocked;
+        }
+    }
+    for (const auto& e : c.objects())
+        count += !e.is_virtual() && e.pass != pass_mode::pass && e.pass != pass_mode::see_through;
+    return count * 4;
+}
+
+void Light_Occluders_Extract(benchmark::State& st)
+{
+    auto w = world();
+    const auto chunks = make_chunks(w);
+    Array<occluder_segment> segments;
+
+    for (auto _ : st)
+    {
+        arrayClear(segments);
+        for (auto* c : chunks)
+        {
+            make_static_occluders(*c, segments);
+            make_dynamic_occluders(*c, segments);
+        }
+        benchmark::DoNotOptimize(segments.data());
+    }
+
+    size_t unmerged = 0;
+    for (auto* c : chunks)
+        unmerged += count_unmerged(*c);
+    st.counters["segments"] = (double)segments.size();
+    st.counters["segments_unmerged"] = (double)unmerged;
+    st.counters["reduction"] = (double)unmerged / (double)segments.size();
+}
+
+// a frame with nothing changed, the static segments come from the cache
+void Light_Occluders_Cached(benchmark::State& st)
+{
+    auto w = world();
+    const auto chunks = make_chunks(w);
+    Array<occluder_segment> segments;
+
+    for (auto _ : st)
+    {
+        arrayClear(segments);
+        for (auto* c : chunks)
+        {
+            arrayAppend(segments, c->static_occluders());
+            make_dynamic_occluders(*c, segments);
+        }
+        benchmark::DoNotOptimize(segments.data());
+    }
+    st.counters["segments"] = (double)segments.size();
+}
+
+// lots of small lights, like consoles and lamps all over the place
+void Light_Index_Build(benchmark::State& st)
+{
+    auto w = world();
+    const auto chunks = make_chunks(w);
+    uint32_t seed = 0x2545f491;
+    for (auto* c : chunks)
+        for (auto i = 0u; i < 10; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            auto proto = light_proto{};
+            proto.max_distance = 2;
+            const auto tile = local_coords{(uint8_t)(seed >> 8 & 15), (uint8_t)(seed >> 16 & 15)};
+            (void)w.make_object<light>(w.make_id(), {c->coord(), tile}, proto);
+        }
+
+    auto index = light_index{};
+    for (auto _ : st)
+    {
+        index.clear();
+        for (auto* c : chunks)
+            index.add_chunk(Vector2(c->coord().x - 2, c->coord().y - 2), *c);
+        index.build({Vector2{-2048}, Vector2{2048}});
+        benchmark::DoNotOptimize(index.segments().data());
+    }
+    const auto& s = index.stats();
+    st.counters["lights"] = (double)s.visible_lights;
+    st.counters["segments"] = (double)s.segments;
+    st.counters["segments_per_light"] = (double)s.selected / (double)s.visible_lights;
+}
+
+BENCHMARK(Light_Occluders_Extract)->Unit(benchmark::kMicrosecond);
+BENCHMARK(Light_Occluders_Cached)->Unit(benchmark::kMicrosecond);
+BENCHMARK(Light_Index_Build)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+} // namespace floormat
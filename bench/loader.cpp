@@ -3,8 +3,13 @@
 #include "loader/wall-cell.hpp"
 #include "serialize/json-helper.hpp"
 #include "serialize/anim.hpp"
+#include "src/sprite-atlas.hpp"
+#include "src/sprite-atlas-cache.hpp"
+#include "compat/assert.hpp"
 #include <cr/ArrayView.h>
 #include <cr/StringIterable.h>
+#include <cr/Optional.h>
+#include <cr/Path.h>
 #include <benchmark/benchmark.h>
 
 namespace floormat {
@@ -56,7 +61,68 @@ void Loader_json(benchmark::State& state)
         run();
 }
 
+// startup without the baked atlas: decode and pack every image
+void Loader_atlas_cold(benchmark::State& state)
+{
+    loader.destroy();
+    loader.set_atlas_cache_path({});
+
+    for (auto _ : state)
+    {
+        loader.destroy();
+        run();
+    }
+    state.counters["layers"] = (double)loader.atlas().used_layers();
+    loader.destroy();
+}
+
+// startup with the baked atlas made by the previous run
+void Loader_atlas_warm(benchmark::State& state)
+{
+    const auto path = Path::join(loader.TEMP_PATH, "bench-sprite-atlas.cache"_s);
+    loader.destroy();
+    if (Path::exists(path))
+        (void)Path::remove(path);
+    loader.set_atlas_cache_path(path);
+    run();
+    fm_assert(loader.save_atlas_cache());
+
+    for (auto _ : state)
+    {
+        loader.destroy();
+        run();
+        fm_assert(!loader.atlas_cache()->is_dirty());
+    }
+    state.counters["layers"] = (double)loader.atlas().used_layers();
+    state.counters["bytes"] = (double)*Path::size(path);
+
+    loader.destroy();
+    loader.set_atlas_cache_path({});
+    (void)Path::remove(path);
+}
+
+// what the editor does at startup, with the images decoded on
+// state.range(0) worker threads; 0 is the serial baseline
+void Loader_preload(benchmark::State& state)
+{
+    const auto thread_count = (uint32_t)state.range(0);
+    loader.destroy();
+    loader.set_atlas_cache_path({});
+
+    for (auto _ : state)
+    {
+        loader.destroy();
+        loader.preload_atlases(thread_count);
+    }
+    state.counters["threads"] = (double)thread_count;
+    state.counters["layers"] = (double)loader.atlas().used_layers();
+    loader.destroy();
+}
+
 BENCHMARK(Loader_json)->Unit(benchmark::kMillisecond);
+BENCHMARK(Loader_atlas_cold)->Unit(benchmark::kMillisecond);
+BENCHMARK(Loader_atlas_warm)->Unit(benchmark::kMillisecond);
+BENCHMARK(Loader_preload)->Arg(0)->Arg(1)->Arg(3)->Arg(7)->Unit(benchmark::kMillisecond)->UseRealTime();
 
 } // namespace
 
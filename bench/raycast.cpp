@@ -216,6 +216,42 @@ void Raycast_Dense(benchmark::State& state)
 
 BENCHMARK(Raycast_Dense)->Unit(benchmark::kMicrosecond);
 
+// short rays in every direction, like the cover grid and line of sight checks
+void Raycast_Batch(benchmark::State& state)
+{
+    const bool batched = state.range(0) != 0;
+    auto w = make_dense_world();
+
+    Array<rc::ray> rays;
+    for (int16_t cy = -2; cy <= 2; cy++)
+        for (int16_t cx = -2; cx <= 2; cx++)
+        {
+            const auto from = point{{cx, cy, 0}, {7, 9}, {3, -5}};
+            for (int k = 0; k < 40; k++)
+            {
+                const auto angle = Rad{(float)k * 2 * Math::Constants<float>::pi() / 40};
+                const auto len = (float)(2 + k % 9) * TILE_SIZE2.x();
+                const auto off = Vector2i(Vector2{Math::cos(angle), Math::sin(angle)} * len);
+                arrayAppend(rays, rc::ray{from, point::normalize_coords(from, off), 0});
+            }
+        }
+    auto results = Array<rc::raycast_result_s>{ValueInit, rays.size()};
+
+    const auto test = [&] {
+        if (batched)
+            raycast_many(w, rays, results);
+        else
+            for (auto i = 0uz; i < rays.size(); i++)
+                results[i] = raycast(w, rays[i].from, rays[i].to, rays[i].self);
+    };
+
+    for (int i = 0; i < 3; i++) test();
+    for (auto _ : state) test();
+    state.SetItemsProcessed((int64_t)(state.iterations() * rays.size()));
+}
+
+BENCHMARK(Raycast_Batch)->Unit(benchmark::kMicrosecond)->ArgName("batched")->Arg(0)->Arg(1);
+
 namespace old_rc {
 
 using rc::raycast_result_s;
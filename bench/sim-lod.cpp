@@ -0,0 +1,123 @@
+#include "src/sim-lod.hpp"
+#include "src/world.hpp"
+#include "src/critter.hpp"
+#include "src/critter-script.hpp"
+#include "src/search-result.hpp"
+#include "src/scenery.hpp"
+#include "src/scenery-proto.hpp"
+#include "src/hole.hpp"
+#include "src/point.inl"
+#include "src/nanosecond.inl"
+#include "loader/loader.hpp"
+#include "compat/borrowed-ptr.inl"
+#include <cr/GrowableArray.h>
+#include <benchmark/benchmark.h>
+
+namespace floormat {
+
+namespace {
+
+constexpr int16_t nchunks_x = 20, nchunks_y = 10;
+constexpr uint32_t walkers_per_row = 5, walkers_per_chunk = walkers_per_row * walkers_per_row;
+constexpr uint32_t path_len = 256;
+
+// 5000 critters over 200 chunks, each pacing back and forth on its own tile
+world make_world()
+{
+    critter_proto proto;
+    proto.atlas = loader.anim_atlas("npc-walk", loader.ANIM_PATH);
+    proto.name = "Walker"_s;
+    proto.playable = false;
+    proto.bbox_size = Vector2ub(tile_size_xy/4);
+
+    auto w = world();
+    for (int16_t cy = 0; cy < nchunks_y; cy++)
+        for (int16_t cx = 0; cx < nchunks_x; cx++)
+            for (auto i = 0u; i < walkers_per_chunk; i++)
+            {
+                const auto ch = chunk_coords_{(int16_t)(cx - nchunks_x/2), (int16_t)(cy - nchunks_y/2), 0};
+                const auto x = (uint8_t)(1 + i % walkers_per_row * 3), y = (uint8_t)(1 + i / walkers_per_row * 3);
+                const auto a = point{ch, {x, y}, {}}, b = point{ch, {(uint8_t)(x+1), y}, {}};
+                path_search_result path;
+                for (auto k = 0u; k < path_len; k++)
+                    arrayAppend(path.raw_path(), k % 2 ? a : b);
+                auto C = w.make_object<critter>(w.make_id(), a.coord(), critter_proto{proto});
+                C->script.do_reassign(critter_script::make_walk_script(move(path)), C);
+            }
+    return w;
+}
+
+void Sim_LOD(benchmark::State& st)
+{
+    Debug quiet{nullptr};
+    const bool use_lod = st.range(0);
+
+    auto w = make_world();
+    // the old behavior is to update only the visible chunks; updating every
+    // chunk at full rate is what the tiers save on
+    Array<chunk_coords_> full;
+    if (use_lod)
+        for (int16_t y = -1; y <= 1; y++)
+            for (int16_t x = -1; x <= 1; x++)
+                arrayAppend(full, chunk_coords_{x, y, 0});
+    else
+        for (int16_t y = 0; y < nchunks_y; y++)
+            for (int16_t x = 0; x < nchunks_x; x++)
+                arrayAppend(full, chunk_coords_{(int16_t)(x - nchunks_x/2), (int16_t)(y - nchunks_y/2), 0});
+
+    sim_lod lod{{ .reduced_radius = 3, .coarse_radius = 10, .reduced_interval = 4, .coarse_interval = 16, }};
+    for (auto _ : st)
+        lod.update(w, full, Millisecond * 16.667);
+
+    uint32_t updates = 0;
+    for (auto x : lod.stats().updates)
+        updates += x;
+    st.counters["updates"] = updates;
+}
+
+BENCHMARK(Sim_LOD)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// mostly idle chunks: scenery and holes, and one walker per chunk.
+// `objects` is how many update() calls a loop over every object makes.
+void Sim_Active(benchmark::State& st)
+{
+    Debug quiet{nullptr};
+    auto w = world();
+    auto table = loader.scenery("table0");
+    auto proto = critter_proto{};
+    proto.atlas = loader.anim_atlas("npc-walk", loader.ANIM_PATH);
+    proto.bbox_size = Vector2ub(tile_size_xy/4);
+
+    Array<chunk_coords_> full;
+    for (int16_t cy = 0; cy < nchunks_y; cy++)
+        for (int16_t cx = 0; cx < nchunks_x; cx++)
+        {
+            const auto ch = chunk_coords_{(int16_t)(cx - nchunks_x/2), (int16_t)(cy - nchunks_y/2), 0};
+            arrayAppend(full, ch);
+            for (uint8_t i = 0; i < 12; i++)
+            {
+                (void)w.make_scenery<false>(w.make_id(), {ch, {i, 2}}, scenery_proto(table));
+                (void)w.make_object<hole, false>(w.make_id(), {ch, {i, 4}}, hole_proto{});
+            }
+            const auto a = point{ch, {2, 10}, {}}, b = point{ch, {12, 10}, {}};
+            path_search_result path;
+            for (auto k = 0u; k < path_len; k++)
+                arrayAppend(path.raw_path(), k % 2 ? a : b);
+            auto C = w.make_object<critter, false>(w.make_id(), a.coord(), critter_proto{proto});
+            C->script.do_reassign(critter_script::make_walk_script(move(path)), C);
+            w[ch].sort_objects();
+        }
+
+    sim_lod lod;
+    for (auto _ : st)
+        lod.update(w, full, Millisecond * 16.667);
+
+    st.counters["updates"] = lod.stats().updates[(size_t)sim_tier::full];
+    st.counters["objects"] = lod.stats().objects[(size_t)sim_tier::full];
+}
+
+BENCHMARK(Sim_Active)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+} // namespace floormat
@@ -0,0 +1,91 @@
+#include "src/sprite-atlas.hpp"
+#include "src/sprite-atlas-impl.hpp"
+#include "src/sprite-constants.hpp"
+#include "src/anim-atlas.hpp"
+#include "src/wall-atlas.hpp"
+#include "src/object.hpp"
+#include "src/scenery-proto.hpp"
+#include "loader/loader.hpp"
+#include "loader/scenery-cell.hpp"
+#include "loader/wall-cell.hpp"
+#include <algorithm>
+#include <cr/GrowableArray.h>
+#include <cr/Optional.h>
+#include <cr/Path.h>
+#include <cr/StringIterable.h>
+#include <benchmark/benchmark.h>
+
+namespace floormat {
+
+namespace {
+
+// every frame of the repository's anim, scenery and wall assets, in the
+// order the loader would pack them
+Array<Vector2ui> asset_sizes()
+{
+    Array<Vector2ui> sizes;
+    Array<const anim_atlas*> seen;
+    const auto add_anim = [&](const anim_atlas& a) {
+        if (std::find(seen.begin(), seen.end(), &a) != seen.end())
+            return;
+        arrayAppend(seen, &a);
+        for (const auto& g : a.info().groups)
+            if (g.mirror_from.isEmpty())
+                for (const auto& f : g.frames)
+                    arrayAppend(sizes, f.size);
+    };
+
+    using LF = Path::ListFlag;
+    auto files = Path::list(loader.ANIM_PATH, LF::SkipDirectories|LF::SkipSpecial|LF::SkipDotAndDotDot);
+    fm_assert(files);
+    for (StringView file : *files)
+        if (file.hasSuffix(".json"_s))
+            add_anim(*loader.anim_atlas(Path::splitExtension(file).first(), loader.ANIM_PATH, loader_policy::warn));
+
+    for (const auto& x : loader.scenery_list())
+        if (x.name != loader.INVALID)
+            add_anim(*loader.scenery(x.name).atlas);
+
+    for (const auto& x : loader.wall_atlas_list())
+        if (x.name != loader.INVALID)
+            for (const auto& f : loader.wall_atlas(x.name)->raw_frame_array())
+                arrayAppend(sizes, f.size);
+
+    return sizes;
+}
+
+void Sprite_atlas_pack(benchmark::State& state)
+{
+    static const auto sizes = asset_sizes();
+    const auto packer = (sprite_atlas_packer)state.range(0);
+    const auto layer_size = (uint16_t)std::min<uint32_t>((uint32_t)state.range(1), SpriteAtlas::max_2d_texture_size());
+
+    SpriteAtlas::Atlas a;
+    a.layer_size = layer_size;
+    a.packer = packer;
+    for (auto _ : state)
+    {
+        SpriteAtlas::free_atlas(a);
+        for (auto size : sizes)
+            SpriteAtlas::alloc_sprite(a, size.x(), size.y());
+    }
+
+    const auto st = SpriteAtlas::atlas_stats(a);
+    state.SetLabel(packer == sprite_atlas_packer::skyline ? "skyline" : "shelf");
+    state.counters["sprites"] = (double)st.sprites;
+    state.counters["layers"] = (double)st.layers;
+    state.counters["used_bytes"] = (double)st.used_bytes;
+    state.counters["layer_bytes"] = (double)st.layer_bytes;
+    state.counters["allocated_bytes"] = (double)st.allocated_bytes;
+    state.counters["occupancy"] = (double)st.occupancy();
+    state.counters["fragmentation"] = (double)st.fragmentation();
+    SpriteAtlas::free_atlas(a);
+}
+
+BENCHMARK(Sprite_atlas_pack)
+    ->ArgsProduct({{(int)sprite_atlas_packer::shelf, (int)sprite_atlas_packer::skyline}, {1024, 2048, 4096}})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+} // namespace floormat
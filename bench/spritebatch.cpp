@@ -0,0 +1,95 @@
+#include "src/spritebatch.hpp"
+#include "src/depth.hpp"
+#include "src/point.inl"
+#include "src/tile-defs.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cr/GrowableArray.h>
+
+namespace floormat {
+
+namespace {
+
+struct recorded_frame
+{
+    struct run { chunk_coords_ coord; uint32_t first, last; bool sort; };
+    Array<run> runs;
+    Array<Quads::vertexes> vertexes;
+    Array<float> depths;
+};
+
+// what the scenery pass emits for a screenful of chunks: per chunk, the
+// critters in _objects order, then the static scenery sorted by depth.
+recorded_frame record_frame()
+{
+    constexpr int16_t size = 8;
+    constexpr uint32_t statics = 200, dynamics = 20;
+    static_assert(size * size * (statics + dynamics) <= Quads::max_quads_per_buffer);
+
+    recorded_frame f;
+    uint32_t seed = 0x9e3779b9;
+    const auto next = [&](uint32_t max) {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) % max;
+    };
+    const auto emit = [&](chunk_coords_ ch) {
+        const auto tile = local_coords{(uint8_t)next(TILE_MAX_DIM), (uint8_t)next(TILE_MAX_DIM)};
+        const auto offset = Vector2b{(int8_t)(next(64) - 32), (int8_t)(next(64) - 32)};
+        const auto depth = Depth::value_at(0.f, point{ch, tile, offset}, (int32_t)next(3) - 1);
+        Quads::vertexes v{};
+        for (auto& x : v)
+            x.depth = depth;
+        arrayAppend(f.vertexes, v);
+        arrayAppend(f.depths, depth);
+    };
+
+    for (int16_t y = 0; y < size; y++)
+        for (int16_t x = 0; x < size; x++)
+        {
+            const auto ch = chunk_coords_{x, y, 0};
+            auto first = (uint32_t)f.depths.size();
+            for (auto i = 0u; i < dynamics; i++)
+                emit(ch);
+            arrayAppend(f.runs, recorded_frame::run{ch, first, (uint32_t)f.depths.size(), true});
+
+            first = (uint32_t)f.depths.size();
+            for (auto i = 0u; i < statics; i++)
+                emit(ch);
+            const auto last = (uint32_t)f.depths.size();
+            std::stable_sort(f.depths.begin() + first, f.depths.begin() + last);
+            for (auto i = first; i < last; i++)
+                for (auto& v : f.vertexes[i])
+                    v.depth = f.depths[i];
+            arrayAppend(f.runs, recorded_frame::run{ch, first, last, false});
+        }
+    return f;
+}
+
+void SpriteBatch_Sort(benchmark::State& st)
+{
+    const bool do_sort = st.range(0);
+    const auto frame = record_frame();
+    auto sb = SpriteBatch{};
+
+    for (auto _ : st)
+    {
+        for (const auto& r : frame.runs)
+        {
+            sb.begin_chunk(r.coord);
+            for (auto i = r.first; i < r.last; i++)
+                sb.emit(frame.vertexes[i], frame.depths[i]);
+            sb.end_chunk(r.sort);
+        }
+        const auto V = sb.sort(do_sort);
+        benchmark::DoNotOptimize(V.data());
+        sb.clear();
+    }
+    st.counters["quads"] = (double)frame.depths.size();
+    st.counters["bytes"] = (double)(frame.depths.size() * sizeof(Quads::vertexes));
+}
+
+BENCHMARK(SpriteBatch_Sort)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+} // namespace floormat
@@ -0,0 +1,35 @@
+#include "cpu-features.hpp"
+#include "compat/arch.hpp"
+
+#if defined _MSC_VER && !defined __clang__ && (defined __x86_64__ || defined __i386__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace floormat {
+
+bool cpu_has_avx2()
+{
+#if !defined __x86_64__ && !defined __i386__
+    return false;
+#elif defined _MSC_VER && !defined __clang__
+    static const bool ret = [] {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        // the OS has to save the ymm registers too
+        constexpr int osxsave = 1 << 27, avx = 1 << 28;
+        if ((info[2] & (osxsave|avx)) != (osxsave|avx) || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & 1 << 5) != 0;
+    }();
+    return ret;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+} // namespace floormat
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace floormat {
+
+// whether the CPU and the OS both support AVX2, for kernels built with
+// [[gnu::target("avx2")]] on top of the baseline instruction set.
+// always false outside x86.
+bool cpu_has_avx2();
+
+} // namespace floormat
@@ -25,6 +25,15 @@ constexpr int fpclassify(float x)
     }
 }
 
+// unsigned keys that sort like the floats they're made of, with -0 == +0
+constexpr uint32_t float_sort_key(float x)
+{
+    const uint32_t u = std::bit_cast<uint32_t>(x);
+    if ((u << 1) == 0u)
+        return 0x80000000u;
+    return (u & 0x80000000u) != 0u ? ~u : (u ^ 0x80000000u);
+}
+
 constexpr float nth_float(float x, uint32_t n)
 {
     const uint32_t u = std::bit_cast<uint32_t>(x);
@@ -5,11 +5,13 @@
 #include "src/anim-atlas.hpp"
 #include "src/critter.hpp"
 #include "src/world.hpp"
+#include "src/chunk-prefetch.hpp"
 #include "floormat/main.hpp"
 #include "floormat/settings.hpp"
 #include "loader/loader.hpp"
 #include <cr/StringIterable.h>
 #include <cr/Arguments.h>
+#include <cr/Path.h>
 
 namespace floormat {
 
@@ -44,6 +46,7 @@ void app::reset_world_pre()
     kill_popups(true);
     tested_light_chunk = {};
     tests_reset_mode();
+    _chunk_prefetcher->reset();
     clear_keys();
     _character_id = 0;
     _render_vobjs = true;
@@ -157,10 +160,13 @@ int app::run_from_argv(const int argc, const char* const* const argv)
     opts.argv = argv;
     opts.argc = argc;
 
+    loader.set_atlas_cache_path(Path::join(loader.TEMP_PATH, "sprite-atlas.cache"_s));
+
     struct app* A = new app{move(opts)};
     floormat_main* M = A->M;
     fm_assert(M != nullptr);
     ret = A->exec();
+    (void)loader.save_atlas_cache();
     loader.destroy();
     delete A;
     delete M;
@@ -31,6 +31,10 @@ struct object;
 struct critter;
 struct point;
 class editor;
+class sim_lod;
+class chunk_streamer;
+class chunk_prefetcher;
+class light_index;
 template<typename T> struct shared_ptr_wrapper;
 struct tests_data_;
 
@@ -193,6 +197,10 @@ private:
     safe_ptr<editor> _editor;
     safe_ptr<key_set> keys_;
     safe_ptr<imgui::text_painter_pool> _text_pool;
+    safe_ptr<sim_lod> _sim_lod;
+    safe_ptr<chunk_streamer> _chunk_streamer;
+    safe_ptr<chunk_prefetcher> _chunk_prefetcher;
+    safe_ptr<light_index> _light_index;
     struct key_modifiers_ { int data[key_COUNT]; } key_modifiers;
     Array<popup_target> inspectors;
     object_id _character_id = 0;
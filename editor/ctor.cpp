@@ -7,6 +7,10 @@
 #include "draw/wireframe-meshes.hpp"
 #include "src/sprite-atlas-impl.hpp"
 #include "src/sprite-atlas.hpp"
+#include "src/sim-lod.hpp"
+#include "src/chunk-stream.hpp"
+#include "src/chunk-prefetch.hpp"
+#include "src/light-index.hpp"
 #include "loader/loader.hpp"
 #include "floormat/main.hpp"
 #include <mg/ImGuiIntegration/Context.h>
@@ -21,6 +25,10 @@ app::app(fm_settings&& opts) :
     _editor{InPlaceInit, this},
     keys_{InPlaceInit, 0u},
     _text_pool{InPlaceInit},
+    _sim_lod{InPlaceInit},
+    _chunk_streamer{InPlaceInit},
+    _chunk_prefetcher{InPlaceInit},
+    _light_index{InPlaceInit},
     key_modifiers{}
 {
     reset_world_post();
@@ -18,7 +18,6 @@
 #include "src/RTree-search.hpp"
 #include "src/spritebatch.hpp"
 #include "compat/limits.hpp"
-#include "src/depth.hpp"
 #include <bit>
 #include <mg/Color.h>
 #include <mg/ImGuiIntegration/Context.h>
@@ -235,34 +234,7 @@ clickable* app::find_clickable_scenery(const Optional<Vector2i>& pixel)
     if (!pixel || _editor->mode() != editor_mode::none)
         return nullptr;
 
-    clickable* item = nullptr;
-
-    const auto array = M->clickable_scenery();
-    const auto p = *pixel;
-    uint32_t depth = 0;
-
-    for (clickable& c : array)
-    {
-        const uint32_t d = Depth::value_atʹ(c.e->position());
-        if (d > depth && c.dest.contains(p))
-        {
-            // mirror inside the frame, before adding the frame's atlas offset
-            const auto posʹ = *pixel - c.dest.min();
-            const auto posʹʹ = !c.mirrored ? posʹ : Vector2i(int(c.src.sizeX()) - 1 - posʹ[0], posʹ[1]);
-            const auto pos = posʹʹ + Vector2i(c.src.min());
-            size_t idx = unsigned(pos.y()) * c.stride + unsigned(pos.x());
-            fm_assert(c.bitmask.isEmpty() || idx < c.bitmask.size());
-            if (c.bitmask.isEmpty() || c.bitmask[idx])
-            {
-                depth = d;
-                item = &c;
-            }
-        }
-    }
-    if (item)
-        return item;
-    else
-        return nullptr;
+    return M->clickable_at(*pixel);
 }
 
 } // namespace floormat
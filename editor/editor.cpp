@@ -8,6 +8,8 @@
 #include "src/sprite-atlas.hpp"
 #include "loader/loader.hpp"
 #include <algorithm>
+#include <thread>
+#include <mg/Functions.h>
 #include <mg/Range.h>
 #include <mg/TextureFormat.h>
 #include <mg/TextureArray.h>
@@ -191,7 +193,19 @@ void editor::on_click(world& world, global_coords pos, int mods, button b)
     }
 }
 
-editor::editor(app* a) : _app{a} {}
+namespace {
+
+// decode the images on all cores before the editors below ask for their
+// atlases one at a time
+app* preload_atlases(app* a)
+{
+    loader.preload_atlases(Math::clamp(std::thread::hardware_concurrency(), 1u, 8u) - 1);
+    return a;
+}
+
+} // namespace
+
+editor::editor(app* a) : _app{preload_atlases(a)} {}
 editor::editor(editor&&) noexcept = default;
 editor& editor::operator=(editor&&) noexcept = default;
 editor::~editor() noexcept = default;
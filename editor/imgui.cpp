@@ -562,9 +562,9 @@ void app::do_lightmap_test()
 
     auto& shader = M->lightmap_shader();
     const auto ns = shader.iter_bounds();
+    auto& index = *_light_index;
 
-    shader.begin_occlusion();
-
+    index.clear();
     for (int j = y - ns; j < y + ns; j++)
         for (int i = x - ns; i < x + ns; i++)
         {
@@ -572,40 +572,13 @@ void app::do_lightmap_test()
             if (auto* chunk = w.at(c))
             {
                 auto offset = Vector2(Vector2i(c.x, c.y) - Vector2i(x, y));
-                shader.add_chunk(offset, *chunk);
+                index.add_chunk(offset, *chunk);
             }
         }
+    index.build(lightmap_shader::bounds());
 
-    shader.end_occlusion();
     shader.bind();
-
-    for (int j = y - ns; j < y + ns; j++)
-        for (int i = x - ns; i < x + ns; i++)
-        {
-            auto c = chunk_coords_{(int16_t)i, (int16_t)j, z};
-            if (auto* chunk = w.at(c))
-            {
-                auto offset = Vector2(Vector2i(c.x, c.y) - Vector2i(x, y));
-                for (const auto& eʹ : chunk->objects())
-                {
-                    if (eʹ->type() == object_type::light)
-                    {
-                        const auto& li = static_cast<const light&>(*eʹ);
-                        if (li.max_distance < 1e-6f)
-                            continue;
-                        light_s L {
-                            .center = Vector2(li.coord.local()) * TILE_SIZE2 + Vector2(li.offset),
-                            .dist = li.max_distance,
-                            .radius = li.radius,
-                            .color = li.color,
-                            .falloff = li.falloff,
-                        };
-                        shader.add_light(offset, L);
-                    }
-                }
-            }
-        }
-
+    shader.add_lights(index);
     shader.finish();
     M->bind();
 }
@@ -5,7 +5,10 @@
 #include "src/point.hpp"
 #include "src/grid-cover.hpp"
 #include "src/world.hpp"
+#include "src/nanosecond.inl"
 #include "floormat/main.hpp"
+#include <thread>
+#include <cr/GrowableArray.h>
 #include <mg/Color.h>
 #include <mg/Functions.h>
 
@@ -30,9 +33,14 @@ constexpr const char* compass_names_16[16] = {
 
 constexpr Color4 color_selected{1, 0.843f, 0, 0.8f};
 
+// main thread's share of filling the visible chunks' octants, per frame
+constexpr Ns fill_budget = 2*Millisecond;
+
 struct cover_test final : base_test
 {
     Cover::Pool pool;
+    Cover::Filler filler;
+    Array<chunk_coords_> visible;
 
     cover_test();
     ~cover_test() noexcept override = default;
@@ -61,7 +69,11 @@ struct cover_test final : base_test
     bool has_result : 1 = false, has_pending : 1 = false;
 };
 
-cover_test::cover_test(): pool{Cover::Params{ .div_size = div_size }} {}
+cover_test::cover_test():
+    pool{Cover::Params{ .div_size = div_size }},
+    filler{pool, Math::clamp(std::thread::hardware_concurrency(), 1u, 4u) - 1}
+{
+}
 
 bool cover_test::handle_key(app& a, const key_event& e, bool is_down)
 {
@@ -211,24 +223,26 @@ void cover_test::draw_overlay(app& a)
 
 void cover_test::update_post(app& a, const Ns&)
 {
+    auto& w = a.main().world();
     if (has_pending)
     {
         has_pending = false;
         extract(a, pending.from);
-        return;
     }
-    if (!has_result)
-        return;
-    auto& w = a.main().world();
-    auto* c = w.at(result.from.chunk3());
-    if (!c)
-        return;
-    pool.maybe_mark_stale_all(w.frame_no());
-    Cover::Grid cg = pool[*c];
-    const auto sk = (uint32_t)selected_octant;
-    if (cg.ensure_octant(sk))
-        return;
-    cg.fill_next_unfilled();
+    else if (has_result)
+    {
+        if (auto* c = w.at(result.from.chunk3()))
+        {
+            pool.maybe_mark_stale_all(w.frame_no());
+            Cover::Grid cg = pool[*c];
+            const auto sk = (uint32_t)selected_octant;
+            if (!cg.ensure_octant(sk))
+                cg.fill_next_unfilled();
+        }
+    }
+    // the rest of the screen in the background, so clicking elsewhere
+    // finds its grid already filled
+    filler.update(w, a.main().get_draw_bounds(visible, {}), fill_budget);
 }
 
 void cover_test::extract(app& a, point pt)
@@ -293,6 +307,12 @@ void cover_test::draw_ui(app&, float)
         snformat(buf, "{}"_cf, pool.params().div_size);
         text(buf);
 
+        do_column("background");
+        const auto& st = filler.stats();
+        snformat(buf, "{} filled, {} dropped, {:.0f}/s, {} in flight"_cf,
+                 st.filled, st.dropped, st.octants_per_second, filler.in_flight());
+        text(buf);
+
         do_column("octant");
 
         constexpr auto fmt_octant_label = [](auto&& out, uint32_t kk) {
@@ -12,6 +12,10 @@
 #include "floormat/main.hpp"
 #include "floormat/draw-bounds.hpp"
 #include "src/critter.hpp"
+#include "src/sim-lod.hpp"
+#include "src/chunk-stream.hpp"
+#include "src/chunk-prefetch.hpp"
+#include "src/point.hpp"
 #include "src/nanosecond.hpp"
 #include "src/timer.hpp"
 #include "src/tile-constants.hpp"
@@ -213,32 +217,21 @@ void app::apply_commands(const key_set& keys)
 void app::update_world(Ns dt)
 {
     auto& world = M->world();
-    const auto frame_no = world.increment_frame_no();
     auto chunks = M->get_draw_bounds(_chunk_bounds_array, { -iTILE_SIZE2 * TILE_MAX_DIM, iTILE_SIZE2 * TILE_MAX_DIM, });
-    for (auto ch : chunks)
-    {
-            auto* const cʹ = world.at(ch);
-            if (!cʹ)
-                continue;
-            auto& c = *cʹ;
-            auto size = (uint32_t)c.objects().size();
-            for (auto i = 0u; i < size; i++)
-            {
-                auto index = size_t{i};
-                auto& e = *c.objects().data()[i].get();
-                if (e.last_frame_no == frame_no) [[unlikely]]
-                    continue;
-                e.last_frame_no = frame_no;
-                e.update(c.objects().data()[i], index, dt); // objects can't delete themselves during update()
-                if (&e.chunk() != cʹ || index > i) [[unlikely]]
-                {
-                    i--;
-                    size = (uint32_t)c.objects().size();
-                }
-            }
-    }
+    _sim_lod->update(world, chunks, dt);
+
+    // the middle of the screen follows do_camera(), and the player walks on its own
+    point tracked[2];
+    size_t tracked_count = 0;
+    tracked[tracked_count++] = M->pixel_to_point(Vector2d(M->window_size()) * .5, _z_level);
+    if (_character_id)
+        if (auto c = world.find_object<critter>(_character_id))
+            tracked[tracked_count++] = c->position();
+    _chunk_prefetcher->update(world, chunks, {tracked, tracked_count}, dt);
+    _chunk_streamer->update(world, chunks);
 
 #ifndef FM_NO_DEBUG
+    const auto frame_no = world.frame_no() - 1;
     for (auto ch : chunks)
     {
         auto* cʹ = world.at(ch);
@@ -250,7 +243,8 @@ void app::update_world(Ns dt)
         for (auto i = 0uz; i < size; i++)
         {
             auto& e = *es[i];
-            fm_assert(e.last_frame_no == frame_no);
+            // also woken up by an object updated after it, or created this frame
+            fm_assert(!e.awake || e.last_frame_no == frame_no || e.last_frame_no == 0);
         }
     }
 #endif
@@ -289,7 +283,7 @@ auto app::get_z_bounds() -> z_bounds
 void app::update(Ns dt)
 {
     auto& w = M->world();
-    w.collect(true);
+    w.collect();
     update_cursor_tile(cursor.pixel);
     tests_pre_update(dt);
     apply_commands(*keys_);
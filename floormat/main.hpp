@@ -62,6 +62,8 @@ struct floormat_main
 
     virtual ArrayView<const clickable> clickable_scenery() const noexcept = 0;
     virtual ArrayView<clickable> clickable_scenery() noexcept = 0;
+    // topmost clickable object drawn at `pixel` in the last frame
+    virtual clickable* clickable_at(Vector2i pixel) noexcept = 0;
     virtual void set_cursor(uint32_t cursor) noexcept = 0;
     virtual uint32_t cursor() const noexcept = 0;
 
@@ -83,6 +85,9 @@ struct floormat_main
 
     void set_render_vobjs(bool value);
     bool is_rendering_vobjs() const;
+    // ground and walls from per-chunk vertex buffers, see SpriteBatch::draw_static()
+    void set_static_chunk_buffers(bool value);
+    bool is_using_static_chunk_buffers() const;
 
     bool is_clipcontrol_zero_to_one_enabled() const noexcept;
 
@@ -98,6 +103,7 @@ protected:
     Vector2 _virtual_scale{ 1, 1 };
     Vector2i _framebuffer_size;
     bool _do_render_vobjs : 1 = true;
+    bool _do_static_chunk_buffers : 1 = true;
     bool _first_frame : 1 = true;
     bool _is_clipcontroL_zero_to_one_enabled = false;
 };
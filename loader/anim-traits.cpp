@@ -1,10 +1,12 @@
 #include "anim-traits.hpp"
+#include "atlas-cache.hpp"
 #include "atlas-loader-storage.hpp"
 #include "anim-cell.hpp"
 #include "src/anim-atlas.hpp"
 #include "src/tile-defs.hpp"
 #include "loader.hpp"
 #include "src/sprite-atlas.hpp"
+#include "src/sprite-atlas-cache.hpp"
 #include "src/sprite-constants.hpp"
 #include "serialize/json-helper.hpp"
 #include "serialize/anim.hpp"
@@ -13,12 +15,58 @@
 #include <cr/StridedArrayView.h>
 #include <cr/Optional.h>
 #include <cr/Path.h>
+#include <cstring>
 #include <mg/ImageData.h>
 #include <mg/ImageView.h>
 #include <mg/PixelStorage.h>
 
 namespace floormat::loader_detail {
 
+namespace {
+
+void copy_mirrored_sprites(anim_def& anim_info)
+{
+    for (anim_group& g : anim_info.groups)
+    {
+        if (g.mirror_from.isEmpty())
+            continue;
+        const auto* begin = anim_info.groups.data(), *end = begin + anim_info.groups.size();
+        const auto* src = std::find_if(begin, end, [&](const anim_group& x) { return x.name == g.mirror_from; });
+        fm_debug_assert(src != end);
+        g.sprites = Array<const SpriteAtlas::Sprite*>{ValueInit, g.frames.size()};
+        for (uint32_t fi = 0; fi < g.frames.size(); fi++)
+        {
+            const auto* s = src->sprites[fi];
+            if (!s) continue;
+            g.sprites[fi] = s;
+        }
+    }
+}
+
+bool use_baked_sprites(anim_def& anim_info, const sprite_atlas_cache::entry& e)
+{
+    size_t count = 0;
+    for (const anim_group& g : anim_info.groups)
+        if (g.mirror_from.isEmpty())
+            count += g.frames.size();
+    if (count != e.sprites.size())
+        return false;
+
+    size_t i = 0;
+    for (anim_group& g : anim_info.groups)
+    {
+        if (!g.mirror_from.isEmpty())
+            continue;
+        g.sprites = Array<const SpriteAtlas::Sprite*>{ValueInit, g.frames.size()};
+        for (uint32_t fi = 0; fi < g.frames.size(); fi++)
+            g.sprites[fi] = &e.sprites[i++];
+    }
+    copy_mirrored_sprites(anim_info);
+    return true;
+}
+
+} // namespace
+
 using anim_traits = atlas_loader_traits<anim_atlas>;
 StringView anim_traits::loader_name() { return "anim_atlas"_s; }
 auto anim_traits::atlas_of(const Cell& x) -> const bptr<Atlas>& { return x.atlas; }
@@ -109,6 +157,20 @@ auto anim_traits::make_atlas(StringView name, const Cell&) -> bptr<Atlas>
         }
     }
 
+    // skip decoding and packing if the baked atlas has this asset as-is
+    auto* cache = loader.atlas_cache();
+    const auto hash = cache ? atlas_cache_hash(json_path, {}, name) : Optional<uint64_t>{};
+    if (hash)
+        if (const auto* e = cache->find(name, *hash); e && use_baked_sprites(anim_info, *e))
+        {
+            auto bitmask = BitArray{NoInit, e->bitmask.size()};
+            if (!bitmask.isEmpty())
+                std::memcpy(bitmask.data(), e->bitmask.data(), (bitmask.size() + 7) / 8);
+            return bptr<class anim_atlas>{InPlace, name, move(bitmask), move(anim_info)};
+        }
+
+    // made on a worker thread by preload_atlases(), along with the image
+    auto bitmask = loader.take_preloaded_bitmask(""_s, name);
     auto tex = loader.texture(""_s, name);
 
     fm_soft_assert(!anim_info.object_name.isEmpty());
@@ -152,24 +214,25 @@ auto anim_traits::make_atlas(StringView name, const Cell&) -> bptr<Atlas>
             }
         }
 
-        for (anim_group& g : anim_info.groups)
-        {
+        copy_mirrored_sprites(anim_info);
+    }
+
+    auto atlas = [&] {
+        if (!bitmask)
+            return bptr<class anim_atlas>{InPlace, name, tex, move(anim_info)};
+        fm_soft_assert(size[2] >= 3 && size[2] <= 4);
+        return bptr<class anim_atlas>{InPlace, name, move(*bitmask), move(anim_info)};
+    }();
+
+    if (hash)
+    {
+        Array<const SpriteAtlas::Sprite*> sprites;
+        for (const anim_group& g : atlas->info().groups)
             if (g.mirror_from.isEmpty())
-                continue;
-            const auto* begin = anim_info.groups.data(), *end = begin + anim_info.groups.size();
-            const auto* src = std::find_if(begin, end, [&](const anim_group& x) { return x.name == g.mirror_from; });
-            fm_debug_assert(src != end);
-            g.sprites = Array<const SpriteAtlas::Sprite*>{ValueInit, g.frames.size()};
-            for (uint32_t fi = 0; fi < g.frames.size(); fi++)
-            {
-                const auto* s = src->sprites[fi];
-                if (!s) continue;
-                g.sprites[fi] = s;
-            }
-        }
+                arrayAppend(sprites, g.sprites);
+        cache->add(name, *hash, sprites, atlas->bitmask());
     }
 
-    auto atlas = bptr<class anim_atlas>{InPlace, name, tex, move(anim_info)};
     return atlas;
 }
 
@@ -0,0 +1,45 @@
+#include "atlas-cache.hpp"
+#include "loader.hpp"
+#include "src/sprite-atlas.hpp"
+#include "src/sprite-atlas-cache.hpp"
+#include <cr/GrowableArray.h>
+#include <cr/Path.h>
+
+namespace floormat::loader_detail {
+
+Optional<uint64_t> atlas_cache_hash(StringView json_path, StringView prefix, StringView name, ArrayView<const char> extra)
+{
+    Optional<Array<char>> json;
+    if (json_path)
+    {
+        json = Path::read(json_path);
+        if (!json)
+            return {};
+    }
+
+    // same order as loader_impl::texture()
+    char buf[fm_FILENAME_MAX];
+    for (auto extension : { ".tga"_s, ".png"_s, ".webp"_s, })
+    {
+        auto path = loader.make_atlas_path(buf, prefix, name, extension);
+        if (!Path::exists(path))
+            continue;
+        auto image = Path::read(path);
+        if (!image)
+            return {};
+        const ArrayView<const char> files[] = { json ? ArrayView<const char>{*json} : nullptr, *image, extra };
+        return sprite_atlas_cache::content_hash(files);
+    }
+    return {};
+}
+
+void add_to_atlas_cache(sprite_atlas_cache& cache, StringView key, uint64_t hash, ArrayView<const sprite> sprites)
+{
+    Array<const SpriteAtlas::Sprite*> array;
+    arrayReserve(array, sprites.size());
+    for (const auto& s : sprites)
+        arrayAppend(array, s.raw());
+    cache.add(key, hash, array, {});
+}
+
+} // namespace floormat::loader_detail
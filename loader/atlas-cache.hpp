@@ -0,0 +1,16 @@
+#pragma once
+#include <cr/Optional.h>
+
+namespace floormat { class sprite; class sprite_atlas_cache; }
+
+namespace floormat::loader_detail {
+
+// Key for sprite_atlas_cache: hashes `json_path` if it's not empty, the
+// image loader_::texture() would pick for `prefix` and `name`, and `extra`.
+// Returns {} if one of them can't be read.
+Optional<uint64_t> atlas_cache_hash(StringView json_path, StringView prefix, StringView name,
+                                    ArrayView<const char> extra = {});
+
+void add_to_atlas_cache(sprite_atlas_cache& cache, StringView key, uint64_t hash, ArrayView<const sprite> sprites);
+
+} // namespace floormat::loader_detail
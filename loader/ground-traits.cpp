@@ -1,9 +1,11 @@
 #include "ground-traits.hpp"
+#include "atlas-cache.hpp"
 #include "atlas-loader-storage.hpp"
 #include "ground-cell.hpp"
 #include "loader.hpp"
 #include "src/tile-defs.hpp"
 #include "src/ground-atlas.hpp"
+#include "src/sprite-atlas-cache.hpp"
 #include "compat/assert.hpp"
 #include <cr/Optional.h>
 #include <mg/ImageView.h>
@@ -37,8 +39,21 @@ auto ground_traits::make_invalid_atlas(Storage& s) -> Cell
 auto ground_traits::make_atlas(StringView name, const Cell& c) -> bptr<Atlas>
 {
     auto def = ground_def{name, c.size, c.pass};
+
+    char buf[fm_FILENAME_MAX];
+    const auto key = loader.make_atlas_path(buf, loader.GROUND_TILESET_PATH, name);
+    auto* cache = loader.atlas_cache();
+    const auto hash = cache
+        ? atlas_cache_hash({}, loader.GROUND_TILESET_PATH, name, {(const char*)&c.size, sizeof c.size})
+        : Optional<uint64_t>{};
+    if (hash)
+        if (const auto* e = cache->find(key, *hash); e && e->sprites.size() == Vector2ui{c.size}.product())
+            return bptr<Atlas>{InPlace, def, ArrayView<const SpriteAtlas::Sprite>{e->sprites}};
+
     auto tex = loader.texture(loader.GROUND_TILESET_PATH, name);
     auto atlas = bptr<Atlas>{InPlace, def, tex};
+    if (hash)
+        add_to_atlas_cache(*cache, key, *hash, atlas->raw_sprite_array());
     return atlas;
 }
 
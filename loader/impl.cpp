@@ -76,6 +76,42 @@ void loader_impl::destroy()
     vobj_atlas_map.clear();
     arrayClear(vobjs);
     _sprite_atlas.reset(); // free it while the GL context is still alive
+    _atlas_cache.clear();
+    _atlas_cache_loaded = false;
+    _preloaded_images.clear();
+    _preloaded_bitmasks.clear();
+}
+
+sprite_atlas& loader_impl::atlas() noexcept
+{
+    // the baked layers must go in before anything is packed live
+    (void)atlas_cache();
+    return _sprite_atlas;
+}
+
+void loader_impl::set_atlas_cache_path(StringView path)
+{
+    fm_assert(!_atlas_cache_loaded);
+    _atlas_cache_path = String{path};
+}
+
+sprite_atlas_cache* loader_impl::atlas_cache() noexcept
+{
+    if (!_atlas_cache_path)
+        return nullptr;
+    if (!_atlas_cache_loaded)
+    {
+        _atlas_cache_loaded = true;
+        (void)_atlas_cache.load(_atlas_cache_path, _sprite_atlas);
+    }
+    return &_atlas_cache;
+}
+
+bool loader_impl::save_atlas_cache()
+{
+    if (!_atlas_cache_path || !_atlas_cache.is_dirty())
+        return false;
+    return _atlas_cache.save(_atlas_cache_path, _sprite_atlas);
 }
 
 
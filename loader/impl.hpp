@@ -1,15 +1,18 @@
 #pragma once
 #include "loader/loader.hpp"
 #include "src/sprite-atlas.hpp"
+#include "src/sprite-atlas-cache.hpp"
 #include "compat/safe-ptr.hpp"
 #include "compat/borrowed-ptr-fwd.hpp"
 #include "atlas-loader-fwd.hpp"
 #include <gtl/phmap.hpp>
 #include <cr/Optional.h>
 #include <cr/Array.h>
+#include <cr/BitArray.h>
 #include <cr/StringStlHash.h>
 #include <cr/Resource.h>
 #include <mg/AbstractImporter.h>
+#include <mg/ImageData.h>
 
 namespace floormat::loader_detail {
 
@@ -40,11 +43,27 @@ struct loader_impl final : loader_
     Trade::ImageData2D make_error_texture(Vector2ui size) override;
     Trade::ImageData2D make_error_texture(Vector2ui size, Vector4ub color) override;
     Trade::ImageData2D texture(StringView prefix, StringView filename) noexcept(false) override;
+    // {} if there's no such file, safe to call from any thread with its own importers
+    static Optional<Trade::ImageData2D> open_texture(Trade::AbstractImporter& tga, Trade::AbstractImporter& image,
+                                                     StringView prefix, StringView filename) noexcept(false);
     Trade::ImageData2D image(StringView path) noexcept(false) override;
 
     // >-----> sprite atlas >----->
     sprite_atlas _sprite_atlas{};
-    sprite_atlas& atlas() noexcept override { return _sprite_atlas; }
+    sprite_atlas_cache _atlas_cache;
+    String _atlas_cache_path;
+    bool _atlas_cache_loaded = false;
+    sprite_atlas& atlas() noexcept override;
+    void set_atlas_cache_path(StringView path) override;
+    sprite_atlas_cache* atlas_cache() noexcept override;
+    bool save_atlas_cache() override;
+
+    // >-----> preload >----->
+    // keyed by make_atlas_path(prefix, filename), taken by texture()
+    gtl::flat_hash_map<String, Trade::ImageData2D> _preloaded_images;
+    gtl::flat_hash_map<String, BitArray> _preloaded_bitmasks;
+    void preload_atlases(uint32_t thread_count) override;
+    Optional<BitArray> take_preloaded_bitmask(StringView prefix, StringView filename) override;
 
     // >-----> ground >----->
     [[nodiscard]] static atlas_loader<class ground_atlas>* make_ground_atlas_loader();
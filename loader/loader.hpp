@@ -26,6 +26,7 @@ class wall_atlas;
 struct scenery_proto;
 struct json_wrapper;
 class sprite_atlas;
+class sprite_atlas_cache;
 
 struct loader_
 {
@@ -38,6 +39,17 @@ struct loader_
     virtual Trade::ImageData2D texture(StringView prefix, StringView filename) noexcept(false) = 0;
     virtual Trade::ImageData2D image(StringView path) noexcept(false) = 0;
     virtual sprite_atlas& atlas() noexcept = 0;
+    // Baked sprite atlas file, see src/sprite-atlas-cache.hpp. Set it before
+    // anything is added to the atlas; an empty path turns the cache off.
+    virtual void set_atlas_cache_path(StringView path) = 0;
+    virtual sprite_atlas_cache* atlas_cache() noexcept = 0;
+    // Writes the file if anything was packed live since it was loaded.
+    virtual bool save_atlas_cache() = 0;
+    // Builds every ground, wall and scenery atlas up front. The images get
+    // decoded, and the scenery bitmasks made, on `thread_count` worker
+    // threads with an importer each; packing stays on this thread and goes
+    // in list order, so the atlas doesn't depend on the thread count.
+    virtual void preload_atlases(uint32_t thread_count) = 0;
 
     virtual const bptr<class ground_atlas>& ground_atlas(StringView filename, loader_policy policy = loader_policy::DEFAULT) noexcept(false) = 0;
     virtual const bptr<class wall_atlas>& wall_atlas(StringView name, loader_policy policy = loader_policy::DEFAULT) noexcept(false) = 0;
@@ -69,6 +81,8 @@ struct loader_
     virtual bptr<class anim_atlas> get_anim_atlas(StringView path) noexcept(false) = 0;
     /** \deprecated{internal use only}*/ [[nodiscard]]
     virtual struct scenery_proto get_scenery(StringView filename, const scenery_cell& c) noexcept(false) = 0;
+    /** \deprecated{internal use only}*/ [[nodiscard]]
+    virtual Optional<BitArray> take_preloaded_bitmask(StringView prefix, StringView filename) = 0;
 
     virtual ~loader_() noexcept;
     fm_DISABLE_COPY(loader_);
@@ -0,0 +1,273 @@
+#include "impl.hpp"
+#include "atlas-cache.hpp"
+#include "ground-cell.hpp"
+#include "wall-cell.hpp"
+#include "scenery-cell.hpp"
+#include "src/anim-atlas.hpp"
+#include "src/sprite-atlas-cache.hpp"
+#include "serialize/corrade-string.hpp"
+#include "serialize/json-wrapper.hpp"
+#include "compat/assert.hpp"
+#include "compat/borrowed-ptr.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cr/GrowableArray.h>
+#include <cr/Optional.h>
+#include <cr/Pointer.h>
+#include <mg/ImageData.h>
+#include <mg/ImageView.h>
+
+namespace floormat::loader_detail {
+
+namespace {
+
+enum class preload_kind : uint8_t { ground, wall, anim, };
+
+struct preload_job
+{
+    // what the atlas getter takes, and what make_atlas() passes to texture()
+    String atlas, prefix, name;
+    // the same inputs as make_atlas() gives atlas_cache_hash()
+    String json_path;
+    Array<char> extra;
+    Optional<uint64_t> baked_hash;
+    preload_kind kind;
+
+    // written by whoever runs it, read by the main thread once it's done
+    Optional<Trade::ImageData2D> image;
+    BitArray bitmask;
+    bool done = false;
+};
+
+void run_job(preload_job& job, Trade::AbstractImporter& tga, Trade::AbstractImporter& image)
+{
+    try
+    {
+        // make_atlas() will take it from the baked atlas instead
+        if (job.baked_hash)
+            if (auto hash = atlas_cache_hash(job.json_path, job.prefix, job.name, job.extra); hash && *hash == *job.baked_hash)
+                return;
+        job.image = loader_impl::open_texture(tga, image, job.prefix, job.name);
+        if (job.image && job.kind == preload_kind::anim)
+            job.bitmask = anim_atlas::make_bitmask(*job.image);
+    }
+    catch (...)
+    {
+        // make_atlas() tries again on the main thread and reports it there
+        job.image = {};
+        job.bitmask = {};
+    }
+}
+
+struct preload_pool
+{
+    // shared with the workers
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    ArrayView<preload_job> jobs;
+    // jobs are handed out only up to `window` past the ones the main thread
+    // consumed, so decoded images don't pile up faster than it packs them
+    uint32_t next = 0, consumed = 0, window = 0;
+    bool quit = false;
+
+    // main thread only
+    Array<std::thread> threads;
+    Array<Pointer<Trade::AbstractImporter>> importers;
+
+    preload_pool(ArrayView<preload_job> jobs, uint32_t thread_count, PluginManager::Manager<Trade::AbstractImporter>& plugins);
+    ~preload_pool() noexcept;
+    fm_DISABLE_MOVE_COPY(preload_pool);
+
+    bool run_next(Trade::AbstractImporter& tga, Trade::AbstractImporter& image, bool block);
+    void wait(uint32_t i, Trade::AbstractImporter& tga, Trade::AbstractImporter& image);
+    void consume(uint32_t i);
+};
+
+preload_pool::preload_pool(ArrayView<preload_job> jobs, uint32_t thread_count,
+                           PluginManager::Manager<Trade::AbstractImporter>& plugins):
+    jobs{jobs}
+{
+    thread_count = std::min(thread_count, (uint32_t)jobs.size());
+    window = thread_count + 2;
+    // importers aren't thread-safe, each worker gets its own pair
+    for (auto i = 0u; i < thread_count; i++)
+    {
+        auto tga = plugins.instantiate("TgaImporter"_s);
+        auto image = plugins.instantiate("StbImageImporter"_s);
+        fm_assert(tga && image);
+        arrayAppend(importers, move(tga));
+        arrayAppend(importers, move(image));
+    }
+    for (auto i = 0u; i < thread_count; i++)
+        arrayAppend(threads, InPlaceInit, [this, i] {
+            while (run_next(*importers[i*2 + 0], *importers[i*2 + 1], true)) {}
+        });
+}
+
+preload_pool::~preload_pool() noexcept
+{
+    {
+        std::lock_guard lock{mutex};
+        quit = true;
+    }
+    done_cv.notify_all();
+    for (auto& t : threads)
+        t.join();
+}
+
+// with `block`, waits for the window to move instead of returning false
+bool preload_pool::run_next(Trade::AbstractImporter& tga, Trade::AbstractImporter& image, bool block)
+{
+    uint32_t i;
+    {
+        std::unique_lock lock{mutex};
+        const auto can_take = [&] { return quit || next >= jobs.size() || next < consumed + window; };
+        if (block)
+            done_cv.wait(lock, can_take);
+        else if (!can_take())
+            return false;
+        if (quit || next >= jobs.size())
+            return false;
+        i = next++;
+    }
+    run_job(jobs[i], tga, image);
+    {
+        std::lock_guard lock{mutex};
+        jobs[i].done = true;
+    }
+    done_cv.notify_all();
+    return true;
+}
+
+void preload_pool::wait(uint32_t i, Trade::AbstractImporter& tga, Trade::AbstractImporter& image)
+{
+    // jobs are handed out in order, so until job `i` is done the main thread
+    // may as well decode the next one itself
+    for (;;)
+    {
+        {
+            std::lock_guard lock{mutex};
+            if (jobs[i].done)
+                return;
+        }
+        if (!run_next(tga, image, false))
+            break;
+    }
+    std::unique_lock lock{mutex};
+    done_cv.wait(lock, [&] { return jobs[i].done; });
+}
+
+void preload_pool::consume(uint32_t i)
+{
+    {
+        std::lock_guard lock{mutex};
+        consumed = i + 1;
+    }
+    done_cv.notify_all();
+}
+
+bool has_job(ArrayView<const preload_job> jobs, preload_kind kind, StringView atlas)
+{
+    for (const auto& x : jobs)
+        if (x.kind == kind && x.atlas == atlas)
+            return true;
+    return false;
+}
+
+} // namespace
+
+void loader_impl::preload_atlases(uint32_t thread_count)
+{
+    ensure_plugins();
+
+    // the order the editor asks for them in
+    char buf[fm_FILENAME_MAX];
+    Array<preload_job> jobs;
+    for (const auto& c : ground_atlas_list())
+        if (c.name != INVALID && !c.atlas)
+            arrayAppend(jobs, preload_job {
+                .atlas = c.name,
+                .prefix = GROUND_TILESET_PATH,
+                .name = c.name,
+                .extra = array(ArrayView<const char>{(const char*)&c.size, sizeof c.size}),
+                .kind = preload_kind::ground,
+            });
+    for (const auto& c : wall_atlas_list())
+        if (c.name != INVALID && !c.atlas)
+        {
+            const auto file = make_atlas_path(buf, WALL_TILESET_PATH, c.name);
+            arrayAppend(jobs, preload_job {
+                .atlas = c.name,
+                .name = file,
+                .json_path = file + ".json"_s,
+                .kind = preload_kind::wall,
+            });
+        }
+    for (const auto& c : scenery_list())
+    {
+        if (c.name == INVALID || c.proto || !c.data->j.contains("atlas-name"))
+            continue;
+        StringView atlas_name = c.data->j.at("atlas-name");
+        if (atlas_name.isEmpty() || has_job(jobs, preload_kind::anim, atlas_name))
+            continue;
+        const auto name = make_atlas_path(buf, SCENERY_PATH, atlas_name);
+        arrayAppend(jobs, preload_job {
+            .atlas = atlas_name,
+            .name = name,
+            .json_path = name + ".json"_s,
+            .kind = preload_kind::anim,
+        });
+    }
+
+    // the workers mustn't look at the cache while make_atlas() adds to it
+    if (auto* cache = atlas_cache())
+        for (auto& job : jobs)
+            if (const auto* e = cache->find(make_atlas_path(buf, job.prefix, job.name)))
+                job.baked_hash = e->hash;
+
+    auto pool = preload_pool{jobs, thread_count, *importer_plugins};
+    for (auto i = 0u; i < jobs.size(); i++)
+    {
+        pool.wait(i, *tga_importer, *image_importer);
+        auto& job = jobs[i];
+        const auto key = String{make_atlas_path(buf, job.prefix, job.name)};
+        _preloaded_images.clear();
+        _preloaded_bitmasks.clear();
+        if (job.image)
+            _preloaded_images.emplace(key, move(*job.image));
+        if (!job.bitmask.isEmpty())
+            _preloaded_bitmasks.emplace(key, move(job.bitmask));
+        job.image = {};
+        pool.consume(i);
+
+        switch (job.kind)
+        {
+        case preload_kind::ground: (void)ground_atlas(job.atlas, loader_policy::DEFAULT); break;
+        case preload_kind::wall: (void)wall_atlas(job.atlas, loader_policy::DEFAULT); break;
+        case preload_kind::anim: (void)anim_atlas(job.atlas, SCENERY_PATH, loader_policy::DEFAULT); break;
+        }
+    }
+    _preloaded_images.clear();
+    _preloaded_bitmasks.clear();
+
+    for (const auto& c : scenery_list())
+        if (c.name != INVALID)
+            (void)scenery(c.name, loader_policy::DEFAULT);
+}
+
+Optional<BitArray> loader_impl::take_preloaded_bitmask(StringView prefix, StringView filename)
+{
+    if (_preloaded_bitmasks.empty())
+        return {};
+    char buf[fm_FILENAME_MAX];
+    auto it = _preloaded_bitmasks.find(String::nullTerminatedView(make_atlas_path(buf, prefix, filename)));
+    if (it == _preloaded_bitmasks.end())
+        return {};
+    auto ret = move(it->second);
+    _preloaded_bitmasks.erase(it);
+    return ret;
+}
+
+} // namespace floormat::loader_detail
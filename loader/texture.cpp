@@ -5,26 +5,20 @@
 #include "compat/exception.hpp"
 #include "compat/strerror.hpp"
 #include <cstring>
+#include <cr/Optional.h>
 #include <cr/Path.h>
 #include <mg/ImageData.h>
 
 namespace floormat::loader_detail {
 
-fm_noinline
-Trade::ImageData2D loader_impl::texture(StringView prefix, StringView filename_) noexcept(false)
+Optional<Trade::ImageData2D> loader_impl::open_texture(Trade::AbstractImporter& tga, Trade::AbstractImporter& image,
+                                                       StringView prefix, StringView filename) noexcept(false)
 {
-    ensure_plugins();
-
     constexpr size_t max_extension_length = 16;
-    const auto N = prefix.size();
-    if (N > 0) [[likely]]
-        fm_assert(prefix[N-1] == '/');
-    fm_soft_assert(filename_.size() + prefix.size() + max_extension_length + 1 < fm_FILENAME_MAX);
-    fm_soft_assert(check_atlas_name(filename_));
-    fm_soft_assert(tga_importer);
+    fm_soft_assert(filename.size() + prefix.size() + max_extension_length + 1 < fm_FILENAME_MAX);
 
     char buf[fm_FILENAME_MAX];
-    const auto path_no_ext = make_atlas_path(buf, prefix, filename_);
+    const auto path_no_ext = make_atlas_path(buf, prefix, filename);
     const auto len = path_no_ext.size();
 
     for (auto extension : { ".tga"_s, ".png"_s, ".webp"_s, })
@@ -34,21 +28,51 @@ Trade::ImageData2D loader_impl::texture(StringView prefix, StringView filename_)
         buf[len + extension.size()] = '\0';
         auto path = StringView{buf, len + extension.size(), StringViewFlag::NullTerminated};
         fm_debug_assert(path.size() < array_size(buf));
-        auto& importer = extension == ".tga"_s ? tga_importer : image_importer;
-        if (Path::exists(path) && importer->openFile(path))
+        auto& importer = extension == ".tga"_s ? tga : image;
+        if (Path::exists(path) && importer.openFile(path))
         {
-            auto img = importer->image2D(0);
+            auto img = importer.image2D(0);
             if (!img)
                 fm_abort("can't allocate image for '%s'", buf);
             auto ret = move(*img);
             return ret;
         }
     }
+    return {};
+}
+
+fm_noinline
+Trade::ImageData2D loader_impl::texture(StringView prefix, StringView filename_) noexcept(false)
+{
+    ensure_plugins();
+
+    const auto N = prefix.size();
+    if (N > 0) [[likely]]
+        fm_assert(prefix[N-1] == '/');
+    fm_soft_assert(check_atlas_name(filename_));
+    fm_soft_assert(tga_importer);
+
+    char buf[fm_FILENAME_MAX];
+    const auto path_no_ext = make_atlas_path(buf, prefix, filename_);
+
+    // decoded ahead of time by preload_atlases()
+    if (!_preloaded_images.empty())
+        if (auto it = _preloaded_images.find(String::nullTerminatedView(path_no_ext)); it != _preloaded_images.end())
+        {
+            auto ret = move(it->second);
+            _preloaded_images.erase(it);
+            return ret;
+        }
+
+    if (auto img = open_texture(*tga_importer, *image_importer, prefix, filename_))
+    {
+        auto ret = move(*img);
+        return ret;
+    }
 
     const auto path = Path::currentDirectory();
-    buf[len] = '\0';
     char errbuf[128];
-    fm_throw("can't open image '{}' (cwd '{}'): {}"_cf, buf, path ? StringView{*path} : "(null)"_s, get_error_string(errbuf));
+    fm_throw("can't open image '{}' (cwd '{}'): {}"_cf, path_no_ext, path ? StringView{*path} : "(null)"_s, get_error_string(errbuf));
 }
 
 } // namespace floormat::loader_detail
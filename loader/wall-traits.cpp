@@ -1,9 +1,11 @@
 #include "wall-traits.hpp"
+#include "atlas-cache.hpp"
 #include "atlas-loader-storage.hpp"
 #include "wall-cell.hpp"
 #include "loader.hpp"
 #include "src/tile-defs.hpp"
 #include "src/wall-atlas.hpp"
+#include "src/sprite-atlas-cache.hpp"
 #include "compat/array-size.hpp"
 #include "compat/exception.hpp"
 #include <cr/Optional.h>
@@ -55,8 +57,17 @@ auto wall_traits::make_atlas(StringView name, const Cell&) -> bptr<Atlas>
     auto def = wall_atlas_def::deserialize(json_name);
     fm_soft_assert(name == def.header.name);
     fm_soft_assert(!def.frames.isEmpty());
+
+    auto* cache = loader.atlas_cache();
+    const auto hash = cache ? atlas_cache_hash(json_name, {}, file) : Optional<uint64_t>{};
+    if (hash)
+        if (const auto* e = cache->find(file, *hash); e && e->sprites.size() == def.frames.size())
+            return bptr<class wall_atlas>(InPlace, move(def), file, ArrayView<const SpriteAtlas::Sprite>{e->sprites});
+
     auto tex = loader.texture(""_s, file);
     auto atlas = bptr<class wall_atlas>(InPlace, move(def), file, tex);
+    if (hash)
+        add_to_atlas_cache(*cache, file, *hash, atlas->raw_sprite_array());
     return atlas;
 }
 
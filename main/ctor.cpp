@@ -3,15 +3,19 @@
 #include "src/search-astar.hpp"
 #include "src/search.hpp"
 #include "src/chunk.hpp"
+#include "src/chunk-mesh-builder.hpp"
 #include <algorithm>
+#include <thread>
 #include <cr/GrowableArray.h>
+#include <mg/Functions.h>
 
 namespace floormat {
 
 main_impl::main_impl(floormat_app& app, fm_settings&& se, int& argc, char** argv) noexcept :
     Platform::Sdl2Application{Arguments{argc, argv},
                               make_conf(se), make_gl_conf(se)},
-    s{move(se)}, app{app}, _shader{_tuc}
+    s{move(se)}, app{app}, _shader{_tuc},
+    _mesh_builder{InPlaceInit, Math::clamp(std::thread::hardware_concurrency(), 1u, 8u) - 1}
 {
     if (s.vsync)
     {
@@ -24,13 +28,12 @@ main_impl::main_impl(floormat_app& app, fm_settings&& se, int& argc, char** argv
         (void)setSwapInterval(0);
     maybe_enable_clipcontrol_zero_to_one();
     set_fp_mask();
-    arrayReserve(_clickable_scenery, 128);
     timeline = Time::now();
 }
 
 class world& main_impl::reset_world(class world&& w) noexcept
 {
-    arrayResize(_clickable_scenery, 0);
+    _clickables.clear();
 
     for (auto& cʹ : _world.chunks())
         for (const auto& eʹ : cʹ.objects())
@@ -8,6 +8,7 @@
 #include "src/fps-counter.hpp"
 #include "shaders/shader.hpp"
 #include "src/chunk.hpp"
+#include "src/chunk-mesh-builder.hpp"
 #include <cr/GrowableArray.h>
 #include <cr/ArrayView.h>
 #include <mg/DefaultFramebuffer.h>
@@ -126,7 +127,6 @@ void main_impl::draw_world() noexcept
     const auto chunks  = get_draw_bounds(_chunk_bounds_array, {});
     const auto sz = window_size();
 
-    arrayResize(_clickable_scenery, 0);
 #ifdef FM_USE_DEPTH32
     framebuffer.fb.clearDepth(0);
 #else
@@ -137,6 +137,15 @@ void main_impl::draw_world() noexcept
     GL::Renderer::setDepthMask(true);
 
     bind();
+    _sprite_batch.begin_frame();
+    _clickables.begin_frame(clickable_index::screen_offset(_shader.camera_offset(), sz), sz, _do_render_vobjs);
+
+    // fill the meshes of every stale chunk up front, on all threads
+    arrayResize(_mesh_chunks, 0);
+    draw_world_0([&](chunk&, int16_t x, int16_t y, int8_t z) {
+        arrayAppend(_mesh_chunks, chunk_coords_{x, y, z});
+    }, chunks, sz);
+    _mesh_builder->build(_world, _mesh_chunks);
 
     // The tint uniform uploads once per SpriteBatch::draw, so dimming other
     // z-levels needs its own batch, drawn underneath the current level's.
@@ -161,17 +170,39 @@ void main_impl::draw_world() noexcept
         _sprite_batch.draw(_shader, do_sort);
     };
 
-    draw_batches([&](chunk& c, int16_t, int16_t, int8_t) {
-        c.ensure_ground_mesh(_sprite_batch);
-        c.ensure_wall_mesh(_sprite_batch);
-    }, false);  // depth-buffered opaque pass; no painter sort needed
+    if (_do_static_chunk_buffers)
+    {
+        // depth-buffered opaque pass straight from each chunk's own buffers,
+        // only chunks whose meshes got rebuilt upload anything.
+        const auto draw_static = [&](bool other_levels) {
+            _shader.set_tint({1, 1, 1, other_levels ? 0.75f : 1.f});
+            draw_world_0([&](chunk& c, int16_t, int16_t, int8_t z) {
+                if (z_bounds.only && (z != z_bounds.cur) != other_levels)
+                    return;
+                c.build_ground_mesh();
+                c.ensure_passability();
+                c.build_wall_mesh();
+                _sprite_batch.draw_static(_shader, c.ground_static_mesh, c.coord());
+                _sprite_batch.draw_static(_shader, c.wall_static_mesh, c.coord());
+            }, chunks, sz);
+        };
+        if (z_bounds.only)
+            draw_static(true);
+        draw_static(false);
+    }
+    else
+        draw_batches([&](chunk& c, int16_t, int16_t, int8_t) {
+            c.ensure_ground_mesh(_sprite_batch);
+            c.ensure_wall_mesh(_sprite_batch);
+        }, false);  // depth-buffered opaque pass; no painter sort needed
 
     GL::Renderer::setDepthMask(false);
 
     draw_batches([&](chunk& c, int16_t, int16_t, int8_t) {
         c.ensure_scenery_mesh(_sprite_batch, _do_render_vobjs);
-        c.add_clickables(_shader, sz, _clickable_scenery, _do_render_vobjs);
+        _clickables.add_chunk(c);
     }, true);
+    _clickables.end_frame();
 
     GL::Renderer::setDepthMask(true);
 
@@ -186,11 +217,16 @@ void main_impl::bind() noexcept
 
 ArrayView<const clickable> main_impl::clickable_scenery() const noexcept
 {
-    return { _clickable_scenery.data(), _clickable_scenery.size() };
+    return _clickables.items();
 }
 
 ArrayView<clickable> main_impl::clickable_scenery() noexcept
 {
-    return { _clickable_scenery.data(), _clickable_scenery.size() };
+    return _clickables.items();
+}
+
+clickable* main_impl::clickable_at(Vector2i pixel) noexcept
+{
+    return _clickables.pick(pixel);
 }
 } // namespace floormat
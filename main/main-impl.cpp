@@ -1,6 +1,7 @@
 #include "main-impl.hpp"
 #include "src/search.hpp"
 #include "src/search-astar.hpp"
+#include "src/chunk-mesh-builder.hpp"
 #include "src/renderer.hpp"
 #include <mg/Renderer.h>
 #include <mg/Extensions.h>
@@ -78,5 +79,7 @@ void main_impl::reset_fps() noexcept { _frame_timings.fps_counter.reset(); }
 void floormat_main::set_render_vobjs(bool value) { _do_render_vobjs = value; }
 bool floormat_main::is_clipcontrol_zero_to_one_enabled() const noexcept { return _is_clipcontroL_zero_to_one_enabled; }
 bool floormat_main::is_rendering_vobjs() const { return _do_render_vobjs; }
+void floormat_main::set_static_chunk_buffers(bool value) { _do_static_chunk_buffers = value; }
+bool floormat_main::is_using_static_chunk_buffers() const { return _do_static_chunk_buffers; }
 
 } // namespace floormat
@@ -9,7 +9,7 @@
 #include "shaders/texture-unit-cache.hpp"
 #include "shaders/shader.hpp"
 #include "shaders/lightmap.hpp"
-#include "main/clickable.hpp"
+#include "src/clickable-index.hpp"
 #include <concepts>
 #include <mg/DebugOutput.h>
 #include <mg/Sdl2Application.h>
@@ -29,6 +29,7 @@ struct scenery;
 class anim_atlas;
 struct clickable;
 class astar;
+class chunk_mesh_builder;
 
 struct main_impl final : private Platform::Sdl2Application, public floormat_main
 {
@@ -70,6 +71,7 @@ struct main_impl final : private Platform::Sdl2Application, public floormat_main
 
     ArrayView<const clickable> clickable_scenery() const noexcept override;
     ArrayView<clickable> clickable_scenery() noexcept override;
+    clickable* clickable_at(Vector2i pixel) noexcept override;
 
     Platform::Sdl2Application& application() noexcept override;
     const Platform::Sdl2Application& application() const noexcept override;
@@ -134,7 +136,7 @@ private:
     struct texture_unit_cache _tuc;
     tile_shader _shader;
     struct lightmap_shader _lightmap_shader{_tuc};
-    Array<clickable> _clickable_scenery;
+    clickable_index _clickables;
     class world _world{};
     uint32_t _mouse_cursor = (uint32_t)-1;
     SpriteBatch _sprite_batch;
@@ -142,6 +144,8 @@ private:
     Framebuffer framebuffer;
 #endif
     safe_ptr<class astar> _astar;
+    safe_ptr<chunk_mesh_builder> _mesh_builder;
+    Array<chunk_coords_> _mesh_chunks;
     Vector2 _dpi_scale = Vector2{1};
 
     void recalc_viewport(Vector2i fb_size, Vector2i win_size) noexcept;
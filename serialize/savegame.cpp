@@ -30,6 +30,7 @@
 #include <cstdio>
 #include <vector>
 #include <algorithm>
+#include <cr/GrowableArray.h>
 #include <cr/Path.h>
 #include <gtl/phmap.hpp>
 
@@ -730,10 +731,6 @@ ok:     void();
 
     void serialize_world()
     {
-        fm_assert(string_array.empty());
-        fm_assert(header_buf.empty());
-        fm_assert(string_buf.empty());
-        fm_assert(atlas_array.empty());
         fm_assert(chunk_array.empty());
 
         for (auto& c : non_const(w).chunks())
@@ -744,6 +741,23 @@ ok:     void();
             return std::tuple{a.z, a.y, a.x} <=> std::tuple{b.z, b.y, b.x} == std::strong_ordering::less;
         });
 
+        serialize_chunks_();
+    }
+
+    void serialize_chunk_record(chunk& c)
+    {
+        fm_assert(chunk_array.empty());
+        chunk_array.push_back({.c = &c });
+        serialize_chunks_();
+    }
+
+    void serialize_chunks_()
+    {
+        fm_assert(string_array.empty());
+        fm_assert(header_buf.empty());
+        fm_assert(string_buf.empty());
+        fm_assert(atlas_array.empty());
+
         for (uint32_t i = 0; auto& [coord, c] : chunk_array)
             serialize_chunk_(*c, chunk_array[i++].buf);
 
@@ -761,6 +775,22 @@ ok:     void();
 
         serialize_strings_();
     }
+
+    template<typename F> void write_buffers(F&& write) const
+    {
+        write(header_buf);
+        write(string_buf);
+        for (const auto& x : atlas_array)
+        {
+            fm_assert(!x.buf.empty());
+            write(x.buf);
+        }
+        for (const auto& x : chunk_array)
+        {
+            fm_assert(!x.buf.empty());
+            write(x.buf);
+        }
+    }
 };
 
 template struct visitor_<writer, true, true>;
@@ -780,6 +810,7 @@ void my_fwrite(FILE_raii& f, const buffer& buf, char(&errbuf)[128])
 
 void world::serialize(StringView filename)
 {
+    page_in_all();
     collect(true);
     char errbuf[128];
     fm_assert(filename.flags() & StringViewFlag::NullTerminated);
@@ -813,18 +844,7 @@ void world::serialize(StringView filename)
             fm_assert(!writer.atlas_map.empty());
             fm_assert(!writer.chunk_array.empty());
         }
-        write(writer.header_buf);
-        write(writer.string_buf);
-        for (const auto& x : writer.atlas_array)
-        {
-            fm_assert(!x.buf.empty());
-            write(x.buf);
-        }
-        for (const auto& x : writer.chunk_array)
-        {
-            fm_assert(!x.buf.empty());
-            write(x.buf);
-        }
+        writer.write_buffers(write);
         {
             struct crc_buf {
                 char buf[sizeof crc_state];
@@ -845,6 +865,26 @@ void world::serialize(StringView filename)
     }
 }
 
+Array<char> world::serialize_chunk(chunk& c)
+{
+    struct writer writer{*this};
+    writer.serialize_chunk_record(c);
+
+    Array<char> ret;
+    uint64_t crc_state = Hash::CRC64_INITIALIZER;
+    writer.write_buffers([&](const buffer& buf) {
+        if (buf.empty())
+            return;
+        crc_state = Hash::crc64_update(crc_state, buf.data.data(), buf.size);
+        arrayAppend(ret, ArrayView<const char>{buf});
+    });
+    struct crc_buf {
+        char buf[sizeof crc_state];
+    } crc = std::bit_cast<crc_buf>(maybe_byteswap(crc_state));
+    arrayAppend(ret, ArrayView<const char>{crc.buf});
+    return ret;
+}
+
 namespace {
 
 template<atlas_type Type> struct atlas_from_type;
@@ -1148,7 +1188,7 @@ ok:
         fm_soft_assert(count == c.objects().size());
     }
 
-    void deserialize_chunk_(binary_reader<const char*>& s)
+    chunk& deserialize_chunk_(binary_reader<const char*>& s)
     {
         auto r = byte_reader{s};
 
@@ -1195,6 +1235,7 @@ ok:
             }, i, r);
 
         deserialize_objects_(c, r);
+        return c;
     }
 
     void deserialize_world(binary_reader<const char*>& s, ArrayView<const char> buf, proto_t proto)
@@ -1204,13 +1245,27 @@ ok:
         deserialize_strings_(s);
         deserialize_atlases(s);
         for (uint32_t i = 0; i < nchunks; i++)
-            deserialize_chunk_(s);
+            (void)deserialize_chunk_(s);
         fm_soft_assert(object_counter);
         w.set_object_counter(object_counter);
         if (PROTO >= 26)
             (void)s.read<sizeof Hash::CRC64_INITIALIZER>();
         s.assert_end();
     }
+
+    chunk& deserialize_chunk_record(binary_reader<const char*>& s, ArrayView<const char> buf, proto_t proto)
+    {
+        fm_soft_assert(!deserialize_header_(s, buf, proto));
+        fm_soft_assert(nchunks == 1);
+        deserialize_strings_(s);
+        deserialize_atlases(s);
+        auto& c = deserialize_chunk_(s);
+        // the world's counter can only have grown since the record was written
+        fm_soft_assert(object_counter <= w.object_counter());
+        (void)s.read<sizeof Hash::CRC64_INITIALIZER>();
+        s.assert_end();
+        return c;
+    }
 };
 
 template struct visitor_<reader<true>, false, true>;
@@ -1282,6 +1337,16 @@ class world world::deserialize(StringView filename, loader_policy asset_policy)
     return w;
 }
 
+chunk& world::deserialize_chunk(ArrayView<const char> record, loader_policy asset_policy) noexcept(false)
+{
+    auto s = binary_reader<const char*>{record.begin(), record.end()};
+    auto proto = reader<false>::deserialize_header_1(s);
+    // records don't outlive the process, so they're always the newest version
+    fm_soft_assert(proto == proto_version);
+    struct reader<true> r{*this, asset_policy};
+    return r.deserialize_chunk_record(s, record, proto);
+}
+
 } // namespace floormat
 
 /*
@@ -1,12 +1,8 @@
 #include "shaders/lightmap.hpp"
 #include "compat/assert.hpp"
 #include "src/tile-defs.hpp"
-#include "src/chunk.hpp"
-#include "src/tile-bbox.hpp"
-#include "src/ground-atlas.hpp"
-#include "src/wall-atlas.hpp"
+#include "src/tile-constants.hpp"
 #include "src/quads-gl.hpp"
-#include "src/object.hpp"
 #include "loader/loader.hpp"
 #include <utility>
 #include <cr/StructuredBindings.h>
@@ -26,7 +22,6 @@ namespace floormat {
 namespace {
 
 constexpr auto neighbor_count = 4;
-constexpr float shadow_wall_depth = 8;
 constexpr float real_image_size = 1024;
 
 constexpr auto half_neighbors = (int)Math::ceil(neighbor_count/2.f);
@@ -228,26 +223,25 @@ lightmap_shader::lightmap_shader(texture_unit_cache& tuc) : tuc{tuc}
 
 void lightmap_shader::add_light(Vector2 neighbor_offset, const light_s& light)
 {
-    neighbor_offset += Vector2((float)half_neighbors);
+    draw_light(neighbor_offset, light, 0, (uint32_t)count);
+}
 
-    constexpr auto tile_size = TILE_SIZE2.sum()/2;
-    float range = 0;
+void lightmap_shader::add_lights(const light_index& index)
+{
+    begin_occlusion();
+    for (const auto& s : index.segments())
+        add_segment(Vector2(half_neighbors), s.a, s.b);
+    end_occlusion();
 
-    fm_assert(light.falloff < light_falloff::COUNT);
-    switch (light.falloff)
-    {
-    case light_falloff::COUNT: std::unreachable();
-    case light_falloff::constant:
-        range = TILE_MAX_DIM;
-        break;
-    case light_falloff::linear:
-    case light_falloff::quadratic:
-        range = light.dist;
-        break;
-    }
+    for (const auto& x : index.lights())
+        draw_light({}, x.light, x.first, x.count);
+}
 
-    range *= tile_size;
-    range = std::fmax(0.f, range);
+void lightmap_shader::draw_light(Vector2 neighbor_offset, const light_s& light, uint32_t first, uint32_t count)
+{
+    fm_debug_assert(first + count <= this->count);
+    neighbor_offset += Vector2((float)half_neighbors);
+    const auto range = light_range(light);
 
     auto center_fragcoord = light.center + neighbor_offset * chunk_size + chunk_offset;
     auto center_clip = clip_start + center_fragcoord * clip_scale;
@@ -282,7 +276,8 @@ void lightmap_shader::add_light(Vector2 neighbor_offset, const light_s& light)
     setUniform(ModeUniform, DrawShadowsMode);
     fm_assert(occlusion_mesh.id());
     auto mesh_view = GL::MeshView{occlusion_mesh};
-    mesh_view.setCount((int32_t)(count * Quads::indexes_per_quad));
+    mesh_view.setIndexOffset((int32_t)(first * Quads::indexes_per_quad))
+             .setCount((int32_t)(count * Quads::indexes_per_quad));
     AbstractShaderProgram::draw(mesh_view);
 
     // --- Pass 2: compute light * (1 - shadow), accumulate to attachment 1 ---
@@ -327,6 +322,12 @@ int lightmap_shader::iter_bounds()
     return half_neighbors;
 }
 
+Math::Range2D<float> lightmap_shader::bounds()
+{
+    const auto min = -Vector2((float)half_neighbors) * chunk_size - chunk_offset;
+    return { min, min + image_size };
+}
+
 void lightmap_shader::add_segment(Vector2 neighbor_offset, Vector2 endpoint_a, Vector2 endpoint_b)
 {
     auto off = neighbor_offset*chunk_size + chunk_offset;
@@ -348,75 +349,6 @@ void lightmap_shader::add_segment(Vector2 neighbor_offset, Vector2 endpoint_a, V
     verts[3] = { seg, Vector2{1, 1} };  // endpoint B, near
 }
 
-void lightmap_shader::add_chunk(Vector2 neighbor_offset, chunk& c)
-{
-    neighbor_offset += Vector2(half_neighbors);
-
-    add_geometry(neighbor_offset, c);
-    add_objects(neighbor_offset, c);
-}
-
-void lightmap_shader::add_geometry(Vector2 neighbor_offset, chunk& c)
-{
-    for (auto i = 0uz; i < TILE_COUNT; i++)
-    {
-        auto t = c[i];
-        if (auto atlas = t.ground_atlas())
-            if (atlas->pass_mode() == pass_mode::blocked)
-            {
-                auto [min, max] = whole_tile(i);
-                // 4 edges: N, E, S, W
-                add_segment(neighbor_offset, {min.x(), max.y()}, {max.x(), max.y()}); // north edge
-                add_segment(neighbor_offset, {max.x(), max.y()}, {max.x(), min.y()}); // east edge
-                add_segment(neighbor_offset, {max.x(), min.y()}, {min.x(), min.y()}); // south edge
-                add_segment(neighbor_offset, {min.x(), min.y()}, {min.x(), max.y()}); // west edge
-            }
-        if (auto atlas = t.wall_north_atlas())
-            if (atlas->info().passability == pass_mode::blocked)
-            {
-                auto start = tile_start(i);
-                auto min = start - Vector2(0, shadow_wall_depth),
-                     max = start + Vector2(TILE_SIZE2[0], 0);
-                add_segment(neighbor_offset, {min.x(), max.y()}, {max.x(), max.y()}); // north edge
-                add_segment(neighbor_offset, {max.x(), max.y()}, {max.x(), min.y()}); // east edge
-                add_segment(neighbor_offset, {max.x(), min.y()}, {min.x(), min.y()}); // south edge
-                add_segment(neighbor_offset, {min.x(), min.y()}, {min.x(), max.y()}); // west edge
-            }
-        if (auto atlas = t.wall_west_atlas())
-            if (atlas->info().passability == pass_mode::blocked)
-            {
-                auto start = tile_start(i);
-                auto min = start - Vector2(shadow_wall_depth, 0),
-                     max = start + Vector2(0, TILE_SIZE[1]);
-                add_segment(neighbor_offset, {min.x(), max.y()}, {max.x(), max.y()}); // north edge
-                add_segment(neighbor_offset, {max.x(), max.y()}, {max.x(), min.y()}); // east edge
-                add_segment(neighbor_offset, {max.x(), min.y()}, {min.x(), min.y()}); // south edge
-                add_segment(neighbor_offset, {min.x(), min.y()}, {min.x(), max.y()}); // west edge
-            }
-    }
-}
-
-void lightmap_shader::add_objects(Vector2 neighbor_offset, chunk& c)
-{
-    for (const auto& eʹ : c.objects())
-    {
-        const auto& e = *eʹ;
-        if (e.is_virtual())
-            continue;
-        if (e.pass == pass_mode::pass || e.pass == pass_mode::see_through)
-            continue;
-        auto center = Vector2(e.offset) + Vector2(e.bbox_offset) +
-                      Vector2(e.coord.local()) * TILE_SIZE2;
-        auto half = Vector2(e.bbox_size)*.5f;
-        auto min = center - half, max = center + half;
-
-        add_segment(neighbor_offset, {min.x(), max.y()}, {max.x(), max.y()}); // north
-        add_segment(neighbor_offset, {max.x(), max.y()}, {max.x(), min.y()}); // east
-        add_segment(neighbor_offset, {max.x(), min.y()}, {min.x(), min.y()}); // south
-        add_segment(neighbor_offset, {min.x(), min.y()}, {min.x(), max.y()}); // west
-    }
-}
-
 void lightmap_shader::setUniform(Uniform u, auto value)
 {
     fm_assert(u < UNIFORM_COUNT);
@@ -424,8 +356,6 @@ void lightmap_shader::setUniform(Uniform u, auto value)
     AbstractShaderProgram::setUniform(loc, value);
 }
 
-bool light_s::operator==(const light_s&) const noexcept = default;
-
 lightmap_shader::~lightmap_shader() = default;
 
 } // namespace floormat
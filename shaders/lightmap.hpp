@@ -1,6 +1,6 @@
 #pragma once
 
-#include "src/light-falloff.hpp"
+#include "src/light-index.hpp"
 #include "src/quads.hpp"
 #include "shaders/texture-unit-cache.hpp"
 #include <array>
@@ -16,19 +16,6 @@ namespace floormat {
 
 struct texture_unit_cache;
 
-struct light_s final
-{
-    Vector2 center;
-    float dist = 1;
-    float radius = 0;
-    Vector4ub color;
-    light_falloff falloff = light_falloff::linear;
-
-    bool operator==(const light_s&) const noexcept;
-};
-
-class chunk;
-
 struct lightmap_shader final : GL::AbstractShaderProgram
 {
     explicit lightmap_shader(texture_unit_cache& tuc);
@@ -46,11 +33,15 @@ struct lightmap_shader final : GL::AbstractShaderProgram
 
     void begin_occlusion();
     void end_occlusion();
-    void add_chunk(Vector2 neighbor_offset, chunk& c);
     void add_light(Vector2 neighbor_offset, const light_s& light);
+    // uploads the segments of a built light_index and draws each of its
+    // lights with only its own; call bind() first and finish() after
+    void add_lights(const light_index& index);
     void bind();
     void finish();
     static int iter_bounds();
+    // what the lightmap covers, in light_index coordinates
+    static Math::Range2D<float> bounds();
 
     GL::Texture2D& accum_texture();
 
@@ -90,9 +81,8 @@ private:
     static Framebuffer make_framebuffer(Vector2i size);
     GL::Mesh make_occlusion_mesh();
 
-    void add_objects(Vector2 neighbor_offset, chunk& c);
-    void add_geometry(Vector2 neighbor_offset, chunk& c);
     void add_segment(Vector2 neighbor_offset, Vector2 endpoint_a, Vector2 endpoint_b);
+    void draw_light(Vector2 neighbor_offset, const light_s& light, uint32_t first, uint32_t count);
     [[nodiscard]] std::array<shadow_vertex, 4>& alloc_quad();
 
     texture_unit_cache& tuc; // NOLINT(*-avoid-const-or-ref-data-members)
@@ -12,10 +12,12 @@ struct local_coords;
 
 struct tile_shader final : private GL::AbstractShaderProgram
 {
-    using Position           = GL::Attribute<0, Vector3>;
-    using TextureCoordinates = GL::Attribute<1, Vector3>;
+    // see Quads::vertex
+    using Position           = GL::Attribute<0, Vector2>;
+    using TextureCoordinates = GL::Attribute<1, Vector2>;
     using LightCoord         = GL::Attribute<2, Vector2>;
     using Depth              = GL::Attribute<3, float>;
+    using Layer              = GL::Attribute<4, float>;
 
     explicit tile_shader(texture_unit_cache& tuc);
     ~tile_shader() override;
@@ -68,6 +70,7 @@ private:
         "texcoords"_s,
         "light_coord"_s,
         "depth"_s,
+        "layer"_s,
     };
 
     texture_unit_cache& tuc; // NOLINT(*-avoid-const-or-ref-data-members)
@@ -3,18 +3,20 @@ precision highp float;
 uniform vec2 scale;
 uniform vec2 offset;
 
-in vec4 position;
-in vec3 texcoords;
+// projected already, in 1/Quads::position_scale pixels
+in vec2 position;
+in vec2 texcoords;
 in vec2 light_coord;
 in float depth;
+in float layer;
 
 noperspective out vec3 frag_texcoords;
 noperspective out vec2 frag_light_coord;
 
 void main() {
-    const float factor = 0.5;
-    float x = -position.y, y = -position.x, z = position.z;
-    gl_Position = vec4((x-y+offset.x)*scale.x, ((x+y+z*2)*factor-offset.y)*scale.y, depth, 1);
-    frag_texcoords = texcoords;
+    const float position_scale = 4.0;
+    vec2 pos = position / position_scale + offset;
+    gl_Position = vec4(pos.x*scale.x, -pos.y*scale.y, depth, 1);
+    frag_texcoords = vec3(texcoords, layer);
     frag_light_coord = light_coord;
 }
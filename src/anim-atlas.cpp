@@ -44,14 +44,18 @@ decltype(anim_atlas::_group_indices) anim_atlas::make_group_indices(const anim_d
 
 anim_atlas::anim_atlas() noexcept = default;
 anim_atlas::anim_atlas(String name, const ImageView2D& image, anim_def info) :
-    _name{move(name)}, _bitmask{make_bitmask(image)},
-    _info{move(info)}, _group_indices{make_group_indices(_info)}
+    anim_atlas{move(name), make_bitmask(image), move(info)}
 {
-    fm_soft_assert(!_info.groups.isEmpty());
-
     const Size<3> size = image.pixels().size();
     fm_soft_assert(size[0]*size[1] == _info.pixel_size.product());
     fm_soft_assert(size[2] >= 3 && size[2] <= 4);
+}
+
+anim_atlas::anim_atlas(String name, BitArray bitmask, anim_def info) :
+    _name{move(name)}, _bitmask{move(bitmask)},
+    _info{move(info)}, _group_indices{make_group_indices(_info)}
+{
+    fm_soft_assert(!_info.groups.isEmpty());
 
     for (const auto pixel_size = _info.pixel_size;
          const auto& group : _info.groups)
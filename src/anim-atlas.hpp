@@ -11,6 +11,9 @@
 
 namespace floormat {
 
+// implementations of anim_atlas::make_bitmask_(), see src/bitmask.cpp
+enum class bitmask_kernel : uint8_t { scalar, sse2, avx2, neon, COUNT, };
+
 class anim_atlas final : public bptr_base
 {
     using texcoords = Quads::texcoords;
@@ -30,6 +33,8 @@ public:
 
     anim_atlas() noexcept;
     anim_atlas(String name, const ImageView2D& tex, anim_def info);
+    // for sprites that were already packed, e.g. from sprite_atlas_cache
+    anim_atlas(String name, BitArray bitmask, anim_def info);
     ~anim_atlas() noexcept override;
 
     anim_atlas(anim_atlas&&) noexcept;
@@ -52,7 +57,12 @@ public:
     fm_DISABLE_COPY(anim_atlas);
 
     static void make_bitmask_(const ImageView2D& tex, BitArray& array);
+    static void make_bitmask_(const ImageView2D& tex, BitArray& array, bitmask_kernel kernel);
     static BitArray make_bitmask(const ImageView2D& tex);
+    // whether it was built in and the CPU has it
+    static bool has_bitmask_kernel(bitmask_kernel kernel);
+    // what make_bitmask_() uses, picked once at runtime
+    static bitmask_kernel best_bitmask_kernel();
 };
 
 } // namespace floormat
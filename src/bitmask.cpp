@@ -1,20 +1,38 @@
 #include "compat/exception.hpp"
+#include "compat/arch.hpp"
+#include "compat/cpu-features.hpp"
 #include "anim-atlas.hpp"
 #include <cstring>
 #include <cr/BitArray.h>
 #include <cr/StridedArrayView.h>
 #include <mg/ImageView.h>
 
+#if defined __x86_64__ || (defined __i386__ && defined __SSE2__)
+#   define FM_BITMASK_X86
+#   include <immintrin.h>
+#   if defined _MSC_VER && !defined __clang__
+#       define FM_BITMASK_AVX2_TARGET
+#   else
+#       define FM_BITMASK_AVX2_TARGET [[gnu::target("avx2")]]
+#   endif
+#elif defined __aarch64__ || defined _M_ARM64
+#   define FM_BITMASK_NEON
+#   include <arm_neon.h>
+#endif
+
 namespace floormat {
 
 constexpr uint8_t amin = 32;
 
-#if 1
 using u8 = uint8_t;
 using u32 = uint32_t;
+using u64 = uint64_t;
 
 namespace {
 
+// Bit (H - j - 1)*W + i is pixel (i, j): rows are flipped and packed
+// back-to-back, so a row's bits don't start on a byte boundary.
+
 template<u32 Count>
 CORRADE_ALWAYS_INLINE
 void bm_loop(const u8* __restrict src, u8* __restrict dest, u32 W, u32 H, u32 S, u32 i, u32 j)
@@ -49,23 +67,8 @@ void bm_loop_body(const u8* __restrict src, u8* __restrict dest, u32 width, u32
     }
 }
 
-} // namespace
-
-void anim_atlas::make_bitmask_(const ImageView2D& tex, BitArray& bitmask)
+void bm_scalar(const u8* __restrict src, u8* __restrict dest, u32 width, u32 height, u32 stride)
 {
-    const auto pixels = tex.pixels();
-    fm_soft_assert(tex.pixelSize() == 4);
-
-    const auto* src   = (const u8*)pixels.data();
-    auto* const dest  = (u8*)bitmask.data();
-    const auto stride = (u32)pixels.stride()[0];
-    const auto size   = pixels.size();
-    const auto width  = (u32)size[1];
-    const auto height = (u32)size[0];
-
-    fm_debug_assert(bitmask.size() % 8 == 0);
-    std::memset(bitmask.data(), 0, bitmask.size()/8);
-
     switch (width & 7)
     {
     default: std::unreachable();
@@ -79,22 +82,174 @@ void anim_atlas::make_bitmask_(const ImageView2D& tex, BitArray& bitmask)
     case 0: bm_loop_body<0>(src, dest, width, height, stride); break;
     }
 }
-#else
+
+// ORs the low `count` <= 32 bits of `bits` in at bit `bit`, dest is zeroed
+CORRADE_ALWAYS_INLINE
+void put_bits(u8* __restrict dest, u32 bit, u32 bits, u32 count)
+{
+    auto* const p = dest + (bit >> 3);
+    const auto x = (u64)bits << (bit & 7);
+    const auto nbytes = ((bit & 7) + count + 7) >> 3;
+    for (auto b = 0u; b < nbytes; b++)
+        p[b] |= (u8)(x >> b*8);
+}
+
+// the row's last few pixels, fewer than a vector's worth
+CORRADE_ALWAYS_INLINE
+void put_tail(const u8* __restrict row, u8* __restrict dest, u32 bit, u32 count)
+{
+    u32 bits = 0;
+    for (auto k = 0u; k < count; k++)
+        bits |= u32{row[k*4 + 3] >= amin} << k;
+    put_bits(dest, bit, bits, count);
+}
+
+#ifdef FM_BITMASK_X86
+
+// 16 pixels of RGBA8, alpha is the top byte of each little-endian dword
+void bm_sse2(const u8* __restrict src, u8* __restrict dest, u32 width, u32 height, u32 stride)
+{
+    const auto min = _mm_set1_epi8((char)amin);
+    for (auto j = 0u; j < height; j++)
+    {
+        const auto* row = src + (size_t)j * stride;
+        const auto bit = (height - j - 1)*width;
+        auto i = 0u;
+        for (; i + 16 <= width; i += 16)
+        {
+            const auto* p = (const __m128i*)(row + i*4);
+            const auto a0 = _mm_srli_epi32(_mm_loadu_si128(p + 0), 24);
+            const auto a1 = _mm_srli_epi32(_mm_loadu_si128(p + 1), 24);
+            const auto a2 = _mm_srli_epi32(_mm_loadu_si128(p + 2), 24);
+            const auto a3 = _mm_srli_epi32(_mm_loadu_si128(p + 3), 24);
+            const auto a = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+            // no unsigned compare in SSE2, max(a, min) == a is a >= min
+            const auto ge = _mm_cmpeq_epi8(_mm_max_epu8(a, min), a);
+            put_bits(dest, bit + i, (u32)_mm_movemask_epi8(ge), 16);
+        }
+        if (i < width)
+            put_tail(row + i*4, dest, bit + i, width - i);
+    }
+}
+
+// 32 pixels, same as above
+FM_BITMASK_AVX2_TARGET
+void bm_avx2(const u8* __restrict src, u8* __restrict dest, u32 width, u32 height, u32 stride)
+{
+    const auto min = _mm256_set1_epi8((char)amin);
+    // the packs work within each 128-bit half, this puts the pixels back in order
+    const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (auto j = 0u; j < height; j++)
+    {
+        const auto* row = src + (size_t)j * stride;
+        const auto bit = (height - j - 1)*width;
+        auto i = 0u;
+        for (; i + 32 <= width; i += 32)
+        {
+            const auto* p = (const __m256i*)(row + i*4);
+            const auto a0 = _mm256_srli_epi32(_mm256_loadu_si256(p + 0), 24);
+            const auto a1 = _mm256_srli_epi32(_mm256_loadu_si256(p + 1), 24);
+            const auto a2 = _mm256_srli_epi32(_mm256_loadu_si256(p + 2), 24);
+            const auto a3 = _mm256_srli_epi32(_mm256_loadu_si256(p + 3), 24);
+            const auto packed = _mm256_packus_epi16(_mm256_packs_epi32(a0, a1), _mm256_packs_epi32(a2, a3));
+            const auto a = _mm256_permutevar8x32_epi32(packed, order);
+            const auto ge = _mm256_cmpeq_epi8(_mm256_max_epu8(a, min), a);
+            put_bits(dest, bit + i, (u32)_mm256_movemask_epi8(ge), 32);
+        }
+        if (i < width)
+            put_tail(row + i*4, dest, bit + i, width - i);
+    }
+}
+
+#endif // FM_BITMASK_X86
+
+#ifdef FM_BITMASK_NEON
+
+// 16 pixels, vld4 splits off the alpha channel
+void bm_neon(const u8* __restrict src, u8* __restrict dest, u32 width, u32 height, u32 stride)
+{
+    static constexpr u8 weights_[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128, };
+    const auto weights = vld1q_u8(weights_);
+    const auto min = vdupq_n_u8(amin);
+    for (auto j = 0u; j < height; j++)
+    {
+        const auto* row = src + (size_t)j * stride;
+        const auto bit = (height - j - 1)*width;
+        auto i = 0u;
+        for (; i + 16 <= width; i += 16)
+        {
+            const auto px = vld4q_u8(row + i*4);
+            const auto w = vandq_u8(vcgeq_u8(px.val[3], min), weights);
+            const auto bits = (u32)vaddv_u8(vget_low_u8(w)) | (u32)vaddv_u8(vget_high_u8(w)) << 8;
+            put_bits(dest, bit + i, bits, 16);
+        }
+        if (i < width)
+            put_tail(row + i*4, dest, bit + i, width - i);
+    }
+}
+
+#endif // FM_BITMASK_NEON
+
+using kernel_fn = void(*)(const u8* __restrict src, u8* __restrict dest, u32 width, u32 height, u32 stride);
+
+kernel_fn get_kernel(bitmask_kernel kernel)
+{
+    switch (kernel)
+    {
+    case bitmask_kernel::scalar: return bm_scalar;
+#ifdef FM_BITMASK_X86
+    case bitmask_kernel::sse2: return bm_sse2;
+    case bitmask_kernel::avx2: return cpu_has_avx2() ? bm_avx2 : nullptr;
+#endif
+#ifdef FM_BITMASK_NEON
+    case bitmask_kernel::neon: return bm_neon;
+#endif
+    default: return nullptr;
+    }
+}
+
+} // namespace
+
+bool anim_atlas::has_bitmask_kernel(bitmask_kernel kernel)
+{
+    return get_kernel(kernel) != nullptr;
+}
+
+bitmask_kernel anim_atlas::best_bitmask_kernel()
+{
+    static const auto kernel = [] {
+        for (auto k : { bitmask_kernel::avx2, bitmask_kernel::sse2, bitmask_kernel::neon, })
+            if (has_bitmask_kernel(k))
+                return k;
+        return bitmask_kernel::scalar;
+    }();
+    return kernel;
+}
+
 void anim_atlas::make_bitmask_(const ImageView2D& tex, BitArray& bitmask)
+{
+    make_bitmask_(tex, bitmask, best_bitmask_kernel());
+}
+
+void anim_atlas::make_bitmask_(const ImageView2D& tex, BitArray& bitmask, bitmask_kernel kernel)
 {
     const auto pixels = tex.pixels();
     fm_soft_assert(tex.pixelSize() == 4);
-    bitmask.resetAll();
+    const auto fn = get_kernel(kernel);
+    fm_assert(fn);
 
-    const auto* const src = (const unsigned char*)pixels.data();
-    const auto stride = (size_t)pixels.stride()[0];
+    const auto* src   = (const u8*)pixels.data();
+    auto* const dest  = (u8*)bitmask.data();
+    const auto stride = (u32)pixels.stride()[0];
     const auto size   = pixels.size();
-    const auto width  = size[1], height = size[0];
+    const auto width  = (u32)size[1];
+    const auto height = (u32)size[0];
 
-    for (auto j = 0u; j < height; j++)
-        for (auto i = 0u; i < width; i++)
-            bitmask.set((height - j - 1)*width + i, src[(j*stride + i*4)+3] >= amin);
+    fm_debug_assert(bitmask.size() % 8 == 0);
+    fm_debug_assert(bitmask.size() >= (size_t)width * height);
+    std::memset(bitmask.data(), 0, bitmask.size()/8);
+
+    fn(src, dest, width, height, stride);
 }
-#endif
 
 } // namespace floormat
@@ -138,9 +138,10 @@ bool chunk::find_hole_in_bbox(Range2D& hole, const Chunk_RTree& rtree, Range2D b
     });
     return ret;
 }
-void chunk::get_all_holes_in_bbox(const hole_callback& fn, chunk& c, Vector2 bb_min, Vector2 bb_max,
+void chunk::get_all_holes_in_bbox(const hole_callback& fn, const chunk& c, Vector2 bb_min, Vector2 bb_max,
                                   pass_through_mask mask)
 {
+    // runs on the mesh builder's workers, so the tree has to be built already
     const auto& rtree = *c.rtree();
     rtree.Search(bb_min.data(), bb_max.data(), [&](uint64_t data, const Chunk_RTree::Rect& r) {
         auto x = std::bit_cast<collision_data>(data);
@@ -149,8 +150,9 @@ void chunk::get_all_holes_in_bbox(const hole_callback& fn, chunk& c, Vector2 bb_
             Vector2 hmin = {r.m_min[0], r.m_min[1]}, hmax = {r.m_max[0], r.m_max[1]};
             if (rect_intersects(hmin, hmax, bb_min, bb_max))
             {
-                auto obj = c.world().find_object<struct hole>(x.id);
-                fm_assert(obj);
+                const auto* e = c.world().find_object_ptr(x.id);
+                fm_assert(e && e->type() == object_type::hole);
+                const auto* obj = static_cast<const struct hole*>(e);
                 int zmaxʹ = (int)obj->z_offset + (int)obj->height;
                 auto zmax = (uint8_t)Math::clamp(zmaxʹ, 0, tile_size_z);
                 fn({hmin, hmax}, {obj->z_offset, zmax});
@@ -234,6 +236,7 @@ void chunk::ensure_passability() noexcept
 }
 
 uint64_t chunk::pass_gen() const noexcept { return _pass_gen; }
+uint32_t chunk::awake_count() const noexcept { return _awake_count; }
 
 bool chunk::_bbox_for_scenery(const object& s, local_coords local, Vector2b offset,
                               Vector2b bbox_offset, Vector2ub bbox_size, bbox& value) noexcept
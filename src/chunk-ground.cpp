@@ -16,7 +16,7 @@ void chunk::ensure_alloc_ground()
         _ground = Pointer<ground_stuff>{InPlaceInit};
 }
 
-void chunk::ensure_ground_mesh(SpriteBatch& sb)
+void chunk::build_ground_mesh()
 {
     if (!_ground)
         return;
@@ -27,6 +27,7 @@ void chunk::ensure_ground_mesh(SpriteBatch& sb)
 
         const float depth_start = Render::get_status().is_clipdepth01_enabled ? 0.f : -1.f;
         const float depth = Depth::value_at(depth_start, point{_coord, {}, {}}, -tile_size_xy * 4);
+        const auto origin = Quads::chunk_origin(_coord);
 
         for (auto i = 0uz; i < TILE_COUNT; i++)
         {
@@ -41,12 +42,19 @@ void chunk::ensure_ground_mesh(SpriteBatch& sb)
             for (auto j = 0uz; j < 4; j++)
             {
                 const auto k = Quads::ccw_order[j];
-                v[j] = { quad[k], texcoords[k], depth };
+                v[j] = Quads::make_vertex(quad[k], texcoords[k], depth, origin);
             }
             ground_static_mesh.add(v, depth, nullptr);
         }
     }
-    sb.emit(ground_static_mesh, false);
+}
+
+void chunk::ensure_ground_mesh(SpriteBatch& sb)
+{
+    if (!_ground)
+        return;
+    build_ground_mesh();
+    sb.emit(ground_static_mesh, _coord, false);
 }
 
 } // namespace floormat
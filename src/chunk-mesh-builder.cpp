@@ -0,0 +1,155 @@
+#include "chunk-mesh-builder.hpp"
+#include "chunk.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cr/Array.h>
+#include <cr/GrowableArray.h>
+
+namespace floormat {
+
+namespace {
+
+void build_chunk(chunk& c)
+{
+    c.build_ground_mesh();
+    c.build_wall_mesh();
+    c.build_scenery_mesh();
+}
+
+} // namespace
+
+struct chunk_mesh_builder::Impl
+{
+    // shared with the workers
+    std::mutex mutex;
+    std::condition_variable job_cv, done_cv;
+    ArrayView<chunk* const> jobs;
+    std::atomic<uint32_t> next = 0;
+    uint64_t round = 0;
+    uint32_t busy = 0;
+    bool quit = false;
+
+    // main thread only
+    Array<std::thread> threads;
+    Array<chunk*> stale;
+    chunk_mesh_build_stats stats;
+
+    explicit Impl(uint32_t thread_count);
+    ~Impl() noexcept;
+
+    void worker();
+    void run();
+};
+
+chunk_mesh_builder::Impl::Impl(uint32_t thread_count)
+{
+    for (auto i = 0u; i < thread_count; i++)
+        arrayAppend(threads, InPlaceInit, [this] { worker(); });
+}
+
+chunk_mesh_builder::Impl::~Impl() noexcept
+{
+    {
+        std::lock_guard lock{mutex};
+        quit = true;
+    }
+    job_cv.notify_all();
+    for (auto& t : threads)
+        t.join();
+}
+
+void chunk_mesh_builder::Impl::run()
+{
+    for (;;)
+    {
+        const auto i = next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= jobs.size())
+            return;
+        build_chunk(*jobs[i]);
+    }
+}
+
+void chunk_mesh_builder::Impl::worker()
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock lock{mutex};
+            job_cv.wait(lock, [&] { return quit || round != seen; });
+            if (quit)
+                return;
+            seen = round;
+        }
+        run();
+        {
+            std::lock_guard lock{mutex};
+            busy--;
+        }
+        done_cv.notify_one();
+    }
+}
+
+chunk_mesh_builder::chunk_mesh_builder(uint32_t thread_count):
+    impl{InPlaceInit, thread_count}
+{
+}
+
+chunk_mesh_builder::~chunk_mesh_builder() noexcept = default;
+
+void chunk_mesh_builder::build(world& w, ArrayView<const chunk_coords_> chunks)
+{
+    auto& I = *impl;
+    const auto t0 = Time::now();
+
+    arrayClear(I.stale);
+    for (auto coord : chunks)
+    {
+        auto* c = w.at(coord);
+        if (!c || !c->needs_mesh_build())
+            continue;
+        // walls look at their west and north neighbors, which mustn't get
+        // faulted in from a worker
+        if (coord.x > chunk_xy_min)
+            (void)w.at(coord + Vector2b{-1, 0});
+        if (coord.y > chunk_xy_min)
+            (void)w.at(coord + Vector2b{0, -1});
+        arrayAppend(I.stale, c);
+    }
+    // the wall mesh reads holes out of the R-tree, and rebuilding it copies
+    // bptrs whose reference counts aren't atomic. only once all the
+    // neighbors above are resident, since they add their holes too.
+    for (auto* c : I.stale)
+        c->ensure_passability();
+
+    if (I.threads.isEmpty() || I.stale.size() < 2)
+        for (auto* c : I.stale)
+            build_chunk(*c);
+    else
+    {
+        {
+            std::lock_guard lock{I.mutex};
+            I.jobs = I.stale;
+            I.next.store(0, std::memory_order_relaxed);
+            I.busy = (uint32_t)I.threads.size();
+            I.round++;
+        }
+        I.job_cv.notify_all();
+        I.run();
+        std::unique_lock lock{I.mutex};
+        I.done_cv.wait(lock, [&] { return I.busy == 0; });
+        I.jobs = {};
+    }
+
+    I.stats.built = (uint32_t)I.stale.size();
+    I.stats.time = Time::now() - t0;
+}
+
+uint32_t chunk_mesh_builder::thread_count() const { return (uint32_t)impl->threads.size(); }
+const chunk_mesh_build_stats& chunk_mesh_builder::stats() const { return impl->stats; }
+
+} // namespace floormat
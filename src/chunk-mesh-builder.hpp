@@ -0,0 +1,45 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "global-coords.hpp"
+#include "nanosecond.hpp"
+#include <cr/ArrayView.h>
+#include <cr/Pointer.h>
+
+namespace floormat {
+
+class world;
+
+struct chunk_mesh_build_stats
+{
+    // in the last build()
+    uint32_t built = 0;
+    Ns time{};
+};
+
+// Refills the static meshes of stale chunks with chunk::build_*_mesh() on
+// worker threads, before draw_world() emits them into the SpriteBatch one
+// chunk at a time. Worth it after loading a map, switching z-levels or big
+// edits, when many chunks go stale at once; the wall meshes are the slowest.
+class chunk_mesh_builder final
+{
+public:
+    // with thread_count == 0 everything gets built on the calling thread
+    explicit chunk_mesh_builder(uint32_t thread_count);
+    ~chunk_mesh_builder() noexcept;
+    fm_DISABLE_MOVE_COPY(chunk_mesh_builder);
+
+    // Pages in `chunks` and their neighbors, then builds the stale ones.
+    // Returns once all of them are done. The world must not be touched by
+    // other threads meanwhile.
+    void build(world& w, ArrayView<const chunk_coords_> chunks);
+
+    uint32_t thread_count() const;
+    const chunk_mesh_build_stats& stats() const;
+
+    struct Impl;
+
+private:
+    Pointer<Impl> impl;
+};
+
+} // namespace floormat
@@ -0,0 +1,479 @@
+#include "chunk-prefetch.hpp"
+#include "chunk-store.hpp"
+#include "chunk.hpp"
+#include "world.hpp"
+#include "grid.hpp"
+#include "grid-pass.hpp"
+#include "timer.hpp"
+#include "point.inl"
+#include "compat/assert.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cr/Array.h>
+#include <cr/GrowableArray.h>
+#include <cr/Optional.h>
+#include <cr/Path.h>
+#include <cr/String.h>
+#include <mg/Functions.h>
+#include <gtl/phmap.hpp>
+
+namespace floormat {
+
+namespace {
+
+struct read_job
+{
+    chunk_coords_ coord;
+    uint64_t generation, seq;
+    String path;
+    size_t size;
+    Array<char> record;
+    bool ok;
+};
+
+void run_job(read_job& job)
+{
+    auto file = Path::read(job.path);
+    job.ok = file && file->size() == job.size;
+    if (job.ok)
+        job.record = move(*file);
+}
+
+enum class prefetch_state : uint8_t { reading, ready, paged_in, };
+
+struct prefetch_entry
+{
+    prefetch_state state;
+    // chunk_store::record_seq() of the record being read or attached
+    uint64_t seq = 0;
+};
+
+struct tracked_pos
+{
+    // in pixels and pixels per second
+    Vector2d pos, velocity;
+    int8_t z;
+};
+
+// anything farther in a single update() is a teleport, not movement
+constexpr double max_jump = chunk_size_xy * 4.;
+
+chunk_coords_ chunk_at_pixel(Vector2d pos, int8_t z)
+{
+    constexpr double half_tile = tile_size_xy * .5;
+    auto c = Math::floor((pos + Vector2d{half_tile}) / (double)chunk_size_xy);
+    c = Math::clamp(c, Vector2d{(double)chunk_xy_min}, Vector2d{(double)chunk_xy_max});
+    return { (int16_t)c.x(), (int16_t)c.y(), z };
+}
+
+} // namespace
+
+struct chunk_prefetcher::Impl
+{
+    // shared with the workers
+    std::mutex mutex;
+    std::condition_variable job_cv, done_cv;
+    Array<Pointer<read_job>> queue, done;
+    bool quit = false;
+
+    // main thread only
+    Array<std::thread> threads;
+    gtl::flat_hash_map<chunk_coords_, prefetch_entry, Hash::chunk_coord_hasher> state;
+    gtl::flat_hash_map<chunk_coords_, uint32_t, Hash::chunk_coord_hasher> wanted_set;
+    Array<chunk_coords_> wanted;
+    Array<tracked_pos> tracked;
+    const class chunk_store* store = nullptr;
+    uint64_t generation = 0, last_faults = 0;
+    uint32_t in_flight = 0, ready = 0, visible_count = 0;
+    chunk_prefetch_params params;
+    chunk_prefetch_stats stats;
+
+    Impl(const chunk_prefetch_params& params, uint32_t thread_count);
+    ~Impl() noexcept;
+
+    void worker();
+    void want(chunk_coords_ coord);
+    void want_around(chunk_coords_ coord);
+    void predict(ArrayView<const chunk_coords_> visible, ArrayView<const point> points, const Ns& dt);
+    void count_needed(world& w, ArrayView<const chunk_coords_> visible);
+    void apply(world& w, Pointer<read_job> job);
+    void apply_done(world& w);
+    void cancel(world& w);
+    void submit(world& w);
+    void page_in(world& w);
+    void drop_all();
+};
+
+chunk_prefetcher::Impl::Impl(const chunk_prefetch_params& params, uint32_t thread_count):
+    params{params}
+{
+    for (auto i = 0u; i < thread_count; i++)
+        arrayAppend(threads, InPlaceInit, [this] { worker(); });
+}
+
+chunk_prefetcher::Impl::~Impl() noexcept
+{
+    {
+        std::lock_guard lock{mutex};
+        quit = true;
+    }
+    job_cv.notify_all();
+    for (auto& t : threads)
+        t.join();
+}
+
+void chunk_prefetcher::Impl::worker()
+{
+    for (;;)
+    {
+        Pointer<read_job> job;
+        {
+            std::unique_lock lock{mutex};
+            job_cv.wait(lock, [&] { return quit || !queue.isEmpty(); });
+            if (quit)
+                return;
+            job = move(queue.front());
+            arrayRemove(queue, 0);
+        }
+        run_job(*job);
+        {
+            std::lock_guard lock{mutex};
+            arrayAppend(done, move(job));
+        }
+        done_cv.notify_one();
+    }
+}
+
+void chunk_prefetcher::Impl::want(chunk_coords_ coord)
+{
+    if (wanted_set.try_emplace(coord, (uint32_t)wanted.size()).second)
+        arrayAppend(wanted, coord);
+}
+
+void chunk_prefetcher::Impl::want_around(chunk_coords_ coord)
+{
+    const auto r = (int32_t)params.radius;
+    for (int32_t y = Math::max(coord.y - r, (int32_t)chunk_xy_min); y <= Math::min(coord.y + r, (int32_t)chunk_xy_max); y++)
+        for (int32_t x = Math::max(coord.x - r, (int32_t)chunk_xy_min); x <= Math::min(coord.x + r, (int32_t)chunk_xy_max); x++)
+            want({(int16_t)x, (int16_t)y, coord.z});
+}
+
+void chunk_prefetcher::Impl::predict(ArrayView<const chunk_coords_> visible, ArrayView<const point> points, const Ns& dt)
+{
+    arrayClear(wanted);
+    wanted_set.clear();
+
+    // what's on screen goes first, then each tracked position from now to the lookahead
+    for (auto coord : visible)
+        want(coord);
+    visible_count = (uint32_t)wanted.size();
+
+    const auto secs = (double)Time::to_seconds(dt);
+    const auto old_size = tracked.size();
+    arrayResize(tracked, ValueInit, points.size());
+
+    for (auto i = 0uz; i < points.size(); i++)
+    {
+        const auto pos = Vector2d(Vector3i(points[i]).xy());
+        const auto z = points[i].chunk3().z;
+        auto& t = tracked[i];
+        if (i >= old_size || t.z != z || (pos - t.pos).length() > max_jump)
+            t.velocity = {};
+        else if (secs > 0)
+            t.velocity = Math::lerp(t.velocity, (pos - t.pos) / secs, .5);
+        t.pos = pos;
+        t.z = z;
+
+        constexpr double step = chunk_size_xy * .5;
+        const auto speed = t.velocity.length();
+        const auto dist = Math::min(speed * (double)Time::to_seconds(params.lookahead),
+                                    (double)params.max_distance * chunk_size_xy);
+        const auto dir = speed > 0 ? t.velocity / speed : Vector2d{};
+        for (double d = 0; ; d += step)
+        {
+            want_around(chunk_at_pixel(t.pos + dir * Math::min(d, dist), z));
+            if (d >= dist)
+                break;
+        }
+    }
+}
+
+void chunk_prefetcher::Impl::count_needed(world& w, ArrayView<const chunk_coords_> visible)
+{
+    for (auto coord : visible)
+    {
+        auto it = state.find(coord);
+        if (w.is_paged_out(coord))
+        {
+            if (it != state.end() && it->second.state == prefetch_state::ready)
+                stats.hits++;
+            else
+                stats.misses++;
+        }
+        else if (it != state.end() && it->second.state == prefetch_state::paged_in)
+        {
+            stats.hits++;
+            state.erase(it);
+        }
+    }
+
+    const auto faults = w.chunk_store().stats().faults;
+    stats.misses += faults - last_faults;
+    last_faults = faults;
+}
+
+void chunk_prefetcher::Impl::apply(world& w, Pointer<read_job> job)
+{
+    fm_debug_assert(in_flight > 0);
+    in_flight--;
+    if (job->generation != generation)
+        return;
+
+    const auto coord = job->coord;
+    // cancel() already gave up on it, see there
+    auto it = state.find(coord);
+    if (it == state.end() || it->second.state != prefetch_state::reading || it->second.seq != job->seq)
+        return;
+    state.erase(it);
+    auto& st = w.chunk_store();
+    // paged in by someone else in the meantime, or no longer in the way
+    if (!w.is_paged_out(coord) || !wanted_set.contains(coord))
+        stats.wasted++;
+    // let world::at() read it and fail loudly
+    else if (!job->ok)
+        return;
+    // paged in and back out while it was being read, the record is newer
+    else if (!st.attach(coord, job->seq, move(job->record)))
+        stats.wasted++;
+    else
+    {
+        state[coord] = {prefetch_state::ready, job->seq};
+        ready++;
+    }
+}
+
+void chunk_prefetcher::Impl::apply_done(world& w)
+{
+    Array<Pointer<read_job>> jobs;
+    {
+        std::lock_guard lock{mutex};
+        jobs = move(done);
+    }
+    for (auto& job : jobs)
+        apply(w, move(job));
+}
+
+void chunk_prefetcher::Impl::cancel(world& w)
+{
+    {
+        std::lock_guard lock{mutex};
+        for (auto i = 0uz; i < queue.size(); )
+        {
+            const auto coord = queue[i]->coord;
+            if (wanted_set.contains(coord))
+            {
+                i++;
+                continue;
+            }
+            state.erase(coord);
+            stats.cancelled++;
+            arrayRemove(queue, i);
+            in_flight--;
+        }
+    }
+
+    auto& st = w.chunk_store();
+    for (auto it = state.begin(); it != state.end(); )
+    {
+        const auto [coord, s] = *it;
+        bool drop = false;
+        switch (s.state)
+        {
+        case prefetch_state::reading:
+            // faulted in by world::at() while being read, and maybe paged out
+            // again since. apply() throws the read away once it's back.
+            if (!w.is_paged_out(coord) || st.record_seq(coord) != s.seq)
+            {
+                drop = true;
+                stats.wasted++;
+            }
+            break;
+        case prefetch_state::ready:
+            // paged in by the time it was needed, see count_needed()
+            if (!w.is_paged_out(coord))
+                drop = true, ready--;
+            // the same, but paged out again as a new record that isn't attached
+            else if (st.record_seq(coord) != s.seq)
+                drop = true, ready--;
+            else if (!wanted_set.contains(coord))
+            {
+                st.detach(coord);
+                drop = true, ready--;
+                stats.wasted++;
+            }
+            break;
+        case prefetch_state::paged_in:
+            // paged back out or collected before it came into view
+            if (!w.resident_at(coord))
+            {
+                drop = true;
+                stats.wasted++;
+            }
+            break;
+        }
+        if (drop)
+            state.erase(it++);
+        else
+            ++it;
+    }
+}
+
+void chunk_prefetcher::Impl::submit(world& w)
+{
+    auto& st = w.chunk_store();
+    bool queued = false;
+    // visible chunks are paged in right away by page_in()
+    for (auto i = visible_count; i < wanted.size(); i++)
+    {
+        const auto coord = wanted[i];
+        if (in_flight >= params.max_in_flight)
+            break;
+        if (!w.is_paged_out(coord) || state.contains(coord))
+            continue;
+        stats.requested++;
+        const auto seq = st.record_seq(coord);
+        if (st.is_in_memory(coord))
+        {
+            // nothing to read, only paging in is left
+            state[coord] = {prefetch_state::ready, seq};
+            ready++;
+            continue;
+        }
+        auto job = Pointer<read_job>{InPlaceInit, coord, generation, seq, st.record_path(coord), st.record_size(coord), Array<char>{}, false};
+        in_flight++;
+        state[coord] = {prefetch_state::reading, seq};
+        if (threads.isEmpty())
+        {
+            run_job(*job);
+            apply(w, move(job));
+        }
+        else
+        {
+            std::lock_guard lock{mutex};
+            arrayAppend(queue, move(job));
+            queued = true;
+        }
+    }
+    if (queued)
+        job_cv.notify_all();
+}
+
+void chunk_prefetcher::Impl::page_in(world& w)
+{
+    uint32_t count = 0;
+    for (auto i = 0u; i < wanted.size(); i++)
+    {
+        const auto coord = wanted[i];
+        // visible chunks get paged in either way, better here than in world::at()
+        const bool needed = i < visible_count;
+        auto it = state.find(coord);
+        const bool is_ready = it != state.end() && it->second.state == prefetch_state::ready;
+        if (needed ? !w.is_paged_out(coord) : !is_ready || count >= params.max_page_ins)
+            continue;
+        auto* c = w.page_in(coord);
+        fm_assert(c);
+        c->ensure_passability();
+        w.raycast_pass_pool()[*c].build_if_stale(Search::never_continue());
+        count++;
+        stats.paged_in++;
+        if (is_ready)
+            ready--;
+        if (!needed)
+            it->second.state = prefetch_state::paged_in;
+        else if (it != state.end())
+            state.erase(it);
+    }
+}
+
+void chunk_prefetcher::Impl::drop_all()
+{
+    {
+        std::lock_guard lock{mutex};
+        stats.cancelled += queue.size();
+        in_flight -= (uint32_t)queue.size();
+        arrayClear(queue);
+    }
+    // jobs still running get thrown away once they're done
+    generation++;
+    state.clear();
+    tracked = {};
+    ready = 0;
+    store = nullptr;
+}
+
+chunk_prefetcher::chunk_prefetcher(const chunk_prefetch_params& params, uint32_t thread_count):
+    impl{InPlaceInit, params, thread_count}
+{
+    set_params(params);
+}
+
+chunk_prefetcher::~chunk_prefetcher() noexcept = default;
+
+void chunk_prefetcher::update(world& w, ArrayView<const chunk_coords_> visible, ArrayView<const point> tracked, const Ns& dt)
+{
+    auto& I = *impl;
+    if (&w.chunk_store() != I.store)
+    {
+        I.drop_all();
+        I.store = &w.chunk_store();
+        I.last_faults = I.store->stats().faults;
+    }
+
+    I.count_needed(w, visible);
+    I.predict(visible, tracked, dt);
+    I.apply_done(w);
+    I.cancel(w);
+    I.submit(w);
+    I.page_in(w);
+
+    I.stats.in_flight = I.in_flight;
+    I.stats.ready = I.ready;
+}
+
+void chunk_prefetcher::finish(world& w)
+{
+    auto& I = *impl;
+    while (I.in_flight > 0)
+    {
+        Array<Pointer<read_job>> jobs;
+        {
+            std::unique_lock lock{I.mutex};
+            I.done_cv.wait(lock, [&] { return !I.done.isEmpty(); });
+            jobs = move(I.done);
+        }
+        for (auto& job : jobs)
+            I.apply(w, move(job));
+    }
+    I.stats.in_flight = I.in_flight;
+    I.stats.ready = I.ready;
+}
+
+void chunk_prefetcher::reset()
+{
+    impl->drop_all();
+    impl->stats.in_flight = impl->in_flight;
+    impl->stats.ready = 0;
+}
+
+void chunk_prefetcher::set_params(const chunk_prefetch_params& params)
+{
+    fm_assert(params.radius <= TILE_MAX_DIM);
+    fm_assert(params.max_in_flight > 0);
+    impl->params = params;
+}
+
+const chunk_prefetch_params& chunk_prefetcher::params() const { return impl->params; }
+const chunk_prefetch_stats& chunk_prefetcher::stats() const { return impl->stats; }
+
+} // namespace floormat
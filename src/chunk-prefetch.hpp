@@ -0,0 +1,74 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "global-coords.hpp"
+#include "nanosecond.hpp"
+#include <cr/ArrayView.h>
+#include <cr/Pointer.h>
+
+namespace floormat {
+
+class world;
+struct point;
+
+struct chunk_prefetch_params
+{
+    // how far into the future tracked positions get extrapolated
+    Ns lookahead{3000000000};
+    // but never more than this many chunks ahead
+    uint32_t max_distance = 8;
+    // chunks around each extrapolated position
+    uint32_t radius = 1;
+    // reads queued or running on the worker thread
+    uint32_t max_in_flight = 16;
+    // page-ins of chunks that were read ahead, on the main thread per update()
+    uint32_t max_page_ins = 4;
+};
+
+struct chunk_prefetch_stats
+{
+    // chunks that came into view after being read or paged in ahead of time
+    uint64_t hits = 0;
+    // chunks that came into view while still paged out, and faults from world::at()
+    uint64_t misses = 0;
+    // chunks read or paged in but moved away from before they came into view
+    uint64_t wasted = 0;
+    // requests dropped before the worker got to them
+    uint64_t cancelled = 0;
+    uint64_t requested = 0, paged_in = 0;
+    // currently
+    uint32_t in_flight = 0, ready = 0;
+};
+
+// Pages in chunks before they come into view, so walking or scrolling into a
+// paged-out area doesn't stall on world::at() faulting them in. The tracked
+// positions (the camera, the player) get extrapolated along their recent
+// velocity. Records of on-disk chunk stores are read on a worker thread and
+// attached to the store; deserializing and building passability stays on the
+// main thread, a few chunks per update().
+class chunk_prefetcher final
+{
+public:
+    // with thread_count == 0 the reads happen inside update()
+    explicit chunk_prefetcher(const chunk_prefetch_params& params = {}, uint32_t thread_count = 1);
+    ~chunk_prefetcher() noexcept;
+    fm_DISABLE_MOVE_COPY(chunk_prefetcher);
+
+    // `visible` is what's needed right now. each entry of `tracked` is
+    // followed by its index across calls to estimate its velocity.
+    void update(world& w, ArrayView<const chunk_coords_> visible, ArrayView<const point> tracked, const Ns& dt);
+    // waits for the reads in flight and applies them
+    void finish(world& w);
+    // drops every request, e.g. after loading another map
+    void reset();
+
+    const chunk_prefetch_params& params() const;
+    void set_params(const chunk_prefetch_params& params);
+    const chunk_prefetch_stats& stats() const;
+
+    struct Impl;
+
+private:
+    Pointer<Impl> impl;
+};
+
+} // namespace floormat
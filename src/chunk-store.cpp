@@ -0,0 +1,143 @@
+#include "chunk-store.hpp"
+#include "compat/assert.hpp"
+#include "compat/exception.hpp"
+#include "compat/format.hpp"
+#include <cr/GrowableArray.h>
+#include <cr/Optional.h>
+#include <cr/Path.h>
+
+namespace floormat {
+
+chunk_store::chunk_store(StringView directory) : _directory{directory}
+{
+    if (_directory && !Path::make(_directory))
+        fm_throw("can't create chunk store directory '{}'"_cf, _directory);
+}
+
+chunk_store::~chunk_store() noexcept
+{
+    if (_directory)
+        for (const auto& [coord, _] : _records)
+            remove_record(coord);
+}
+
+String chunk_store::record_path(chunk_coords_ coord) const
+{
+    char buf[32];
+    snformat(buf, "{}_{}_{}.chunk"_cf, coord.x, coord.y, (int)coord.z);
+    return Path::join(_directory, buf);
+}
+
+void chunk_store::remove_record(chunk_coords_ coord)
+{
+    if (!Path::remove(record_path(coord)))
+        fm_warn("failed to remove chunk record for %d:%d:%d", (int)coord.x, (int)coord.y, (int)coord.z);
+}
+
+void chunk_store::put(chunk_coords_ coord, Array<char>&& record)
+{
+    fm_assert(!record.isEmpty());
+    const auto size = record.size();
+    if (_directory)
+    {
+        auto path = record_path(coord);
+        if (!Path::write(path, ArrayView<const char>{record}))
+            fm_throw("can't write chunk record '{}'"_cf, path);
+        record = {};
+    }
+    auto [it, fresh] = _records.try_emplace(coord, entry{move(record), size, ++_seq});
+    fm_assert(fresh);
+    _bytes += size;
+}
+
+Array<char> chunk_store::take(chunk_coords_ coord)
+{
+    auto it = _records.find(coord);
+    fm_assert(it != _records.end());
+    auto e = move(it->second);
+    _records.erase(it);
+    fm_debug_assert(_bytes >= e.size);
+    _bytes -= e.size;
+    if (!_directory)
+        return move(e.record);
+
+    Array<char> record;
+    if (!e.record.isEmpty())
+        record = move(e.record);
+    else
+    {
+        auto path = record_path(coord);
+        auto file = Path::read(path);
+        if (!file || file->size() != e.size)
+            fm_throw("can't read chunk record '{}'"_cf, path);
+        record = move(*file);
+    }
+    remove_record(coord);
+    return record;
+}
+
+bool chunk_store::is_in_memory(chunk_coords_ coord) const
+{
+    auto it = _records.find(coord);
+    fm_assert(it != _records.end());
+    return !it->second.record.isEmpty();
+}
+
+size_t chunk_store::record_size(chunk_coords_ coord) const
+{
+    auto it = _records.find(coord);
+    fm_assert(it != _records.end());
+    return it->second.size;
+}
+
+uint64_t chunk_store::record_seq(chunk_coords_ coord) const
+{
+    auto it = _records.find(coord);
+    fm_assert(it != _records.end());
+    return it->second.seq;
+}
+
+bool chunk_store::attach(chunk_coords_ coord, uint64_t seq, Array<char>&& record)
+{
+    auto it = _records.find(coord);
+    if (it == _records.end() || it->second.seq != seq)
+        return false;
+    auto& e = it->second;
+    fm_assert(_directory && e.record.isEmpty());
+    fm_assert(record.size() == e.size);
+    e.record = move(record);
+    return true;
+}
+
+void chunk_store::detach(chunk_coords_ coord)
+{
+    auto it = _records.find(coord);
+    fm_assert(it != _records.end());
+    if (_directory)
+        it->second.record = {};
+}
+
+void chunk_store::coords(Array<chunk_coords_>& out) const
+{
+    arrayReserve(out, out.size() + _records.size());
+    for (const auto& [coord, _] : _records)
+        arrayAppend(out, coord);
+}
+
+void chunk_store::clear()
+{
+    if (_directory)
+        for (const auto& [coord, _] : _records)
+            remove_record(coord);
+    _records.clear();
+    _bytes = 0;
+}
+
+bool chunk_store::contains(chunk_coords_ coord) const { return _records.contains(coord); }
+size_t chunk_store::size() const { return _records.size(); }
+size_t chunk_store::bytes() const { return _bytes; }
+StringView chunk_store::directory() const { return _directory; }
+chunk_store_stats& chunk_store::stats() { return _stats; }
+const chunk_store_stats& chunk_store::stats() const { return _stats; }
+
+} // namespace floormat
@@ -0,0 +1,75 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "global-coords.hpp"
+#include "nanosecond.hpp"
+#include <cr/Array.h>
+#include <cr/String.h>
+#include <gtl/phmap.hpp>
+
+namespace floormat {
+
+struct chunk_store_stats
+{
+    uint64_t page_ins = 0, page_outs = 0;
+    // page-ins from world::at() or world::operator[] rather than a prefetch
+    uint64_t faults = 0;
+    Ns page_in_last{}, page_in_max{}, page_in_total{};
+};
+
+// Backing store for chunks paged out by world::page_out(). Each chunk is one
+// record in the savegame format, kept in memory or written to a file of its
+// own in `directory`.
+class chunk_store
+{
+public:
+    explicit chunk_store(StringView directory = {});
+    ~chunk_store() noexcept;
+    fm_DISABLE_COPY(chunk_store);
+
+    void put(chunk_coords_ coord, Array<char>&& record);
+    Array<char> take(chunk_coords_ coord);
+    bool contains(chunk_coords_ coord) const;
+    void coords(Array<chunk_coords_>& out) const;
+    void clear();
+
+    // For reading records ahead of take() on another thread. Only on-disk
+    // records need it, the rest are always in memory.
+    bool is_in_memory(chunk_coords_ coord) const;
+    String record_path(chunk_coords_ coord) const;
+    size_t record_size(chunk_coords_ coord) const;
+    // changes each time the chunk is paged out, so a read that raced with a
+    // page-in and another page-out can tell its record is stale
+    uint64_t record_seq(chunk_coords_ coord) const;
+    // a record read from record_path(); take() returns it instead of reading the file.
+    // returns false and drops it if the record at `coord` isn't `seq` anymore.
+    bool attach(chunk_coords_ coord, uint64_t seq, Array<char>&& record);
+    void detach(chunk_coords_ coord);
+
+    size_t size() const;
+    // total size of the records
+    size_t bytes() const;
+    StringView directory() const;
+
+    chunk_store_stats& stats();
+    const chunk_store_stats& stats() const;
+
+private:
+    void remove_record(chunk_coords_ coord);
+
+    // the record itself, or an empty array with its size if it's on disk and
+    // wasn't attached
+    struct entry
+    {
+        Array<char> record;
+        size_t size;
+        uint64_t seq;
+    };
+
+    gtl::flat_hash_map<chunk_coords_, entry, Hash::chunk_coord_hasher> _records;
+    String _directory;
+    size_t _bytes = 0;
+    uint64_t _seq = 0;
+    chunk_store_stats _stats;
+};
+
+} // namespace floormat
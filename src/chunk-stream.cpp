@@ -0,0 +1,123 @@
+#include "chunk-stream.hpp"
+#include "chunk-store.hpp"
+#include "world.hpp"
+#include "chunk.hpp"
+#include "nanosecond.inl"
+#include <algorithm>
+#include <cr/GrowableArray.h>
+#include <mg/Functions.h>
+
+namespace floormat {
+
+chunk_streamer::chunk_streamer(const chunk_stream_params& params)
+{
+    set_params(params);
+}
+
+void chunk_streamer::set_params(const chunk_stream_params& params)
+{
+    fm_assert(params.radius <= TILE_MAX_DIM * 4);
+    fm_assert(params.max_resident > 0);
+    _params = params;
+}
+
+const chunk_stream_params& chunk_streamer::params() const { return _params; }
+const chunk_stream_stats& chunk_streamer::stats() const { return _stats; }
+
+void chunk_streamer::update(world& w, ArrayView<const chunk_coords_> keep)
+{
+    const auto tick = ++_tick;
+    _stats.page_ins = 0;
+    _stats.page_outs = 0;
+    _stats.pinned = 0;
+
+    if (!keep.isEmpty())
+    {
+        auto min = Vector2i{keep[0].x, keep[0].y}, max = min;
+        int8_t z_min = keep[0].z, z_max = keep[0].z;
+        for (const auto& ch : keep)
+        {
+            const auto pos = Vector2i{ch.x, ch.y};
+            min = Math::min(min, pos);
+            max = Math::max(max, pos);
+            z_min = Math::min(z_min, ch.z);
+            z_max = Math::max(z_max, ch.z);
+        }
+        const auto r = Vector2i{(int32_t)_params.radius};
+        min = Math::max(min - r, Vector2i{chunk_xy_min});
+        max = Math::min(max + r, Vector2i{chunk_xy_max});
+
+        for (int32_t z = z_min; z <= z_max; z++)
+            for (int32_t y = min.y(); y <= max.y(); y++)
+                for (int32_t x = min.x(); x <= max.x(); x++)
+                {
+                    const auto coord = chunk_coords_{(int16_t)x, (int16_t)y, (int8_t)z};
+                    if (w.is_paged_out(coord))
+                    {
+                        if (_stats.page_ins >= _params.max_page_ins)
+                            continue;
+                        (void)w.page_in(coord);
+                        _stats.page_ins++;
+                    }
+                    else if (!w.contains(coord))
+                        continue;
+                    _last_needed[coord] = tick;
+                }
+    }
+
+    auto& store = w.chunk_store();
+    arrayClear(_candidates);
+    _stats.resident_bytes = 0;
+    for (auto& c : w.chunks())
+    {
+        _stats.resident_bytes += c.memory_usage();
+        auto it = _last_needed.find(c.coord());
+        // chunks created since the last update() count as needed just now
+        if (it == _last_needed.end())
+            it = _last_needed.try_emplace(c.coord(), tick).first;
+        if (it->second != tick)
+            arrayAppend(_candidates, candidate{it->second, &c});
+    }
+
+    // coordinates of chunks that were collected in the meantime
+    if (_last_needed.size() > 2 * (w.size() + 64))
+        for (auto it = _last_needed.begin(); it != _last_needed.end(); )
+            if (!w.contains(it->first))
+                _last_needed.erase(it++);
+            else
+                ++it;
+
+    const auto size = w.size();
+    if (size > _params.max_resident && !_candidates.isEmpty())
+    {
+        const auto n = Math::min(_candidates.size(), size - _params.max_resident);
+        auto* const begin = _candidates.begin();
+        std::sort(begin, _candidates.end(), [](const candidate& a, const candidate& b) {
+            return a.last_needed < b.last_needed;
+        });
+        for (auto i = 0uz; i < _candidates.size() && _stats.page_outs < Math::min(n, (size_t)_params.max_page_outs); i++)
+        {
+            auto& c = *begin[i].c;
+            const auto coord = c.coord();
+            const auto bytes = c.memory_usage();
+            if (w.page_out(c))
+            {
+                _last_needed.erase(coord);
+                _stats.resident_bytes -= bytes;
+                _stats.page_outs++;
+            }
+            else
+                _stats.pinned++;
+        }
+    }
+
+    _stats.resident = (uint32_t)w.size();
+    _stats.paged_out = (uint32_t)store.size();
+    _stats.store_bytes = store.bytes();
+    const auto& st = store.stats();
+    _stats.page_in_last = st.page_in_last;
+    _stats.page_in_max = st.page_in_max;
+    _stats.page_in_avg = st.page_ins ? st.page_in_total / st.page_ins : Ns{};
+}
+
+} // namespace floormat
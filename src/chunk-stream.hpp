@@ -0,0 +1,71 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "global-coords.hpp"
+#include "nanosecond.hpp"
+#include <cr/Array.h>
+#include <cr/ArrayView.h>
+#include <gtl/phmap.hpp>
+
+namespace floormat {
+
+class world;
+class chunk;
+
+struct chunk_stream_params
+{
+    // chunks this close to the area passed to update() stay in memory
+    uint32_t radius = 6;
+    // farther away, the chunks needed least recently get paged out past this many
+    uint32_t max_resident = 1024;
+    // work done by a single update()
+    uint32_t max_page_ins = 32, max_page_outs = 32;
+};
+
+struct chunk_stream_stats
+{
+    uint32_t resident = 0, paged_out = 0;
+    // chunks that had to be paged out but couldn't, see world::can_page_out()
+    uint32_t pinned = 0;
+    // estimated from chunk::memory_usage()
+    size_t resident_bytes = 0;
+    size_t store_bytes = 0;
+    // in the last update()
+    uint32_t page_ins = 0, page_outs = 0;
+    // of every page-in so far, see chunk_store_stats
+    Ns page_in_last{}, page_in_max{}, page_in_avg{};
+};
+
+// Keeps memory use bounded on big maps. Chunks around the area passed to
+// update() get paged in ahead of time, and once there are too many chunks in
+// memory, the ones farthest back in time get paged out to the world's
+// chunk_store. Anything else that touches a paged-out chunk through
+// world::at() pages it back in on the spot.
+class chunk_streamer
+{
+public:
+    explicit chunk_streamer(const chunk_stream_params& params = {});
+    fm_DISABLE_COPY(chunk_streamer);
+
+    // `keep` is usually what's on screen and being simulated
+    void update(world& w, ArrayView<const chunk_coords_> keep);
+
+    const chunk_stream_params& params() const;
+    void set_params(const chunk_stream_params& params);
+    // of the last update()
+    const chunk_stream_stats& stats() const;
+
+private:
+    struct candidate
+    {
+        uint64_t last_needed;
+        chunk* c;
+    };
+
+    gtl::flat_hash_map<chunk_coords_, uint64_t, Hash::chunk_coord_hasher> _last_needed;
+    Array<candidate> _candidates;
+    chunk_stream_params _params;
+    chunk_stream_stats _stats;
+    uint64_t _tick = 0;
+};
+
+} // namespace floormat
@@ -85,6 +85,17 @@ chunk_table::~chunk_table() noexcept
 }
 
 chunk* chunk_table::chunk_at(chunk_coords_ ch) noexcept
+{
+    auto* c = slot_at(ch);
+    return c == stub() ? nullptr : c;
+}
+
+const chunk* chunk_table::chunk_at(chunk_coords_ ch) const noexcept
+{
+    return const_cast<chunk_table*>(this)->chunk_at(ch);
+}
+
+chunk* chunk_table::slot_at(chunk_coords_ ch) const noexcept
 {
     fm_assert(ch.z >= chunk_z_min && ch.z <= chunk_z_max);
     fm_assert(uint32_t(ch.x + chunk_xbias) < uint32_t(chunk_xbias) * 2u
@@ -113,11 +124,6 @@ chunk* chunk_table::chunk_at(chunk_coords_ ch) noexcept
     return cell->data[(ly - cell->ymin) * w + (lx - cell->xmin)];
 }
 
-const chunk* chunk_table::chunk_at(chunk_coords_ ch) const noexcept
-{
-    return const_cast<chunk_table*>(this)->chunk_at(ch);
-}
-
 void chunk_table::update_slot(chunk_coords_ ch, chunk* p) noexcept
 {
     fm_assert(ch.z >= chunk_z_min && ch.z <= chunk_z_max);
@@ -20,8 +20,14 @@ public:
     ~chunk_table() noexcept;
     fm_DISABLE_COPY(chunk_table);
 
+    // null for chunks that don't exist or are paged out
     chunk*       chunk_at(chunk_coords_ ch) noexcept;
     const chunk* chunk_at(chunk_coords_ ch) const noexcept;
+    // like chunk_at() but returns stub() for paged-out chunks
+    chunk*       slot_at(chunk_coords_ ch) const noexcept;
+
+    // left in the slot of a chunk paged out by world::page_out()
+    static chunk* stub() noexcept { return reinterpret_cast<chunk*>(uintptr_t{1}); }
 
     std::array<chunk*, 8>       neighbors(chunk_coords_ ch0) noexcept;
     std::array<const chunk*, 8> neighbors(chunk_coords_ ch0) const noexcept;
@@ -43,12 +43,11 @@ enum class HoleRegion : uint8_t { Wall, Corner };
 ArrayView<HoleData> find_wall_holes_in_world_coords(Array<HoleData>& output, chunk& c, local_coords tile_pos, bool IsWest, HoleRegion region)
 {
     auto wall_bb = [&] -> Optional<Pair<Vector2, Vector2>> {
-        auto tile = c[tile_pos];
-        const auto* atlas = !IsWest ? tile.wall_north_atlas().get() : tile.wall_west_atlas().get();
+        const auto k = tile_pos.to_index();
+        const auto* atlas = c.wall_atlas_at(k*2 + IsWest);
         if (!atlas)
             return NullOpt;
         const auto d = (float)atlas->info().depth;
-        const auto k = tile_pos.to_index();
         switch (region)
         {
         case HoleRegion::Wall:
@@ -79,7 +78,7 @@ struct WallFragment
     Range3D world_coords;
 };
 
-Array<Range2D> wall_fragments, next_wall_fragments;
+thread_local Array<Range2D> wall_fragments, next_wall_fragments;
 
 ArrayView<WallFragment> cut_wall_face(Array<WallFragment>& output, ArrayView<const HoleData> holes,
                                       local_coords tile_pos, float depth, bool IsWest, HoleRegion region)
@@ -211,10 +210,18 @@ uint32_t variant_index(uint32_t frame_count, global_coords coord, variant_t vari
     return variant % frame_count;
 }
 
-Array<HoleData> hole_data;
+// scratch space, per thread since chunks get built in parallel, see chunk_mesh_builder
+thread_local Array<HoleData> hole_data;
 
-Array<WallFragment> fragdata;
-Array<WallFragment> corner_fragdata;
+thread_local Array<WallFragment> fragdata;
+thread_local Array<WallFragment> corner_fragdata;
+
+// neither copies a bptr, their counts aren't atomic
+bool has_wall_at_offset(chunk& c, local_coords pos, Vector2i off, bool is_west)
+{
+    auto t = c.at_offset(pos, off);
+    return t && t->chunk().wall_atlas_at(t->index()*2 + is_west);
+}
 
 template<Group_ G, bool IsWest>
 void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff& W,
@@ -229,6 +236,7 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
     const auto variant_2 = W.variants[k];
     const auto pos = local_coords{tile};
     const auto center = Vector3(point{c.coord(), pos, {}});
+    const auto origin = Quads::chunk_origin(c.coord());
     const auto& dir = A.calc_direction(D);
     const float depth_start = Render::get_status().is_clipdepth01_enabled ? 0.f : -1.f;
     const auto Depth = A.info().depth;
@@ -243,18 +251,18 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
 
         if constexpr(!IsWest)
         {
-            if (auto t = c.at_offset(pos, {-1, 0}); !(t && t->wall_north_atlas()))
+            if (!has_wall_at_offset(c, pos, {-1, 0}, false))
             {
                 if (W.atlases[k + 1]) // west on same tile
                     pillar_ok = true;
-                if (auto t = c.at_offset(pos, {0, -1}); t && t->wall_west_atlas())
+                if (has_wall_at_offset(c, pos, {0, -1}, true))
                     corner_ok = true;
             }
         }
         else
         {
-            if (auto t = c.at_offset(pos, {0, -1}); !(t && t->wall_west_atlas()))
-                if (auto t = c.at_offset(pos, {-1, 0}); t && t->wall_north_atlas())
+            if (!has_wall_at_offset(c, pos, {0, -1}, true))
+                if (has_wall_at_offset(c, pos, {-1, 0}, false))
                     corner_ok = true;
         }
 
@@ -296,7 +304,7 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
                     for (uint8_t j = 0; j < 4; j++)
                     {
                         const auto k = Quads::ccw_order[j];
-                        v[j] = {quad[k] + center, texcoords[k], depth[k]};
+                        v[j] = Quads::make_vertex(quad[k] + center, texcoords[k], depth[k], origin);
                     }
                     wsl.add(v, depth[0], nullptr);
                 }
@@ -366,7 +374,7 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
                     }
                     Quads::vertexes v;
                     for (uint8_t j = 0; j < 4; j++)
-                        v[j] = {quad[j] + center, texcoords[j], depth[j]};
+                        v[j] = Quads::make_vertex(quad[j] + center, texcoords[j], depth[j], origin);
                     wsl.add(v, depth[0], nullptr);
                 }
             }
@@ -437,7 +445,7 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
 
                 Quads::vertexes v;
                 for (uint8_t j = 0; j < 4; j++)
-                    v[j] = {quad[j] + center, texcoords[j], depth[j]};
+                    v[j] = Quads::make_vertex(quad[j] + center, texcoords[j], depth[j], origin);
                 wsl.add(v, depth[0], nullptr);
             }
             else if constexpr (G == Group_::side)
@@ -481,7 +489,7 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
 
                 Quads::vertexes v;
                 for (uint8_t j = 0; j < 4; j++)
-                    v[j] = {quad[j] + center, texcoords[j], depth[j]};
+                    v[j] = Quads::make_vertex(quad[j] + center, texcoords[j], depth[j], origin);
                 wsl.add(v, depth[0], nullptr);
             }
             else if constexpr (G == Group_::top)
@@ -533,7 +541,7 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
                 for (uint8_t j = 0; j < 4; j++)
                 {
                     const auto k = Quads::ccw_order[j];
-                    v[j] = {quad[k] + center, texcoords[k], depth[k]};
+                    v[j] = Quads::make_vertex(quad[k] + center, texcoords[k], depth[k], origin);
                 }
                 wsl.add(v, depth[0], nullptr);
             }
@@ -545,7 +553,7 @@ void do_wall_part(const Group& group, wall_atlas& A, chunk& c, chunk::wall_stuff
 
 } // namespace
 
-void chunk::ensure_wall_mesh(SpriteBatch& sb)
+void chunk::build_wall_mesh()
 {
     if (!_walls)
         return;
@@ -585,7 +593,17 @@ void chunk::ensure_wall_mesh(SpriteBatch& sb)
             }
         }
     }
-    sb.emit(wall_static_mesh, false);
 }
 
+void chunk::ensure_wall_mesh(SpriteBatch& sb)
+{
+    if (!_walls)
+        return;
+    ensure_passability();
+    build_wall_mesh();
+    sb.emit(wall_static_mesh, _coord, false);
+}
+
+wall_atlas* chunk::wall_atlas_at(size_t i) const noexcept { return _walls ? _walls->atlases[i].get() : nullptr; }
+
 } // namespace floormat
@@ -1,6 +1,10 @@
 #include "chunk.hpp"
 #include "chunk-iter.hpp"
 #include "object.hpp"
+#include "critter.hpp"
+#include "scenery.hpp"
+#include "light.hpp"
+#include "hole.hpp"
 #include "world.hpp"
 #include "log.hpp"
 #include "RTree.h"
@@ -18,6 +22,21 @@ constexpr auto object_id_lessp = [](const auto& a, const auto& b) { return a->id
 
 size_t _reload_no_ = 0; // NOLINT
 
+size_t object_size(const object& e)
+{
+    switch (e.type())
+    {
+    case object_type::none:
+    case object_type::COUNT:
+        break;
+    case object_type::critter: return sizeof(critter);
+    case object_type::light: return sizeof(light);
+    case object_type::hole: return sizeof(hole);
+    case object_type::scenery: return std::max(sizeof(generic_scenery), sizeof(door_scenery));
+    }
+    return sizeof(object);
+}
+
 } // namespace
 
 bool chunk::empty(bool force) const noexcept
@@ -33,6 +52,32 @@ bool chunk::empty(bool force) const noexcept
     return true;
 }
 
+void chunk::mark_maybe_empty() noexcept
+{
+    _maybe_empty = true;
+    if (!_collect_queued)
+    {
+        _collect_queued = true;
+        _world->queue_collect(this);
+    }
+}
+
+size_t chunk::memory_usage() const noexcept
+{
+    size_t ret = sizeof(chunk) + sizeof(RTree);
+    if (_ground)
+        ret += sizeof(ground_stuff);
+    if (_walls)
+        ret += sizeof(wall_stuff);
+    ret += arrayCapacity(non_const(_objects)) * sizeof(bptr<object>);
+    for (const auto& e : _objects)
+        ret += object_size(*e);
+    ret += ground_static_mesh.memory_usage() + wall_static_mesh.memory_usage() + scenery_static_mesh.memory_usage();
+    ret += arrayCapacity(non_const(static_clickables)) * sizeof(clickable);
+    ret += arrayCapacity(non_const(_static_occluders)) * sizeof(occluder_segment);
+    return ret;
+}
+
 ground_atlas* chunk::ground_atlas_at(size_t i) const noexcept { return _ground ? _ground->atlases[i].get() : nullptr; }
 
 tile_ref chunk::operator[](size_t idx) noexcept { return { *this, uint8_t(idx) }; }
@@ -118,6 +163,7 @@ chunk::chunk(class world& w, chunk_coords_ ch) noexcept :
     _pass_gen{w.next_pass_gen()}
 {
     _world->register_chunk(this);
+    mark_maybe_empty();
 }
 
 chunk::~chunk() noexcept
@@ -141,6 +187,7 @@ void chunk::sort_objects()
 void chunk::add_object_pre(const bptr<object>& e)
 {
     fm_assert(&*e->c == this);
+    _awake_count += e->awake;
     const bool dyn = e->is_dynamic();
     const bool upd_passability = e->updates_passability();
     const bool upd_walls = e->updates_walls();
@@ -195,6 +242,8 @@ void chunk::remove_object(size_t i)
     {
         auto& e = *eʹ;
         fm_assert(e.c == this);
+        fm_debug_assert(_awake_count >= e.awake);
+        _awake_count -= e.awake;
 
         const bool dyn = e.is_dynamic();
         const bool upd_passability = e.updates_passability();
@@ -215,6 +264,8 @@ void chunk::remove_object(size_t i)
 
     }
     arrayRemove(_objects, i);
+    if (_objects.isEmpty())
+        mark_maybe_empty();
 }
 
 const_objects_view chunk::objects() const
@@ -7,6 +7,8 @@
 #include "search-pred.hpp"
 #include "sprite-list.hpp"
 #include "pass-through.hpp"
+#include "main/clickable.hpp"
+#include "light-occluders.hpp"
 #include <array>
 #include <cr/Array.h>
 #include <cr/Pointer.h>
@@ -20,7 +22,6 @@ struct object;
 struct object_proto;
 class SpriteBatch;
 struct tile_shader;
-struct clickable;
 class const_objects_view;
 
 class chunk final
@@ -42,6 +43,8 @@ public:
     Optional<const_tile_ref> at_offset(const_tile_ref r, Vector2i off) const;
 
     bool empty(bool force = false) const noexcept;
+    // queues the chunk for world::collect() to check
+    void mark_maybe_empty() noexcept;
 
     explicit chunk(class world& w, chunk_coords_ ch) noexcept;
     ~chunk() noexcept;
@@ -66,17 +69,38 @@ public:
     void ensure_alloc_walls();
     void ensure_ground_mesh(SpriteBatch& sb);
     ground_atlas* ground_atlas_at(size_t i) const noexcept;
+    // `i` is tile index * 2, plus one for the west wall
+    wall_atlas* wall_atlas_at(size_t i) const noexcept;
     void ensure_wall_mesh(SpriteBatch& sb);
 
     SpriteList scenery_static_mesh;
     SpriteList wall_static_mesh;
     SpriteList ground_static_mesh;
+    // static scenery for clickable_index, filled along with the scenery mesh
+    // and sharing its generation. `dest` is relative to the projected world
+    // origin rather than the screen.
+    Array<clickable> static_clickables;
 
     void ensure_scenery_mesh(SpriteBatch& sb, bool render_vobjs);
-    void add_clickables(const tile_shader& shader, Vector2i win_size, Array<clickable>& array, bool draw_vobjs);
+
+    // The CPU half of ensure_*_mesh(): refill the static meshes above if
+    // they're stale, without emitting them. Different chunks can be built on
+    // different threads as long as their neighbors are resident, nothing
+    // else modifies the world and ensure_passability() has already run for
+    // the wall mesh, see chunk_mesh_builder.
+    void build_ground_mesh();
+    void build_wall_mesh();
+    void build_scenery_mesh();
+    bool needs_mesh_build() const noexcept;
 
     void ensure_passability() noexcept;
     uint64_t pass_gen() const noexcept;
+    // shadow casters for lightmap_shader, made again once pass_gen() changes
+    ArrayView<const occluder_segment> static_occluders();
+    // objects that aren't asleep, see object::sleep()
+    uint32_t awake_count() const noexcept;
+    // a rough estimate of the heap memory taken up by the chunk and its objects
+    size_t memory_usage() const noexcept;
     RTree* rtree() noexcept;
     const RTree* rtree() const noexcept;
     class world& world() noexcept;
@@ -85,7 +109,7 @@ public:
     [[nodiscard]] bool can_place_object(const object_proto& proto, local_coords pos);
     [[nodiscard]] static bool find_hole_in_bbox(Range2D& hole, const Chunk_RTree& rtree, Range2D bbox, pass_through_mask mask);
     using hole_callback = const fu2::function_view<void(Math::Range2D<float> hole, Math::Range1D<uint8_t> z) const>;
-    static void get_all_holes_in_bbox(const hole_callback& fn, chunk& c, Vector2 bb_min, Vector2 bb_max, pass_through_mask mask);
+    static void get_all_holes_in_bbox(const hole_callback& fn, const chunk& c, Vector2 bb_min, Vector2 bb_max, pass_through_mask mask);
 
     void on_teardown();
     bool is_teardown() const;
@@ -117,6 +141,9 @@ private:
     chunk* _prev = nullptr;
     chunk_coords_ _coord;
     uint64_t _pass_gen;
+    uint64_t _occluders_gen = 0;
+    Array<occluder_segment> _static_occluders;
+    uint32_t _awake_count = 0;
 
     mutable bool _maybe_empty      : 1 = true,
                  _ground_modified  : 1 = true,
@@ -124,7 +151,8 @@ private:
                  _scenery_modified : 1 = true,
                  _pass_modified    : 1 = true,
                  _teardown         : 1 = false,
-                 _objects_sorted   : 1 = true;
+                 _objects_sorted   : 1 = true,
+                 _collect_queued   : 1 = false;
 
     void add_object(const bptr<object>& e);
     void add_object_pre(const bptr<object>& e);
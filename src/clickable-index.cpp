@@ -0,0 +1,197 @@
+#include "clickable-index.hpp"
+#include "chunk.hpp"
+#include "object.hpp"
+#include "anim-atlas.hpp"
+#include "depth.hpp"
+#include "shaders/shader.hpp"
+#include "compat/assert.hpp"
+#include <algorithm>
+#include <utility>
+#include <cr/GrowableArray.h>
+#include <mg/Functions.h>
+
+namespace floormat {
+
+clickable clickable_index::make_clickable(object* obj)
+{
+    const auto& s = *obj;
+    const auto& a = *s.atlas;
+    const auto& g = a.group(s.r);
+    const auto& f = a.frame(s.r, s.frame);
+    const auto pos = Vector2i(Math::floor(tile_shader::project(Vector3(s.position()) + Vector3(g.offset)) - Vector2(f.ground)));
+    return clickable {
+        .src = {f.offset, f.offset + f.size},
+        .dest = {pos, pos + Vector2i(f.size)},
+        .bitmask = a.bitmask(),
+        .e = obj,
+        .stride = a.info().pixel_size[0],
+        .mirrored = !g.mirror_from.isEmpty(),
+    };
+}
+
+Vector2i clickable_index::screen_offset(Vector2d camera_offset, Vector2i win_size)
+{
+    return Vector2i(Math::floor(camera_offset + Vector2d(win_size)*.5));
+}
+
+void clickable_index::begin_frame(Vector2i offset, Vector2i win_size, bool draw_vobjs)
+{
+    if (offset != _offset || win_size != _win_size || draw_vobjs != _draw_vobjs)
+        _valid = false;
+    _offset = offset;
+    _win_size = win_size;
+    _draw_vobjs = draw_vobjs;
+
+    using std::swap;
+    swap(_chunks, _prev_chunks);
+    arrayClear(_chunks);
+    arrayClear(_frame_chunks);
+    arrayResize(_items, _static_count);
+    _stats = {};
+}
+
+void clickable_index::add_chunk(chunk& c)
+{
+    arrayAppend(_chunks, chunk_key{&c, c.scenery_static_mesh.generation});
+    arrayAppend(_frame_chunks, &c);
+
+    for (const auto& eʹ : c.objects())
+    {
+        auto& e = *eʹ;
+        if (!e.is_dynamic() || !_draw_vobjs && e.is_virtual())
+            continue;
+        auto x = make_clickable(&e);
+        x.dest = {x.dest.min() + _offset, x.dest.max() + _offset};
+        if (x.dest.min() < _win_size && x.dest.max() >= Vector2i())
+            arrayAppend(_items, x);
+    }
+}
+
+void clickable_index::end_frame()
+{
+    const auto dynamic_count = (uint32_t)_items.size() - _static_count;
+    if (!_valid || _chunks.size() != _prev_chunks.size() ||
+        !std::equal(_chunks.begin(), _chunks.end(), _prev_chunks.begin()))
+    {
+        // keep this frame's dynamic objects across the rebuild
+        Array<clickable> dynamic;
+        arrayAppend(dynamic, arrayView(_items).exceptPrefix(_static_count));
+        rebuild();
+        arrayAppend(_items, dynamic);
+    }
+    _stats.static_count = _static_count;
+    _stats.dynamic_count = dynamic_count;
+}
+
+void clickable_index::add_static(ArrayView<const clickable> list)
+{
+    for (auto x : list)
+    {
+        if (!_draw_vobjs && x.e->is_virtual())
+            continue;
+        x.dest = {x.dest.min() + _offset, x.dest.max() + _offset};
+        if (x.dest.min() < _win_size && x.dest.max() >= Vector2i())
+            arrayAppend(_items, x);
+    }
+}
+
+void clickable_index::rebuild()
+{
+    arrayClear(_items);
+    for (const auto* c : _frame_chunks)
+        add_static(c->static_clickables);
+    _static_count = (uint32_t)_items.size();
+
+    // counting sort of the static items into the cells they overlap
+    _cells = Math::max(Vector2i{1}, (_win_size + Vector2i{cell_size - 1}) / cell_size);
+    const auto cell_count = (uint32_t)(_cells.x() * _cells.y());
+    const auto cell_range = [this](const clickable& x) {
+        const auto min = Math::clamp(x.dest.min() / cell_size, Vector2i{}, _cells - Vector2i{1});
+        const auto max = Math::clamp((x.dest.max() - Vector2i{1}) / cell_size, Vector2i{}, _cells - Vector2i{1});
+        return std::pair{min, max};
+    };
+
+    arrayResize(_cell_start, NoInit, cell_count + 1);
+    for (auto& x : _cell_start)
+        x = 0;
+    for (auto i = 0u; i < _static_count; i++)
+    {
+        const auto [min, max] = cell_range(_items[i]);
+        for (auto y = min.y(); y <= max.y(); y++)
+            for (auto x = min.x(); x <= max.x(); x++)
+                _cell_start[(uint32_t)(y * _cells.x() + x) + 1]++;
+    }
+    for (auto i = 0u; i < cell_count; i++)
+        _cell_start[i+1] += _cell_start[i];
+
+    arrayResize(_cell_items, NoInit, _cell_start[cell_count]);
+    for (auto i = 0u; i < _static_count; i++)
+    {
+        const auto [min, max] = cell_range(_items[i]);
+        for (auto y = min.y(); y <= max.y(); y++)
+            for (auto x = min.x(); x <= max.x(); x++)
+                _cell_items[_cell_start[(uint32_t)(y * _cells.x() + x)]++] = i;
+    }
+    // each start got moved to the next cell's
+    for (auto i = cell_count; i > 0; i--)
+        _cell_start[i] = _cell_start[i-1];
+    _cell_start[0] = 0;
+
+    _valid = true;
+    _stats.rebuilt = true;
+}
+
+void clickable_index::clear()
+{
+    arrayClear(_items);
+    arrayClear(_cell_items);
+    arrayClear(_chunks);
+    arrayClear(_prev_chunks);
+    arrayClear(_frame_chunks);
+    _static_count = 0;
+    _valid = false;
+}
+
+bool clickable_index::hit(const clickable& c, Vector2i pixel)
+{
+    if (!c.dest.contains(pixel))
+        return false;
+    // mirror inside the frame, before adding the frame's atlas offset
+    const auto posʹ = pixel - c.dest.min();
+    const auto posʹʹ = !c.mirrored ? posʹ : Vector2i(int(c.src.sizeX()) - 1 - posʹ[0], posʹ[1]);
+    const auto pos = posʹʹ + Vector2i(c.src.min());
+    size_t idx = unsigned(pos.y()) * c.stride + unsigned(pos.x());
+    fm_assert(c.bitmask.isEmpty() || idx < c.bitmask.size());
+    return c.bitmask.isEmpty() || c.bitmask[idx];
+}
+
+clickable* clickable_index::pick(Vector2i pixel)
+{
+    clickable* item = nullptr;
+    uint32_t depth = 0;
+    const auto test = [&](clickable& c) {
+        const uint32_t d = Depth::value_atʹ(c.e->position());
+        if (d > depth && hit(c, pixel))
+        {
+            depth = d;
+            item = &c;
+        }
+    };
+
+    if (_valid && pixel >= Vector2i() && pixel < _win_size)
+    {
+        const auto cell = (uint32_t)(pixel.y() / cell_size * _cells.x() + pixel.x() / cell_size);
+        for (auto i = _cell_start[cell]; i < _cell_start[cell+1]; i++)
+            test(_items[_cell_items[i]]);
+    }
+    for (auto i = _static_count; i < _items.size(); i++)
+        test(_items[i]);
+
+    return item;
+}
+
+ArrayView<clickable> clickable_index::items() { return _items; }
+ArrayView<const clickable> clickable_index::items() const { return _items; }
+const clickable_index_stats& clickable_index::stats() const { return _stats; }
+
+} // namespace floormat
@@ -0,0 +1,66 @@
+#pragma once
+#include "main/clickable.hpp"
+#include <cr/Array.h>
+#include <mg/Vector2.h>
+
+namespace floormat {
+
+class chunk;
+
+struct clickable_index_stats
+{
+    // in the last end_frame()
+    uint32_t static_count = 0, dynamic_count = 0;
+    bool rebuilt = false;
+};
+
+// Screen-space lookup for the objects under the mouse cursor. Static
+// scenery comes from each chunk's `static_clickables`, filled together with
+// its scenery mesh, and only gets placed on screen and binned into a grid of
+// `cell_size` pixels once the camera, the window or a chunk's scenery
+// changes. Dynamic objects are few and get redone every frame.
+class clickable_index final
+{
+    struct chunk_key
+    {
+        const chunk* c;
+        uint64_t generation;
+        bool operator==(const chunk_key&) const = default;
+    };
+
+    Array<clickable> _items;                // static ones first
+    Array<uint32_t> _cell_start, _cell_items;
+    Array<chunk_key> _chunks, _prev_chunks;
+    Array<const chunk*> _frame_chunks;
+    Vector2i _offset, _win_size, _cells;
+    uint32_t _static_count = 0;
+    clickable_index_stats _stats;
+    bool _draw_vobjs : 1 = false,
+         _valid      : 1 = false;
+
+    void rebuild();
+    void add_static(ArrayView<const clickable> list);
+    static bool hit(const clickable& c, Vector2i pixel);
+
+public:
+    static constexpr int cell_size = 64;
+
+    // `offset` is where the projected world origin ends up on screen
+    void begin_frame(Vector2i offset, Vector2i win_size, bool draw_vobjs);
+    void add_chunk(chunk& c);
+    void end_frame();
+    // forgets everything, for when the chunks get freed
+    void clear();
+
+    // topmost object whose sprite isn't transparent at `pixel`
+    clickable* pick(Vector2i pixel);
+    ArrayView<clickable> items();
+    ArrayView<const clickable> items() const;
+    const clickable_index_stats& stats() const;
+
+    static Vector2i screen_offset(Vector2d camera_offset, Vector2i win_size);
+    // with `dest` relative to the projected world origin
+    static clickable make_clickable(object* obj);
+};
+
+} // namespace floormat
@@ -5,7 +5,10 @@
 #include "critter.hpp"
 #include "search-result.hpp"
 #include "search-astar.hpp"
+#include "search-dstar.hpp"
+#include "world.hpp"
 #include "entity/name-of.hpp"
+#include <mg/Functions.h>
 #include <utility>
 
 namespace floormat {
@@ -19,25 +22,35 @@ using psr = path_search_result;
 
 struct walk_script final : critter_script
 {
-    enum class walk_mode : uint8_t { none, line, path, };
+    enum class walk_mode : uint8_t { none, line, path, replan, };
+    struct replan_tag {};
+
+    // consecutive blocked moves with nothing changed in the pass grid before giving up
+    static constexpr uint8_t max_replan_tries = 8;
 
     StringView name() const override;
     const void* id() const override;
     void on_init(const bptr<critter>& c) override;
     void on_update(const bptr<critter>& c, size_t& i, const Ns& dt) override;
+    void on_update_coarse(const bptr<critter>& c, size_t& i, const Ns& dt) override;
     void on_destroy(const bptr<critter>& c, script_destroy_reason reason) override;
     void delete_self() noexcept override;
 
     explicit walk_script(point dest);
     explicit walk_script(psr path);
+    walk_script(point dest, replan_tag);
 
     bool walk_line(const bptr<critter>& c, size_t& i, const Ns& dt);
     bool walk_path(const bptr<critter>& c, size_t& i, const Ns& dt);
+    bool walk_replan(const bptr<critter>& c, size_t& i, const Ns& dt);
+    bool walk_path_coarse(const bptr<critter>& c, size_t& i, const Ns& dt);
 
 private:
     point dest;
     psr path;
+    Pointer<dstar_lite> planner;
     uint32_t path_index = -1u;
+    uint8_t replan_tries = 0;
     walk_mode mode = failwith<walk_mode>("walk_mode not set");
 };
 
@@ -59,6 +72,15 @@ void walk_script::on_init(const bptr<critter>& c)
         fm_assert(!path.empty());
         dest = path.path().back();
         break;
+    case walk_mode::replan: {
+        constexpr auto chunk_size = iTILE_SIZE2 * TILE_MAX_DIM;
+        const auto vec = Math::abs(dest - c->position()) * 2 + chunk_size;
+        planner->reset(c->world(), c->position(), dest, (uint32_t)vec.length(),
+                       Vector2ui{c->bbox_size}, Search::without_critters());
+        path = planner->plan(c->world());
+        path_index = 0;
+        break;
+    }
     default:
         fm_assert(false);
     }
@@ -80,6 +102,10 @@ void walk_script::on_update(const bptr<critter>& c, size_t& i, const Ns& dt)
         if (walk_path(c, i, dt))
             goto done;
         return;
+    case walk_mode::replan:
+        if (walk_replan(c, i, dt))
+            goto done;
+        return;
     case walk_mode::none:
         break;
     }
@@ -92,6 +118,21 @@ done:
     c->script.do_clear(c);
 }
 
+void walk_script::on_update_coarse(const bptr<critter>& c, size_t& i, const Ns& dt)
+{
+    // a straight line was never searched, and a replanning walker without a
+    // path has to plan first, so only follow a path that's already there
+    if (mode == walk_mode::line || path.empty() || c->maybe_stop_auto_movement())
+        return on_update(c, i, dt);
+
+    if (walk_path_coarse(c, i, dt))
+    {
+        Debug{} << "  finished walking";
+        c->clear_auto_movement();
+        c->script.do_clear(c);
+    }
+}
+
 walk_script::walk_script(point dest) : dest{dest}, mode{walk_mode::line} {}
 
 walk_script::walk_script(psr pathʹ) :
@@ -103,6 +144,14 @@ walk_script::walk_script(psr pathʹ) :
     fm_assert(!path.empty());
 }
 
+walk_script::walk_script(point dest, replan_tag) :
+    dest{dest},
+    planner{InPlaceInit},
+    path_index{0},
+    mode{walk_mode::replan}
+{
+}
+
 bool walk_script::walk_line(const bptr<critter>& c, size_t& i, const Ns& dtʹ)
 {
     auto dt = dtʹ;
@@ -127,9 +176,63 @@ bool walk_script::walk_path(const bptr<critter>& c, size_t& i, const Ns& dtʹ)
     return false;
 }
 
+bool walk_script::walk_path_coarse(const bptr<critter>& c, size_t& i, const Ns& dtʹ)
+{
+    auto dt = dtʹ;
+    while (dt != Ns{})
+    {
+        while (path_index < path.size() && c->position() == path.path()[path_index])
+            path_index++;
+        if (path_index == path.size())
+            return true;
+        point cur = path.path()[path_index];
+        auto ret = c->move_toward_coarse(i, dt, cur);
+        if (!ret.moved)
+            return false;
+    }
+    return false;
+}
+
+bool walk_script::walk_replan(const bptr<critter>& c, size_t& i, const Ns& dtʹ)
+{
+    auto& w = c->world();
+    planner->set_start(c->position());
+    if (planner->sync(w) || path.empty())
+    {
+        path = planner->plan(w);
+        path_index = 0;
+        if (path.empty())
+            return true;
+    }
+
+    auto dt = dtʹ;
+    while (dt != Ns{})
+    {
+        while (path_index < path.size() && c->position() == path.path()[path_index])
+            path_index++;
+        if (path_index == path.size())
+            return true;
+        point cur = path.path()[path_index];
+        auto ret = c->move_toward(i, dt, cur);
+        if (ret.blocked)
+        {
+            // retry against the repaired search tree next tick. whatever is in
+            // the way may not be in the pass grid (e.g. critters), so give up
+            // if nothing keeps changing.
+            path = {};
+            return ++replan_tries > max_replan_tries;
+        }
+        if (!ret.moved)
+            return false;
+        replan_tries = 0;
+    }
+    return false;
+}
+
 } // namespace
 
 ScriptPtr critter_script::make_walk_script(point dest) { return ScriptPtr(new walk_script{dest}); }
 ScriptPtr critter_script::make_walk_script(psr path)   { return ScriptPtr(new walk_script{move(path)}); }
+ScriptPtr critter_script::make_replanning_walk_script(point dest) { return ScriptPtr(new walk_script{dest, walk_script::replan_tag{}}); }
 
 } // namespace floormat
@@ -4,4 +4,6 @@ namespace floormat {
 
 object_type critter_script::type() const { return object_type::critter; }
 
+void critter_script::on_update_coarse(const bptr<critter>& c, size_t& i, const Ns& dt) { on_update(c, i, dt); }
+
 } // namespace floormat
@@ -17,6 +17,9 @@ struct critter_script : base_script
 
     virtual void on_init(const bptr<critter>& c) = 0;
     virtual void on_update(const bptr<critter>& c, size_t& i, const Ns& dt) = 0;
+    // called instead of on_update() far from the camera. may cut corners, e.g.
+    // skip collision checks along a path found earlier. defaults to on_update().
+    virtual void on_update_coarse(const bptr<critter>& c, size_t& i, const Ns& dt);
     virtual void on_destroy(const bptr<critter>& c, script_destroy_reason reason) = 0;
     virtual void delete_self() = 0;
 
@@ -24,6 +27,8 @@ struct critter_script : base_script
 
     static Pointer<critter_script> make_walk_script(point to);
     static Pointer<critter_script> make_walk_script(path_search_result path);
+    // keeps a D* Lite search per walker and repairs it when the pass grid changes
+    static Pointer<critter_script> make_replanning_walk_script(point to);
 };
 
 } // namespace floormat
@@ -136,18 +136,38 @@ sweep_result sweep_critter(critter& C, Vector2 displacement)
     return find_swept_collider(C.chunk(), critter_bbox_local(C), displacement, pred);
 }
 
+sweep_result sweep_critter_earliest(critter& C, Vector2 displacement)
+{
+    const auto self_id = C.id;
+    auto pred = [self_id](class chunk&, collision_data x, Range2D) {
+        return x.id == self_id ? path_search_continue::pass : path_search_continue::blocked;
+    };
+    return find_earliest_swept_collider(C.chunk(), critter_bbox_local(C), displacement, pred);
+}
+
 enum class step_result : uint8_t { blocked, moved, accumulated };
 
-void advance_anim_frames(critter& C, uint32_t nsteps, float anim_speed, uint32_t nframes_atlas)
+uint64_t anim_advance(uint32_t nsteps, float anim_speed)
 {
     fm_debug_assert(anim_speed >= 0 && anim_speed <= 64);
-    const auto adv = uint64_t(float(nsteps) * anim_speed * float(anim_speed_unit));
+    return uint64_t(float(nsteps) * anim_speed * float(anim_speed_unit));
+}
+
+// progress carries over, so applying a sum of advances is the same as
+// applying them one at a time
+void apply_anim_advance(critter& C, uint64_t adv, uint32_t nframes_atlas)
+{
     const auto total = uint64_t(C.anim_progress) + adv;
     const auto whole = uint32_t(total / anim_speed_unit);
     C.anim_progress = uint32_t(total % anim_speed_unit);
     C.frame = uint16_t((uint32_t(C.frame) + whole) % nframes_atlas);
 }
 
+void advance_anim_frames(critter& C, uint32_t nsteps, float anim_speed, uint32_t nframes_atlas)
+{
+    apply_anim_advance(C, anim_advance(nsteps, anim_speed), nframes_atlas);
+}
+
 // offset_frac: scalar magnitude of pending sub-pixel motion.
 // update_movement clears on stuck so alternatives()' alt-direction isZero writes don't leak.
 step_result update_movement_body(size_t& i, critter& C, const anim_def& info, uint32_t nsteps, rotation new_r, rotation visible_r)
@@ -284,6 +304,72 @@ Ns return_unspent_dt(uint32_t nframes, float speed, Ns frame_duration)
     return Ns{(uint64_t)((double)(uint64_t)(nframes * frame_duration) / (double)speed)};
 }
 
+struct toward_step
+{
+    Vector2i off_i;
+    uint32_t nsteps;
+    uint16_t offset_frac;
+};
+
+// one iteration of move_toward()'s loop, minus the sweep and the move
+toward_step plan_toward_step(step_s step, rotation new_r, uint32_t nframes, uint16_t offset_frac)
+{
+    // Max steps for the operation to avoid overshooting
+    constexpr uint32_t len_limit = tile_size_xy;
+    const auto nsteps = (uint8_t)Math::min({nframes, step.count, len_limit});
+    fm_assert(nsteps > 0);
+    using Frac = decltype(critter::offset_frac);
+    constexpr auto frac = (float{limits<Frac>::max}+1)/2;
+    constexpr auto inv_frac = 1 / frac;
+    const auto vec = rotation_to_vec(new_r);
+    const auto from_accum = (float)offset_frac * inv_frac * vec;
+    const auto offset_ = vec * float(nsteps) + from_accum;
+    // Clamp to movement budget consumed this iteration
+    const auto abs_limit = Vector2i(Math::abs(step.direction)) * int(nsteps);
+    const auto off_i = Math::clamp(Vector2i(offset_), -abs_limit, abs_limit);
+    const auto rem_vec = offset_ - Vector2(off_i);
+    const auto rem_frac = Math::clamp(rem_vec.length() * frac, 0.f, float(limits<Frac>::max));
+    return { off_i, nsteps, Frac(rem_frac) };
+}
+
+struct straight_run
+{
+    Vector2i delta;
+    uint64_t anim_adv = 0;
+    uint32_t nframes;
+    uint16_t offset_frac;
+};
+
+// Replays the loop's bookkeeping along the current straight leg without
+// sweeping. Stops at `dest`, where the direction changes, when the frames
+// run out, or before the displacement gets longer than `max_len` on an axis.
+straight_run plan_straight_run(point from, const point& dest, rotation r, uint32_t nframes,
+                               uint16_t offset_frac, float anim_speed, int32_t max_len)
+{
+    straight_run run{ {}, 0, nframes, offset_frac };
+    while (run.nframes > 0)
+    {
+        const auto pos = from + run.delta;
+        if (pos == dest)
+            break;
+        const auto step = next_step(pos, dest);
+        if (dir_from_step(step) != r)
+            break;
+        const auto st = plan_toward_step(step, r, run.nframes, run.offset_frac);
+        if (!st.off_i.isZero())
+        {
+            const auto delta = run.delta + st.off_i;
+            if (Math::max(Math::abs(delta.x()), Math::abs(delta.y())) > max_len)
+                break;
+            run.delta = delta;
+            run.anim_adv += anim_advance(st.nsteps, anim_speed);
+        }
+        run.offset_frac = st.offset_frac;
+        run.nframes -= st.nsteps;
+    }
+    return run;
+}
+
 } // namespace
 
 extern template class Script<critter, critter_script>;
@@ -311,8 +397,14 @@ bool critter_proto::operator==(const object_proto& e0) const
            && Math::abs(anim_speed - s0.anim_speed) < 1e-8f && playable == s0.playable;
 }
 
-void critter::set_keys(bool L, bool R, bool U, bool D) { moves = { L, R, U, D, moves.AUTO, }; }
-void critter::set_keys_auto() { moves_ = m_auto_mask.val; }
+void critter::set_keys(bool L, bool R, bool U, bool D)
+{
+    moves = { L, R, U, D, moves.AUTO, };
+    if (moves_)
+        wake();
+}
+
+void critter::set_keys_auto() { moves_ = m_auto_mask.val; wake(); }
 void critter::clear_auto_movement() { moves_ &= ~m_auto_mask.val; }
 bool critter::maybe_stop_auto_movement()
 {
@@ -351,6 +443,21 @@ void critter::update(const bptr<object>& ptrʹ, size_t& i, const Ns& dt)
                 update_movement(i, dt, new_r);
         }
     }
+
+    // set_keys() and assigning a script wake it up again
+    if (!moves_ && script.is_empty())
+        sleep();
+}
+
+void critter::update_coarse(const bptr<object>& ptrʹ, size_t& i, const Ns& dt)
+{
+    fm_debug_assert(&*ptrʹ == this);
+
+    if (playable) [[unlikely]]
+        return update(ptrʹ, i, dt);
+
+    check_script_update_1(script.state());
+    script->on_update_coarse(static_pointer_cast<critter>(ptrʹ), i, dt);
 }
 
 void critter::update_movement(size_t& i, const Ns& dt, rotation new_r)
@@ -385,7 +492,7 @@ void critter::update_movement(size_t& i, const Ns& dt, rotation new_r)
     }
 }
 
-auto critter::move_toward(size_t& index, Ns& dt, const point& dest) -> move_result
+auto critter::move_toward(size_t& index, Ns& dt, const point& dest, move_mode mode) -> move_result
 {
     fm_assert(is_dynamic());
     fm_assert(bbox_size.x() && bbox_size.y());
@@ -426,23 +533,39 @@ auto critter::move_toward(size_t& index, Ns& dt, const point& dest) -> move_resu
         //Debug{} << "step" << step.direction << step.count << "|" << C.position();
         fm_assert(step.direction != Vector2b{} && step.count > 0);
         const auto new_r = dir_from_step(step);
-        // Max steps for the operation to avoid overshooting
-        constexpr uint32_t len_limit = tile_size_xy;
-        const auto nsteps = (uint8_t)Math::min({nframes, step.count, len_limit});
-        fm_assert(nsteps > 0);
-        using Frac = decltype(critter::offset_frac);
-        constexpr auto frac = (float{limits<Frac>::max}+1)/2;
-        constexpr auto inv_frac = 1 / frac;
-        const auto vec = rotation_to_vec(new_r);
-        const auto from_accum = (float)offset_frac * inv_frac * vec;
-        const auto offset_ = vec * float(nsteps) + from_accum;
-        // Clamp to movement budget consumed this iteration
-        const auto abs_limit = Vector2i(Math::abs(step.direction)) * int(nsteps);
-        const auto off_i = Math::clamp(Vector2i(offset_), -abs_limit, abs_limit);
-        //Debug{} << "vec" << vec << "mag" << mag << "off_i" << off_i << "offset_" << C.offset_frac_;
-        const auto rem_vec = offset_ - Vector2(off_i);
-        const auto rem_frac = Math::clamp(rem_vec.length() * frac, 0.f, float(limits<Frac>::max));
-        offset_frac = Frac(rem_frac);
+
+        // Sweep the rest of the straight leg at once. Every step of it lies on
+        // the swept segment, so whatever ends a pixel short of the first contact
+        // would have been clear one step at a time as well. A rotation changes
+        // the bbox between the sweep and the move; leave that step to the loop.
+        if (mode == move_mode::analytic && new_r == r)
+        {
+            // stay within the neighbors the sweep searches
+            constexpr int32_t max_len = TILE_MAX_DIM * tile_size_xy / 2;
+            auto run = plan_straight_run(from, dest, new_r, nframes, offset_frac, anim_speed, max_len);
+            if (!run.delta.isZero())
+            {
+                const auto sw = sweep_critter_earliest(*this, Vector2(run.delta));
+                if (sw.has_collider)
+                {
+                    const auto len = Math::max(Math::abs(run.delta.x()), Math::abs(run.delta.y()));
+                    const auto safe_len = (int32_t)(sw.time * (float)len) - 1;
+                    run = plan_straight_run(from, dest, new_r, nframes, offset_frac, anim_speed, safe_len);
+                }
+                if (!run.delta.isZero() && move_to(index, run.delta, new_r))
+                {
+                    moved = true;
+                    apply_anim_advance(*this, run.anim_adv, info.nframes);
+                    offset_frac = run.offset_frac;
+                    nframes = run.nframes;
+                    continue;
+                }
+            }
+        }
+
+        const auto [off_i, nsteps, frac_] = plan_toward_step(step, new_r, nframes, offset_frac);
+        //Debug{} << "off_i" << off_i << "offset_frac" << frac_;
+        offset_frac = frac_;
 
         //DBG << "nsteps" << nsteps;
         nframes -= nsteps;
@@ -480,6 +603,58 @@ auto critter::move_toward(size_t& index, Ns& dt, const point& dest) -> move_resu
     return { .blocked = false, .moved = moved };
 }
 
+auto critter::move_toward_coarse(size_t& index, Ns& dt, const point& dest) -> move_result
+{
+    fm_assert(is_dynamic());
+
+    if (speed == 0) [[unlikely]]
+    {
+        dt = Ns{};
+        return {.blocked = position() != dest, .moved = false};
+    }
+
+    const auto& info = atlas->info();
+    const auto hz = info.fps;
+    constexpr auto ns_in_sec = Ns((int)1e9);
+    const auto frame_duration = ns_in_sec / hz;
+    auto nframes = alloc_frame_time(dt, delta, hz, speed);
+    dt = Ns{};
+
+    // move_toward()'s loop without the sweep, moving only once at the end
+    auto pos = position();
+    auto new_r = r;
+    uint64_t anim_adv = 0;
+    bool moved = false;
+    while (nframes > 0)
+    {
+        if (pos == dest)
+        {
+            offset_frac = {};
+            break;
+        }
+        const auto step = next_step(pos, dest);
+        const auto step_r = dir_from_step(step);
+        const auto [off_i, nsteps, frac_] = plan_toward_step(step, step_r, nframes, offset_frac);
+        offset_frac = frac_;
+        nframes -= nsteps;
+        if (!off_i.isZero())
+        {
+            pos = pos + off_i;
+            new_r = step_r;
+            anim_adv += anim_advance(nsteps, anim_speed);
+            moved = true;
+        }
+    }
+    dt = return_unspent_dt(nframes, speed, frame_duration);
+
+    if (!moved)
+        return { .blocked = false, .moved = false };
+
+    teleport_to(index, pos, new_r);
+    apply_anim_advance(*this, anim_adv, info.nframes);
+    return { .blocked = false, .moved = true };
+}
+
 object_type critter::type() const noexcept { return object_type::critter; }
 
 critter::operator critter_proto() const
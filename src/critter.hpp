@@ -33,10 +33,19 @@ struct critter final : object
     explicit operator critter_proto() const;
 
     void update(const bptr<object>& ptr, size_t& i, const Ns& dt) override;
+    // for far-away critters, see sim_lod
+    void update_coarse(const bptr<object>& ptr, size_t& i, const Ns& dt);
     void update_movement(size_t& i, const Ns& dt, rotation r);
 
     struct move_result { bool blocked, moved; };
-    [[nodiscard]] move_result move_toward(size_t& i, Ns& dt, const point& dest);
+    // analytic sweeps each straight leg once and steps only near obstacles;
+    // per_step sweeps every step. both end in the same state. analytic is
+    // opt-in, callers get the per-step loop unless they ask for it.
+    enum class move_mode : uint8_t { per_step, analytic, };
+    [[nodiscard]] move_result move_toward(size_t& i, Ns& dt, const point& dest, move_mode mode = move_mode::per_step);
+    // same pace as move_toward() but teleports without any collision checks;
+    // only for following a path that's already known to be clear.
+    [[nodiscard]] move_result move_toward_coarse(size_t& i, Ns& dt, const point& dest);
 
     int32_t depth_offset() const override;
 
@@ -4,11 +4,18 @@
 #include "object.hpp"
 #include "world.hpp"
 #include "raycast.hpp"
+#include "raycast-snapshot.hpp"
+#include "timer.hpp"
 #include "point.inl"
 #include "compat/function2.hpp"
 #include <cfloat>
 #include <array>
+#include <bit>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <cr/Array.h>
+#include <cr/GrowableArray.h>
 #include <mg/Functions.h>
 #include <mg/Timeline.h>
 #include <gtl/phmap.hpp>
@@ -58,15 +65,15 @@ constexpr std::array<uint8_t, octant_count> octant_order = {
     17, 18, 19, 21, 22, 23, 25, 26, 27, 29, 30, 31,
 };
 
-uint8_t raycast_one(chunk& self,
+template<typename Cast>
+uint8_t raycast_one(chunk_coords_ coord,
                     uint32_t cell_x, uint32_t cell_y,
                     uint32_t div_size, uint32_t octant,
-                    Pass::Pool& pass_pool,
+                    const Cast& cast,
                     uint32_t max_ray_px = chunk_size_xy)
 {
     fm_assert(div_size > 0);
     fm_assert(chunk_size_xy % div_size == 0);
-    fm_assert(pass_pool.params().div_size == div_size);
     fm_debug_assert(octant < octant_count);
     fm_debug_assert(cell_x < chunk_size_xy / div_size);
     fm_debug_assert(cell_y < chunk_size_xy / div_size);
@@ -78,7 +85,7 @@ uint8_t raycast_one(chunk& self,
     };
 
     const point chunk_nw{
-        self.coord(),
+        coord,
         local_coords{0, 0},
         Vector2b{(int8_t)(-tile_size_xy/2), (int8_t)(-tile_size_xy/2)},
     };
@@ -88,7 +95,7 @@ uint8_t raycast_one(chunk& self,
     const Vector2i delta{Vector2(dir * (float)max_ray_px)};
     const point to = from + delta;
 
-    const auto r = raycast(self.world(), from, to, 0, pass_pool, can_shoot_through);
+    const auto r = cast(from, to);
 
     uint32_t dist_px;
     if (!r.has_result || r.success)
@@ -100,72 +107,15 @@ uint8_t raycast_one(chunk& self,
     return (uint8_t)Math::min<uint32_t>(units, 255);
 }
 
-} // namespace
-
-struct CoverGrid : GridBase
+// Writes octant k of every cell. `pass_bits` is the chunk's own pass grid
+// bitmap and `cast` raycasts with the cover predicate, either against the
+// world or against a raycast_snapshot, so the main thread and the workers
+// share this code.
+template<typename Cast>
+void fill_cells(uint32_t k, uint32_t div_size, chunk_coords_ coord,
+                const uint8_t* pass_bits, const Cast& cast,
+                ArrayView<CoverCell> cells)
 {
-    using Params = Grid::Cover::Params;
-
-    Params params;
-    Array<CoverCell> cells;
-    uint32_t built_octants = 0;
-
-    CoverGrid(chunk& c, Params params);
-    ~CoverGrid() noexcept = default;
-
-    void reset_for_reuse(chunk& ch, Params new_params);
-    void clear_cells();
-
-    static uint32_t get_cell_index(uint32_t x, uint32_t y, uint32_t div_count);
-    uint32_t get_cell_index_from_coord(local_coords local, Vector2b offset) const;
-
-    void build_impl(chunk* self);
-    bool fill_octant(uint32_t k, chunk& self);
-    bool fill_next_unfilled(chunk& self);
-};
-
-uint32_t CoverGrid::get_cell_index(uint32_t x, uint32_t y, uint32_t div_count)
-{
-    return GridBase::pack_bit_index(x, y, div_count);
-}
-
-uint32_t CoverGrid::get_cell_index_from_coord(local_coords local, Vector2b offset) const
-{
-    const auto dc = chunk_size_xy / params.div_size;
-    return GridBase::pack_bit_index_from_coord(local, offset, params.div_size, dc);
-}
-
-void CoverGrid::clear_cells()
-{
-    for (auto& cc : cells)
-        for (auto& d : cc.distance)
-            d = 0;
-}
-
-void CoverGrid::build_impl(chunk* self)
-{
-    built_octants = 0;
-    // else a rebuild serves the previous build's octants 1..31 until re-filled
-    clear_cells();
-    fill_octant(0, *self);
-
-    for (auto i = 0u; i < 8; i++)
-        versions[i] = neighbors[i] ? neighbors[i]->pass_gen() : (uint64_t)-1;
-    versions[8] = self->pass_gen();
-}
-
-bool CoverGrid::fill_octant(uint32_t k, chunk& self)
-{
-    fm_debug_assert(k < octant_count);
-    if (built_octants & (1u << k))
-        return false;
-
-    auto& pass_pool = w->cover_pass_pool();
-    pass_pool.maybe_mark_stale_all(w->frame_no());
-    Timeline timeline;
-    timeline.start();
-
-    const uint32_t div_size = params.div_size;
     const uint32_t dc = chunk_size_xy / div_size;
 
     const auto dir = direction_for_octant(k);
@@ -187,9 +137,6 @@ bool CoverGrid::fill_octant(uint32_t k, chunk& self)
         else if (sy == 0)    { sk = sk_x;    step_t = t_delta_x; }
         else                 { sk = sk_diag; step_t = t_delta_x; }
 
-        auto pass_grid = pass_pool[self];
-        pass_grid.build_if_stale(can_shoot_through);
-
         Array<uint16_t> px_dist{ValueInit, dc * dc};
 
         const int32_t dc_i = (int32_t)dc;
@@ -199,10 +146,11 @@ bool CoverGrid::fill_octant(uint32_t k, chunk& self)
             for (int32_t x_idx = 0; x_idx < dc_i; ++x_idx)
             {
                 const int32_t cx = sx > 0 ? dc_i - 1 - x_idx : x_idx;
-                const uint32_t idx = get_cell_index((uint32_t)cx, (uint32_t)cy, dc);
+                const uint32_t idx = GridBase::pack_bit_index((uint32_t)cx, (uint32_t)cy, dc);
 
                 const auto bit_idx = Pass::Grid::get_bitmask_index((uint32_t)cx, (uint32_t)cy, dc);
-                const bool passable = pass_grid.bit(bit_idx);
+                // same layout as BitView::read()
+                const bool passable = pass_bits[bit_idx >> 3] >> (bit_idx & 7) & 1;
 
                 uint32_t dist_px;
                 if (!passable)
@@ -219,13 +167,13 @@ bool CoverGrid::fill_octant(uint32_t k, chunk& self)
 
                     if (nx >= 0 && nx < dc_i && ny >= 0 && ny < dc_i)
                     {
-                        const uint32_t n_idx = get_cell_index((uint32_t)nx, (uint32_t)ny, dc);
+                        const uint32_t n_idx = GridBase::pack_bit_index((uint32_t)nx, (uint32_t)ny, dc);
                         // round: truncating div_size*sqrt2 loses ~2.8% per diagonal step
                         dist_px = (uint32_t)px_dist[n_idx] + (uint32_t)(step_t + .5f);
                     }
                     else
                     {
-                        const auto u = raycast_one(self, (uint32_t)cx, (uint32_t)cy, div_size, k, pass_pool);
+                        const auto u = raycast_one(coord, (uint32_t)cx, (uint32_t)cy, div_size, k, cast);
                         dist_px = (uint32_t)u * div_size;
                     }
                 }
@@ -243,10 +191,85 @@ bool CoverGrid::fill_octant(uint32_t k, chunk& self)
         for (uint32_t cy = 0; cy < dc; ++cy)
             for (uint32_t cx = 0; cx < dc; ++cx)
             {
-                const auto idx = get_cell_index(cx, cy, dc);
-                cells[idx].distance[k] = raycast_one(self, cx, cy, div_size, k, pass_pool);
+                const auto idx = GridBase::pack_bit_index(cx, cy, dc);
+                cells[idx].distance[k] = raycast_one(coord, cx, cy, div_size, k, cast);
             }
     }
+}
+
+} // namespace
+
+struct CoverGrid : GridBase
+{
+    using Params = Grid::Cover::Params;
+
+    Params params;
+    Array<CoverCell> cells;
+    uint32_t built_octants = 0;
+
+    CoverGrid(chunk& c, Params params);
+    ~CoverGrid() noexcept = default;
+
+    void reset_for_reuse(chunk& ch, Params new_params);
+    void clear_cells();
+
+    static uint32_t get_cell_index(uint32_t x, uint32_t y, uint32_t div_count);
+    uint32_t get_cell_index_from_coord(local_coords local, Vector2b offset) const;
+
+    void build_impl(chunk* self);
+    bool fill_octant(uint32_t k, chunk& self);
+    bool fill_next_unfilled(chunk& self);
+};
+
+uint32_t CoverGrid::get_cell_index(uint32_t x, uint32_t y, uint32_t div_count)
+{
+    return GridBase::pack_bit_index(x, y, div_count);
+}
+
+uint32_t CoverGrid::get_cell_index_from_coord(local_coords local, Vector2b offset) const
+{
+    const auto dc = chunk_size_xy / params.div_size;
+    return GridBase::pack_bit_index_from_coord(local, offset, params.div_size, dc);
+}
+
+void CoverGrid::clear_cells()
+{
+    for (auto& cc : cells)
+        for (auto& d : cc.distance)
+            d = 0;
+}
+
+void CoverGrid::build_impl(chunk* self)
+{
+    built_octants = 0;
+    // else a rebuild serves the previous build's octants 1..31 until re-filled
+    clear_cells();
+    fill_octant(0, *self);
+
+    for (auto i = 0u; i < 8; i++)
+        versions[i] = neighbors[i] ? neighbors[i]->pass_gen() : (uint64_t)-1;
+    versions[8] = self->pass_gen();
+}
+
+bool CoverGrid::fill_octant(uint32_t k, chunk& self)
+{
+    fm_debug_assert(k < octant_count);
+    if (built_octants & (1u << k))
+        return false;
+
+    auto& pass_pool = w->cover_pass_pool();
+    pass_pool.maybe_mark_stale_all(w->frame_no());
+    fm_assert(pass_pool.params().div_size == params.div_size);
+    Timeline timeline;
+    timeline.start();
+
+    auto pass_grid = pass_pool[self];
+    pass_grid.build_if_stale(can_shoot_through);
+
+    const auto cast = [&](point from, point to) {
+        return raycast(*w, from, to, 0, pass_pool, can_shoot_through);
+    };
+    fill_cells(k, params.div_size, coord, pass_grid.bits().data, cast, cells);
 
     built_octants |= (1u << k);
 #if 0
@@ -298,6 +321,9 @@ Params Params::validate() const
 }
 
 bool Params::operator==(const Params&) const noexcept = default;
+
+const Search::pred& shoot_through_pred() { return detail::grid::can_shoot_through; }
+
 Grid::~Grid() noexcept = default;
 Grid::Grid(const Grid&) noexcept = default;
 Grid& Grid::operator=(const Grid&) & noexcept = default;
@@ -387,7 +413,7 @@ void Pool::maybe_mark_stale_all(uint64_t frame_no)
     {
         auto* g = it->second;
         g->maybe_mark_stale();
-        if (!g->w->at(g->coord))
+        if (!g->w->resident_at(g->coord))
         {
             g->c = nullptr;
             it = pool->grids.erase(it);
@@ -410,4 +436,261 @@ Params Pool::params() const { return pool->params; }
 uint64_t Pool::frame_no() const { return pool->frame_no; }
 uint32_t Pool::pooled_count() const { return pool->freelist.size(); }
 
+namespace {
+
+static_assert(octant_count == 32);
+constexpr uint32_t all_octants = (uint32_t)-1;
+// a ray is one chunk long, and the walk also reads the neighbors of every
+// chunk it passes through
+constexpr int32_t snapshot_radius = 2;
+
+struct FillJob
+{
+    chunk_coords_ coord;
+    uint64_t build_no = 0;
+    uint32_t div_size = 0;
+    uint32_t octants = 0;
+    rc::raycast_snapshot snap;
+    Array<detail::grid::CoverCell> cells;
+};
+
+void run_job(FillJob& job)
+{
+    const auto* own = job.snap.find(job.coord);
+    fm_assert(own);
+    const auto cast = [&](point from, point to) { return rc::raycast(job.snap, from, to); };
+    for (auto k : detail::grid::octant_order)
+        if (job.octants & (1u << k))
+            detail::grid::fill_cells(k, job.div_size, job.coord, own->bits.data(), cast, job.cells);
+}
+
+} // namespace
+
+struct Filler::Impl
+{
+    Pool& pool;
+    detail::grid::Pool<detail::grid::CoverGrid>* grids;
+
+    // shared with the workers
+    std::mutex mutex;
+    std::condition_variable job_cv, done_cv;
+    Array<Pointer<FillJob>> queue, done;
+    bool quit = false;
+
+    // main thread only
+    Array<std::thread> threads;
+    Array<Pointer<FillJob>> spare;
+    Array<chunk_coords_> busy;
+    Stats stats;
+    Time window_start = Time::now();
+    uint64_t window_filled = 0;
+
+    Impl(Pool& pool, detail::grid::Pool<detail::grid::CoverGrid>* grids, uint32_t thread_count);
+    ~Impl() noexcept;
+
+    void worker();
+    Pointer<FillJob> make_job(world& w, chunk& c, const detail::grid::CoverGrid& g);
+    void apply(world& w, Pointer<FillJob> job);
+    void apply_done(world& w);
+};
+
+Filler::Impl::Impl(Pool& pool, detail::grid::Pool<detail::grid::CoverGrid>* grids, uint32_t thread_count):
+    pool{pool}, grids{grids}
+{
+    for (auto i = 0u; i < thread_count; i++)
+        arrayAppend(threads, InPlaceInit, [this] { worker(); });
+}
+
+Filler::Impl::~Impl() noexcept
+{
+    {
+        std::lock_guard lock{mutex};
+        quit = true;
+    }
+    job_cv.notify_all();
+    for (auto& t : threads)
+        t.join();
+}
+
+void Filler::Impl::worker()
+{
+    for (;;)
+    {
+        Pointer<FillJob> job;
+        {
+            std::unique_lock lock{mutex};
+            job_cv.wait(lock, [&] { return quit || !queue.isEmpty(); });
+            if (quit)
+                return;
+            job = move(queue.front());
+            arrayRemove(queue, 0);
+        }
+        run_job(*job);
+        {
+            std::lock_guard lock{mutex};
+            arrayAppend(done, move(job));
+        }
+        done_cv.notify_one();
+    }
+}
+
+Pointer<FillJob> Filler::Impl::make_job(world& w, chunk& c, const detail::grid::CoverGrid& g)
+{
+    Pointer<FillJob> job;
+    if (!spare.isEmpty())
+    {
+        job = move(spare.back());
+        arrayRemoveSuffix(spare);
+    }
+    else
+        job = Pointer<FillJob>{InPlaceInit};
+
+    const auto div_size = pool.params().div_size;
+    const auto dc = chunk_size_xy / div_size;
+    auto& pass_pool = w.cover_pass_pool();
+    fm_assert(pass_pool.params().div_size == div_size);
+
+    job->coord = c.coord();
+    job->build_no = g.build_no;
+    job->div_size = div_size;
+    job->octants = ~g.built_octants;
+    job->snap.capture(w, c.coord(), snapshot_radius, pass_pool, detail::grid::can_shoot_through, 0);
+    if (job->cells.size() != dc*dc)
+        job->cells = Array<detail::grid::CoverCell>{NoInit, dc*dc};
+    return job;
+}
+
+void Filler::Impl::apply(world& w, Pointer<FillJob> job)
+{
+    for (auto i = 0u; i < busy.size(); i++)
+        if (busy[i] == job->coord)
+        {
+            arrayRemove(busy, i);
+            break;
+        }
+
+    detail::grid::CoverGrid* g = nullptr;
+    if (w.resident_at(job->coord))
+        if (auto it = grids->grids.find(job->coord); it != grids->grids.end())
+            g = it->second;
+    if (g)
+        g->maybe_mark_stale();
+
+    if (!g || g->is_stale() || g->build_no != job->build_no)
+        stats.dropped += (uint64_t)std::popcount(job->octants);
+    else
+    {
+        const auto dc = chunk_size_xy / job->div_size;
+        uint32_t count = 0;
+        for (auto k = 0u; k < octant_count; k++)
+        {
+            const auto bit = 1u << k;
+            // the main thread may have filled it since
+            if (!(job->octants & bit) || (g->built_octants & bit))
+                continue;
+            for (auto i = 0u; i < dc*dc; i++)
+                g->cells[i].distance[k] = job->cells[i].distance[k];
+            g->built_octants |= bit;
+            count++;
+        }
+        stats.filled += count;
+        window_filled += count;
+    }
+
+    arrayAppend(spare, move(job));
+}
+
+void Filler::Impl::apply_done(world& w)
+{
+    Array<Pointer<FillJob>> jobs;
+    {
+        std::lock_guard lock{mutex};
+        jobs = move(done);
+    }
+    for (auto& job : jobs)
+        apply(w, move(job));
+}
+
+Filler::Filler(Pool& pool, uint32_t thread_count):
+    impl{InPlaceInit, pool, pool.pool, thread_count}
+{
+}
+
+Filler::~Filler() noexcept = default;
+
+void Filler::update(world& w, ArrayView<const chunk_coords_> chunks, Ns budget)
+{
+    auto& I = *impl;
+    const auto t0 = Time::now();
+
+    if (I.pool.frame_no() != w.frame_no())
+        I.pool.maybe_mark_stale_all(w.frame_no());
+    I.apply_done(w);
+
+    const auto max_in_flight = Math::max(1u, (uint32_t)I.threads.size()) * 2;
+    for (auto coord : chunks)
+    {
+        if (I.busy.size() >= max_in_flight || Time::now() - t0 >= budget)
+            break;
+
+        bool is_busy = false;
+        for (auto b : I.busy)
+            is_busy |= b == coord;
+        if (is_busy)
+            continue;
+
+        auto* c = w.at(coord);
+        if (!c)
+            continue;
+        auto g = I.pool[*c];
+        // octant 0 is filled by the build itself, on this thread
+        g.build_if_stale();
+        if (g.built_octants() == all_octants)
+            continue;
+
+        auto job = I.make_job(w, *c, *g.raw());
+        if (I.threads.isEmpty())
+        {
+            run_job(*job);
+            I.apply(w, move(job));
+        }
+        else
+        {
+            arrayAppend(I.busy, coord);
+            {
+                std::lock_guard lock{I.mutex};
+                arrayAppend(I.queue, move(job));
+            }
+            I.job_cv.notify_one();
+        }
+    }
+
+    const auto now = Time::now();
+    if (const auto dt = now - I.window_start; dt >= Second)
+    {
+        I.stats.octants_per_second = (float)I.window_filled / Time::to_seconds(dt);
+        I.window_filled = 0;
+        I.window_start = now;
+    }
+}
+
+void Filler::finish(world& w)
+{
+    auto& I = *impl;
+    while (!I.busy.isEmpty())
+    {
+        Array<Pointer<FillJob>> jobs;
+        {
+            std::unique_lock lock{I.mutex};
+            I.done_cv.wait(lock, [&] { return !I.done.isEmpty(); });
+            jobs = move(I.done);
+        }
+        for (auto& job : jobs)
+            I.apply(w, move(job));
+    }
+}
+
+auto Filler::stats() const -> const Stats& { return impl->stats; }
+uint32_t Filler::in_flight() const { return (uint32_t)impl->busy.size(); }
+
 } // namespace floormat::Grid::Cover
@@ -1,5 +1,9 @@
 #pragma once
 #include "grid.hpp"
+#include "nanosecond.hpp"
+#include "search-pred.hpp"
+#include <cr/ArrayView.h>
+#include <cr/Pointer.h>
 
 namespace floormat {
 struct local_coords;
@@ -16,6 +20,9 @@ namespace floormat::Grid::Cover {
 
 inline constexpr uint32_t octant_count = 32;
 
+// what world::cover_pass_pool() is built with
+const Search::pred& shoot_through_pred();
+
 struct Params
 {
     uint32_t div_size = tile_size_xy;
@@ -58,6 +65,7 @@ public:
 
 class Pool final
 {
+    friend class Filler;
     detail::grid::Pool<detail::grid::CoverGrid>* pool;
 
 public:
@@ -76,6 +84,40 @@ public:
     uint32_t pooled_count() const;
 };
 
+// Fills the missing octants of a set of chunks on worker threads, so the
+// first cover query in an area doesn't pay for 31 octants at once. Each job
+// raycasts against a snapshot taken on the main thread; results for a grid
+// that was rebuilt or went stale in the meantime are thrown away.
+class Filler final
+{
+public:
+    struct Stats
+    {
+        uint64_t filled = 0, dropped = 0;
+        float octants_per_second = 0;
+    };
+
+    // with thread_count == 0 the jobs run inside update()
+    Filler(Pool& pool, uint32_t thread_count);
+    ~Filler() noexcept;
+    fm_DISABLE_MOVE_COPY(Filler);
+
+    // Applies finished jobs and starts new ones for `chunks`, in order.
+    // `budget` bounds the main thread's share of the work, i.e. snapshots
+    // and applying results, not what the workers do.
+    void update(world& w, ArrayView<const chunk_coords_> chunks, Ns budget);
+    // waits for every started job and applies it
+    void finish(world& w);
+
+    const Stats& stats() const;
+    uint32_t in_flight() const;
+
+    struct Impl;
+
+private:
+    Pointer<Impl> impl;
+};
+
 } // namespace floormat::Grid::Cover
 
 namespace floormat {
@@ -0,0 +1,335 @@
+#include "grid-fov.hpp"
+#include "grid-pass.hpp"
+#include "grid-cover.hpp"
+#include "point.hpp"
+#include "world.hpp"
+#include <array>
+#include <cstring>
+#include <cr/Array.h>
+#include <cr/GrowableArray.h>
+#include <mg/Functions.h>
+
+namespace floormat::Grid::Fov {
+
+namespace {
+
+constexpr uint32_t max_window = 3;
+
+int32_t floor_div(int32_t a, int32_t b)
+{
+    const auto q = a / b;
+    return q * b > a ? q - 1 : q;
+}
+
+int64_t floor_div(int64_t a, int64_t b)
+{
+    const auto q = a / b;
+    return q * b > a ? q - 1 : q;
+}
+
+int64_t ceil_div(int64_t a, int64_t b) { return -floor_div(-a, b); }
+
+struct key
+{
+    Vector2i cell;
+    int8_t z;
+    uint32_t radius;
+
+    bool operator==(const key&) const noexcept = default;
+};
+
+// build_no 0 means the chunk wasn't loaded
+struct dep
+{
+    chunk_coords_ coord;
+    uint64_t build_no;
+
+    bool operator==(const dep&) const noexcept = default;
+};
+
+struct deps
+{
+    std::array<dep, max_window*max_window> list;
+    std::array<const uint8_t*, max_window*max_window> bits;
+    uint32_t count = 0;
+    Vector2i chunk_min;
+    int32_t nx = 0;
+
+    bool same(const deps& o) const
+    {
+        if (count != o.count)
+            return false;
+        for (auto i = 0u; i < count; i++)
+            if (list[i] != o.list[i])
+                return false;
+        return true;
+    }
+};
+
+struct entry
+{
+    key k;
+    deps d;
+    Array<uint8_t> bits;
+    uint64_t last_use = 0;
+    uint32_t visible_count = 0;
+    bool used = false;
+};
+
+// slopes are fractions with a positive denominator, so they compare exactly
+struct slope
+{
+    int32_t num, den;
+};
+
+struct row
+{
+    int32_t depth;
+    slope start, end;
+};
+
+slope slope_at(int32_t depth, int32_t col) { return { 2*col - 1, 2*depth }; }
+
+bool is_symmetric(const row& r, int32_t col)
+{
+    return (int64_t)col * r.start.den >= (int64_t)r.depth * r.start.num &&
+           (int64_t)col * r.end.den <= (int64_t)r.depth * r.end.num;
+}
+
+Vector2i transform(uint32_t quadrant, int32_t depth, int32_t col)
+{
+    switch (quadrant)
+    {
+    case 0: return { col, -depth };
+    case 1: return { depth, col };
+    case 2: return { col, depth };
+    default: return { -depth, col };
+    }
+}
+
+struct window
+{
+    const deps& d;
+    Vector2i origin;
+    int32_t dc;
+
+    bool is_opaque(Vector2i offset) const
+    {
+        const auto cell = origin + offset;
+        const auto cx = floor_div(cell.x(), dc), cy = floor_div(cell.y(), dc);
+        const auto idx = (uint32_t)((cy - d.chunk_min.y()) * d.nx + (cx - d.chunk_min.x()));
+        fm_debug_assert(idx < d.count);
+        const auto* bits = d.bits[idx];
+        if (!bits)
+            return true;
+        const auto i = (uint32_t)((cell.y() - cy*dc) * dc + (cell.x() - cx*dc));
+        return !(bits[i >> 3] >> (i & 7) & 1);
+    }
+};
+
+} // namespace
+
+struct Cache::Impl
+{
+    Array<entry> entries;
+    Array<row> stack;
+    Stats stats;
+    uint64_t tick = 0;
+
+    explicit Impl(uint32_t capacity);
+
+    void gather(world& w, Pass::Pool& pool, const key& k, uint32_t div_size, deps& d);
+    void cast(const window& win, entry& e);
+};
+
+Cache::Impl::Impl(uint32_t capacity):
+    entries{ValueInit, capacity}
+{
+    fm_assert(capacity > 0);
+}
+
+void Cache::Impl::gather(world& w, Pass::Pool& pool, const key& k, uint32_t div_size, deps& d)
+{
+    const auto dc = (int32_t)(chunk_size_xy / div_size);
+    const auto r = (int32_t)k.radius;
+    const auto min = Vector2i{floor_div(k.cell.x() - r, dc), floor_div(k.cell.y() - r, dc)};
+    const auto max = Vector2i{floor_div(k.cell.x() + r, dc), floor_div(k.cell.y() + r, dc)};
+    fm_debug_assert(max.x() - min.x() < (int32_t)max_window && max.y() - min.y() < (int32_t)max_window);
+
+    d.count = 0;
+    d.chunk_min = min;
+    d.nx = max.x() - min.x() + 1;
+    for (auto cy = min.y(); cy <= max.y(); cy++)
+        for (auto cx = min.x(); cx <= max.x(); cx++)
+        {
+            const auto coord = chunk_coords_{(int16_t)cx, (int16_t)cy, k.z};
+            const auto i = d.count++;
+            d.list[i] = { coord, 0 };
+            d.bits[i] = nullptr;
+            if (auto* c = w.at(coord))
+            {
+                auto g = pool[*c];
+                g.build_if_stale(Cover::shoot_through_pred());
+                d.list[i].build_no = g.build_no();
+                d.bits[i] = g.bits().data;
+            }
+        }
+}
+
+void Cache::Impl::cast(const window& win, entry& e)
+{
+    const auto radius = (int32_t)e.k.radius;
+    const auto side = (uint32_t)(2*radius + 1);
+    const auto byte_count = (side*side + 7) / 8;
+    if (e.bits.size() != byte_count)
+        e.bits = Array<uint8_t>{NoInit, byte_count};
+    std::memset(e.bits.data(), 0, byte_count);
+
+    uint32_t count = 0;
+    auto reveal = [&](Vector2i d) {
+        const auto i = (uint32_t)(d.y() + radius) * side + (uint32_t)(d.x() + radius);
+        const auto mask = uint8_t(1u << (i & 7));
+        count += !(e.bits[i >> 3] & mask);
+        e.bits[i >> 3] |= mask;
+    };
+    reveal({});
+
+    const auto r2 = radius * radius;
+    for (auto quadrant = 0u; quadrant < 4; quadrant++)
+    {
+        arrayClear(stack);
+        arrayAppend(stack, row{1, {-1, 1}, {1, 1}});
+        while (!stack.isEmpty())
+        {
+            auto r = stack.back();
+            arrayRemoveSuffix(stack);
+            if (r.depth > radius)
+                continue;
+
+            // round half up and half down, respectively
+            const auto min_col = (int32_t)floor_div(2*(int64_t)r.depth*r.start.num + r.start.den, 2*(int64_t)r.start.den);
+            const auto max_col = (int32_t)ceil_div(2*(int64_t)r.depth*r.end.num - r.end.den, 2*(int64_t)r.end.den);
+
+            int prev = -1; // -1 none, 0 clear, 1 opaque
+            for (auto col = min_col; col <= max_col; col++)
+            {
+                const auto d = transform(quadrant, r.depth, col);
+                const bool opaque = win.is_opaque(d);
+                if ((opaque || is_symmetric(r, col)) && d.dot() <= r2)
+                    reveal(d);
+                if (prev == 1 && !opaque)
+                    r.start = slope_at(r.depth, col);
+                if (prev == 0 && opaque)
+                    arrayAppend(stack, row{r.depth + 1, r.start, slope_at(r.depth, col)});
+                prev = opaque;
+            }
+            if (prev == 0)
+                arrayAppend(stack, row{r.depth + 1, r.start, r.end});
+        }
+    }
+
+    e.visible_count = count;
+}
+
+Vector2i cell_of(point pt, uint32_t div_size)
+{
+    constexpr auto half_tile = Vector2i(tile_size_xy/2);
+    const auto dc = (int32_t)(chunk_size_xy / div_size);
+    const auto ch = pt.chunk();
+    auto pos = Vector2i(pt.local()) * tile_size_xy + Vector2i(pt.offset()) + half_tile;
+    fm_debug_assert(pos >= Vector2i{0});
+    return Vector2i{ch.x, ch.y} * dc + pos / (int32_t)div_size;
+}
+
+View::View(const uint8_t* data, Vector2i origin, uint32_t radius, uint32_t visible_count):
+    data{data}, origin_{origin}, radius_{radius}, visible_count_{visible_count}
+{
+}
+
+bool View::visible(Vector2i offset) const
+{
+    const auto r = (int32_t)radius_;
+    if (Math::abs(offset.x()) > r || Math::abs(offset.y()) > r)
+        return false;
+    const auto i = (uint32_t)(offset.y() + r) * side() + (uint32_t)(offset.x() + r);
+    return data[i >> 3] >> (i & 7) & 1;
+}
+
+bool View::visible_cell(Vector2i cell) const { return visible(cell - origin_); }
+Vector2i View::origin() const { return origin_; }
+uint32_t View::radius() const { return radius_; }
+uint32_t View::side() const { return 2*radius_ + 1; }
+uint32_t View::visible_count() const { return visible_count_; }
+
+Cache::Cache(uint32_t capacity): impl{InPlaceInit, capacity} {}
+Cache::~Cache() noexcept = default;
+
+View Cache::compute(world& w, point origin, uint32_t radius)
+{
+    fm_assert(radius <= max_radius);
+    auto& I = *impl;
+    auto& pool = w.cover_pass_pool();
+    if (pool.frame_no() != w.frame_no())
+        pool.maybe_mark_stale_all(w.frame_no());
+
+    const auto div_size = pool.params().div_size;
+    const auto k = key{cell_of(origin, div_size), origin.chunk3().z, radius};
+    deps d;
+    I.gather(w, pool, k, div_size, d);
+    I.tick++;
+
+    entry* e = nullptr;
+    for (auto& x : I.entries)
+        if (x.used && x.k == k)
+        {
+            e = &x;
+            break;
+        }
+
+    if (e && e->d.same(d))
+        I.stats.hits++;
+    else
+    {
+        I.stats.misses++;
+        if (e)
+            I.stats.invalidated++;
+        else
+            for (auto& x : I.entries)
+            {
+                if (!x.used)
+                {
+                    e = &x;
+                    break;
+                }
+                if (!e || x.last_use < e->last_use)
+                    e = &x;
+            }
+        e->k = k;
+        e->d = d;
+        e->used = true;
+        I.cast(window{d, k.cell, (int32_t)(chunk_size_xy / div_size)}, *e);
+    }
+
+    e->last_use = I.tick;
+    return View{e->bits.data(), k.cell, radius, e->visible_count};
+}
+
+void Cache::clear()
+{
+    for (auto& e : impl->entries)
+        e.used = false;
+}
+
+const Stats& Cache::stats() const { return impl->stats; }
+
+uint32_t Cache::size() const
+{
+    uint32_t n = 0;
+    for (const auto& e : impl->entries)
+        n += e.used;
+    return n;
+}
+
+uint32_t Cache::capacity() const { return (uint32_t)impl->entries.size(); }
+
+} // namespace floormat::Grid::Fov
@@ -0,0 +1,75 @@
+#pragma once
+#include "grid.hpp"
+#include <cr/Pointer.h>
+
+namespace floormat {
+struct point;
+class world;
+}
+
+namespace floormat::Grid::Fov {
+
+// Cells are those of world::cover_pass_pool(), numbered across chunks as
+// chunk * div_count + local cell. A cell is opaque if its bit is clear, or
+// if its chunk isn't loaded.
+Vector2i cell_of(point pt, uint32_t div_size);
+
+struct Stats
+{
+    uint64_t hits = 0, misses = 0;
+    // misses on an existing entry whose pass grids were rebuilt since
+    uint64_t invalidated = 0;
+};
+
+// Visible cells within `radius` of the origin cell, as a row-major bitset
+// over the (2*radius+1)² window centered on it. Opaque cells that are seen
+// count as visible. Only valid until the next compute() on the same Cache.
+class View
+{
+    const uint8_t* data;
+    Vector2i origin_;
+    uint32_t radius_, visible_count_;
+
+public:
+    View(const uint8_t* data, Vector2i origin, uint32_t radius, uint32_t visible_count);
+
+    bool visible(Vector2i offset) const;
+    bool visible_cell(Vector2i cell) const;
+
+    Vector2i origin() const;
+    uint32_t radius() const;
+    uint32_t side() const;
+    uint32_t visible_count() const;
+};
+
+// Symmetric shadowcasting over the pass grid bitmaps: if B is visible from
+// A then A is visible from B. Results are cached per (origin cell, z,
+// radius) and revalidated on every hit against the build numbers of the
+// pass grids under the window.
+class Cache final
+{
+public:
+    explicit Cache(uint32_t capacity = 32);
+    ~Cache() noexcept;
+    fm_DISABLE_MOVE_COPY(Cache);
+
+    View compute(world& w, point origin, uint32_t radius);
+    void clear();
+
+    const Stats& stats() const;
+    uint32_t size() const;
+    uint32_t capacity() const;
+
+    static constexpr uint32_t max_radius = chunk_size_xy / 8;
+
+    struct Impl;
+
+private:
+    Pointer<Impl> impl;
+};
+
+} // namespace floormat::Grid::Fov
+
+namespace floormat {
+namespace Fov = floormat::Grid::Fov;
+} // namespace floormat
@@ -9,7 +9,9 @@
 #include "compat/function2.hpp"
 #include <bit>
 #include <array>
+#include <cstring>
 #include <cr/BitArray.h>
+#include <cr/GrowableArray.h>
 #include <mg/Functions.h>
 #include <mg/Range.h>
 #include <gtl/phmap.hpp>
@@ -124,7 +126,11 @@ struct PassGrid : GridBase
 
     Params params;
     BitArray bitmask;
+    BitArray prev_bitmask;
+    Array<uint32_t> changed;
+    uint64_t prev_build_no = 0;
     bool all_empty = false;
+    bool changes_complete = false;
 
     PassGrid(chunk& c, Params params);
     ~PassGrid() noexcept;
@@ -137,6 +143,7 @@ struct PassGrid : GridBase
     bool is_all_empty() const noexcept { return all_empty; }
 
     void build_impl(chunk* self, const pred& predicate);
+    void diff_against_previous(uint32_t bit_count);
 };
 
 uint32_t PassGrid::get_bitmask_index(uint32_t x, uint32_t y, uint32_t div_count)
@@ -155,8 +162,49 @@ Range2D PassGrid::get_coord_from_div(uint32_t x, uint32_t y) const
     return GridBase::coord_range_from_div(x, y, params.div_size, params.bbox_size);
 }
 
+void PassGrid::diff_against_previous(uint32_t bit_count)
+{
+    arrayClear(changed);
+    changes_complete = prev_build_no != 0;
+    if (!changes_complete)
+        return;
+
+    const auto* cur  = reinterpret_cast<const uint8_t*>(bitmask.data());
+    const auto* prev = reinterpret_cast<const uint8_t*>(prev_bitmask.data());
+    const auto nbytes = (bit_count + 7) / 8;
+    for (auto i = 0u; i < nbytes; i++)
+    {
+        auto x = uint32_t(cur[i] ^ prev[i]);
+        while (x)
+        {
+            const auto bit = i * 8 + (uint32_t)std::countr_zero(x);
+            x &= x - 1;
+            if (bit >= bit_count) [[unlikely]]
+                break;
+            if (changed.size() >= floormat::Grid::Pass::Grid::max_changed_cells) [[unlikely]]
+            {
+                // too many to be worth listing; consumers redo the whole chunk
+                arrayClear(changed);
+                changes_complete = false;
+                return;
+            }
+            arrayAppend(changed, bit);
+        }
+    }
+}
+
 void PassGrid::build_impl(chunk* self, const pred& predicate)
 {
+    // keep the old bits around so consumers holding onto search state can
+    // be told which cells flipped, instead of starting over
+    prev_build_no = build_no;
+    if (prev_build_no != 0)
+    {
+        if (prev_bitmask.size() != bitmask.size()) [[unlikely]]
+            prev_bitmask = BitArray{NoInit, bitmask.size()};
+        std::memcpy(prev_bitmask.data(), bitmask.data(), (bitmask.size() + 7) / 8);
+    }
+
     bitmask.setAll();
     fm_debug_assert(bitmask.offset() == 0);
     uint8_t* const bits{reinterpret_cast<uint8_t*>(bitmask.data())};
@@ -237,6 +285,8 @@ void PassGrid::build_impl(chunk* self, const pred& predicate)
         });
     }
 
+    diff_against_previous(div_countʹ*div_countʹ);
+
     for (auto i = 0u; i < 8; i++)
         versions[i] = neighbors[i] ? neighbors[i]->pass_gen() : (uint64_t)-1;
     versions[8] = self->pass_gen();
@@ -266,6 +316,11 @@ void PassGrid::reset_for_reuse(chunk& ch, Params new_params)
 {
     reset_base_for_reuse(ch);
     params = new_params;
+    // the old bits belong to another chunk; don't diff against them
+    build_no = 0;
+    prev_build_no = 0;
+    changes_complete = false;
+    arrayClear(changed);
     const auto div_count = chunk_size_xy / params.div_size;
     const auto bits = div_count * div_count;
     if (bitmask.size() < bits) [[unlikely]]
@@ -422,6 +477,24 @@ uint64_t Grid::build_no() const
     return grid->build_no;
 }
 
+uint64_t Grid::prev_build_no() const
+{
+    detail::grid::check_frame_sync(pool, grid);
+    return grid->prev_build_no;
+}
+
+bool Grid::changes_complete() const
+{
+    detail::grid::check_frame_sync(pool, grid);
+    return grid->changes_complete;
+}
+
+ArrayView<const uint32_t> Grid::changed_cells() const
+{
+    detail::grid::check_frame_sync(pool, grid);
+    return grid->changed;
+}
+
 bool Grid::is_all_empty() const
 {
     detail::grid::check_frame_sync(pool, grid);
@@ -50,6 +50,13 @@ public:
     uint64_t build_no() const;
     bool is_all_empty() const;
 
+    // Cells whose bit flipped between the build numbered prev_build_no() and
+    // the current one. Only meaningful if changes_complete() is true, otherwise
+    // assume every cell changed (first build, reuse, or too many flips).
+    uint64_t prev_build_no() const;
+    bool changes_complete() const;
+    ArrayView<const uint32_t> changed_cells() const;
+
     detail::grid::PassGrid* raw() const noexcept;
 
     void mark_stale();
@@ -59,6 +66,7 @@ public:
     void build_if_stale(const pred& predicate);
 
     static constexpr uint32_t min_bbox_size = 4;
+    static constexpr uint32_t max_changed_cells = 256;
 };
 
 // The build predicate is not part of a grid's staleness key. Use each Pool
@@ -83,7 +83,8 @@ void GridBase::maybe_mark_stale_impl(fu2::function_view<chunk*(chunk_coords_) co
 
 void GridBase::maybe_mark_stale()
 {
-    maybe_mark_stale_impl([this](chunk_coords_ ch) { return w->at(ch); });
+    // a paged-out chunk counts as changed, no need to page it in to tell
+    maybe_mark_stale_impl([this](chunk_coords_ ch) { return w->resident_at(ch); });
 }
 
 uint32_t GridBase::pack_bit_index(uint32_t i, uint32_t j, uint32_t div_count)
@@ -1,4 +1,5 @@
 #include "ground-atlas.hpp"
+#include "sprite-atlas-impl.hpp"
 #include "quads.hpp"
 #include "compat/assert.hpp"
 #include "compat/exception.hpp"
@@ -47,6 +48,16 @@ ground_atlas::ground_atlas(ground_def info, const ImageView2D& image) :
     }
 }
 
+ground_atlas::ground_atlas(ground_def info, ArrayView<const SpriteAtlas::Sprite> sprites) :
+    _def{move(info)}, _path{make_path(_def.name)}
+{
+    fm_soft_assert(_def.size.x() > 0 && _def.size.y() > 0);
+    fm_soft_assert(sprites.size() == num_tiles());
+    arrayReserve(_frame_sprites, sprites.size());
+    for (const auto& s : sprites)
+        arrayAppend(_frame_sprites, sprite{&s});
+}
+
 Quads::texcoords ground_atlas::texcoords_for_id(size_t i) const
 {
     fm_assert(i < num_tiles());
@@ -26,6 +26,8 @@ class ground_atlas final : public bptr_base
 
 public:
     ground_atlas(ground_def info, const ImageView2D& img);
+    // tiles that were already packed, e.g. from sprite_atlas_cache
+    ground_atlas(ground_def info, ArrayView<const SpriteAtlas::Sprite> sprites);
     texcoords texcoords_for_id(size_t id) const;
     size_t num_tiles() const;
     Vector2ub num_tiles2() const { return _def.size; }
@@ -52,6 +52,7 @@ hole_proto::hole_proto()
 hole::hole(object_id id, floormat::chunk& c, const hole_proto& proto):
     object{id, c, proto}, height{proto.height}, z_offset{proto.z_offset}, flags{proto.flags}
 {
+    non_const(awake) = false;
 }
 
 hole::~hole() noexcept
@@ -0,0 +1,190 @@
+#include "light-index.hpp"
+#include "chunk.hpp"
+#include "light.hpp"
+#include "tile-constants.hpp"
+#include "compat/assert.hpp"
+#include <cmath>
+#include <utility>
+#include <cr/GrowableArray.h>
+#include <mg/Functions.h>
+
+namespace floormat {
+
+namespace {
+
+constexpr auto chunk_size = TILE_SIZE2 * TILE_MAX_DIM;
+constexpr int max_cells = 64;
+
+float distance_sq(const occluder_segment& s, Vector2 p)
+{
+    const auto ab = s.b - s.a;
+    const auto len = ab.dot();
+    const auto t = len > 0 ? Math::clamp(Math::dot(p - s.a, ab) / len, 0.f, 1.f) : 0.f;
+    return (s.a + ab * t - p).dot();
+}
+
+} // namespace
+
+float light_range(const light_s& light)
+{
+    constexpr auto tile_size = TILE_SIZE2.sum()/2;
+    float range = 0;
+
+    fm_assert(light.falloff < light_falloff::COUNT);
+    switch (light.falloff)
+    {
+    case light_falloff::COUNT: std::unreachable();
+    case light_falloff::constant:
+        range = TILE_MAX_DIM;
+        break;
+    case light_falloff::linear:
+    case light_falloff::quadratic:
+        range = light.dist;
+        break;
+    }
+
+    return std::fmax(0.f, range * tile_size);
+}
+
+void light_index::clear()
+{
+    arrayClear(_all_lights);
+    arrayClear(_all_segments);
+    arrayClear(_lights);
+    arrayClear(_segments);
+    _stats = {};
+}
+
+void light_index::add_chunk(Vector2 neighbor_offset, chunk& c)
+{
+    const auto off = neighbor_offset * chunk_size;
+
+    arrayClear(_scratch);
+    arrayAppend(_scratch, c.static_occluders());
+    make_dynamic_occluders(c, _scratch);
+    for (const auto& s : _scratch)
+        arrayAppend(_all_segments, occluder_segment{s.a + off, s.b + off});
+
+    for (const auto& eʹ : c.objects())
+    {
+        if (eʹ->type() != object_type::light)
+            continue;
+        const auto& li = static_cast<const light&>(*eʹ);
+        if (li.max_distance < 1e-6f)
+            continue;
+        add_light(light_s {
+            .center = Vector2(li.coord.local()) * TILE_SIZE2 + Vector2(li.offset) + off,
+            .dist = li.max_distance,
+            .radius = li.radius,
+            .color = li.color,
+            .falloff = li.falloff,
+        });
+    }
+}
+
+void light_index::add_light(const light_s& light)
+{
+    arrayAppend(_all_lights, light);
+}
+
+void light_index::bin_segments()
+{
+    auto min = Vector2{0}, max = Vector2{0};
+    if (!_all_segments.isEmpty())
+    {
+        min = max = _all_segments[0].a;
+        for (const auto& s : _all_segments)
+        {
+            min = Math::min(min, Math::min(s.a, s.b));
+            max = Math::max(max, Math::max(s.a, s.b));
+        }
+    }
+    _origin = min;
+    _cells = Math::clamp(Vector2i(Math::ceil((max - min) / cell_size)), Vector2i{1}, Vector2i{max_cells});
+    const auto cell_count = (uint32_t)(_cells.x() * _cells.y());
+
+    // same counting sort as clickable_index::rebuild()
+    arrayResize(_cell_start, NoInit, cell_count + 1);
+    for (auto& x : _cell_start)
+        x = 0;
+    const auto cell_range = [this](const occluder_segment& s) {
+        const auto a = Vector2i((Math::min(s.a, s.b) - _origin) / cell_size),
+                   b = Vector2i((Math::max(s.a, s.b) - _origin) / cell_size);
+        return std::pair{Math::min(a, _cells - Vector2i{1}), Math::min(b, _cells - Vector2i{1})};
+    };
+    for (const auto& s : _all_segments)
+    {
+        const auto [a, b] = cell_range(s);
+        for (auto y = a.y(); y <= b.y(); y++)
+            for (auto x = a.x(); x <= b.x(); x++)
+                _cell_start[(uint32_t)(y * _cells.x() + x) + 1]++;
+    }
+    for (auto i = 0u; i < cell_count; i++)
+        _cell_start[i+1] += _cell_start[i];
+
+    arrayResize(_cell_items, NoInit, _cell_start[cell_count]);
+    for (auto i = 0u; i < _all_segments.size(); i++)
+    {
+        const auto [a, b] = cell_range(_all_segments[i]);
+        for (auto y = a.y(); y <= b.y(); y++)
+            for (auto x = a.x(); x <= b.x(); x++)
+                _cell_items[_cell_start[(uint32_t)(y * _cells.x() + x)]++] = i;
+    }
+    for (auto i = cell_count; i > 0; i--)
+        _cell_start[i] = _cell_start[i-1];
+    _cell_start[0] = 0;
+}
+
+void light_index::build(const Math::Range2D<float>& view)
+{
+    arrayClear(_lights);
+    arrayClear(_segments);
+    bin_segments();
+    arrayResize(_seen, NoInit, _all_segments.size());
+    for (auto& x : _seen)
+        x = 0;
+
+    _stats = {
+        .lights = (uint32_t)_all_lights.size(),
+        .segments = (uint32_t)_all_segments.size(),
+    };
+
+    for (const auto& L : _all_lights)
+    {
+        const auto range = light_range(L);
+        const auto min = L.center - Vector2{range}, max = L.center + Vector2{range};
+        if (!(min < view.max() && max > view.min()))
+            continue;
+
+        const auto stamp = (uint32_t)_lights.size() + 1;
+        const auto first = (uint32_t)_segments.size();
+        const auto a = Math::clamp(Vector2i(Math::floor((min - _origin) / cell_size)), Vector2i{0}, _cells - Vector2i{1}),
+                   b = Math::clamp(Vector2i(Math::floor((max - _origin) / cell_size)), Vector2i{0}, _cells - Vector2i{1});
+        for (auto y = a.y(); y <= b.y(); y++)
+            for (auto x = a.x(); x <= b.x(); x++)
+            {
+                const auto cell = (uint32_t)(y * _cells.x() + x);
+                for (auto k = _cell_start[cell]; k < _cell_start[cell+1]; k++)
+                {
+                    const auto i = _cell_items[k];
+                    if (_seen[i] == stamp)
+                        continue;
+                    _seen[i] = stamp;
+                    if (distance_sq(_all_segments[i], L.center) <= range * range)
+                        arrayAppend(_segments, _all_segments[i]);
+                }
+            }
+        arrayAppend(_lights, light_entry{L, first, (uint32_t)_segments.size() - first});
+    }
+
+    _stats.visible_lights = (uint32_t)_lights.size();
+    _stats.selected = (uint32_t)_segments.size();
+}
+
+ArrayView<const light_index::light_entry> light_index::lights() const { return _lights; }
+ArrayView<const occluder_segment> light_index::segments() const { return _segments; }
+const light_index_stats& light_index::stats() const { return _stats; }
+
+bool light_s::operator==(const light_s&) const noexcept = default;
+
+} // namespace floormat
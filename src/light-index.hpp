@@ -0,0 +1,74 @@
+#pragma once
+#include "src/light-falloff.hpp"
+#include "src/light-occluders.hpp"
+#include <cr/Array.h>
+#include <mg/Vector4.h>
+#include <mg/Range.h>
+
+namespace floormat {
+
+class chunk;
+
+struct light_s final
+{
+    Vector2 center;
+    float dist = 1;
+    float radius = 0;
+    Vector4ub color;
+    light_falloff falloff = light_falloff::linear;
+
+    bool operator==(const light_s&) const noexcept;
+};
+
+// how far the light reaches, in pixels
+float light_range(const light_s& light);
+
+struct light_index_stats
+{
+    // in the last build()
+    uint32_t lights = 0, visible_lights = 0;
+    // `selected` adds up every visible light's own segments
+    uint32_t segments = 0, selected = 0;
+};
+
+// The CPU half of the lightmap: gathers the lights and shadow casters of
+// the chunks around a light, drops the lights that can't reach the view,
+// and gives every other light only the segments inside its range, found
+// through a grid of `cell_size` pixels. Positions are relative to the
+// origin chunk, i.e. local pixels plus `neighbor_offset` chunks.
+class light_index final
+{
+public:
+    struct light_entry
+    {
+        light_s light;
+        // into segments()
+        uint32_t first, count;
+    };
+
+    static constexpr float cell_size = 256;
+
+    void clear();
+    // lights with a zero distance are skipped
+    void add_chunk(Vector2 neighbor_offset, chunk& c);
+    void add_light(const light_s& light);
+    void build(const Math::Range2D<float>& view);
+
+    ArrayView<const light_entry> lights() const;
+    ArrayView<const occluder_segment> segments() const;
+    const light_index_stats& stats() const;
+
+private:
+    Array<light_s> _all_lights;
+    Array<occluder_segment> _all_segments, _scratch;
+    Array<light_entry> _lights;
+    Array<occluder_segment> _segments;
+    Array<uint32_t> _cell_start, _cell_items, _seen;
+    Vector2 _origin;
+    Vector2i _cells;
+    light_index_stats _stats;
+
+    void bin_segments();
+};
+
+} // namespace floormat
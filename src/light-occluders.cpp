@@ -0,0 +1,150 @@
+#include "light-occluders.hpp"
+#include "chunk.hpp"
+#include "chunk-iter.hpp"
+#include "object.hpp"
+#include "tile-constants.hpp"
+#include "ground-atlas.hpp"
+#include "wall-atlas.hpp"
+#include <array>
+#include <cr/GrowableArray.h>
+
+namespace floormat {
+
+namespace {
+
+constexpr auto N = (uint32_t)TILE_MAX_DIM;
+
+// tile edge `i` of a row or column, same as tile_start()
+constexpr float edge(uint32_t i) { return (float)i * tile_size_xy - tile_size_xy/2; }
+
+// calls emit(first, last) for each run of consecutive `i` where pred(i) holds
+template<typename Pred, typename Emit>
+void for_each_run(const Pred& pred, const Emit& emit)
+{
+    for (auto i = 0u; i < N; )
+    {
+        if (!pred(i))
+        {
+            i++;
+            continue;
+        }
+        auto j = i + 1;
+        while (j < N && pred(j))
+            j++;
+        emit(i, j);
+        i = j;
+    }
+}
+
+void add_rect(Array<occluder_segment>& output, Vector2 min, Vector2 max)
+{
+    arrayAppend(output, {
+        occluder_segment{{min.x(), max.y()}, {max.x(), max.y()}}, // north
+        occluder_segment{{max.x(), max.y()}, {max.x(), min.y()}}, // east
+        occluder_segment{{max.x(), min.y()}, {min.x(), min.y()}}, // south
+        occluder_segment{{min.x(), min.y()}, {min.x(), max.y()}}, // west
+    });
+}
+
+bool is_blocking(const object& e)
+{
+    return !e.is_virtual() && e.pass != pass_mode::pass && e.pass != pass_mode::see_through;
+}
+
+// see chunk::add_object_pre()
+bool tracks_pass_gen(const object& e)
+{
+    return !e.is_dynamic() || e.updates_passability();
+}
+
+void add_object(Array<occluder_segment>& output, const object& e)
+{
+    auto center = Vector2(e.offset) + Vector2(e.bbox_offset) + Vector2(e.coord.local()) * TILE_SIZE2;
+    auto half = Vector2(e.bbox_size)*.5f;
+    add_rect(output, center - half, center + half);
+}
+
+void add_ground(Array<occluder_segment>& output, const chunk& c)
+{
+    std::array<std::array<bool, N>, N> blocked; // [y][x]
+    for (auto i = 0u; i < TILE_COUNT; i++)
+    {
+        const auto* atlas = c.ground_atlas_at(i);
+        blocked[i / N][i % N] = atlas && atlas->pass_mode() == pass_mode::blocked;
+    }
+    const auto at = [&](uint32_t x, uint32_t y) { return x < N && y < N && blocked[y][x]; };
+
+    // The edges between two blocked tiles are inside the union and can't add
+    // to its shadow. What's left is joined into one segment per straight run,
+    // keeping each tile edge's own direction.
+    for (auto k = 0u; k <= N; k++)
+    {
+        const auto e = edge(k);
+        // north edges of row k-1, south edges of row k
+        for_each_run([&](uint32_t x) { return at(x, k-1) && !at(x, k); }, [&](uint32_t x0, uint32_t x1) {
+            arrayAppend(output, occluder_segment{{edge(x0), e}, {edge(x1), e}});
+        });
+        for_each_run([&](uint32_t x) { return at(x, k) && !at(x, k-1); }, [&](uint32_t x0, uint32_t x1) {
+            arrayAppend(output, occluder_segment{{edge(x1), e}, {edge(x0), e}});
+        });
+        // east edges of column k-1, west edges of column k
+        for_each_run([&](uint32_t y) { return at(k-1, y) && !at(k, y); }, [&](uint32_t y0, uint32_t y1) {
+            arrayAppend(output, occluder_segment{{e, edge(y1)}, {e, edge(y0)}});
+        });
+        for_each_run([&](uint32_t y) { return at(k, y) && !at(k-1, y); }, [&](uint32_t y0, uint32_t y1) {
+            arrayAppend(output, occluder_segment{{e, edge(y0)}, {e, edge(y1)}});
+        });
+    }
+}
+
+void add_walls(Array<occluder_segment>& output, const chunk& c)
+{
+    const auto blocked = [&](uint32_t x, uint32_t y, bool is_west) {
+        const auto* atlas = c.wall_atlas_at((y*N + x)*2 + is_west);
+        return atlas && atlas->info().passability == pass_mode::blocked;
+    };
+
+    // a row of north walls is a single thin box, and so is a column of west walls
+    for (auto k = 0u; k < N; k++)
+    {
+        const auto e = edge(k);
+        for_each_run([&](uint32_t x) { return blocked(x, k, false); }, [&](uint32_t x0, uint32_t x1) {
+            add_rect(output, {edge(x0), e - shadow_wall_depth}, {edge(x1), e});
+        });
+        for_each_run([&](uint32_t y) { return blocked(k, y, true); }, [&](uint32_t y0, uint32_t y1) {
+            add_rect(output, {e - shadow_wall_depth, edge(y0)}, {e, edge(y1)});
+        });
+    }
+}
+
+} // namespace
+
+void make_static_occluders(const chunk& c, Array<occluder_segment>& output)
+{
+    add_ground(output, c);
+    add_walls(output, c);
+    for (const auto& e : c.objects())
+        if (is_blocking(e) && tracks_pass_gen(e))
+            add_object(output, e);
+}
+
+void make_dynamic_occluders(const chunk& c, Array<occluder_segment>& output)
+{
+    for (const auto& e : c.objects())
+        if (is_blocking(e) && !tracks_pass_gen(e))
+            add_object(output, e);
+}
+
+ArrayView<const occluder_segment> chunk::static_occluders()
+{
+    // pass_gen() only moves on the first change after ensure_passability()
+    if (_pass_modified || _occluders_gen != _pass_gen)
+    {
+        arrayClear(_static_occluders);
+        make_static_occluders(*this, _static_occluders);
+        _occluders_gen = _pass_modified ? 0 : _pass_gen;
+    }
+    return _static_occluders;
+}
+
+} // namespace floormat
@@ -0,0 +1,25 @@
+#pragma once
+#include <cr/Array.h>
+#include <mg/Vector2.h>
+
+namespace floormat {
+
+class chunk;
+
+// An edge that casts a shadow in the lightmap, in the chunk's local pixel
+// coordinates, as taken by lightmap_shader::add_segment().
+struct occluder_segment
+{
+    Vector2 a, b;
+};
+
+constexpr inline float shadow_wall_depth = 8;
+
+// Blocked ground tiles as the outline of their union, walls merged along
+// runs of tiles, and the objects whose bboxes can't change without bumping
+// chunk::pass_gen(). Appends to `output`.
+void make_static_occluders(const chunk& c, Array<occluder_segment>& output);
+// The other blocking objects, which can move without the chunk knowing.
+void make_dynamic_occluders(const chunk& c, Array<occluder_segment>& output);
+
+} // namespace floormat
@@ -3,6 +3,7 @@
 #include "loader/loader.hpp"
 #include "loader/vobj-cell.hpp"
 #include "compat/borrowed-ptr.inl"
+#include "compat/non-const.hpp"
 #include <mg/Functions.h>
 
 namespace floormat {
@@ -48,6 +49,7 @@ light::light(object_id id, class chunk& c, const light_proto& proto) :
     falloff{proto.falloff},
     enabled{proto.enabled}
 {
+    non_const(awake) = false;
 }
 
 int32_t light::depth_offset() const
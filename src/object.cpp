@@ -300,6 +300,34 @@ bool object::is_virtual() const { return false; }
 point object::position() const { return {coord, offset}; }
 object_type object::type_of() const noexcept { return type(); }
 
+void object::wake()
+{
+    if (awake)
+        return;
+    non_const(awake) = true;
+    c->_awake_count++;
+    // don't hand it the time it spent asleep. an object updated in the
+    // current or the previous frame keeps last_frame_no so it isn't updated
+    // twice in one frame.
+    if (last_frame_no + 1 < c->world().frame_no())
+        last_frame_no = 0;
+}
+
+void object::sleep()
+{
+    if (!awake)
+        return;
+    non_const(awake) = false;
+    fm_debug_assert(c->_awake_count > 0);
+    c->_awake_count--;
+}
+
+void object::sleep_for(uint32_t nframes)
+{
+    sleep();
+    c->world().wake_after(id, nframes);
+}
+
 bool object::is_dynamic() const { return atlas->info().fps > 0; }
 bool object::updates_passability() const { return false; }
 bool object::updates_walls() const { return false; }
@@ -56,6 +56,8 @@ struct object : bptr_base
     uint32_t delta = 0;
     const rotation r = rotation::N; // todo remove bitfield?
     const pass_mode pass = pass_mode::see_through;
+    // asleep objects are skipped by the update loop until something wakes them
+    const bool awake = true;
     bool ephemeral : 1 = false;
     //char _pad[4]; // got 4 bytes left
 
@@ -76,6 +78,9 @@ struct object : bptr_base
     virtual bool can_activate(size_t i) const;
     virtual bool activate(size_t i);
     virtual void update(const bptr<object>& self, size_t& i, const Ns& dt) = 0;
+    void wake();
+    void sleep();
+    void sleep_for(uint32_t nframes);
     void rotate(size_t i, rotation r);
     bool can_rotate(global_coords coord, rotation new_r, rotation old_r, Vector2b offset, Vector2b bbox_offset, Vector2ub bbox_size);
     bool can_move_to(Vector2i delta, global_coords coord, Vector2b offset, Vector2b bbox_offset, Vector2ub bbox_size);
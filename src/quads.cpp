@@ -1,12 +1,18 @@
 #include "quads.hpp"
 #include "depth.hpp"
 #include "renderer.hpp"
+#include "global-coords.hpp"
+#include "tile-constants.hpp"
+#include "shaders/shader.hpp"
+#include "compat/limits.hpp"
+#include <cmath>
+#include <mg/Functions.h>
 #include <mg/Vector2.h>
 #include <mg/Vector3.h>
 
 namespace floormat::Quads {
 
-static_assert(sizeof(vertex) == 28);
+static_assert(sizeof(vertex) == 16);
 
 static_assert(sizeof(index_type) <= 4); // GL index types are <= 32-bit
 
@@ -20,6 +26,29 @@ float depth_start()
 
 } // namespace
 
+Vector2i chunk_origin(chunk_coords_ c)
+{
+    constexpr auto size = (int32_t)TILE_MAX_DIM * tile_size_xy;
+    const auto x = c.x * size, y = c.y * size, z = c.z * tile_size_z;
+    // tile_shader::project() without the rounding
+    static_assert(tile_shader::foreshortening_factor == 0.5f && size % 2 == 0);
+    return { x - y, (x + y) / 2 - z };
+}
+
+vertex make_vertex(const Vector3& position, const Vector3& texcoords, float depth, Vector2i origin)
+{
+    const auto pos = (tile_shader::project(position) - Vector2(origin)) * (float)position_scale;
+    fm_debug_assert(std::fabs(pos.x()) <= limits<Short>::max && std::fabs(pos.y()) <= limits<Short>::max);
+    const auto uv = Math::clamp(texcoords.xy(), Vector2{0}, Vector2{1}) * (float)limits<UnsignedShort>::max;
+    fm_debug_assert(texcoords.z() >= 0 && texcoords.z() <= (float)limits<UnsignedShort>::max);
+    return {
+        .position = Vector2s{Math::round(pos)},
+        .texcoords = Vector2us{Math::round(uv)},
+        .layer = (UnsignedShort)texcoords.z(),
+        .depth = depth,
+    };
+}
+
 indexes quad_indexes(size_t N)
 {
     using I = index_type;
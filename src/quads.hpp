@@ -2,16 +2,27 @@
 #include <array>
 #include <mg/Vector3.h>
 
-namespace floormat { struct point; }
+namespace floormat { struct point; struct chunk_coords_; }
 
 namespace floormat::Quads {
 
+// The position is tile_shader::project()ed and relative to the origin of the
+// chunk the quad belongs to, see chunk_origin(). SpriteBatch moves it to the
+// camera before uploading. Texcoords are unorm16 within the atlas layer.
 struct vertex {
-    Vector3 position;
-    Vector3 texcoords;
+    Vector2s position; // in 1/position_scale pixels
+    Vector2us texcoords;
+    UnsignedShort layer, _pad = 0;
     float depth;
 };
 
+constexpr inline int32_t position_scale = 4;
+
+// the chunk's world origin, projected
+Vector2i chunk_origin(chunk_coords_ c);
+// world position, and texcoords as returned by sprite_atlas::texcoords_for()
+vertex make_vertex(const Vector3& position, const Vector3& texcoords, float depth, Vector2i origin);
+
 using index_type = UnsignedShort; // widen (e.g. UnsignedInt) to raise the per-buffer cap
 constexpr inline uint32_t vertexes_per_quad = 4;
 constexpr inline uint32_t indexes_per_quad  = 6;
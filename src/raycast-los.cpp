@@ -0,0 +1,210 @@
+#include "raycast-los.hpp"
+#include "grid-fov.hpp"
+#include "grid-pass.hpp"
+#include "chunk.hpp"
+#include "world.hpp"
+#include "compat/hash.hpp"
+#include <array>
+#include <cr/Array.h>
+#include <mg/Functions.h>
+#include <gtl/phmap.hpp>
+
+namespace floormat::rc {
+
+namespace {
+
+int32_t floor_div(int32_t a, int32_t b)
+{
+    const auto q = a / b;
+    return q * b > a ? q - 1 : q;
+}
+
+struct key
+{
+    int32_t ax, ay, bx, by, z;
+    uint32_t pred_id;
+
+    bool operator==(const key&) const noexcept = default;
+};
+
+static_assert(sizeof(key) == 6*4);
+
+struct key_hasher
+{
+    size_t operator()(const key& k) const noexcept { return hash_buf(&k, sizeof k); }
+};
+
+struct dep
+{
+    chunk_coords_ coord;
+    uint64_t pass_gen;
+};
+
+struct slot
+{
+    key k;
+    std::array<dep, los_cache::max_chunks> deps;
+    uint8_t dep_count = 0;
+    bool visible : 1 = false,
+         used    : 1 = false,
+         recent  : 1 = false;
+};
+
+uint64_t pass_gen_at(world& w, chunk_coords_ coord)
+{
+    // paged out counts as changed, it gets paged in if the ray gets there
+    auto* c = w.resident_at(coord);
+    return c ? c->pass_gen() : (uint64_t)-1;
+}
+
+point cell_center(Vector2i cell, int8_t z, uint32_t div_size)
+{
+    const auto dc = (int32_t)(chunk_size_xy / div_size);
+    const auto per_tile = tile_size_xy / (int32_t)div_size;
+    const auto ch = Vector2i{floor_div(cell.x(), dc), floor_div(cell.y(), dc)};
+    const auto local = cell - ch * dc;
+    const auto tile = local / per_tile;
+    const auto offset = (local - tile * per_tile) * (int32_t)div_size + Vector2i((int32_t)div_size/2 - tile_size_xy/2);
+    return point{chunk_coords_{(int16_t)ch.x(), (int16_t)ch.y(), z}, local_coords{tile.x(), tile.y()}, Vector2b(offset)};
+}
+
+// the walk reads the 3x3 chunks around every chunk it crosses, and the
+// ray stays within the chunk bounding box of its endpoints
+bool gather_deps(world& w, point from, point to, slot& s)
+{
+    const auto a = from.chunk(), b = to.chunk();
+    const auto x0 = Math::min(a.x, b.x) - 1, x1 = Math::max(a.x, b.x) + 1;
+    const auto y0 = Math::min(a.y, b.y) - 1, y1 = Math::max(a.y, b.y) + 1;
+    if ((uint32_t)((x1 - x0 + 1) * (y1 - y0 + 1)) > los_cache::max_chunks)
+        return false;
+
+    s.dep_count = 0;
+    for (auto y = y0; y <= y1; y++)
+        for (auto x = x0; x <= x1; x++)
+        {
+            const auto coord = chunk_coords_{(int16_t)x, (int16_t)y, from.chunk3().z};
+            s.deps[s.dep_count++] = { coord, pass_gen_at(w, coord) };
+        }
+    return true;
+}
+
+bool is_fresh(world& w, const slot& s)
+{
+    for (auto i = 0u; i < s.dep_count; i++)
+        if (pass_gen_at(w, s.deps[i].coord) != s.deps[i].pass_gen)
+            return false;
+    return true;
+}
+
+} // namespace
+
+struct los_cache::impl_s
+{
+    Array<slot> slots;
+    gtl::flat_hash_map<key, uint32_t, key_hasher> index;
+    stats_s stats;
+    uint32_t hand = 0;
+
+    explicit impl_s(uint32_t capacity);
+    uint32_t take_slot();
+};
+
+los_cache::impl_s::impl_s(uint32_t capacity):
+    slots{ValueInit, capacity}
+{
+    fm_assert(capacity > 0);
+    index.reserve(capacity);
+}
+
+// clock: skip the slots hit since the hand last passed them
+uint32_t los_cache::impl_s::take_slot()
+{
+    const auto n = (uint32_t)slots.size();
+    for (;;)
+    {
+        const auto i = hand;
+        hand = (hand + 1) % n;
+        auto& s = slots[i];
+        if (!s.used)
+            return i;
+        if (s.recent)
+        {
+            s.recent = false;
+            continue;
+        }
+        index.erase(s.k);
+        s.used = false;
+        stats.evicted++;
+        return i;
+    }
+}
+
+float los_cache::stats_s::hit_rate() const
+{
+    const auto total = hits + misses;
+    return total ? (float)((double)hits / (double)total) : 0.f;
+}
+
+los_cache::los_cache(uint32_t capacity): impl{InPlaceInit, capacity} {}
+los_cache::~los_cache() noexcept = default;
+
+bool los_cache::can_see(world& w, point from, point to, uint32_t pred_id,
+                        Grid::Pass::Pool& pool, const Search::pred& pred)
+{
+    fm_assert(from.chunk3().z == to.chunk3().z);
+    auto& I = *impl;
+    const auto div_size = pool.params().div_size;
+    const auto z = from.chunk3().z;
+    const auto a = Fov::cell_of(from, div_size), b = Fov::cell_of(to, div_size);
+    const auto k = key{a.x(), a.y(), b.x(), b.y(), z, pred_id};
+    const auto from_ = cell_center(a, z, div_size), to_ = cell_center(b, z, div_size);
+
+    uint32_t i;
+    if (auto it = I.index.find(k); it != I.index.end())
+    {
+        i = it->second;
+        auto& s = I.slots[i];
+        if (is_fresh(w, s))
+        {
+            I.stats.hits++;
+            s.recent = true;
+            return s.visible;
+        }
+        I.stats.stale++;
+    }
+    else
+    {
+        slot tmp;
+        if (!gather_deps(w, from_, to_, tmp))
+        {
+            I.stats.misses++;
+            I.stats.uncached++;
+            return raycast(w, from_, to_, 0, pool, pred).success;
+        }
+        i = I.take_slot();
+        I.index[k] = i;
+    }
+
+    I.stats.misses++;
+    auto& s = I.slots[i];
+    s.k = k;
+    (void)gather_deps(w, from_, to_, s);
+    s.visible = raycast(w, from_, to_, 0, pool, pred).success;
+    s.used = true;
+    s.recent = false;
+    return s.visible;
+}
+
+void los_cache::clear()
+{
+    for (auto& s : impl->slots)
+        s.used = false;
+    impl->index.clear();
+    impl->hand = 0;
+}
+
+auto los_cache::stats() const -> const stats_s& { return impl->stats; }
+uint32_t los_cache::size() const { return (uint32_t)impl->index.size(); }
+uint32_t los_cache::capacity() const { return (uint32_t)impl->slots.size(); }
+
+} // namespace floormat::rc
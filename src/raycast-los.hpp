@@ -0,0 +1,46 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "raycast.hpp"
+#include <cr/Pointer.h>
+
+namespace floormat::rc {
+
+// Remembers "can A see B" between pass grid cells. Every entry is tagged
+// with the pass_gen of the chunks its ray reads, i.e. the chunks it crosses
+// and their neighbors, and is re-checked against them on each hit. Dynamic
+// objects don't bump pass_gen when they move, so the predicate has to let
+// them through, as the shoot-through one does with critters; that includes
+// the observer, since rays are cast with self = 0.
+class los_cache final
+{
+public:
+    struct stats_s
+    {
+        uint64_t hits = 0, misses = 0, stale = 0, evicted = 0, uncached = 0;
+        float hit_rate() const;
+    };
+
+    explicit los_cache(uint32_t capacity = 4096);
+    ~los_cache() noexcept;
+    fm_DISABLE_MOVE_COPY(los_cache);
+
+    // `from` and `to` are snapped to the centers of their cells in `pool`,
+    // which has to be built with `pred`. `pred_id` tells predicates apart.
+    bool can_see(world& w, point from, point to, uint32_t pred_id,
+                 Grid::Pass::Pool& pool, const Search::pred& pred);
+
+    void clear();
+    const stats_s& stats() const;
+    uint32_t size() const;
+    uint32_t capacity() const;
+
+    // rays whose chunks don't fit are cast every time
+    static constexpr uint32_t max_chunks = 16;
+
+    struct impl_s;
+
+private:
+    Pointer<impl_s> impl;
+};
+
+} // namespace floormat::rc
@@ -0,0 +1,40 @@
+#pragma once
+#include "raycast.hpp"
+#include <cr/Array.h>
+
+namespace floormat::rc {
+
+// Frozen copy of what raycast() reads around a chunk: the pass grid bits and
+// the colliders that block under the predicate. It's captured on the main
+// thread, and after that it can be read from any thread while the world
+// changes. Rays must stay within radius - 1 chunks of the center.
+struct raycast_snapshot
+{
+    struct rect
+    {
+        Vector2 min, max;
+        collision_data data;
+    };
+
+    struct chunk_data
+    {
+        chunk_coords_ coord;
+        Array<uint8_t> bits;
+        Array<rect> rects;
+        bool present : 1 = false,
+             all_empty : 1 = false;
+    };
+
+    void capture(world& w, chunk_coords_ center, int32_t radius,
+                 Grid::Pass::Pool& pool, const Search::pred& pred, object_id self);
+    const chunk_data* find(chunk_coords_ coord) const;
+
+    Array<chunk_data> chunks;
+    chunk_coords_ center;
+    int32_t radius = 0;
+    uint32_t div_size = 0;
+};
+
+[[nodiscard]] raycast_result_s raycast(const raycast_snapshot& snap, point from, point to);
+
+} // namespace floormat::rc
@@ -1,4 +1,5 @@
 #include "raycast-diag.hpp"
+#include "raycast-snapshot.hpp"
 #include "tile-constants.hpp"
 #include "pass-mode.hpp"
 #include "world.hpp"
@@ -7,13 +8,27 @@
 #include "search.hpp"
 #include "RTree-search.hpp"
 #include "compat/function2.hpp"
+#include "compat/arch.hpp"
+#include "compat/cpu-features.hpp"
 #include <cfloat>
 #include <bit>
+#include <algorithm>
+#include <cstring>
 #include <cr/StructuredBindings.h>
 #include <cr/GrowableArray.h>
 #include <mg/Functions.h>
 #include <mg/Timeline.h>
 
+#if defined __x86_64__ || (defined __i386__ && defined __SSE2__)
+#   define FM_RAYCAST_X86
+#   include <immintrin.h>
+#   if defined _MSC_VER && !defined __clang__
+#       define FM_RAYCAST_AVX2_TARGET
+#   else
+#       define FM_RAYCAST_AVX2_TARGET [[gnu::target("avx2")]]
+#   endif
+#endif
+
 namespace floormat::rc {
 
 namespace {
@@ -89,10 +104,81 @@ constexpr bool within_chunk_bounds(Math::Vector2<T> p0, Math::Vector2<T> p1)
 
 template bool within_chunk_bounds<int>(Math::Vector2<int> p0, Math::Vector2<int> p1);
 
-template<bool EnableDiagnostics>
+bool is_blocking(chunk& c, collision_data x, const Rect& r,
+                 object_id self, const Search::pred& pred)
+{
+    if (x.id == self || x.pass == (uint64_t)pass_mode::pass)
+        return false;
+    // same hole-marker filter as is_passable_1
+    if (x.type == (uint64_t)collision_type::none)
+        return false;
+    auto range = Range2D{{r.m_min[0], r.m_min[1]}, {r.m_max[0], r.m_max[1]}};
+    return pred(c, x, range) != path_search_continue::pass;
+}
+
+// what the walk reads, straight from the world. the pool has to be in sync
+// with the world's frame already.
+struct world_source
+{
+    using chunk_ref = chunk*;
+
+    world& w;
+    Grid::Pass::Pool& pool;
+    const Search::pred& pred;
+    object_id self;
+
+    int32_t div_size() const { return (int32_t)pool.params().div_size; }
+    chunk_ref at(chunk_coords_ coord) const { return w.at(coord); }
+
+    // nullptr if no cell is blocked
+    const uint8_t* bits(chunk_ref c) const
+    {
+        auto g = pool[*c];
+        // a pool holds bitmaps built for one predicate only (see grid-pass.hpp)
+        g.build_if_stale(pred);
+        return g.is_all_empty() ? nullptr : g.bits().data;
+    }
+
+    template<typename F>
+    void search(chunk_ref c, Vector2 fmin, Vector2 fmax, F&& fun) const
+    {
+        c->rtree()->Search(fmin.data(), fmax.data(), [&](uint64_t data, const Rect& r)
+        {
+            auto x = std::bit_cast<collision_data>(data);
+            if (is_blocking(*c, x, r, self, pred))
+                fun(x, Vector2{r.m_min[0], r.m_min[1]}, Vector2{r.m_max[0], r.m_max[1]});
+            return true;
+        });
+    }
+};
+
+// same, from a raycast_snapshot. colliders were filtered when it was captured,
+// but come out in a different order than from the RTree, so of two colliders
+// hit at the exact same distance the other one may be reported.
+struct snapshot_source
+{
+    using chunk_ref = const raycast_snapshot::chunk_data*;
+
+    const raycast_snapshot& snap;
+
+    int32_t div_size() const { return (int32_t)snap.div_size; }
+    chunk_ref at(chunk_coords_ coord) const { return snap.find(coord); }
+    const uint8_t* bits(chunk_ref c) const { return c->all_empty ? nullptr : c->bits.data(); }
+
+    template<typename F>
+    void search(chunk_ref c, Vector2 fmin, Vector2 fmax, F&& fun) const
+    {
+        // same inclusive test as RTree::Overlap()
+        for (const auto& r : c->rects)
+            if (!(fmin.x() > r.max.x() || r.min.x() > fmax.x() ||
+                  fmin.y() > r.max.y() || r.min.y() > fmax.y()))
+                fun(r.data, r.min, r.max);
+    }
+};
+
+template<bool EnableDiagnostics, typename Source>
 raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_diag_s&, std::nullptr_t> diag,
-                               world& w, point from, point to, object_id self,
-                               Grid::Pass::Pool& pool, const Search::pred& pred)
+                               const Source& src, point from, point to)
 {
     raycast_result_s result;
     fm_assert(from.chunk3().z == to.chunk3().z);
@@ -141,11 +227,8 @@ raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_dia
         .success = false,
     };
 
-    if (pool.frame_no() != w.frame_no())
-        pool.maybe_mark_stale_all(w.frame_no());
-
     constexpr auto half_tile_i = tile_size<int>.x() / 2;
-    const auto div_size_i = (int32_t)pool.params().div_size;
+    const auto div_size_i = src.div_size();
     const auto div_size_f = (float)div_size_i;
     const auto cells_per_chunk = chunk_size<int>.x() / div_size_i;
 
@@ -207,9 +290,9 @@ raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_dia
     }
 
     Vector2i last_chunk_off { (int32_t)1<<30, (int32_t)1<<30 };
-    chunk* last_nb[9] = {};
-    chunk* last_c = nullptr;
-    Pass::Grid last_g{nullptr, nullptr};
+    typename Source::chunk_ref last_nb[9] = {};
+    typename Source::chunk_ref last_c = nullptr;
+    const uint8_t* last_bits = nullptr;
     bool last_g_built = false;
     bool last_chunk_empty = true;
 
@@ -232,7 +315,7 @@ raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_dia
                         (int16_t)(from.chunk().x + chunk_off_x + i - 1),
                         (int16_t)(from.chunk().y + chunk_off_y + j - 1),
                         from.chunk3().z };
-                    last_nb[j*3 + i] = w.at(co);
+                    last_nb[j*3 + i] = src.at(co);
                 }
             last_c = last_nb[4];
             last_g_built = false;
@@ -260,17 +343,16 @@ raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_dia
         {
             if (!last_g_built)
             {
-                last_g = pool[*last_c];
-                // a pool holds bitmaps built for one predicate only (see grid-pass.hpp)
-                last_g.build_if_stale(pred);
-                last_chunk_empty = last_g.is_all_empty();
+                last_bits = src.bits(last_c);
+                last_chunk_empty = !last_bits;
                 last_g_built = true;
             }
             if (!last_chunk_empty)
             {
                 auto bit_idx = Pass::Grid::get_bitmask_index(
                     (uint32_t)local_cell_x, (uint32_t)local_cell_y, (uint32_t)cells_per_chunk);
-                bit = last_g.bit(bit_idx);
+                // same layout as BitView::read()
+                bit = last_bits[bit_idx >> 3] >> (bit_idx & 7) & 1;
             }
         }
         else
@@ -335,25 +417,15 @@ raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_dia
                         (float)(from.local().y * tile_size<int>.y() + from.offset().y()) - nb_world_y,
                     };
 
-                    nb->rtree()->Search(fmin.data(), fmax.data(), [&](uint64_t data, const Rect& r)
+                    src.search(nb, fmin, fmax, [&](collision_data x, Vector2 rmin, Vector2 rmax)
                     {
-                        auto x = std::bit_cast<collision_data>(data);
-                        if (x.id == self || x.pass == (uint64_t)pass_mode::pass)
-                            return true;
-                        // same hole-marker filter as is_passable_1
-                        if (x.type == (uint64_t)collision_type::none)
-                            return true;
-                        auto range = Range2D{{r.m_min[0], r.m_min[1]}, {r.m_max[0], r.m_max[1]}};
-                        if (pred(*nb, x, range) == path_search_continue::pass)
-                            return true;
                         auto ret = ray_aabb_intersection(origin, dir_inv_norm,
-                                                         {{{r.m_min[0]-fuzz2, r.m_min[1]-fuzz2},
-                                                           {r.m_max[0]+fuzz2, r.m_max[1]+fuzz2}}},
+                                                         {{rmin - Vector2{fuzz2}, rmax + Vector2{fuzz2}}},
                                                          signs);
                         if (!ret.result)
-                            return true;
+                            return;
                         if (ret.tmin > ray_len) [[unlikely]]
-                            return true;
+                            return;
                         if (ret.tmin < min_tmin) [[likely]]
                         {
                             min_tmin = ret.tmin;
@@ -361,7 +433,6 @@ raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_dia
                             result.collider = x;
                             b = false;
                         }
-                        return true;
                     });
                 }
             }
@@ -444,6 +515,330 @@ raycast_result_s do_raycasting(std::conditional_t<EnableDiagnostics, raycast_dia
     return result;
 }
 
+
+// Batched walk. Every lane runs the same DDA as do_raycasting() over the pass
+// grid bits only. A lane that stays in clear cells until the end of its ray is
+// a success without looking at the RTree, anything else is left for the exact
+// walk. Float rounding may differ from the scalar loop by a few ulps, so near
+// ties between the x and y steps probe the cell the other branch would've
+// entered as well. That keeps the clear set a superset of the cells the
+// scalar walk visits, and any disagreement only sends a ray to the slow path.
+
+constexpr uint32_t lane_count = 8;
+constexpr float tie_abs = .25f, tie_rel = 1e-4f;
+
+constexpr int32_t floor_div(int32_t a, int32_t b)
+{
+    return a >= 0 ? a / b : -((b - 1 - a) / b);
+}
+
+enum class cell_state : uint8_t { clear, bits, blocked, };
+
+struct bitmap_cache
+{
+    struct entry
+    {
+        chunk_coords_ coord;
+        const uint8_t* bits = nullptr;
+        cell_state state = cell_state::blocked;
+        bool valid = false;
+    };
+
+    world& w;
+    Grid::Pass::Pool& pool;
+    const Search::pred& pred;
+    int32_t cells_per_chunk;
+    std::array<entry, 64> slots = {};
+
+    const entry& get(chunk_coords_ coord)
+    {
+        auto& e = slots[((uint32_t)coord.x & 7) | ((uint32_t)coord.y & 7) << 3];
+        if (e.valid && e.coord == coord) [[likely]]
+            return e;
+
+        e = { .coord = coord, .bits = nullptr, .state = cell_state::blocked, .valid = true, };
+        if (auto* c = w.at(coord))
+        {
+            auto g = pool[*c];
+            g.build_if_stale(pred);
+            if (g.is_all_empty())
+                e.state = cell_state::clear;
+            else
+            {
+                e.bits = g.bits().data;
+                e.state = cell_state::bits;
+            }
+        }
+        else
+        {
+            // same rule as do_raycasting(): a missing chunk is only clear if
+            // no loaded neighbor can overhang into it
+            bool all_missing = true;
+            for (int j = -1; j <= 1; j++)
+                for (int i = -1; i <= 1; i++)
+                    all_missing &= !w.at(coord + Vector2i{i, j});
+            e.state = all_missing ? cell_state::clear : cell_state::blocked;
+        }
+        return e;
+    }
+
+    bool is_clear(chunk_coords_ origin, int32_t cell_x, int32_t cell_y)
+    {
+        const auto cpc = cells_per_chunk;
+        const auto off_x = floor_div(cell_x, cpc), off_y = floor_div(cell_y, cpc);
+        const auto& e = get({ (int16_t)(origin.x + off_x), (int16_t)(origin.y + off_y), origin.z });
+        switch (e.state)
+        {
+        case cell_state::clear: return true;
+        case cell_state::blocked: return false;
+        case cell_state::bits: break;
+        }
+        // same layout as GridBase::pack_bit_index() and BitView::read()
+        const auto idx = (uint32_t)((cell_y - off_y * cpc) * cpc + (cell_x - off_x * cpc));
+        return e.bits[idx >> 3] >> (idx & 7) & 1;
+    }
+};
+
+struct ray_lanes
+{
+    alignas(32) float t_max_x[lane_count], t_max_y[lane_count];
+    alignas(32) float t_delta_x[lane_count], t_delta_y[lane_count];
+    alignas(32) float t_entry[lane_count], t_end[lane_count];
+    alignas(32) int32_t cell_x[lane_count], cell_y[lane_count];
+    alignas(32) int32_t step_x[lane_count], step_y[lane_count];
+    alignas(32) int32_t stepped_x[lane_count], tie[lane_count];
+    chunk_coords_ origin[lane_count];
+    uint32_t ray[lane_count];
+};
+
+// advances every lane by one cell, free lanes included
+void step_lanes_scalar(ray_lanes& L)
+{
+    for (auto i = 0u; i < lane_count; i++)
+    {
+        const float tx = L.t_max_x[i], ty = L.t_max_y[i];
+        const bool x = tx < ty;
+        L.tie[i] = -(int32_t)(Math::abs(tx - ty) <= tie_abs + tie_rel * Math::min(tx, ty));
+        L.stepped_x[i] = -(int32_t)x;
+        if (x)
+        {
+            L.t_entry[i] = tx;
+            L.t_max_x[i] = tx + L.t_delta_x[i];
+            L.cell_x[i] += L.step_x[i];
+        }
+        else
+        {
+            L.t_entry[i] = ty;
+            L.t_max_y[i] = ty + L.t_delta_y[i];
+            L.cell_y[i] += L.step_y[i];
+        }
+    }
+}
+
+#ifdef FM_RAYCAST_X86
+
+// all eight lanes at once, same as above
+FM_RAYCAST_AVX2_TARGET
+void step_lanes_avx2(ray_lanes& L)
+{
+    const auto tx = _mm256_load_ps(L.t_max_x), ty = _mm256_load_ps(L.t_max_y);
+    const auto dx = _mm256_load_ps(L.t_delta_x), dy = _mm256_load_ps(L.t_delta_y);
+    const auto cx = _mm256_load_si256((const __m256i*)L.cell_x);
+    const auto cy = _mm256_load_si256((const __m256i*)L.cell_y);
+    const auto sx = _mm256_load_si256((const __m256i*)L.step_x);
+    const auto sy = _mm256_load_si256((const __m256i*)L.step_y);
+
+    const auto mx = _mm256_cmp_ps(tx, ty, _CMP_LT_OQ);
+    const auto mxi = _mm256_castps_si256(mx);
+    const auto diff = _mm256_andnot_ps(_mm256_set1_ps(-0.f), _mm256_sub_ps(tx, ty));
+    const auto tol = _mm256_add_ps(_mm256_set1_ps(tie_abs),
+                                   _mm256_mul_ps(_mm256_set1_ps(tie_rel), _mm256_min_ps(tx, ty)));
+
+    _mm256_store_ps(L.t_entry, _mm256_blendv_ps(ty, tx, mx));
+    _mm256_store_ps(L.t_max_x, _mm256_blendv_ps(tx, _mm256_add_ps(tx, dx), mx));
+    _mm256_store_ps(L.t_max_y, _mm256_blendv_ps(_mm256_add_ps(ty, dy), ty, mx));
+    _mm256_store_si256((__m256i*)L.cell_x, _mm256_add_epi32(cx, _mm256_and_si256(sx, mxi)));
+    _mm256_store_si256((__m256i*)L.cell_y, _mm256_add_epi32(cy, _mm256_andnot_si256(mxi, sy)));
+    _mm256_store_si256((__m256i*)L.stepped_x, mxi);
+    _mm256_store_si256((__m256i*)L.tie, _mm256_castps_si256(_mm256_cmp_ps(diff, tol, _CMP_LE_OQ)));
+}
+
+#endif // FM_RAYCAST_X86
+
+using step_lanes_fn = void(*)(ray_lanes& L);
+
+step_lanes_fn get_lane_kernel(lane_kernel kernel)
+{
+    switch (kernel)
+    {
+    case lane_kernel::scalar: return step_lanes_scalar;
+#ifdef FM_RAYCAST_X86
+    case lane_kernel::avx2: return cpu_has_avx2() ? step_lanes_avx2 : nullptr;
+#endif
+    default: return nullptr;
+    }
+}
+
+enum class lane_start : uint8_t { trivial, walk, exact, };
+
+lane_start start_lane(ray_lanes& L, uint32_t i, const ray& r, bitmap_cache& G, float div_size_f)
+{
+    using Math::abs;
+    using Math::floor;
+
+    constexpr auto eps = 1e-6f;
+    constexpr auto half_tile_i = tile_size<int>.x() / 2;
+
+    fm_assert(r.from.chunk3().z == r.to.chunk3().z);
+
+    const auto V = pt_to_vec(r.from, r.to);
+    const auto ray_len = V.length();
+    if (ray_len < eps)
+        return lane_start::trivial;
+    const auto dir = V * (1.f/ray_len);
+
+    const Vector2 from_shifted {
+        (float)(r.from.local().x * tile_size<int>.x() + r.from.offset().x() + half_tile_i),
+        (float)(r.from.local().y * tile_size<int>.y() + r.from.offset().y() + half_tile_i),
+    };
+    const auto cell_x = (int32_t)floor(from_shifted.x() / div_size_f);
+    const auto cell_y = (int32_t)floor(from_shifted.y() / div_size_f);
+    const int step_x = dir.x() > 0 ? 1 : (dir.x() < 0 ? -1 : 0);
+    const int step_y = dir.y() > 0 ? 1 : (dir.y() < 0 ? -1 : 0);
+
+    L.t_max_x[i] = step_x == 0 ? FLT_MAX :
+        (((step_x > 0 ? (float)(cell_x + 1) : (float)cell_x) * div_size_f) - from_shifted.x()) / dir.x();
+    L.t_max_y[i] = step_y == 0 ? FLT_MAX :
+        (((step_y > 0 ? (float)(cell_y + 1) : (float)cell_y) * div_size_f) - from_shifted.y()) / dir.y();
+    L.t_delta_x[i] = step_x == 0 ? FLT_MAX : abs(div_size_f / dir.x());
+    L.t_delta_y[i] = step_y == 0 ? FLT_MAX : abs(div_size_f / dir.y());
+    L.t_entry[i] = 0;
+    L.t_end[i] = ray_len + eps + tie_abs + tie_rel * ray_len;
+    L.cell_x[i] = cell_x;
+    L.cell_y[i] = cell_y;
+    L.step_x[i] = step_x;
+    L.step_y[i] = step_y;
+    L.origin[i] = r.from.chunk3();
+
+    return G.is_clear(L.origin[i], cell_x, cell_y) ? lane_start::walk : lane_start::exact;
+}
+
+raycast_result_s clear_result(point from, point to)
+{
+    return {
+        .from = from,
+        .to = to,
+        .collision = {},
+        .collider = {
+            .type = (uint64_t)collision_type::none,
+            .pass = (uint64_t)pass_mode::pass,
+            .id   = ((uint64_t)1 << collision_data_BITS)-1,
+        },
+        .has_result = true,
+        .success = true,
+    };
+}
+
+void do_raycasting_many(world& w, ArrayView<const ray> rays, ArrayView<raycast_result_s> results,
+                        Grid::Pass::Pool& pool, const Search::pred& pred, lane_kernel kernel)
+{
+    fm_assert(rays.size() == results.size());
+    const auto step_lanes = get_lane_kernel(kernel);
+    fm_assert(step_lanes);
+    const auto count = (uint32_t)rays.size();
+    if (!count)
+        return;
+
+    if (pool.frame_no() != w.frame_no())
+        pool.maybe_mark_stale_all(w.frame_no());
+
+    const auto div_size_i = (int32_t)pool.params().div_size;
+    const auto div_size_f = (float)div_size_i;
+    auto G = bitmap_cache{ w, pool, pred, chunk_size<int>.x() / div_size_i, };
+
+    // rays from the same chunk share most of their bitmaps
+    Array<uint32_t> order{NoInit, count};
+    for (auto i = 0u; i < count; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const auto ca = rays[a].from.chunk3(), cb = rays[b].from.chunk3();
+        if (ca.z != cb.z) return ca.z < cb.z;
+        if (ca.y != cb.y) return ca.y < cb.y;
+        if (ca.x != cb.x) return ca.x < cb.x;
+        return a < b;
+    });
+
+    Array<uint32_t> exact;
+    ray_lanes L;
+    for (auto i = 0u; i < lane_count; i++)
+    {
+        L.t_max_x[i] = L.t_max_y[i] = L.t_delta_x[i] = L.t_delta_y[i] = 1;
+        L.cell_x[i] = L.cell_y[i] = L.step_x[i] = L.step_y[i] = 0;
+    }
+    uint32_t active = 0, next = 0;
+
+    const auto refill = [&] {
+        for (auto i = 0u; i < lane_count && next < count; i++)
+        {
+            if (active & (1u << i))
+                continue;
+            while (next < count)
+            {
+                const auto idx = order[next++];
+                const auto& r = rays[idx];
+                const auto st = start_lane(L, i, r, G, div_size_f);
+                if (st == lane_start::walk)
+                {
+                    L.ray[i] = idx;
+                    active |= 1u << i;
+                    break;
+                }
+                else if (st == lane_start::trivial)
+                    results[idx] = clear_result(r.from, r.to);
+                else
+                    arrayAppend(exact, idx);
+            }
+        }
+    };
+
+    refill();
+    while (active)
+    {
+        step_lanes(L);
+        for (auto i = 0u; i < lane_count; i++)
+        {
+            if (!(active & (1u << i)))
+                continue;
+            const auto idx = L.ray[i];
+            if (L.t_entry[i] > L.t_end[i])
+            {
+                results[idx] = clear_result(rays[idx].from, rays[idx].to);
+                active &= ~(1u << i);
+                continue;
+            }
+            bool clear = G.is_clear(L.origin[i], L.cell_x[i], L.cell_y[i]);
+            if (clear && L.tie[i])
+            {
+                const auto ox = L.stepped_x[i] ? -L.step_x[i] : L.step_x[i],
+                           oy = L.stepped_x[i] ? L.step_y[i] : -L.step_y[i];
+                clear = G.is_clear(L.origin[i], L.cell_x[i] + ox, L.cell_y[i] + oy);
+            }
+            if (!clear)
+            {
+                arrayAppend(exact, idx);
+                active &= ~(1u << i);
+            }
+        }
+        refill();
+    }
+
+    for (auto idx : exact)
+    {
+        const auto& r = rays[idx];
+        results[idx] = do_raycasting<false>(nullptr, world_source{w, pool, pred, r.self}, r.from, r.to);
+    }
+}
+
 } // namespace
 
 raycast_result_s raycast(world& w, point from, point to, object_id self,
@@ -451,7 +846,9 @@ raycast_result_s raycast(world& w, point from, point to, object_id self,
 {
     Timeline timeline;
     timeline.start();
-    auto ret = do_raycasting<false>(nullptr, w, from, to, self, pass_grid_pool, pred);
+    if (pass_grid_pool.frame_no() != w.frame_no())
+        pass_grid_pool.maybe_mark_stale_all(w.frame_no());
+    auto ret = do_raycasting<false>(nullptr, world_source{w, pass_grid_pool, pred, self}, from, to);
     ret.time = timeline.currentFrameDuration();
     return ret;
 }
@@ -466,7 +863,9 @@ raycast_result_s raycast_with_diag(raycast_diag_s& diag, world& w, point from, p
 {
     Timeline timeline;
     timeline.start();
-    auto ret = do_raycasting<true>(diag, w, from, to, self, pass_grid_pool, pred);
+    if (pass_grid_pool.frame_no() != w.frame_no())
+        pass_grid_pool.maybe_mark_stale_all(w.frame_no());
+    auto ret = do_raycasting<true>(diag, world_source{w, pass_grid_pool, pred, self}, from, to);
     ret.time = timeline.currentFrameDuration();
     return ret;
 }
@@ -476,4 +875,109 @@ raycast_result_s raycast_with_diag(raycast_diag_s& diag, world& w, point from, p
     return raycast_with_diag(diag, w, from, to, self, w.raycast_pass_pool(), Search::never_continue());
 }
 
+raycast_result_s raycast(const raycast_snapshot& snap, point from, point to)
+{
+    Timeline timeline;
+    timeline.start();
+    auto ret = do_raycasting<false>(nullptr, snapshot_source{snap}, from, to);
+    ret.time = timeline.currentFrameDuration();
+    return ret;
+}
+
+void raycast_snapshot::capture(world& w, chunk_coords_ center_, int32_t radius_,
+                               Grid::Pass::Pool& pool, const Search::pred& pred, object_id self)
+{
+    fm_assert(radius_ >= 0);
+    if (pool.frame_no() != w.frame_no())
+        pool.maybe_mark_stale_all(w.frame_no());
+
+    center = center_;
+    radius = radius_;
+    div_size = pool.params().div_size;
+
+    const auto side = (uint32_t)(2*radius + 1);
+    const auto dc = chunk_size_xy / div_size;
+    const auto byte_count = (dc*dc + 7) / 8;
+    if (chunks.size() != side*side)
+        chunks = Array<chunk_data>{ValueInit, side*side};
+
+    constexpr float inf = FLT_MAX;
+    constexpr float all_min[2] = { -inf, -inf }, all_max[2] = { inf, inf };
+
+    for (auto j = 0u; j < side; j++)
+        for (auto i = 0u; i < side; i++)
+        {
+            auto& d = chunks[j*side + i];
+            d.coord = center + Vector2i{(int)i - radius, (int)j - radius};
+            d.present = false;
+            arrayClear(d.rects);
+
+            auto* c = w.at(d.coord);
+            if (!c)
+                continue;
+
+            d.present = true;
+            auto g = pool[*c];
+            g.build_if_stale(pred);
+            d.all_empty = g.is_all_empty();
+            if (d.bits.size() != byte_count)
+                d.bits = Array<uint8_t>{NoInit, byte_count};
+            std::memcpy(d.bits.data(), g.bits().data, byte_count);
+
+            c->rtree()->Search(all_min, all_max, [&](uint64_t data, const Rect& r) {
+                auto x = std::bit_cast<collision_data>(data);
+                if (is_blocking(*c, x, r, self, pred))
+                    arrayAppend(d.rects, rect{
+                        .min = {r.m_min[0], r.m_min[1]},
+                        .max = {r.m_max[0], r.m_max[1]},
+                        .data = x,
+                    });
+                return true;
+            });
+        }
+}
+
+auto raycast_snapshot::find(chunk_coords_ coord) const -> const chunk_data*
+{
+    const auto dx = coord.x - center.x, dy = coord.y - center.y;
+    if (coord.z != center.z || Math::abs(dx) > radius || Math::abs(dy) > radius)
+        return nullptr;
+    const auto side = 2*radius + 1;
+    const auto& d = chunks[(uint32_t)((dy + radius)*side + dx + radius)];
+    return d.present ? &d : nullptr;
+}
+
+bool has_lane_kernel(lane_kernel kernel)
+{
+    return get_lane_kernel(kernel) != nullptr;
+}
+
+lane_kernel best_lane_kernel()
+{
+    static const auto kernel = has_lane_kernel(lane_kernel::avx2) ? lane_kernel::avx2 : lane_kernel::scalar;
+    return kernel;
+}
+
+void raycast_many(world& w, ArrayView<const ray> rays, ArrayView<raycast_result_s> results,
+                  Grid::Pass::Pool& pass_grid_pool, Search::pred const& pred, lane_kernel kernel)
+{
+    Timeline timeline;
+    timeline.start();
+    do_raycasting_many(w, rays, results, pass_grid_pool, pred, kernel);
+    const auto time = timeline.currentFrameDuration();
+    for (auto& r : results)
+        r.time = time;
+}
+
+void raycast_many(world& w, ArrayView<const ray> rays, ArrayView<raycast_result_s> results,
+                  Grid::Pass::Pool& pass_grid_pool, Search::pred const& pred)
+{
+    raycast_many(w, rays, results, pass_grid_pool, pred, best_lane_kernel());
+}
+
+void raycast_many(world& w, ArrayView<const ray> rays, ArrayView<raycast_result_s> results)
+{
+    raycast_many(w, rays, results, w.raycast_pass_pool(), Search::never_continue());
+}
+
 } // namespace floormat::rc
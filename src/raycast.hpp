@@ -3,6 +3,7 @@
 #include "src/collision.hpp"
 #include "src/point.hpp"
 #include "src/search-pred.hpp"
+#include <cr/ArrayView.h>
 
 namespace floormat {
 
@@ -27,6 +28,12 @@ struct raycast_result_s
          success    : 1 = false;
 };
 
+struct ray
+{
+    point from, to;
+    object_id self = 0;
+};
+
 [[nodiscard]] raycast_result_s raycast(world& w, point from, point to, object_id self);
 [[nodiscard]] raycast_result_s raycast(world& w, point from, point to, object_id self,
                                        Grid::Pass::Pool& pass_grid_pool, Search::pred const& pred);
@@ -34,10 +41,27 @@ struct raycast_result_s
 [[nodiscard]] raycast_result_s raycast_with_diag(raycast_diag_s& diag, world& w, point from, point to, object_id self,
                                                  Grid::Pass::Pool& pass_grid_pool, const Search::pred& pred);
 
+// how raycast_many() advances its eight lanes. avx2 is picked at run time
+// when the CPU has it, see has_lane_kernel().
+enum class lane_kernel : uint8_t { scalar, avx2, };
+
+bool has_lane_kernel(lane_kernel kernel);
+lane_kernel best_lane_kernel();
+
+// Same results as one raycast() per ray. Rays are walked over the pass grid
+// bitmaps eight at a time, and only those that touch an occupied cell run
+// the exact per-ray walk. `time` is set to the duration of the whole batch.
+void raycast_many(world& w, ArrayView<const ray> rays, ArrayView<raycast_result_s> results);
+void raycast_many(world& w, ArrayView<const ray> rays, ArrayView<raycast_result_s> results,
+                  Grid::Pass::Pool& pass_grid_pool, const Search::pred& pred);
+void raycast_many(world& w, ArrayView<const ray> rays, ArrayView<raycast_result_s> results,
+                  Grid::Pass::Pool& pass_grid_pool, const Search::pred& pred, lane_kernel kernel);
+
 } // namespace floormat::rc
 
 namespace floormat {
 
 using floormat::rc::raycast;
+using floormat::rc::raycast_many;
 
 } // namespace floormat
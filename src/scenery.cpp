@@ -3,6 +3,7 @@
 #include "compat/assert.hpp"
 #include "compat/exception.hpp"
 #include "compat/borrowed-ptr.inl"
+#include "compat/non-const.hpp"
 #include "tile-constants.hpp"
 #include "anim-atlas.hpp"
 #include "rotation.inl"
@@ -68,7 +69,10 @@ generic_scenery::operator generic_scenery_proto() const
 
 generic_scenery::generic_scenery(object_id id, class chunk& c, const generic_scenery_proto& p, const scenery_proto& p0) :
     scenery{id, c, p0}, active{p.active}, interactive{p.interactive}
-{}
+{
+    // update() doesn't do anything
+    non_const(awake) = false;
+}
 
 // ---------- door_scenery ----------
 
@@ -77,7 +81,7 @@ enum scenery_type door_scenery::scenery_type() const { return scenery_type::door
 void door_scenery::update(const bptr<object>&, size_t&, const Ns& dt)
 {
     if (!atlas || !active)
-        return;
+        return sleep();
 
     fm_assert(atlas);
     auto& anim = *atlas;
@@ -103,6 +107,7 @@ void door_scenery::update(const bptr<object>&, size_t&, const Ns& dt)
     {
         closing = false;
         delta = 0;
+        sleep();
     }
     //if ((p == pass_mode::pass) != (old_pass == pass_mode::pass)) Debug{} << "update: need reposition" << (frame == 0 ? "-1" : "1");
 }
@@ -127,6 +132,7 @@ bool door_scenery::activate(size_t)
     closing = frame == 0;
     frame += closing ? 1 : -1;
     active = true;
+    wake();
     return true;
 }
 
@@ -148,6 +154,8 @@ door_scenery::operator door_scenery_proto() const
 
 door_scenery::door_scenery(object_id id, class chunk& c, const door_scenery_proto& p, const scenery_proto& p0) :
     scenery{id, c, p0}, closing{p.closing}, active{p.active}, interactive{p.interactive}
-{}
+{
+    non_const(awake) = active;
+}
 
 } // namespace floormat
@@ -12,6 +12,7 @@ enum class script_destroy_reason : uint8_t
     quit,       // game is being shut down
     kill,       // object is being deleted from the gameworld
     unassign,   // script is unassigned from object
+    unload,     // object's chunk is being paged out, see world::page_out()
     COUNT,
 };
 
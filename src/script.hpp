@@ -51,6 +51,7 @@ public:
     script_lifecycle state() const;
     S* operator->();
     explicit operator bool() const;
+    bool is_empty() const;
 
     void do_create(S* ptr);
     void do_create(Pointer<S> ptr);
@@ -1,6 +1,7 @@
 #pragma once
 #include "script.hpp"
 #include "compat/assert.hpp"
+#include "compat/borrowed-ptr.inl"
 #include <utility>
 #include <cr/StringView.h>
 #include <cr/Pointer.h>
@@ -61,6 +62,7 @@ Script<S, Obj>::Script(): ptr{nullptr}, _state{script_lifecycle::no_init}
 
 template <typename S, typename Obj> script_lifecycle Script<S, Obj>::state() const { return _state; }
 template<typename S, typename Obj> Script<S, Obj>::operator bool() const { return ptr; }
+template<typename S, typename Obj> bool Script<S, Obj>::is_empty() const { return ptr == make_empty(); }
 
 template <typename S, typename Obj>
 S* Script<S, Obj>::operator->()
@@ -116,6 +118,7 @@ void Script<S, Obj>::do_reassign(S* p, const bptr<Obj>& obj)
     ptr->delete_self();
     ptr = p;
     p->on_init(obj);
+    obj->wake();
 }
 
 template <typename S, typename Obj>
@@ -6,6 +6,7 @@
 #include "search.hpp"
 #include "world.hpp"
 #include "point.inl"
+#include "timer.hpp"
 #include "compat/array-size.hpp"
 #include "compat/format.hpp"
 #include "compat/function2.hpp"
@@ -14,7 +15,6 @@
 #include <cr/GrowableArray.h>
 #include <mg/Functions.h>
 #include <mg/Range.h>
-#include <mg/Timeline.h>
 
 namespace floormat {
 
@@ -32,6 +32,14 @@ struct astar::frontier
     uint32_t g_score = (uint32_t)-1;
 };
 
+// one small heap per integer f-score, ordered by the same comparator as
+// the binary heap, so ties come out the same way
+struct astar::buckets
+{
+    Array<Array<frontier>> list;
+    uint32_t cur = (uint32_t)-1, max = 0, count = 0;
+};
+
 using visited = astar::visited;
 using frontier = astar::frontier;
 using Search::div_size;
@@ -40,34 +48,6 @@ using Search::min_size;
 
 namespace {
 
-void simplify_path(ArrayView<const point> src, Array<point>& dest)
-{
-    const auto size = (uint32_t)src.size();
-
-    if (size == 0) [[unlikely]]
-        return;
-
-    arrayAppend(dest, src[0]);
-    if (size < 2) [[unlikely]]
-        return;
-
-    auto last_vec = src[1] - src[0];
-
-    for (auto i = 2u; i < size; i++)
-    {
-        const auto vec = src[i] - src[i-1];
-        if (vec != last_vec)
-        {
-            if (dest.back() != src[i-1])
-                arrayAppend(dest, src[i-1]);
-            last_vec = vec;
-        }
-    }
-
-    if (dest.back() != src.back())
-        arrayAppend(dest, src.back());
-}
-
 struct dir_step { Vector2i dir; uint32_t len; };
 
 constexpr auto directions = []() constexpr
@@ -94,11 +74,14 @@ constexpr auto directions = []() constexpr
 
 struct heap_comparator
 {
+    // node id last so both frontier policies pop in the same order
     static bool operator()(frontier a, frontier b)
     {
         const auto ka = (uint64_t{a.f_score} << 32) | uint64_t{~a.g_score};
         const auto kb = (uint64_t{b.f_score} << 32) | uint64_t{~b.g_score};
-        return ka > kb;
+        if (ka != kb)
+            return ka > kb;
+        return a.node > b.node;
     }
 };
 
@@ -128,7 +111,7 @@ void set_result_from_idx(path_search_result& result,
     arrayAppend(temp_nodes, from);
 
     std::reverse(temp_nodes.begin(), temp_nodes.end());
-    simplify_path(temp_nodes, result.raw_path());
+    Search::simplify_path(temp_nodes, result.raw_path());
     arrayClear(temp_nodes);
 }
 
@@ -146,6 +129,43 @@ frontier pop_from_heap(Array<frontier>& Q)
     return n;
 }
 
+bool is_empty(const Array<frontier>& Q) { return Q.isEmpty(); }
+void clear_frontier(Array<frontier>& Q) { arrayResize(Q, 0); }
+
+void add_to_heap(astar::buckets& B, uint32_t id, uint32_t f_score, uint32_t g_score)
+{
+    if (f_score >= B.list.size()) [[unlikely]]
+        arrayResize(B.list, Math::max(f_score + 1, (uint32_t)B.list.size() * 2));
+    auto& b = B.list[f_score];
+    add_to_heap(b, id, f_score, g_score);
+    B.count++;
+    // f is almost monotone, but the goal hop and the heuristic's rounding can
+    // push below the bucket being drained, so step back rather than reorder
+    B.cur = Math::min(B.cur, f_score);
+    B.max = Math::max(B.max, f_score);
+}
+
+frontier pop_from_heap(astar::buckets& B)
+{
+    fm_debug_assert(B.count > 0);
+    while (B.list[B.cur].isEmpty())
+        B.cur++;
+    B.count--;
+    return pop_from_heap(B.list[B.cur]);
+}
+
+bool is_empty(const astar::buckets& B) { return B.count == 0; }
+
+void clear_frontier(astar::buckets& B)
+{
+    if (B.count > 0)
+        for (auto i = B.cur; i <= B.max; i++)
+            arrayResize(B.list[i], 0);
+    B.count = 0;
+    B.cur = (uint32_t)-1;
+    B.max = 0;
+}
+
 bool is_passable_swept(world& w, Search::cache& cache, Grid::Pass::Pool& pool,
                        point a, point b, const astar::pred& p)
 {
@@ -180,10 +200,10 @@ bool is_passable_swept(world& w, Search::cache& cache, Grid::Pass::Pool& pool,
     return true;
 }
 
-template<bool IsDiagonal, int Debug>
+template<bool IsDiagonal, int Debug, typename Frontier>
 CORRADE_ALWAYS_INLINE
 void do_dir(world& w, Grid::Pass::Pool& pool, Search::cache& cache,
-            Array<visited>& nodes, Array<frontier>& Q,
+            Array<visited>& nodes, Frontier& Q,
             const astar::pred& p, const astar::heuristic& h,
             dir_step dirs,
             point to, point cur_pt,
@@ -239,8 +259,60 @@ void do_dir(world& w, Grid::Pass::Pool& pool, Search::cache& cache,
 
 } // namespace
 
+void Search::simplify_path(ArrayView<const point> src, Array<point>& dest)
+{
+    const auto size = (uint32_t)src.size();
+
+    if (size == 0) [[unlikely]]
+        return;
+
+    arrayAppend(dest, src[0]);
+    if (size < 2) [[unlikely]]
+        return;
+
+    auto last_vec = src[1] - src[0];
+
+    for (auto i = 2u; i < size; i++)
+    {
+        const auto vec = src[i] - src[i-1];
+        if (vec != last_vec)
+        {
+            if (dest.back() != src[i-1])
+                arrayAppend(dest, src[i-1]);
+            last_vec = vec;
+        }
+    }
+
+    if (dest.back() != src.back())
+        arrayAppend(dest, src.back());
+}
+
+struct astar::state
+{
+    world* w = nullptr;
+    Grid::Pass::Pool* pool = nullptr;
+    pred p = Search::never_continue();
+    heuristic h = Search::octile_distance();
+    point from, to;
+    uint32_t max_dist = 0;
+    Vector2ui own_size;
+
+    uint32_t closest_h = (uint32_t)-1;
+    uint32_t closest_idx = (uint32_t)-1;
+    uint32_t goal_idx = (uint32_t)-1;
+    uint32_t to_idx = (uint32_t)-1;
+
+    uint32_t expanded = 0, slices = 0;
+    Ns elapsed{};
+    frontier_policy policy = frontier_policy::binary_heap;
+    search_status status = search_status::idle;
+    path_search_result result;
+};
+
 astar::astar() :
-    _cache{InPlaceInit, (uint32_t)Search::div_size.x()}
+    _cache{InPlaceInit, (uint32_t)Search::div_size.x()},
+    _buckets{InPlaceInit},
+    _state{InPlaceInit}
 {
 }
 
@@ -255,55 +327,107 @@ void astar::reserve(size_t capacity)
 void astar::clear()
 {
     arrayResize(nodes, 0);
-    arrayResize(Q, 0);
+    clear_frontier(Q);
+    clear_frontier(*_buckets);
 }
 
 Search::cache* astar::cache() { return &*_cache; }
+void astar::set_frontier_policy(frontier_policy policy) { _policy = policy; }
+auto astar::get_frontier_policy() const -> frontier_policy { return _policy; }
+auto astar::status() const -> search_status { return _state->status; }
+uint32_t astar::expansion_count() const { return _state->expanded; }
+uint32_t astar::slice_count() const { return _state->slices; }
 
 template<int Debug>
 path_search_result astar::Dijkstra(world& w, const point from, const point to,
-                                   uint32_t max_dist, Vector2ui own_size_,
+                                   uint32_t max_dist, Vector2ui own_size,
                                    const pred& p, const heuristic& h)
 {
-    reserve(initial_capacity);
+    begin(w, from, to, max_dist, own_size, p, h);
+    resume<Debug>(w, {});
+    return take_result();
+}
 
-    Timeline timeline;
-    if constexpr(Debug > 0)
-        timeline.start();
+void astar::begin(world& w, const point from, const point to,
+                  uint32_t max_dist, Vector2ui own_size_,
+                  const pred& p, const heuristic& h)
+{
+    const auto t0 = Time::now();
 
+    reserve(initial_capacity);
     clear();
 
+    auto& s = *_state;
+    s.w = &w;
+    s.pool = nullptr;
+    s.p = p;
+    s.h = h;
+    s.from = from;
+    s.to = to;
+    s.max_dist = max_dist;
+    s.closest_h = (uint32_t)-1;
+    s.closest_idx = (uint32_t)-1;
+    s.goal_idx = (uint32_t)-1;
+    s.to_idx = (uint32_t)-1;
+    s.expanded = 0;
+    s.slices = 0;
+    s.elapsed = Ns{};
+    s.policy = _policy;
+    s.status = search_status::done;
+    s.result = {};
+
     if (from.coord().z() != to.coord().z()) [[unlikely]]
-        return {};
+        return;
 
     // todo try removing this eventually
     if (from.coord().z() != 0) [[unlikely]]
-        return {};
+        return;
 
-    auto& cache = *_cache;
-    cache.allocate(from, max_dist);
+    _cache->allocate(from, max_dist);
 
     constexpr auto size_max = uint32_t{tile_size_xy}*uint32_t{TILE_MAX_DIM};
     fm_assert(own_size_ < Vector2ui{size_max});
-    const auto own_size = Math::max(own_size_, min_size);
-    constexpr auto goal_thres_lin = (uint32_t)(div_size.length() + 1.5f);
+    s.own_size = Math::max(own_size_, min_size);
 
-    const auto bbox_size = Math::max(own_size.x(), own_size.y());
-    auto& pool = w.pass_pool_registry().pool_for(bbox_size);
-    pool.maybe_mark_stale_all(w.frame_no());
+    const auto bbox_size = Math::max(s.own_size.x(), s.own_size.y());
+    s.pool = &w.pass_pool_registry().pool_for(bbox_size);
+    s.pool->maybe_mark_stale_all(w.frame_no());
 
-    auto* const from_chunk = w.at(from.chunk3());
-    const auto from_neighbors = w.neighbors(from.chunk3());
-    const auto from_center = TILE_SIZE2 * Vector2(from.local()) + Vector2(from.offset());
-    const auto own_half = Vector2(own_size/2);
+    const auto own_half = Vector2(s.own_size/2);
 
-    if (auto R = Range2D::fromCenter(from_center, own_half);
-        !Search::is_passable_(from_chunk, from_neighbors, R.min(), R.max(), p))
-        return {};
+    if (auto R = Range2D::fromCenter(TILE_SIZE2 * Vector2(from.local()) + Vector2(from.offset()), own_half);
+        !Search::is_passable_(w.at(from.chunk3()), w.neighbors(from.chunk3()), R.min(), R.max(), p))
+        return;
 
     if (auto R = Range2D::fromCenter(TILE_SIZE2 * Vector2(to.local()) + Vector2(to.offset()), own_half);
         !Search::is_passable_(w.at(to.chunk3()), w.neighbors(to.chunk3()), R.min(), R.max(), p))
-        return {};
+        return;
+
+    switch (s.policy)
+    {
+    case frontier_policy::binary_heap: seed_(Q); break;
+    case frontier_policy::bucket_queue: seed_(*_buckets); break;
+    }
+
+    s.status = search_status::running;
+    s.elapsed += Time::now() - t0;
+}
+
+template<typename Frontier>
+void astar::seed_(Frontier& Q)
+{
+    auto& s = *_state;
+    auto& w = *s.w;
+    auto& cache = *_cache;
+    auto& pool = *s.pool;
+    const auto from = s.from, to = s.to;
+    const auto& p = s.p;
+    const auto& h = s.h;
+
+    auto* const from_chunk = w.at(from.chunk3());
+    const auto from_neighbors = w.neighbors(from.chunk3());
+    const auto from_center = TILE_SIZE2 * Vector2(from.local()) + Vector2(from.offset());
+    const auto own_half = Vector2(s.own_size/2);
 
     constexpr Vector2i seed_offsets[9] = {
         {  0,             0            },
@@ -334,18 +458,86 @@ path_search_result astar::Dijkstra(world& w, const point from, const point to,
             cache.add_index(pt, idx);
             arrayAppend(nodes, {.dist = dist, .prev = (uint32_t)-1, .pt = pt, });
             uint32_t f_score = dist + h(pt, to);
-            if (dist < max_dist && f_score < max_dist)
+            if (dist < s.max_dist && f_score < s.max_dist)
                 add_to_heap(Q, idx, f_score, dist);
         }
     }
+}
 
-    auto closest_h = (uint32_t)-1;
-    uint32_t closest_idx = (uint32_t)-1;
-    auto goal_idx = (uint32_t)-1;
-    auto to_idx = (uint32_t)-1;
+template<int Debug>
+auto astar::resume(world& w, const slice_budget& budget) -> search_status
+{
+    auto& s = *_state;
+    if (s.status != search_status::running)
+        return s.status;
+
+    fm_assert(s.w == &w);
+    fm_assert(budget.max_expansions > 0);
 
-    while (!Q.isEmpty())
+    const auto t0 = Time::now();
+    const auto expanded0 = s.expanded;
+    // other code may have advanced the frame since the last slice
+    s.pool->maybe_mark_stale_all(w.frame_no());
+
+    bool done = false;
+    switch (s.policy)
+    {
+    case frontier_policy::binary_heap:
+        if ((done = step_<Debug>(Q, budget, t0)))
+            clear_frontier(Q);
+        break;
+    case frontier_policy::bucket_queue:
+        if ((done = step_<Debug>(*_buckets, budget, t0)))
+            clear_frontier(*_buckets);
+        break;
+    }
+
+    const auto dt = Time::now() - t0;
+    s.elapsed += dt;
+    s.slices++;
+
+    if constexpr (Debug >= 1)
     {
+        char buf[128];
+        auto len = snformat(buf, "Dijkstra: slice {} expanded {} in {:.2f} ms\n"_cf,
+                            s.slices, s.expanded - expanded0, Time::to_milliseconds(dt));
+        len = Math::min(len, array_size(buf)-1);
+        std::fwrite(buf, len, 1, stdout);
+        std::fflush(stdout);
+    }
+
+    if (done)
+        finish_<Debug>();
+
+    return s.status;
+}
+
+template<int Debug, typename Frontier>
+bool astar::step_(Frontier& Q, const slice_budget& budget, const Time& t0)
+{
+    constexpr auto goal_thres_lin = (uint32_t)(div_size.length() + 1.5f);
+    // Time::now() isn't free, don't call it on every pop
+    constexpr uint32_t clock_interval = 64;
+
+    auto& s = *_state;
+    auto& w = *s.w;
+    auto& cache = *_cache;
+    auto& pool = *s.pool;
+    const auto to = s.to;
+    const auto max_dist = s.max_dist;
+    const auto& p = s.p;
+    const auto& h = s.h;
+
+    const bool timed = budget.max_time != Ns{(uint64_t)-1};
+    uint32_t count = 0;
+
+    while (!is_empty(Q))
+    {
+        if (count >= budget.max_expansions) [[unlikely]]
+            return false;
+        if (timed && count && count % clock_interval == 0 && Time::now() - t0 >= budget.max_time) [[unlikely]]
+            return false;
+
         const auto front = pop_from_heap(Q);
         const auto cur_idx = front.node;
         point cur_pt;
@@ -355,23 +547,25 @@ path_search_result astar::Dijkstra(world& w, const point from, const point to,
             continue;
         cur_pt = n.pt;
         cur_dist = n.dist;
+        count++;
+        s.expanded++;
 
-        if (cur_idx == to_idx) [[unlikely]]
+        if (cur_idx == s.to_idx) [[unlikely]]
         {
-            goal_idx = cur_idx;
-            break;
+            s.goal_idx = cur_idx;
+            return true;
         }
 
         const uint32_t goal_dist = point::distance(cur_pt, to);
 
-        if (goal_dist < closest_h)
+        if (goal_dist < s.closest_h)
         {
-            closest_h = goal_dist;
-            closest_idx = cur_idx;
+            s.closest_h = goal_dist;
+            s.closest_idx = cur_idx;
 
             if constexpr (Debug >= 2)
                 DBG_nospace << "closest node"
-                            << " px:" << closest_h << " path:" << cur_dist
+                            << " px:" << goal_dist << " path:" << cur_dist
                             << " pos:" << cur_pt;
         }
 
@@ -380,18 +574,18 @@ path_search_result astar::Dijkstra(world& w, const point from, const point to,
             if (is_passable_swept(w, cache, pool, cur_pt, to, p))
             {
                 const auto new_dist = cur_dist + goal_dist;
-                if (to_idx == (uint32_t)-1)
+                if (s.to_idx == (uint32_t)-1)
                 {
-                    to_idx = (uint32_t)nodes.size();
+                    s.to_idx = (uint32_t)nodes.size();
                     arrayAppend(nodes, visited{ .dist = new_dist, .prev = cur_idx, .pt = to, });
-                    add_to_heap(Q, to_idx, new_dist, new_dist);
+                    add_to_heap(Q, s.to_idx, new_dist, new_dist);
                 }
-                else if (new_dist < nodes[to_idx].dist)
+                else if (new_dist < nodes[s.to_idx].dist)
                 {
-                    auto& tn = nodes[to_idx];
+                    auto& tn = nodes[s.to_idx];
                     tn.dist = new_dist;
                     tn.prev = cur_idx;
-                    add_to_heap(Q, to_idx, new_dist, new_dist);
+                    add_to_heap(Q, s.to_idx, new_dist, new_dist);
                 }
             }
         }
@@ -405,22 +599,31 @@ path_search_result astar::Dijkstra(world& w, const point from, const point to,
         }
     }
 
-    path_search_result result;
+    return true;
+}
+
+template<int Debug>
+void astar::finish_()
+{
+    auto& s = *_state;
+    const auto from = s.from, to = s.to;
+    auto& result = s.result;
 
-    if (goal_idx != (uint32_t)-1)
+    if (s.goal_idx != (uint32_t)-1)
     {
         result.set_found(true);
         result.set_distance(0);
-        set_result_from_idx(result, temp_nodes, nodes, from, to, goal_idx);
+        set_result_from_idx(result, temp_nodes, nodes, from, to, s.goal_idx);
     }
-    else if (closest_idx != (uint32_t)-1)
+    else if (s.closest_idx != (uint32_t)-1)
     {
         result.set_found(false);
-        result.set_distance(closest_h);
-        set_result_from_idx(result, temp_nodes, nodes, from, to, closest_idx);
+        result.set_distance(s.closest_h);
+        set_result_from_idx(result, temp_nodes, nodes, from, to, s.closest_idx);
     }
 
-    result.set_time(timeline.currentFrameTime());
+    result.set_time(Time::to_seconds(s.elapsed));
+    s.status = search_status::done;
 
     if constexpr (Debug >= 1)
     {
@@ -428,27 +631,29 @@ path_search_result astar::Dijkstra(world& w, const point from, const point to,
             Vector2i(Math::abs(from.coord() - to.coord())) * iTILE_SIZE2
             + Vector2i(Math::abs(Vector2i(from.offset()) - Vector2i(to.offset())));
         auto d0 = (uint32_t)d0_.length();
-        char buf[128];
+        char buf[160];
         size_t len = 0;
         const auto time = result.time() * 1e3f;
-        if (goal_idx != (uint32_t)-1)
+        if (s.goal_idx != (uint32_t)-1)
         {
-            auto d = nodes[goal_idx].dist;
+            auto d = nodes[s.goal_idx].dist;
             len = snformat(buf, "Dijkstra: found in {:.2f} ms "
-                                "len:{} len0:{} ratio:{:.4}\n"_cf,
+                                "len:{} len0:{} ratio:{:.4} expanded:{} slices:{}\n"_cf,
                            time, d, d0,
-                           d > 0 && d0 > 0 ? (float)d/(float)d0 : 1);
+                           d > 0 && d0 > 0 ? (float)d/(float)d0 : 1,
+                           s.expanded, s.slices);
         }
-        else if (closest_idx != (uint32_t)-1)
+        else if (s.closest_idx != (uint32_t)-1)
         {
-            const auto& closest = nodes[closest_idx];
+            const auto& closest = nodes[s.closest_idx];
             // dist == 0 is legitimate: the {0,0} seed costs nothing when the
             // start has no sub-tile offset, and it can remain the closest node
             fm_assert(closest.dist != (uint32_t)-1);
             len = snformat(buf, "Dijkstra: no path found in {:.2f} ms "
-                                "closest:{} len:{} len0:{} ratio:{:.4}\n"_cf,
-                           time, closest_h, closest.dist, d0,
-                           d0 > 0 ? (float)closest.dist/(float)d0 : 1);
+                                "closest:{} len:{} len0:{} ratio:{:.4} expanded:{} slices:{}\n"_cf,
+                           time, s.closest_h, closest.dist, d0,
+                           d0 > 0 ? (float)closest.dist/(float)d0 : 1,
+                           s.expanded, s.slices);
         }
         if (len)
         {
@@ -457,15 +662,23 @@ path_search_result astar::Dijkstra(world& w, const point from, const point to,
             std::fflush(stdout);
         }
     }
+}
 
-    arrayResize(Q, 0);
-
-    return result;
+path_search_result astar::take_result()
+{
+    auto& s = *_state;
+    fm_assert(s.status == search_status::done);
+    s.status = search_status::idle;
+    return move(s.result);
 }
 
 template path_search_result astar::Dijkstra<0>(world&, point, point, uint32_t, Vector2ui, const pred&, const heuristic&);
 template path_search_result astar::Dijkstra<1>(world&, point, point, uint32_t, Vector2ui, const pred&, const heuristic&);
 template path_search_result astar::Dijkstra<2>(world&, point, point, uint32_t, Vector2ui, const pred&, const heuristic&);
 template path_search_result astar::Dijkstra<3>(world&, point, point, uint32_t, Vector2ui, const pred&, const heuristic&);
+template auto astar::resume<0>(world&, const slice_budget&) -> search_status;
+template auto astar::resume<1>(world&, const slice_budget&) -> search_status;
+template auto astar::resume<2>(world&, const slice_budget&) -> search_status;
+template auto astar::resume<3>(world&, const slice_budget&) -> search_status;
 
 } // namespace floormat
@@ -3,14 +3,21 @@
 #include "search-constants.hpp"
 #include "search-pred.hpp"
 #include "object-id.hpp"
+#include "nanosecond.hpp"
 #include <cr/Array.h>
+#include <cr/Pointer.h>
 
-namespace floormat::Search { struct cache; }
+namespace floormat { struct point; struct Time; }
+
+namespace floormat::Search {
+struct cache;
+// drops intermediate points that continue in the same direction
+void simplify_path(ArrayView<const point> src, Array<point>& dest);
+} // namespace floormat::Search
 
 namespace floormat {
 
 class world;
-struct point;
 struct path_search_result;
 
 class astar
@@ -18,16 +25,34 @@ class astar
 public:
     struct visited;
     struct frontier;
+    struct buckets;
+    struct state;
+
+    // costs are small integers, so a bucket per f-score beats the binary heap
+    // on big open searches. both pop in the same order and find the same paths.
+    enum class frontier_policy : uint8_t { binary_heap, bucket_queue, };
 
     using pred = Search::pred;
     using heuristic = Search::heuristic;
 
+    enum class search_status : uint8_t { idle, running, done, };
+
+    // whichever runs out first ends the slice. the clock is only read every
+    // few dozen expansions, so a slice can overshoot max_time by that much.
+    struct slice_budget
+    {
+        uint32_t max_expansions = (uint32_t)-1;
+        Ns max_time{(uint64_t)-1};
+    };
+
     astar();
     ~astar() noexcept;
     void reserve(size_t capacity);
     void clear();
 
     struct Search::cache* cache();
+    void set_frontier_policy(frontier_policy policy);
+    frontier_policy get_frontier_policy() const;
 
     // todo add simple bresenham short-circuit
     template<int Debug = 0>
@@ -36,13 +61,35 @@ public:
                                 const pred& p,
                                 const heuristic& h = Search::octile_distance());
 
+    // resumable Dijkstra(): begin() seeds the search, each resume() expands
+    // nodes until the budget runs out, and take_result() hands over the path
+    // once the status is done. unless the world changes between slices the
+    // result is the same as a single Dijkstra() call. `p` and `h` are views
+    // and have to outlive the search.
+    void begin(world& w, point from, point to,
+               uint32_t max_dist, Vector2ui own_size,
+               const pred& p,
+               const heuristic& h = Search::octile_distance());
+    template<int Debug = 0> search_status resume(world& w, const slice_budget& budget);
+    path_search_result take_result();
+    search_status status() const;
+    uint32_t expansion_count() const;
+    uint32_t slice_count() const;
+
 private:
     static constexpr auto initial_capacity = TILE_COUNT * 32 * Search::div_factor*Search::div_factor;
 
+    template<typename Frontier> void seed_(Frontier& Q);
+    template<int Debug, typename Frontier> bool step_(Frontier& Q, const slice_budget& budget, const Time& t0);
+    template<int Debug> void finish_();
+
     safe_ptr<struct Search::cache> _cache;
+    Pointer<buckets> _buckets;
+    Pointer<state> _state;
     Array<visited> nodes;
     Array<frontier> Q;
     Array<point> temp_nodes;
+    frontier_policy _policy = frontier_policy::binary_heap;
 };
 
 } // namespace floormat
@@ -42,14 +42,16 @@ void cache::allocate(point from, uint32_t max_dist)
     auto cells_per_chunk = (size_t)div_count_ * div_count_;
     auto total_cells = len * cells_per_chunk;
 
-    if (total_cells > exists.size())
+    if (total_cells > slots.size())
     {
-        indexes = Array<uint32_t>{NoInit, total_cells};
-        exists = BitArray{ValueInit, total_cells};
+        slots = Array<slot>{ValueInit, total_cells};
+        generation = 1;
     }
-    else
+    else if (++generation == 0) [[unlikely]]
     {
-        exists.resetAll();
+        for (auto& s : slots)
+            s.generation = 0;
+        generation = 1;
     }
 }
 
@@ -87,9 +89,9 @@ void cache::add_index(size_t chunk_index, size_t tile_index, uint32_t index)
     fm_debug_assert(index != (uint32_t)-1);
     auto cells_per_chunk = (size_t)div_count_ * div_count_;
     auto flat = chunk_index * cells_per_chunk + tile_index;
-    fm_debug_assert(!exists[flat]);
-    exists.set(flat);
-    indexes[flat] = index;
+    auto& s = slots[flat];
+    fm_debug_assert(s.generation != generation);
+    s = { generation, index };
 }
 
 void cache::add_index(point pt, uint32_t index)
@@ -104,8 +106,9 @@ uint32_t cache::lookup_index(size_t chunk_index, size_t tile_index)
 {
     auto cells_per_chunk = (size_t)div_count_ * div_count_;
     auto flat = chunk_index * cells_per_chunk + tile_index;
-    if (exists[flat])
-        return indexes[flat];
+    const auto& s = slots[flat];
+    if (s.generation == generation)
+        return s.index;
     else
         return (uint32_t)-1;
 }
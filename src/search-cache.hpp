@@ -2,7 +2,6 @@
 #include "compat/defs.hpp"
 #include "grid-pass.hpp"
 #include <cr/Array.h>
-#include <cr/BitArray.h>
 #include <mg/Vector2.h>
 
 namespace floormat {
@@ -15,12 +14,20 @@ namespace floormat::Search {
 
 struct cache
 {
+    // a slot only counts if its stamp matches the current search, so
+    // allocate() doesn't have to wipe the whole window every query
+    struct slot
+    {
+        uint32_t generation = 0;
+        uint32_t index;
+    };
+
     Vector2ui size;
     Vector2i start{(int)((1u << 31) - 1)};
     uint32_t div_size_;
     uint32_t div_count_;
-    Array<uint32_t> indexes;
-    BitArray exists;
+    uint32_t generation = 0;
+    Array<slot> slots;
 
     explicit cache(uint32_t div_size);
     ~cache() noexcept;
@@ -0,0 +1,527 @@
+#include "search-dstar.hpp"
+#include "search-astar.hpp"
+#include "search-cache.hpp"
+#include "search-constants.hpp"
+#include "search-result.hpp"
+#include "grid-pass.hpp"
+#include "grid-pass-pool.hpp"
+#include "world.hpp"
+#include "point.inl"
+#include "compat/function2.hpp"
+#include "compat/hash-table-load-factor.hpp"
+#include <algorithm>
+#include <cr/GrowableArray.h>
+#include <mg/Functions.h>
+#include <mg/Timeline.h>
+#include <gtl/phmap.hpp>
+
+namespace floormat {
+
+namespace {
+
+using Search::div_size;
+using Search::min_size;
+
+constexpr auto inf = (uint32_t)-1;
+constexpr int div = (int)div_size.x();
+constexpr int div_count = (int)chunk_size_xy / div;
+constexpr int half_tile = tile_size_xy / 2;
+constexpr uint32_t axial_cost = (uint32_t)div_size.x();
+constexpr uint32_t diag_cost = (uint32_t)(div_size.length() + 1.f); // NOLINT, same as search-astar.cpp
+static_assert(div_size.x() == div_size.y());
+
+enum : uint8_t { pass_unknown, pass_yes, pass_no, };
+
+constexpr Vector2i cell_dirs[8] = {
+    { -1, -1 }, {  0, -1 }, {  1, -1 }, { -1,  0 },
+    {  1,  1 }, {  1,  0 }, { -1,  1 }, {  0,  1 },
+};
+
+constexpr int floor_div(int a, int b)
+{
+    const int q = a / b;
+    return (a < 0 && a % b) ? q - 1 : q;
+}
+
+constexpr uint32_t add_sat(uint32_t a, uint32_t b)
+{
+    return a == inf || b == inf || a + b < a ? inf : a + b;
+}
+
+constexpr uint32_t heuristic(Vector2i a, Vector2i b)
+{
+    const auto d = Vector2ui(Math::abs(a - b));
+    const uint32_t mn = Math::min(d.x(), d.y()), mx = Math::max(d.x(), d.y());
+    return mx * axial_cost + mn * (diag_cost - axial_cost);
+}
+
+constexpr uint64_t cell_hash_key(Vector2i cell)
+{
+    return uint64_t{(uint32_t)cell.x()} << 32 | uint64_t{(uint32_t)cell.y()};
+}
+
+Vector2i cell_from_point(point pt)
+{
+    const auto px = Vector3i(pt);
+    return { floor_div(px.x() + half_tile, div), floor_div(px.y() + half_tile, div) };
+}
+
+point point_from_cell(Vector2i cell, int8_t z)
+{
+    // the lattice point of a cell is its low corner, the same points Dijkstra() visits
+    return point{Vector3i{cell.x() * div - half_tile, cell.y() * div - half_tile, z * tile_size_z}};
+}
+
+chunk_coords_ chunk_of_cell(Vector2i cell, int8_t z)
+{
+    return { (int16_t)floor_div(cell.x(), div_count), (int16_t)floor_div(cell.y(), div_count), z };
+}
+
+struct key
+{
+    uint32_t k1 = inf, k2 = inf;
+    constexpr bool operator==(const key&) const noexcept = default;
+    constexpr auto operator<=>(const key&) const noexcept = default;
+};
+
+struct heap_entry
+{
+    key k;
+    uint32_t idx;
+};
+
+struct heap_comparator
+{
+    static bool operator()(const heap_entry& a, const heap_entry& b)
+    {
+        if (a.k != b.k)
+            return a.k > b.k;
+        return a.idx > b.idx;
+    }
+};
+
+} // namespace
+
+struct dstar_lite::node
+{
+    Vector2i cell;
+    uint32_t g = inf, rhs = inf;
+    key k;
+    bool queued : 1 = false;
+    uint8_t pass : 2 = pass_unknown;
+};
+
+struct dstar_lite::Impl
+{
+    Array<node> nodes;
+    Array<heap_entry> Q;
+    Array<uint64_t> pending;
+    gtl::flat_hash_map<uint64_t, uint32_t> index;
+    gtl::flat_hash_map<chunk_coords_, uint64_t, Hash::chunk_coord_hasher> seen_chunks;
+    Search::cache cache{(uint32_t)div};
+
+    pred p = Search::never_continue();
+    struct stats st;
+    point from, to;
+    Vector2i start, last_start, goal;
+    Vector2i window_min, window_max;
+    uint32_t bbox_size = 0, max_dist = 0, km = 0;
+    int8_t z = 0;
+    bool valid = false;
+
+    Grid::Pass::Pool& pool(world& w);
+    bool in_window(Vector2i cell) const;
+    uint32_t find(Vector2i cell) const;
+    uint32_t find_or_add(Vector2i cell);
+    bool passable(world& w, uint32_t idx);
+    uint32_t cost(world& w, Vector2i from_cell, Vector2i dir);
+    key calc_key(uint32_t idx) const;
+    void update_vertex(world& w, uint32_t idx);
+    void push(uint32_t idx);
+    bool top(heap_entry& ret);
+    void compute_shortest_path(world& w);
+    void note_chunk(chunk_coords_ ch, uint64_t build_no);
+    void cell_changed(world& w, Vector2i cell);
+};
+
+Grid::Pass::Pool& dstar_lite::Impl::pool(world& w)
+{
+    return w.pass_pool_registry().pool_for(bbox_size);
+}
+
+bool dstar_lite::Impl::in_window(Vector2i cell) const
+{
+    return cell >= window_min && cell < window_max;
+}
+
+uint32_t dstar_lite::Impl::find(Vector2i cell) const
+{
+    auto it = index.find(cell_hash_key(cell));
+    return it != index.end() ? it->second : inf;
+}
+
+uint32_t dstar_lite::Impl::find_or_add(Vector2i cell)
+{
+    auto [it, fresh] = index.try_emplace(cell_hash_key(cell), (uint32_t)nodes.size());
+    if (fresh)
+    {
+        arrayAppend(nodes, node{ .cell = cell, });
+        Hash::set_open_addressing_load_factor(index);
+    }
+    return it->second;
+}
+
+void dstar_lite::Impl::note_chunk(chunk_coords_ ch, uint64_t build_no)
+{
+    if (seen_chunks.try_emplace(ch, build_no).second)
+        Hash::set_open_addressing_load_factor(seen_chunks);
+}
+
+bool dstar_lite::Impl::passable(world& w, uint32_t idx)
+{
+    if (auto pass = nodes[idx].pass; pass != pass_unknown)
+        return pass == pass_yes;
+
+    const auto cell = nodes[idx].cell;
+    bool ret;
+    if (!in_window(cell))
+        ret = false;
+    else
+    {
+        const auto ch = chunk_of_cell(cell, z);
+        auto& pool = this->pool(w);
+        if (auto* c = w.at(ch))
+        {
+            auto grid = pool[*c];
+            grid.build_if_stale(p);
+            note_chunk(ch, grid.build_no());
+            const auto local = cell - Vector2i(ch.x, ch.y) * div_count;
+            ret = grid.bit(Grid::Pass::Grid::get_bitmask_index((uint32_t)local.x(), (uint32_t)local.y(), (uint32_t)div_count));
+        }
+        else
+        {
+            // no grid for a missing chunk, but its neighbors' colliders can still reach in
+            note_chunk(ch, 0);
+            ret = cache.is_passable_for_bbox(w, pool, point_from_cell(cell, z), p);
+        }
+    }
+    nodes[idx].pass = ret ? pass_yes : pass_no;
+    return ret;
+}
+
+uint32_t dstar_lite::Impl::cost(world& w, Vector2i from_cell, Vector2i dir)
+{
+    const auto to_idx = find_or_add(from_cell + dir);
+    if (!passable(w, to_idx))
+        return inf;
+    if (dir.x() && dir.y())
+    {
+        // off-axis cells, same as cache::is_passable_between_diag()
+        if (!passable(w, find_or_add(from_cell + Vector2i{dir.x(), 0})) ||
+            !passable(w, find_or_add(from_cell + Vector2i{0, dir.y()})))
+            return inf;
+        return diag_cost;
+    }
+    return axial_cost;
+}
+
+key dstar_lite::Impl::calc_key(uint32_t idx) const
+{
+    const auto& n = nodes[idx];
+    const auto m = Math::min(n.g, n.rhs);
+    return { add_sat(add_sat(m, heuristic(start, n.cell)), km), m };
+}
+
+void dstar_lite::Impl::push(uint32_t idx)
+{
+    auto& n = nodes[idx];
+    n.k = calc_key(idx);
+    n.queued = true;
+    arrayAppend(Q, heap_entry{ n.k, idx });
+    std::push_heap(Q.begin(), Q.end(), heap_comparator{});
+}
+
+bool dstar_lite::Impl::top(heap_entry& ret)
+{
+    // entries are never removed in place; skip the ones superseded by a later push
+    while (!Q.isEmpty())
+    {
+        const auto& e = Q.front();
+        const auto& n = nodes[e.idx];
+        if (n.queued && n.k == e.k)
+        {
+            ret = e;
+            return true;
+        }
+        std::pop_heap(Q.begin(), Q.end(), heap_comparator{});
+        arrayRemoveSuffix(Q);
+    }
+    return false;
+}
+
+void dstar_lite::Impl::update_vertex(world& w, uint32_t idx)
+{
+    st.updated++;
+    if (nodes[idx].cell != goal)
+    {
+        uint32_t rhs = inf;
+        const auto cell = nodes[idx].cell;
+        for (auto dir : cell_dirs)
+        {
+            const auto c = cost(w, cell, dir);
+            if (c == inf)
+                continue;
+            const auto g = nodes[find(cell + dir)].g;
+            rhs = Math::min(rhs, add_sat(c, g));
+        }
+        nodes[idx].rhs = rhs;
+    }
+    auto& n = nodes[idx];
+    n.queued = false;
+    if (n.g != n.rhs)
+        push(idx);
+}
+
+void dstar_lite::Impl::compute_shortest_path(world& w)
+{
+    const auto start_idx = find_or_add(start);
+    heap_entry e;
+
+    while (top(e))
+    {
+        const auto start_key = calc_key(start_idx);
+        const auto& sn = nodes[start_idx];
+        if (!(e.k < start_key) && sn.rhs == sn.g)
+            break;
+        // every key left is a lower bound on the path cost; the goal is out of reach
+        if (e.k.k1 >= add_sat(max_dist, km))
+            break;
+
+        std::pop_heap(Q.begin(), Q.end(), heap_comparator{});
+        arrayRemoveSuffix(Q);
+        const auto u = e.idx;
+        nodes[u].queued = false;
+        st.expanded++;
+
+        if (const auto k_new = calc_key(u); e.k < k_new)
+            push(u);
+        else if (nodes[u].g > nodes[u].rhs)
+        {
+            nodes[u].g = nodes[u].rhs;
+            const auto cell = nodes[u].cell;
+            for (auto dir : cell_dirs)
+                update_vertex(w, find_or_add(cell + dir));
+        }
+        else
+        {
+            nodes[u].g = inf;
+            update_vertex(w, u);
+            const auto cell = nodes[u].cell;
+            for (auto dir : cell_dirs)
+                update_vertex(w, find_or_add(cell + dir));
+        }
+    }
+}
+
+void dstar_lite::Impl::cell_changed(world& w, Vector2i cell)
+{
+    st.cells_changed++;
+    if (auto idx = find(cell); idx != inf)
+        nodes[idx].pass = pass_unknown;
+    // only edges leading into the cell and diagonals cutting past it changed,
+    // and those all start at a neighbor. untouched neighbors have rhs = inf anyway.
+    for (auto dir : cell_dirs)
+        if (auto idx = find(cell + dir); idx != inf)
+            update_vertex(w, idx);
+}
+
+dstar_lite::dstar_lite() = default;
+dstar_lite::~dstar_lite() noexcept = default;
+
+void dstar_lite::reset(world& w, point from, point to, uint32_t max_dist, Vector2ui own_size_, const pred& p)
+{
+    auto& I = *impl;
+    arrayClear(I.nodes);
+    arrayClear(I.Q);
+    arrayClear(I.pending);
+    I.index.clear();
+    I.seen_chunks.clear();
+    I.st = {};
+    I.km = 0;
+    I.valid = false;
+
+    if (from.coord().z() != to.coord().z()) [[unlikely]]
+        return;
+
+    // todo same restriction as Dijkstra()
+    if (from.coord().z() != 0) [[unlikely]]
+        return;
+
+    constexpr auto size_max = uint32_t{tile_size_xy}*uint32_t{TILE_MAX_DIM};
+    fm_assert(own_size_ < Vector2ui{size_max});
+    const auto own_size = Math::max(own_size_, min_size);
+
+    I.p = p;
+    I.from = from;
+    I.to = to;
+    I.z = from.coord().z();
+    I.max_dist = max_dist;
+    I.bbox_size = Math::max(own_size.x(), own_size.y());
+    I.start = cell_from_point(from);
+    I.last_start = I.start;
+    I.goal = cell_from_point(to);
+
+    const auto off = Vector2i(Search::cache::get_size_to_allocate(max_dist));
+    const auto goal_chunk = Vector2i(to.chunk());
+    I.window_min = (goal_chunk - off) * div_count;
+    I.window_max = (goal_chunk + off + Vector2i(1)) * div_count;
+    I.valid = true;
+
+    I.pool(w).maybe_mark_stale_all(w.frame_no());
+
+    const auto goal_idx = I.find_or_add(I.goal);
+    I.nodes[goal_idx].rhs = 0;
+    I.push(goal_idx);
+}
+
+void dstar_lite::set_start(point from)
+{
+    auto& I = *impl;
+    fm_assert(I.valid);
+    fm_assert(from.coord().z() == I.z);
+    I.from = from;
+    I.start = cell_from_point(from);
+}
+
+bool dstar_lite::sync(world& w)
+{
+    auto& I = *impl;
+    if (!I.valid)
+        return false;
+
+    auto& pool = I.pool(w);
+    pool.maybe_mark_stale_all(w.frame_no());
+
+    arrayClear(I.pending);
+    Array<chunk_coords_> whole_chunks;
+
+    // paged-out chunks are redone whole rather than paged in here
+    for (auto& [ch, seen] : I.seen_chunks)
+    {
+        auto* c = w.resident_at(ch);
+        if (!c)
+        {
+            if (seen != 0)
+                arrayAppend(whole_chunks, ch);
+            seen = 0;
+            continue;
+        }
+        auto grid = pool[*c];
+        grid.build_if_stale(I.p);
+        const auto build_no = grid.build_no();
+        if (build_no == seen)
+            continue;
+        if (seen != 0 && grid.prev_build_no() == seen && grid.changes_complete())
+        {
+            const auto base = Vector2i(ch.x, ch.y) * div_count;
+            for (auto bit : grid.changed_cells())
+                arrayAppend(I.pending, cell_hash_key(base + Vector2i{(int)(bit % div_count), (int)(bit / div_count)}));
+        }
+        else
+            arrayAppend(whole_chunks, ch);
+        seen = build_no;
+    }
+
+    // a missing chunk's cells were checked against its neighbors' colliders,
+    // so redo them too when a neighbor changed
+    for (auto i = 0uz, sz = whole_chunks.size(); i < sz; i++)
+        for (auto off : world::neighbor_offsets)
+        {
+            const auto nb = whole_chunks[i] + off;
+            if (auto it = I.seen_chunks.find(nb); it != I.seen_chunks.end() && it->second == 0)
+                if (std::find(whole_chunks.begin(), whole_chunks.end(), nb) == whole_chunks.end())
+                    arrayAppend(whole_chunks, nb);
+        }
+
+    for (const auto& n : I.nodes)
+        if (std::find(whole_chunks.begin(), whole_chunks.end(), chunk_of_cell(n.cell, I.z)) != whole_chunks.end())
+            arrayAppend(I.pending, cell_hash_key(n.cell));
+    I.st.chunks_invalidated += (uint32_t)whole_chunks.size();
+
+    if (I.pending.isEmpty())
+        return false;
+
+    I.km = add_sat(I.km, heuristic(I.last_start, I.start));
+    I.last_start = I.start;
+
+    std::sort(I.pending.begin(), I.pending.end());
+    auto* const end = std::unique(I.pending.begin(), I.pending.end());
+    for (auto* k = I.pending.begin(); k != end; k++)
+        I.cell_changed(w, Vector2i{(int32_t)(uint32_t)(*k >> 32), (int32_t)(uint32_t)*k});
+    arrayClear(I.pending);
+
+    return true;
+}
+
+path_search_result dstar_lite::plan(world& w)
+{
+    auto& I = *impl;
+    path_search_result result;
+    if (!I.valid)
+        return result;
+
+    Timeline timeline;
+    timeline.start();
+
+    I.pool(w).maybe_mark_stale_all(w.frame_no());
+    I.compute_shortest_path(w);
+
+    const auto start_idx = I.find_or_add(I.start);
+    if (I.nodes[start_idx].g == inf)
+    {
+        result.set_time(timeline.currentFrameTime());
+        return result;
+    }
+
+    Array<point> temp_nodes;
+    arrayAppend(temp_nodes, I.from);
+    auto cur = I.start;
+    // each step strictly decreases g, so this can't loop; bound it anyway
+    for (auto i = 0uz, max = I.nodes.size(); cur != I.goal && i < max; i++)
+    {
+        auto best = inf;
+        Vector2i best_cell = cur;
+        for (auto dir : cell_dirs)
+        {
+            const auto c = I.cost(w, cur, dir);
+            if (c == inf)
+                continue;
+            if (auto val = add_sat(c, I.nodes[I.find(cur + dir)].g); val < best)
+            {
+                best = val;
+                best_cell = cur + dir;
+            }
+        }
+        if (best == inf) [[unlikely]]
+            return {};
+        cur = best_cell;
+        arrayAppend(temp_nodes, point_from_cell(cur, I.z));
+    }
+    if (cur != I.goal) [[unlikely]]
+        return {};
+    arrayAppend(temp_nodes, I.to);
+
+    Search::simplify_path(temp_nodes, result.raw_path());
+    result.set_found(true);
+    result.set_distance(0);
+    result.set_cost(I.nodes[start_idx].g);
+    result.set_time(timeline.currentFrameTime());
+    return result;
+}
+
+bool dstar_lite::is_valid() const { return impl->valid; }
+point dstar_lite::goal() const { return impl->to; }
+const struct dstar_lite::stats& dstar_lite::stats() const { return impl->st; }
+size_t dstar_lite::node_count() const { return impl->nodes.size(); }
+
+} // namespace floormat
@@ -0,0 +1,52 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "compat/safe-ptr.hpp"
+#include "search-pred.hpp"
+#include "point.hpp"
+
+namespace floormat {
+
+class world;
+struct path_search_result;
+
+// D* Lite over the same div_size lattice as astar::Dijkstra(), one cell per
+// pass-grid bit. The search runs backward from the goal, so the walker moving
+// only bumps the key modifier, and cells flipped in the pass grids get their
+// g-values repaired in place instead of searching again from scratch.
+class dstar_lite
+{
+public:
+    struct node;
+    struct Impl;
+
+    using pred = Search::pred;
+
+    struct stats
+    {
+        uint32_t expanded = 0;
+        uint32_t updated = 0;
+        uint32_t cells_changed = 0;
+        uint32_t chunks_invalidated = 0;
+    };
+
+    dstar_lite();
+    ~dstar_lite() noexcept;
+    fm_DISABLE_COPY(dstar_lite);
+
+    // drops all search state. `p` is a view and has to outlive this object.
+    void reset(world& w, point from, point to, uint32_t max_dist, Vector2ui own_size, const pred& p);
+    void set_start(point from);
+    // pulls changed cells from the pass grids; returns whether any tracked cell changed
+    bool sync(world& w);
+    path_search_result plan(world& w);
+
+    bool is_valid() const;
+    point goal() const;
+    const struct stats& stats() const;
+    size_t node_count() const;
+
+private:
+    safe_ptr<Impl> impl;
+};
+
+} // namespace floormat
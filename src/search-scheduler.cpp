@@ -0,0 +1,148 @@
+#include "search-scheduler.hpp"
+#include "search-result.hpp"
+#include "world.hpp"
+#include "timer.hpp"
+#include "compat/exception.hpp"
+#include <cr/GrowableArray.h>
+#include <mg/Functions.h>
+
+namespace floormat {
+
+namespace {
+
+// below this a slice is mostly bookkeeping
+constexpr uint32_t min_slice_expansions = 64;
+
+} // namespace
+
+search_scheduler::search_scheduler(const slice_budget& frame_budget) :
+    _budget{frame_budget}
+{
+    fm_assert(frame_budget.max_expansions > 0);
+}
+
+search_scheduler::~search_scheduler() noexcept = default;
+
+auto search_scheduler::submit(world& w, point from, point to, uint32_t max_dist,
+                              Vector2ui own_size, const pred& p) -> job_id
+{
+    Pointer<astar> search;
+    if (!_spare.isEmpty())
+    {
+        search = move(_spare.back());
+        arrayRemoveSuffix(_spare);
+    }
+    else
+        search = Pointer<astar>{InPlaceInit};
+
+    search->begin(w, from, to, max_dist, own_size, p);
+    const auto id = _next_id++;
+    if (_next_id == 0) [[unlikely]]
+        _next_id = 1;
+    arrayAppend(_jobs, job{ move(search), id });
+    return id;
+}
+
+void search_scheduler::update(world& w)
+{
+    using status = astar::search_status;
+
+    uint32_t running = 0;
+    for (const auto& j : _jobs)
+        running += j.search->status() == status::running;
+    if (!running)
+        return;
+
+    const auto t0 = Time::now();
+    const bool timed = _budget.max_time != Ns{(uint64_t)-1};
+    const auto size = (uint32_t)_jobs.size();
+    uint32_t used = 0, last = _cursor % size;
+
+    for (uint32_t k = 0; k < size && running > 0; k++)
+    {
+        const auto i = (_cursor + k) % size;
+        auto& search = *_jobs[i].search;
+        if (search.status() != status::running)
+            continue;
+
+        slice_budget slice;
+        if (_budget.max_expansions != (uint32_t)-1)
+        {
+            const auto left = _budget.max_expansions - used;
+            if (!left)
+                break;
+            slice.max_expansions = Math::min(left, Math::max(left / running, min_slice_expansions));
+        }
+        if (timed)
+        {
+            const auto elapsed = Time::now() - t0;
+            if (elapsed >= _budget.max_time)
+                break;
+            slice.max_time = (_budget.max_time - elapsed) / running;
+        }
+
+        const auto expanded0 = search.expansion_count();
+        search.resume(w, slice);
+        used += search.expansion_count() - expanded0;
+        running--;
+        last = i;
+    }
+
+    _cursor = last + 1;
+}
+
+uint32_t search_scheduler::find(job_id id) const
+{
+    for (auto i = 0u; i < _jobs.size(); i++)
+        if (_jobs[i].id == id)
+            return i;
+    fm_throw("no search job with id {}"_cf, id);
+}
+
+void search_scheduler::release(uint32_t i)
+{
+    arrayAppend(_spare, move(_jobs[i].search));
+    arrayRemove(_jobs, i);
+    if (_cursor > i)
+        _cursor--;
+}
+
+bool search_scheduler::is_done(job_id id) const
+{
+    return _jobs[find(id)].search->status() == astar::search_status::done;
+}
+
+path_search_result search_scheduler::take(job_id id)
+{
+    const auto i = find(id);
+    auto result = _jobs[i].search->take_result();
+    release(i);
+    return result;
+}
+
+void search_scheduler::cancel(job_id id)
+{
+    const auto i = find(id);
+    auto& search = *_jobs[i].search;
+    if (search.status() == astar::search_status::done)
+        (void)search.take_result();
+    release(i);
+}
+
+uint32_t search_scheduler::active_count() const
+{
+    uint32_t n = 0;
+    for (const auto& j : _jobs)
+        n += j.search->status() == astar::search_status::running;
+    return n;
+}
+
+auto search_scheduler::budget() const -> const slice_budget& { return _budget; }
+
+void search_scheduler::set_budget(const slice_budget& frame_budget)
+{
+    fm_assert(frame_budget.max_expansions > 0);
+    _budget = frame_budget;
+}
+
+} // namespace floormat
@@ -0,0 +1,55 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "search-astar.hpp"
+#include <cr/Array.h>
+#include <cr/Pointer.h>
+
+namespace floormat {
+
+class world;
+struct path_search_result;
+
+// spreads resumable astar searches over frames. update() splits one frame's
+// budget between the running jobs, starting each frame where the last one
+// stopped so a long search can't starve the others.
+class search_scheduler
+{
+public:
+    using job_id = uint32_t;
+    using pred = astar::pred;
+    using slice_budget = astar::slice_budget;
+
+    explicit search_scheduler(const slice_budget& frame_budget);
+    ~search_scheduler() noexcept;
+    fm_DISABLE_COPY(search_scheduler);
+
+    // `p` is a view and has to outlive the job
+    job_id submit(world& w, point from, point to, uint32_t max_dist, Vector2ui own_size, const pred& p);
+    void update(world& w);
+
+    bool is_done(job_id id) const;
+    path_search_result take(job_id id);
+    void cancel(job_id id);
+
+    uint32_t active_count() const;
+    const slice_budget& budget() const;
+    void set_budget(const slice_budget& frame_budget);
+
+private:
+    struct job
+    {
+        Pointer<astar> search;
+        job_id id;
+    };
+
+    uint32_t find(job_id id) const;
+    void release(uint32_t i);
+
+    Array<job> _jobs;
+    Array<Pointer<astar>> _spare;
+    slice_budget _budget;
+    job_id _next_id = 1;
+    uint32_t _cursor = 0;
+};
+
+} // namespace floormat
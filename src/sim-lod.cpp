@@ -0,0 +1,150 @@
+#include "sim-lod.hpp"
+#include "world.hpp"
+#include "chunk.hpp"
+#include "critter.hpp"
+#include "nanosecond.inl"
+#include "compat/borrowed-ptr.inl"
+#include <mg/Functions.h>
+
+namespace floormat {
+
+namespace {
+
+// spreads the chunks of a ring over the frames of its interval. the
+// coordinates are floor-modded first, a negative one cast to unsigned
+// would only line up across zero for power-of-two intervals.
+uint32_t phase_of(int32_t x, int32_t y, uint32_t interval)
+{
+    const auto n = (int32_t)interval;
+    const auto xʹ = (uint32_t)((x % n + n) % n), yʹ = (uint32_t)((y % n + n) % n);
+    return (xʹ + yʹ * 3u) % interval;
+}
+
+} // namespace
+
+sim_lod::sim_lod(const sim_lod_params& params)
+{
+    set_params(params);
+}
+
+void sim_lod::set_params(const sim_lod_params& params)
+{
+    fm_assert(params.reduced_radius <= params.coarse_radius);
+    fm_assert(params.coarse_radius <= TILE_MAX_DIM * 4);
+    fm_assert(params.reduced_interval >= 1 && params.reduced_interval <= max_interval);
+    fm_assert(params.coarse_interval >= 1 && params.coarse_interval <= max_interval);
+    _params = params;
+}
+
+const sim_lod_params& sim_lod::params() const { return _params; }
+const sim_lod_stats& sim_lod::stats() const { return _stats; }
+
+sim_tier sim_lod::tier_of(chunk_coords_ coord) const
+{
+    if (coord.z < _z_min || coord.z > _z_max)
+        return sim_tier::frozen;
+    const auto pos = Vector2i{coord.x, coord.y};
+    const auto d = Math::max(Math::max(_min - pos, pos - _max), Vector2i{0});
+    const auto dist = (uint32_t)Math::max(d.x(), d.y());
+    if (dist == 0)
+        return sim_tier::full;
+    else if (dist <= _params.reduced_radius)
+        return sim_tier::reduced;
+    else if (dist <= _params.coarse_radius)
+        return sim_tier::coarse;
+    else
+        return sim_tier::frozen;
+}
+
+Ns sim_lod::time_since(uint64_t last_frame_no, uint64_t frame_no, Ns dt) const
+{
+    // never updated, or frozen for a while, so don't catch up
+    if (last_frame_no == 0 || frame_no - last_frame_no >= _clock.size())
+        return dt;
+    const auto& now = _clock[frame_no % _clock.size()];
+    const auto& then = _clock[last_frame_no % _clock.size()];
+    if (then.frame_no != last_frame_no)
+        return dt;
+    fm_debug_assert(now.frame_no == frame_no);
+    return now.time - then.time;
+}
+
+void sim_lod::update(world& w, ArrayView<const chunk_coords_> full, Ns dt)
+{
+    const auto frame_no = w.increment_frame_no();
+    {
+        const auto& prev = _clock[(frame_no - 1) % _clock.size()];
+        const auto start = prev.frame_no == frame_no - 1 ? prev.time : Ns{};
+        _clock[frame_no % _clock.size()] = { frame_no, start + dt };
+    }
+    w.expire_wake_timers(frame_no);
+
+    _stats = {};
+    _z_min = 0;
+    _z_max = -1;
+    if (full.isEmpty())
+        return;
+
+    _min = _max = Vector2i{full[0].x, full[0].y};
+    _z_min = _z_max = full[0].z;
+    for (const auto& ch : full)
+    {
+        const auto pos = Vector2i{ch.x, ch.y};
+        _min = Math::min(_min, pos);
+        _max = Math::max(_max, pos);
+        _z_min = Math::min(_z_min, ch.z);
+        _z_max = Math::max(_z_max, ch.z);
+    }
+
+    const auto r = (int32_t)_params.coarse_radius;
+    for (int32_t z = _z_min; z <= _z_max; z++)
+        for (int32_t y = _min.y() - r; y <= _max.y() + r; y++)
+            for (int32_t x = _min.x() - r; x <= _max.x() + r; x++)
+            {
+                const auto coord = chunk_coords_{(int16_t)x, (int16_t)y, (int8_t)z};
+                // paged-out chunks are as good as frozen
+                auto* c = w.resident_at(coord);
+                if (!c)
+                    continue;
+                const auto tier = tier_of(coord);
+                _stats.chunks[(size_t)tier]++;
+                if (tier != sim_tier::full)
+                {
+                    const auto interval = tier == sim_tier::reduced ? _params.reduced_interval : _params.coarse_interval;
+                    if ((frame_no + phase_of(x, y, interval)) % interval != 0)
+                        continue;
+                }
+                update_chunk(*c, tier, frame_no, dt);
+            }
+}
+
+void sim_lod::update_chunk(chunk& c, sim_tier tier, uint64_t frame_no, Ns dt)
+{
+    auto& count = _stats.updates[(size_t)tier];
+    auto size = (uint32_t)c.objects().size();
+    _stats.objects[(size_t)tier] += size;
+    if (!c.awake_count())
+        return;
+    for (auto i = 0u; i < size; i++)
+    {
+        auto index = size_t{i};
+        const auto& eʹ = c.objects().data()[i];
+        auto& e = *eʹ;
+        if (!e.awake || e.last_frame_no == frame_no) [[unlikely]]
+            continue;
+        const auto dtʹ = time_since(e.last_frame_no, frame_no, dt);
+        e.last_frame_no = frame_no;
+        count++;
+        if (tier == sim_tier::coarse && e.type() == object_type::critter)
+            static_cast<critter&>(e).update_coarse(eʹ, index, dtʹ);
+        else
+            e.update(eʹ, index, dtʹ); // objects can't delete themselves during update()
+        if (&e.chunk() != &c || index > i) [[unlikely]]
+        {
+            i--;
+            size = (uint32_t)c.objects().size();
+        }
+    }
+}
+
+} // namespace floormat
@@ -0,0 +1,73 @@
+#pragma once
+#include "compat/defs.hpp"
+#include "global-coords.hpp"
+#include "nanosecond.hpp"
+#include <array>
+#include <cr/ArrayView.h>
+
+namespace floormat {
+
+class world;
+class chunk;
+
+enum class sim_tier : uint8_t { full, reduced, coarse, frozen, COUNT, };
+
+struct sim_lod_params
+{
+    // width of the rings around the full-rate area, in chunks
+    uint32_t reduced_radius = 2, coarse_radius = 4;
+    // chunks in a ring take turns, one every that many frames
+    uint32_t reduced_interval = 4, coarse_interval = 16;
+};
+
+struct sim_lod_stats
+{
+    // chunks that exist in each tier, and how many objects got updated
+    std::array<uint32_t, (size_t)sim_tier::COUNT> chunks{}, updates{};
+    // objects in the chunks whose turn it was, awake or not
+    std::array<uint32_t, (size_t)sim_tier::COUNT> objects{};
+};
+
+// Replaces the update loop over the visible chunks. Chunks within the
+// bounding box of `full` update every frame like before. The rings around it
+// update less often, and their objects get all the time they missed at once.
+// Critters in the outer ring go through critter::update_coarse(). Anything
+// farther away doesn't get updated at all, and neither do objects that are
+// asleep, see object::sleep().
+class sim_lod
+{
+public:
+    explicit sim_lod(const sim_lod_params& params = {});
+    fm_DISABLE_COPY(sim_lod);
+
+    void update(world& w, ArrayView<const chunk_coords_> full, Ns dt);
+
+    // relative to the full-rate area of the last update()
+    sim_tier tier_of(chunk_coords_ coord) const;
+
+    const sim_lod_params& params() const;
+    void set_params(const sim_lod_params& params);
+    // of the last update()
+    const sim_lod_stats& stats() const;
+
+    static constexpr uint32_t max_interval = 64;
+
+private:
+    struct clock_slot
+    {
+        uint64_t frame_no = 0;
+        Ns time{};
+    };
+
+    Ns time_since(uint64_t last_frame_no, uint64_t frame_no, Ns dt) const;
+    void update_chunk(chunk& c, sim_tier tier, uint64_t frame_no, Ns dt);
+
+    // accumulated dt by frame, for objects that skipped some
+    std::array<clock_slot, max_interval * 2> _clock;
+    sim_lod_params _params;
+    sim_lod_stats _stats;
+    Vector2i _min, _max;
+    int8_t _z_min = 0, _z_max = -1;
+};
+
+} // namespace floormat
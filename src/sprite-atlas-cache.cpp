@@ -0,0 +1,293 @@
+#include "sprite-atlas-cache.hpp"
+#include "sprite-atlas.hpp"
+#include "compat/assert.hpp"
+#include <cstring>
+#include <algorithm>
+#include <cr/GrowableArray.h>
+#include <cr/Optional.h>
+#include <cr/Path.h>
+
+namespace floormat {
+
+namespace {
+
+constexpr char file_magic[8] = { 'f', 'm', '-', 'a', 't', 'l', 'a', 's' };
+constexpr uint32_t file_version = 1;
+constexpr size_t layer_alignment = 64;
+
+// all sections are in native byte order, it's a cache
+struct file_header
+{
+    char magic[8];
+    uint32_t version;
+    uint16_t layer_size, n_layers;
+    uint32_t n_entries, n_sprites;
+    uint32_t names_size, _pad0;
+    uint64_t bitmasks_size;
+};
+
+struct file_entry
+{
+    uint64_t hash;
+    uint64_t bitmask_offset, bitmask_bits;
+    uint32_t name_offset, name_size;
+    uint32_t first_sprite, sprite_count;
+};
+
+static_assert(sizeof(file_header) == 32);
+static_assert(sizeof(file_entry) == 40);
+static_assert(sizeof(SpriteAtlas::Sprite) == sizeof(uint64_t));
+
+constexpr size_t align_up(size_t x, size_t a) { return (x + a - 1) & ~(a - 1); }
+constexpr size_t bitmask_bytes(size_t bits) { return align_up((bits + 7) / 8, 8); }
+
+struct reader
+{
+    ArrayView<const char> buf;
+    size_t pos = 0;
+    bool ok = true;
+
+    ArrayView<const char> take(size_t size)
+    {
+        if (!ok || size > buf.size() - pos)
+        {
+            ok = false;
+            return {};
+        }
+        auto ret = buf.sliceSize(pos, size);
+        pos += size;
+        return ret;
+    }
+
+    template<typename T> T read()
+    {
+        T x{};
+        if (auto src = take(sizeof x); ok)
+            std::memcpy(&x, src.data(), sizeof x);
+        return x;
+    }
+};
+
+template<typename T> void append(Array<char>& buf, const T& x)
+{
+    arrayAppend(buf, ArrayView<const char>{reinterpret_cast<const char*>(&x), sizeof x});
+}
+
+bool check_sprite(const SpriteAtlas::Sprite& s, uint32_t layer_size, uint32_t n_layers)
+{
+    const auto w = (uint32_t)s.width + 1, h = (uint32_t)s.height + 1;
+    const auto slot_w = s.is_rotated ? h : w, slot_h = s.is_rotated ? w : h;
+    return s.layer < n_layers && s.x + slot_w <= layer_size && s.y + slot_h <= layer_size;
+}
+
+} // namespace
+
+bool sprite_atlas_cache::load(StringView path, sprite_atlas& atlas)
+{
+    clear();
+    const auto filename = String::nullTerminatedView(path);
+    if (!Path::exists(filename))
+        return false;
+
+    auto file = Path::mapRead(filename);
+    if (!file)
+    {
+        fm_warn("can't map sprite atlas cache '%s'", filename.data());
+        return false;
+    }
+
+    auto r = reader{*file};
+    const auto header = r.read<file_header>();
+    if (!r.ok || std::memcmp(header.magic, file_magic, sizeof file_magic) != 0 ||
+        header.version != file_version || header.layer_size == 0 || header.n_layers == 0)
+    {
+        fm_warn("sprite atlas cache '%s' is stale or corrupt, ignoring it", filename.data());
+        return false;
+    }
+
+    const auto entries = r.take((size_t)header.n_entries * sizeof(file_entry));
+    const auto sprites = r.take((size_t)header.n_sprites * sizeof(SpriteAtlas::Sprite));
+    const auto names = r.take(header.names_size);
+    const auto bitmasks = r.take((size_t)header.bitmasks_size);
+    const auto layer_size = (size_t)header.layer_size;
+    r.take(align_up(r.pos, layer_alignment) - r.pos);
+    const auto layers = r.take((size_t)header.n_layers * layer_size * layer_size * 4);
+
+    auto fail = [&] {
+        fm_warn("sprite atlas cache '%s' is corrupt, ignoring it", filename.data());
+        clear();
+        return false;
+    };
+
+    if (!r.ok || r.pos != file->size())
+        return fail();
+
+    _entries.reserve(header.n_entries);
+    for (auto i = 0u; i < header.n_entries; i++)
+    {
+        file_entry e;
+        std::memcpy(&e, entries.data() + i * sizeof e, sizeof e);
+        if (e.name_offset > names.size() || e.name_size > names.size() - e.name_offset ||
+            e.first_sprite > header.n_sprites || e.sprite_count > header.n_sprites - e.first_sprite ||
+            e.bitmask_offset > bitmasks.size() || bitmask_bytes(e.bitmask_bits) > bitmasks.size() - e.bitmask_offset)
+            return fail();
+
+        auto x = entry {
+            .hash = e.hash,
+            .sprites = Array<SpriteAtlas::Sprite>{NoInit, e.sprite_count},
+            .bitmask = BitArray{NoInit, e.bitmask_bits},
+        };
+        if (e.sprite_count)
+            std::memcpy(x.sprites.data(), sprites.data() + e.first_sprite * sizeof(SpriteAtlas::Sprite),
+                        e.sprite_count * sizeof(SpriteAtlas::Sprite));
+        for (const auto& s : x.sprites)
+            if (!check_sprite(s, header.layer_size, header.n_layers))
+                return fail();
+        if (e.bitmask_bits)
+            std::memcpy(x.bitmask.data(), bitmasks.data() + e.bitmask_offset, (e.bitmask_bits + 7) / 8);
+
+        auto name = String{StringView{names.data() + e.name_offset, e.name_size}};
+        if (!_entries.try_emplace(move(name), move(x)).second)
+            return fail();
+    }
+
+    if (!atlas.adopt_layers(header.layer_size, header.n_layers, layers))
+    {
+        fm_warn("sprite atlas cache '%s' was baked with a different layer size, ignoring it", filename.data());
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool sprite_atlas_cache::save(StringView path, sprite_atlas& atlas) const
+{
+    const auto n_layers = atlas.used_layers();
+    if (!n_layers)
+        return false;
+
+    // sorted so that baking the same assets gives the same file
+    Array<decltype(_entries)::const_pointer> sorted;
+    arrayReserve(sorted, _entries.size());
+    for (const auto& x : _entries)
+        arrayAppend(sorted, &x);
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return StringView{a->first} < StringView{b->first}; });
+
+    Array<file_entry> entries;
+    Array<char> sprites, names, bitmasks;
+    arrayReserve(entries, sorted.size());
+    uint32_t n_sprites = 0;
+    for (const auto* p : sorted)
+    {
+        const auto& [name, x] = *p;
+        arrayAppend(entries, file_entry {
+            .hash = x.hash,
+            .bitmask_offset = bitmasks.size(),
+            .bitmask_bits = x.bitmask.size(),
+            .name_offset = (uint32_t)names.size(),
+            .name_size = (uint32_t)name.size(),
+            .first_sprite = n_sprites,
+            .sprite_count = (uint32_t)x.sprites.size(),
+        });
+        arrayAppend(names, ArrayView<const char>{name.data(), name.size()});
+        arrayAppend(sprites, arrayCast<const char>(ArrayView<const SpriteAtlas::Sprite>{x.sprites}));
+        const auto bits = ArrayView<const char>{reinterpret_cast<const char*>(x.bitmask.data()), (x.bitmask.size() + 7) / 8};
+        arrayAppend(bitmasks, bits);
+        arrayResize(bitmasks, ValueInit, bitmasks.size() + bitmask_bytes(x.bitmask.size()) - bits.size());
+        n_sprites += (uint32_t)x.sprites.size();
+    }
+
+    auto header = file_header {
+        .magic = {},
+        .version = file_version,
+        .layer_size = atlas.layer_size(),
+        .n_layers = n_layers,
+        .n_entries = (uint32_t)entries.size(),
+        .n_sprites = n_sprites,
+        .names_size = (uint32_t)names.size(),
+        ._pad0 = 0,
+        .bitmasks_size = bitmasks.size(),
+    };
+    std::memcpy(header.magic, file_magic, sizeof file_magic);
+
+    const auto layers = atlas.read_layers();
+    Array<char> buf;
+    arrayReserve(buf, sizeof header + entries.size() * sizeof(file_entry) + sprites.size() +
+                      names.size() + bitmasks.size() + layer_alignment + layers.size());
+    append(buf, header);
+    arrayAppend(buf, arrayCast<const char>(ArrayView<const file_entry>{entries}));
+    arrayAppend(buf, sprites);
+    arrayAppend(buf, names);
+    arrayAppend(buf, bitmasks);
+    arrayResize(buf, ValueInit, align_up(buf.size(), layer_alignment));
+    arrayAppend(buf, layers);
+
+    // write-then-rename, a crash halfway through shouldn't leave a corrupt cache
+    const auto tmp = String{path} + ".tmp"_s;
+    if (!Path::write(tmp, ArrayView<const char>{buf}) || !Path::move(tmp, path))
+    {
+        fm_warn("can't write sprite atlas cache '%s'", tmp.data());
+        return false;
+    }
+    return true;
+}
+
+void sprite_atlas_cache::clear()
+{
+    _entries.clear();
+    _retired = {};
+    _dirty = false;
+}
+
+auto sprite_atlas_cache::find(StringView name, uint64_t hash) const -> const entry*
+{
+    const auto* e = find(name);
+    return e && e->hash == hash ? e : nullptr;
+}
+
+auto sprite_atlas_cache::find(StringView name) const -> const entry*
+{
+    auto it = _entries.find(String::nullTerminatedView(name));
+    return it != _entries.end() ? &it->second : nullptr;
+}
+
+void sprite_atlas_cache::add(StringView name, uint64_t hash,
+                             ArrayView<const SpriteAtlas::Sprite* const> sprites,
+                             BitArrayView bitmask)
+{
+    fm_assert(bitmask.offset() == 0);
+    auto x = entry {
+        .hash = hash,
+        .sprites = Array<SpriteAtlas::Sprite>{NoInit, sprites.size()},
+        .bitmask = BitArray{NoInit, bitmask.size()},
+    };
+    for (auto i = 0uz; i < sprites.size(); i++)
+        x.sprites[i] = *sprites[i];
+    if (!bitmask.isEmpty())
+        std::memcpy(x.bitmask.data(), bitmask.data(), (bitmask.size() + 7) / 8);
+    auto [it, fresh] = _entries.try_emplace(String{name});
+    // atlases made from the old entry may still be around
+    if (!fresh)
+        arrayAppend(_retired, move(it->second.sprites));
+    it->second = move(x);
+    _dirty = true;
+}
+
+bool sprite_atlas_cache::is_dirty() const { return _dirty; }
+size_t sprite_atlas_cache::size() const { return _entries.size(); }
+
+uint64_t sprite_atlas_cache::content_hash(ArrayView<const ArrayView<const char>> files)
+{
+    // boost::hash_combine's mixing, the file sizes go in too so that moving
+    // bytes from one file into the other still changes the hash
+    uint64_t h = 0;
+    for (const auto& f : files)
+    {
+        for (uint64_t x : { (uint64_t)hash_buf(f.data(), f.size()), (uint64_t)f.size() })
+            h ^= x + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+} // namespace floormat
@@ -0,0 +1,57 @@
+#pragma once
+#include "src/sprite-atlas-impl.hpp"
+#include "compat/hash.hpp"
+#include <cr/Array.h>
+#include <cr/BitArray.h>
+#include <cr/String.h>
+#include <gtl/phmap.hpp>
+
+namespace floormat {
+
+class sprite_atlas;
+
+// A baked sprite_atlas on disk: the packed layers as raw RGBA8, plus each
+// asset's sprites and hit-test bitmask keyed by a hash of the asset's source
+// files. Loading it uploads the layers as-is, so an asset whose hash still
+// matches needs neither decoding nor packing. Anything new or changed is
+// packed live into fresh layers and gets added for the next save().
+//
+// Assets that changed leave their old sprites behind in the baked layers;
+// delete the file to repack from scratch.
+class sprite_atlas_cache final
+{
+public:
+    struct entry
+    {
+        uint64_t hash = 0;
+        Array<SpriteAtlas::Sprite> sprites;
+        BitArray bitmask;
+    };
+
+    // `atlas` must be empty. Returns false if the file is missing, stale or
+    // corrupt, and the cache then starts out empty.
+    bool load(StringView path, sprite_atlas& atlas);
+    bool save(StringView path, sprite_atlas& atlas) const;
+    void clear();
+
+    // nullptr if `name` isn't baked or its hash changed
+    const entry* find(StringView name, uint64_t hash) const;
+    // nullptr if `name` isn't baked, whatever its hash
+    const entry* find(StringView name) const;
+    void add(StringView name, uint64_t hash, ArrayView<const SpriteAtlas::Sprite* const> sprites, BitArrayView bitmask);
+
+    // whether add() was called since load()
+    bool is_dirty() const;
+    size_t size() const;
+
+    static uint64_t content_hash(ArrayView<const ArrayView<const char>> files);
+
+private:
+    struct string_equals { bool operator()(StringView a, StringView b) const { return a == b; } };
+
+    gtl::flat_hash_map<String, entry, hash_string_view, string_equals> _entries;
+    Array<Array<SpriteAtlas::Sprite>> _retired;
+    bool _dirty = false;
+};
+
+} // namespace floormat
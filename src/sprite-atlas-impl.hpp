@@ -1,4 +1,5 @@
 #pragma once
+#include "sprite-atlas.hpp"
 #include <array>
 #include <cr/Array.h>
 #include <cr/Pointer.h>
@@ -29,9 +30,18 @@ struct Shelf
     uint64_t _pad0 : 11 = 0;
 };
 
+// a run of the skyline packer's top edge, [x, x+width) is filled up to y
+struct SkylineNode
+{
+    uint16_t x, y, width;
+};
+
 struct Layer
 {
     Array<Pointer<Shelf>> shelves {};
+    // skyline packer only. nodes are sorted by x and span the whole layer
+    Array<SkylineNode> skyline {};
+    Array<Pointer<Sprite>> sprites {};
     uint16_t next_y = 0;
 };
 
@@ -48,6 +58,9 @@ struct Atlas
     GL::Texture2DArray texture{NoCreate};
     uint16_t layer_size = 0;
     uint16_t n_layers = 0;
+    // the first `baked_layers` layers came from adopt_layers()
+    uint16_t baked_layers = 0;
+    sprite_atlas_packer packer = sprite_atlas_packer::shelf;
 
     struct ShelfPair { Shelf* p; uint32_t index; };
 };
@@ -57,8 +70,13 @@ uint32_t max_2d_texture_size();
 uint16_t alloc_more_layers_count(uint16_t cur_layers, const Atlas& A);
 void realloc_atlas(Atlas& atlas, uint16_t new_n_layers);
 void free_atlas(Atlas& atlas);
+void resolve_layer_size(Atlas& atlas);
+void adopt_layers(Atlas& atlas, uint16_t count, ArrayView<const char> pixels);
+Array<char> read_layers(Atlas& atlas);
 Atlas::ShelfPair alloc_new_shelf(Atlas& atlas, uint32_t height);
 Sprite* alloc_sprite(Atlas& atlas, uint32_t w, uint32_t h, bool allow_rotate = true);
+Sprite* alloc_sprite_skyline(Atlas& atlas, uint32_t w, uint32_t h, bool allow_rotate = true);
+sprite_atlas_stats atlas_stats(const Atlas& atlas);
 void upload_sprite(Atlas& atlas, const Sprite& sprite, const ImageView2D& pixels);
 std::array<Vector3, 4> texcoords_for_sprite(const Atlas& atlas, const Sprite& sprite, bool mirror);
 std::array<Vector3, 4> texcoords_for_subrect(const Atlas& atlas, const Sprite& sprite,
@@ -5,6 +5,7 @@
 #include "src/quads.hpp"
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <bit>
 #include <algorithm>
 #include <cr/GrowableArray.h>
@@ -130,6 +131,78 @@ void free_atlas(Atlas& atlas)
     atlas.layers = {};
     atlas.height_classes = {};
     atlas.n_layers = 0;
+    atlas.baked_layers = 0;
+}
+
+void resolve_layer_size(Atlas& atlas)
+{
+    if (atlas.layer_size == 0)
+    {
+        auto ls = max_2d_texture_size();
+        ls = std::min<uint32_t>(ls, max_layer_size);
+        fm_assert(ls > 0);
+        atlas.layer_size = (uint16_t)ls;
+    }
+}
+
+void adopt_layers(Atlas& atlas, uint16_t count, ArrayView<const char> pixels)
+{
+    fm_assert(atlas.layer_size > 0);
+    fm_assert(atlas.layers.isEmpty());
+    fm_assert(count > 0 && count <= 1u << 14);
+    const auto ls = (Int)atlas.layer_size;
+    fm_assert(pixels.size() == (size_t)count * (size_t)ls * (size_t)ls * 4);
+
+    // round up so that alloc_more_layers_count() keeps doubling from a power of two
+    if (atlas.n_layers < count)
+        realloc_atlas(atlas, (uint16_t)std::bit_ceil((uint32_t)count));
+    atlas.texture.setSubImage(0, {},
+        ImageView3D{PixelFormat::RGBA8Unorm, {ls, ls, (Int)count}, pixels});
+
+    // the packer has no shelves for these, so mark them full; new sprites
+    // go to a fresh layer after them
+    arrayReserve(atlas.layers, count);
+    for (auto i = 0u; i < count; i++)
+    {
+        auto& L = arrayAppend(atlas.layers, InPlaceInit);
+        L.next_y = atlas.layer_size;
+        arrayAppend(L.skyline, SkylineNode{0, atlas.layer_size, atlas.layer_size});
+    }
+    atlas.baked_layers = count;
+}
+
+Array<char> read_layers(Atlas& atlas)
+{
+    fm_assert(!atlas.layers.isEmpty());
+    const auto ls = (Int)atlas.layer_size;
+    const auto n = (Int)atlas.layers.size();
+    // whole texture, subImage() would need GL 4.5 or ARB_get_texture_sub_image.
+    // the spare layers at the end get dropped
+    auto img = atlas.texture.image(0, Image3D{PixelFormat::RGBA8Unorm});
+    const auto size = (size_t)n * (size_t)ls * (size_t)ls * 4;
+    fm_assert(img.size() == (Vector3i{ls, ls, (Int)atlas.n_layers}));
+    fm_assert(img.data().size() >= size);
+    auto data = img.release();
+    if (data.size() == size)
+        return data;
+    auto ret = Array<char>{NoInit, size};
+    std::memcpy(ret.data(), data.data(), size);
+    return ret;
+}
+
+static uint32_t add_layer(Atlas& atlas)
+{
+    if (atlas.layers.size() >= atlas.n_layers)
+    {
+        // GL texture has no spare slots either; grow it.
+        auto new_n = alloc_more_layers_count(atlas.n_layers, atlas);
+        realloc_atlas(atlas, new_n);
+    }
+    arrayReserve(atlas.layers, 16);
+    auto& L = arrayAppend(atlas.layers, InPlaceInit);
+    if (atlas.packer == sprite_atlas_packer::skyline)
+        arrayAppend(L.skyline, SkylineNode{0, 0, atlas.layer_size});
+    return (uint32_t)(atlas.layers.size() - 1);
 }
 
 Atlas::ShelfPair alloc_new_shelf(Atlas& atlas, uint32_t height)
@@ -162,18 +235,7 @@ Atlas::ShelfPair alloc_new_shelf(Atlas& atlas, uint32_t height)
         }
 
     if (layer_idx == (uint32_t)-1)
-    {
-        // No layer has room — must create a new Layer.
-        if (atlas.layers.size() >= atlas.n_layers)
-        {
-            // GL texture has no spare slots either; grow it.
-            auto new_n = alloc_more_layers_count(atlas.n_layers, atlas);
-            realloc_atlas(atlas, new_n);
-        }
-        arrayReserve(atlas.layers, 16);
-        arrayAppend(atlas.layers, InPlaceInit);
-        layer_idx = (uint32_t)(atlas.layers.size() - 1);
-    }
+        layer_idx = add_layer(atlas); // No layer has room — must create a new Layer.
 
     fm_debug_assert(layer_idx < 1u << 14);
     // place the new Shelf at the layer's vertical watermark and advance it.
@@ -223,6 +285,9 @@ static Atlas::ShelfPair get_shelf(Atlas& atlas, uint32_t w, uint32_t h, bool& is
 
 Sprite* alloc_sprite(Atlas& atlas, uint32_t w, uint32_t h, bool allow_rotate)
 {
+    if (atlas.packer == sprite_atlas_packer::skyline)
+        return alloc_sprite_skyline(atlas, w, h, allow_rotate);
+
     fm_assert(w > 0 && h > 0);
     fm_assert(w <= max_texture_xy && h <= max_texture_xy);
     fm_assert(w <= atlas.layer_size && h <= atlas.layer_size);
@@ -269,6 +334,167 @@ Sprite* alloc_sprite(Atlas& atlas, uint32_t w, uint32_t h, bool allow_rotate)
     return &*sp;
 }
 
+namespace {
+
+struct SkylineFit
+{
+    uint32_t node, x, y, w, h;
+    bool is_rotated;
+};
+
+// lowest y at which a w-by-h slot starting at node `i` clears the skyline
+bool skyline_fit(const Layer& L, uint32_t i, uint32_t w, uint32_t h, uint32_t layer_size, uint32_t& y)
+{
+    const auto& nodes = L.skyline;
+    const uint32_t x = nodes[i].x;
+    if (x + w > layer_size)
+        return false;
+    y = 0;
+    for (uint32_t left = w; left > 0; i++)
+    {
+        fm_debug_assert(i < nodes.size());
+        y = std::max<uint32_t>(y, nodes[i].y);
+        if (y + h > layer_size)
+            return false;
+        left -= std::min<uint32_t>(left, nodes[i].width);
+    }
+    return true;
+}
+
+// bottom-left: lowest top edge, then leftmost
+bool skyline_find(const Atlas& atlas, const Layer& L, uint32_t w, uint32_t h, bool allow_rotate, SkylineFit& best)
+{
+    bool found = false;
+    for (uint32_t i = 0; i < L.skyline.size(); i++)
+        for (uint32_t r = 0; r < (allow_rotate && w != h ? 2u : 1u); r++)
+        {
+            const auto sw = r ? h : w, sh = r ? w : h;
+            uint32_t y;
+            if (!skyline_fit(L, i, sw, sh, atlas.layer_size, y))
+                continue;
+            const uint32_t x = L.skyline[i].x;
+            if (!found || y + sh < best.y + best.h || (y + sh == best.y + best.h && x < best.x))
+            {
+                best = { i, x, y, sw, sh, r != 0 };
+                found = true;
+            }
+        }
+    return found;
+}
+
+void skyline_add(Layer& L, const SkylineFit& fit)
+{
+    auto& nodes = L.skyline;
+    arrayInsert(nodes, fit.node, SkylineNode{(uint16_t)fit.x, (uint16_t)(fit.y + fit.h), (uint16_t)fit.w});
+
+    // shrink or drop whatever the new node now covers
+    const uint32_t end = fit.x + fit.w;
+    for (uint32_t j = fit.node + 1; j < nodes.size(); )
+    {
+        auto& n = nodes[j];
+        const uint32_t n_end = (uint32_t)n.x + n.width;
+        if (n.x >= end)
+            break;
+        if (n_end <= end)
+        {
+            arrayRemove(nodes, j);
+            continue;
+        }
+        n.width = (uint16_t)(n_end - end);
+        n.x = (uint16_t)end;
+        break;
+    }
+
+    for (uint32_t j = 0; j + 1 < nodes.size(); )
+        if (nodes[j].y == nodes[j+1].y)
+        {
+            nodes[j].width = (uint16_t)(nodes[j].width + nodes[j+1].width);
+            arrayRemove(nodes, j+1);
+        }
+        else
+            j++;
+}
+
+} // namespace
+
+Sprite* alloc_sprite_skyline(Atlas& atlas, uint32_t w, uint32_t h, bool allow_rotate)
+{
+    fm_assert(w > 0 && h > 0);
+    fm_assert(w <= max_texture_xy && h <= max_texture_xy);
+    fm_assert(w <= atlas.layer_size && h <= atlas.layer_size);
+    fm_assert(atlas.packer == sprite_atlas_packer::skyline);
+
+    // fill the layers in order, a new one only when nothing fits
+    SkylineFit fit{};
+    auto layer_idx = (uint32_t)-1;
+    for (uint32_t i = atlas.baked_layers; i < atlas.layers.size(); i++)
+        if (skyline_find(atlas, atlas.layers[i], w, h, allow_rotate, fit))
+        {
+            layer_idx = i;
+            break;
+        }
+    if (layer_idx == (uint32_t)-1)
+    {
+        layer_idx = add_layer(atlas);
+        const bool found = skyline_find(atlas, atlas.layers[layer_idx], w, h, allow_rotate, fit);
+        fm_assert(found);
+    }
+    fm_debug_assert(layer_idx < 1u << 14);
+
+    Layer& L = atlas.layers[layer_idx];
+    skyline_add(L, fit);
+    arrayReserve(L.sprites, 16);
+    auto& sp = arrayAppend(L.sprites, InPlaceInit, InPlaceInit, Sprite {
+        .x = fit.x,
+        .y = fit.y,
+        .layer = layer_idx,
+        .width = w - 1,
+        .height = h - 1,
+        .is_rotated = fit.is_rotated,
+    });
+    return &*sp;
+}
+
+sprite_atlas_stats atlas_stats(const Atlas& atlas)
+{
+    const auto ls = (uint64_t)atlas.layer_size;
+    const auto layer_bytes = ls * ls * 4;
+    sprite_atlas_stats st {
+        .layers = (uint16_t)atlas.layers.size(),
+        .allocated_layers = atlas.n_layers,
+        .used_bytes = atlas.baked_layers * layer_bytes,
+        .layer_bytes = atlas.layers.size() * layer_bytes,
+        .allocated_bytes = atlas.n_layers * layer_bytes,
+    };
+
+    const auto add = [&](const Sprite& s) {
+        st.sprites++;
+        st.used_bytes += ((uint64_t)s.width + 1) * ((uint64_t)s.height + 1) * 4;
+    };
+    for (const Layer& L : atlas.layers)
+    {
+        if (atlas.packer == sprite_atlas_packer::skyline)
+        {
+            for (const auto& s : L.sprites)
+                add(*s);
+            for (const auto& n : L.skyline)
+                st.free_bytes += (ls - n.y) * n.width * 4;
+        }
+        else
+        {
+            // only the same height class can use the rest of a shelf
+            st.free_bytes += (ls - L.next_y) * ls * 4;
+            for (const auto& sh : L.shelves)
+            {
+                for (const auto& s : sh->sprites)
+                    add(*s);
+                st.free_bytes += (ls - sh->next_x) * ((uint64_t)sh->height_class + 1) * 4;
+            }
+        }
+    }
+    return st;
+}
+
 void upload_sprite(Atlas& atlas, const Sprite& sprite, const ImageView2D& pixels)
 {
     // Sprite stores width/height as `size - 1` of the ORIGINAL dims so 1024
@@ -525,6 +751,13 @@ sprite_atlas::sprite_atlas(uint16_t layer_size)
     _atlas->layer_size = layer_size;
 }
 
+sprite_atlas::sprite_atlas(uint16_t layer_size, sprite_atlas_packer packer)
+    : _atlas{InPlaceInit}
+{
+    _atlas->layer_size = layer_size;
+    _atlas->packer = packer;
+}
+
 sprite_atlas::~sprite_atlas() noexcept = default;
 sprite_atlas::sprite_atlas(sprite_atlas&&) noexcept = default;
 sprite_atlas& sprite_atlas::operator=(sprite_atlas&&) noexcept = default;
@@ -534,13 +767,7 @@ uint16_t sprite_atlas::n_layers() const   { return _atlas->n_layers; }
 
 sprite sprite_atlas::add(const ImageView2D& pixels, bool allow_rotate)
 {
-    if (_atlas->layer_size == 0)
-    {
-        auto ls = SpriteAtlas::max_2d_texture_size();
-        ls = std::min<uint32_t>(ls, SpriteAtlas::max_layer_size);
-        fm_assert(ls > 0);
-        _atlas->layer_size = (uint16_t)ls;
-    }
+    SpriteAtlas::resolve_layer_size(*_atlas);
     auto size = pixels.size();
     auto* s = SpriteAtlas::alloc_sprite(*_atlas,
                                         (uint32_t)size.x(),
@@ -573,6 +800,39 @@ void sprite_atlas::reset()
     SpriteAtlas::free_atlas(*_atlas);
 }
 
+bool sprite_atlas::adopt_layers(uint16_t layer_size, uint16_t count, ArrayView<const char> pixels)
+{
+    SpriteAtlas::resolve_layer_size(*_atlas);
+    if (layer_size != _atlas->layer_size || !_atlas->layers.isEmpty())
+        return false;
+    SpriteAtlas::adopt_layers(*_atlas, count, pixels);
+    return true;
+}
+
+Array<char> sprite_atlas::read_layers()
+{
+    return SpriteAtlas::read_layers(*_atlas);
+}
+
+uint16_t sprite_atlas::used_layers() const
+{
+    return (uint16_t)_atlas->layers.size();
+}
+
+sprite_atlas_packer sprite_atlas::packer() const { return _atlas->packer; }
+sprite_atlas_stats sprite_atlas::stats() const { return SpriteAtlas::atlas_stats(*_atlas); }
+
+float sprite_atlas_stats::occupancy() const
+{
+    return layer_bytes ? (float)((double)used_bytes / (double)layer_bytes) : 0.f;
+}
+
+float sprite_atlas_stats::fragmentation() const
+{
+    const auto taken = layer_bytes - free_bytes;
+    return taken ? (float)((double)(taken - used_bytes) / (double)taken) : 0.f;
+}
+
 void sprite_atlas::dump(StringView out_path)
 {
     SpriteAtlas::dump_atlas(*_atlas, out_path);
@@ -11,6 +11,33 @@ struct Sprite;
 
 namespace floormat {
 
+enum class sprite_atlas_packer : uint8_t
+{
+    // rows of sprites of similar height, see SpriteAtlas::quantize_height()
+    shelf,
+    // skyline bottom-left, each sprite goes wherever its top edge ends up
+    // lowest. Slower to pack, wastes less with mixed sizes.
+    skyline,
+};
+
+// In RGBA8 bytes. Baked layers count as fully used.
+struct sprite_atlas_stats
+{
+    uint32_t sprites = 0;
+    uint16_t layers = 0, allocated_layers = 0;
+    // sprite pixels
+    uint64_t used_bytes = 0;
+    // space in the used layers the packer can still hand out
+    uint64_t free_bytes = 0;
+    // the used layers, and the whole texture including spare layers
+    uint64_t layer_bytes = 0, allocated_bytes = 0;
+
+    // used / layer bytes
+    float occupancy() const;
+    // how much of the space the packer has given up on holds no pixels
+    float fragmentation() const;
+};
+
 class sprite
 {
 public:
@@ -34,6 +61,8 @@ class sprite_atlas
 public:
     explicit sprite_atlas();
     explicit sprite_atlas(uint16_t layer_size);
+    // a zero `layer_size` is picked from the GL limits on the first add()
+    explicit sprite_atlas(uint16_t layer_size, sprite_atlas_packer packer);
     ~sprite_atlas() noexcept;
 
     sprite_atlas(const sprite_atlas&) = delete;
@@ -43,6 +72,9 @@ public:
 
     uint16_t layer_size() const;
     uint16_t n_layers() const;
+    uint16_t used_layers() const;
+    sprite_atlas_packer packer() const;
+    sprite_atlas_stats stats() const;
 
     sprite add(const ImageView2D& pixels, bool allow_rotate = true);
 
@@ -63,6 +95,15 @@ public:
     // Release the GL texture and bookkeeping. layer_size is preserved.
     void reset();
 
+    // Baked layers from sprite_atlas_cache, RGBA8 and `layer_size` squared
+    // each. Only works on an atlas nothing was added to yet, and only if
+    // `layer_size` is what add() would have picked. The packer never goes
+    // back into these layers, later add() calls start a new one.
+    [[nodiscard]] bool adopt_layers(uint16_t layer_size, uint16_t count, ArrayView<const char> pixels);
+
+    // RGBA8 contents of the first used_layers() layers, for baking.
+    Array<char> read_layers();
+
     // Debug: dump each atlas layer (or slabs of layers) to PNG files at
     // `out_path.NNN.png`. Forwards to SpriteAtlas::dump_atlas so callers
     // don't need the impl header.
@@ -1,9 +1,20 @@
 #include "sprite-list.hpp"
+#include "compat/non-const.hpp"
+#include <atomic>
 #include <cr/GrowableArray.h>
 
 namespace floormat {
 
-SpriteList::SpriteList()
+namespace {
+
+std::atomic<uint64_t> next_generation = 1; // NOLINT(*-avoid-non-const-global-variables)
+
+uint64_t make_generation() { return next_generation.fetch_add(1, std::memory_order_relaxed); }
+
+} // namespace
+
+SpriteList::SpriteList():
+    generation{make_generation()}
 {
 }
 
@@ -12,6 +23,13 @@ uint32_t SpriteList::size() const
     return (uint32_t)Vertexes.size();
 }
 
+size_t SpriteList::memory_usage() const
+{
+    return arrayCapacity(non_const(Vertexes)) * sizeof(Quads::vertexes) +
+           arrayCapacity(non_const(Depths)) * sizeof(float) +
+           arrayCapacity(non_const(Objects)) * sizeof(object*);
+}
+
 void SpriteList::add(const Quads::vertexes& vertexes, float depth, object* obj)
 {
     arrayReserve(Vertexes, 16);
@@ -28,6 +46,7 @@ void SpriteList::clear()
     arrayClear(Vertexes);
     arrayClear(Depths);
     arrayClear(Objects);
+    generation = make_generation();
 }
 
 } //
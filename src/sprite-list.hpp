@@ -12,10 +12,15 @@ struct SpriteList
     Array<Quads::vertexes> Vertexes;
     Array<float> Depths;
     Array<object*> Objects;
+    // unique across all lists, changes on every clear(). lets SpriteBatch
+    // tell whether its copy on the GPU is still current.
+    uint64_t generation;
 
     void add(const Quads::vertexes& vertexes, float depth, object* obj);
     void clear();
     uint32_t size() const;
+    // heap memory taken up by the arrays
+    size_t memory_usage() const;
 
     SpriteList();
 
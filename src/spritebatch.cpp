@@ -4,22 +4,22 @@
 #include "src/anim-atlas.hpp"
 #include "src/point.inl"
 #include "src/sprite-list.hpp"
-#include "main/clickable.hpp"
 #include "shaders/shader.hpp"
 #include "loader/loader.hpp"
 #include "src/sprite-atlas.hpp"
-#include <cfloat>
+#include "src/camera-offset.hpp"
+#include "compat/float.hpp"
+#include "compat/limits.hpp"
+#include <cstring>
 #include <utility>
-#include <ranges>
-#include <algorithm>
 #include <cr/GrowableArray.h>
+#include <gtl/phmap.hpp>
 #include <mg/Mesh.h>
 #include <mg/Buffer.h>
+#include <mg/Functions.h>
 
 namespace floormat {
 
-namespace ranges = std::ranges;
-
 namespace {
 
 template<typename T>
@@ -35,13 +35,6 @@ uint32_t ensure_buffer_size(GL::Buffer& buf, uint32_t capacity, uint32_t count)
     return new_cap;
 }
 
-struct merge_state
-{
-    struct run { uint32_t pos, end; };
-    Array<run> runs;
-    Array<uint32_t> tree;
-};
-
 struct quick_draw
 {
     GL::Mesh _mesh{NoCreate};
@@ -60,21 +53,120 @@ struct draw_item
 {
     Quads::vertexes vertexes;
     float depth;
+    // into Impl::origins
+    uint32_t origin;
 };
 
+// from the chunk's origin to the one of the batch, see draw()
+Quads::vertexes move_to(const Quads::vertexes& vertexes, Vector2i delta)
+{
+    constexpr auto min = Vector2i{limits<Short>::min}, max = Vector2i{limits<Short>::max};
+    auto ret = vertexes;
+    for (auto& v : ret)
+        v.position = Vector2s{Math::clamp(Vector2i{v.position} + delta, min, max)};
+    return ret;
+}
+
+void add_vertex_buffer(GL::Mesh& mesh, GL::Buffer& buffer)
+{
+    using S = tile_shader;
+    mesh.addVertexBuffer(buffer, 0,
+                         S::Position{S::Position::DataType::Short},
+                         S::TextureCoordinates{S::TextureCoordinates::DataType::UnsignedShort, S::TextureCoordinates::DataOption::Normalized},
+                         S::Layer{S::Layer::DataType::UnsignedShort},
+                         sizeof(UnsignedShort),
+                         S::Depth{});
+}
+
+// depth key in the upper half, emit index in the lower one
+inline uint64_t make_sort_key(float depth, uint32_t i)
+{
+    return (uint64_t)float_sort_key(depth) << 32 | i;
+}
+
+inline uint32_t sort_key_index(uint64_t x) { return (uint32_t)x; }
+
+// Stable LSD radix sort on the depth half of the keys, a byte per pass.
+// Passes where every key has the same byte are skipped, so the exponent
+// bytes of nearby depths cost nothing. The result ends up in `a`.
+void radix_sort(uint64_t* a, uint64_t* tmp, uint32_t n)
+{
+    if (n < 64)
+    {
+        for (auto i = 1u; i < n; i++)
+        {
+            const auto x = a[i];
+            auto j = i;
+            for (; j > 0 && a[j-1] >> 32 > x >> 32; j--)
+                a[j] = a[j-1];
+            a[j] = x;
+        }
+        return;
+    }
+
+    uint32_t hist[4][256] = {};
+    for (auto i = 0u; i < n; i++)
+    {
+        const auto k = (uint32_t)(a[i] >> 32);
+        hist[0][k & 0xff]++;
+        hist[1][k >> 8 & 0xff]++;
+        hist[2][k >> 16 & 0xff]++;
+        hist[3][k >> 24]++;
+    }
+
+    auto* src = a;
+    auto* dst = tmp;
+    for (auto pass = 0u; pass < 4; pass++)
+    {
+        const auto shift = 32 + pass * 8;
+        auto& h = hist[pass];
+        if (h[src[0] >> shift & 0xff] == n)
+            continue;
+        uint32_t sum = 0;
+        for (auto& x : h)
+        {
+            const auto count = x;
+            x = sum;
+            sum += count;
+        }
+        for (auto i = 0u; i < n; i++)
+            dst[h[src[i] >> shift & 0xff]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != a)
+        std::memcpy(a, src, n * sizeof *a);
+}
+
+// lists not drawn for this many frames lose their buffers
+constexpr uint64_t static_mesh_max_age = 120;
+
 } // namespace
 
-struct SpriteBatch::Impl
+struct SpriteBatch::static_mesh
 {
-    merge_state m;
+    GL::Mesh mesh{NoCreate};
+    GL::Buffer vertex_buffer{NoCreate};
+    uint64_t generation = 0, last_frame = 0;
+    uint32_t capacity = 0;
+};
 
+struct SpriteBatch::Impl
+{
     quick_draw quick;
+    // keyed by address, the generation tells apart lists reusing one
+    gtl::flat_hash_map<const SpriteList*, static_mesh> static_meshes;
+    sprite_batch_stats stats;
+    uint64_t frame = 0;
 
     Array<Quads::vertexes> vertex_buffer;
     Array<Quads::indexes> index_buffer;
 
     Array<draw_item> data;
-    Array<uint32_t> starts, sort_indexes, merge_output;
+    // chunk boundaries, and the chunks passed end_chunk(true)
+    Array<uint32_t> starts, sorted_chunks;
+    // of each begin_chunk(), and the same relative to the batch's origin
+    Array<Vector2i> origins, deltas;
+    Array<uint64_t> keys, keys_tmp;
 
     slot slots[slot_count];
     GL::Buffer index_buffer_handle{NoCreate};
@@ -91,18 +183,19 @@ SpriteBatch::SpriteBatch()
     arrayReserve(impl.index_buffer, 16);
     arrayReserve(impl.data, 16);
     arrayReserve(impl.starts, 16);
-    arrayReserve(impl.sort_indexes, 16);
 }
 
 SpriteBatch::~SpriteBatch() noexcept = default;
 
-void SpriteBatch::begin_chunk()
+void SpriteBatch::begin_chunk(chunk_coords_ c)
 {
     auto& impl = *this->impl;
     fm_assert(!impl.in_chunk);
-    fm_debug_assert(impl.sort_indexes.size() == impl.data.size());
     fm_debug_assert(impl.last_start == impl.data.size());
     impl.in_chunk = true;
+    const auto origin = Quads::chunk_origin(c);
+    if (impl.origins.isEmpty() || impl.origins.back() != origin)
+        arrayAppend(impl.origins, origin);
 }
 
 void SpriteBatch::clear()
@@ -112,10 +205,8 @@ void SpriteBatch::clear()
     arrayClear(impl.vertex_buffer);
     arrayClear(impl.data);
     arrayClear(impl.starts);
-    arrayClear(impl.sort_indexes);
-    arrayClear(impl.merge_output);
-    arrayClear(impl.m.runs);
-    arrayClear(impl.m.tree);
+    arrayClear(impl.sorted_chunks);
+    arrayClear(impl.origins);
     //arrayClear(impl.index_buffer);
     impl.last_start = 0;
     impl.in_chunk = false;
@@ -146,11 +237,13 @@ void SpriteBatch::emit(const Quads::vertexes& vertexes, float depth)
     auto& item = impl.data.back();
     item.vertexes = vertexes;
     item.depth = depth;
+    item.origin = (uint32_t)impl.origins.size() - 1;
+    impl.stats.bytes_emitted += sizeof vertexes;
 }
 
-void SpriteBatch::emit(SpriteList& list, bool render_vobjs)
+void SpriteBatch::emit(SpriteList& list, chunk_coords_ c, bool render_vobjs)
 {
-    begin_chunk();
+    begin_chunk(c);
     const auto size = list.size();
     for (auto i = 0u; i < size; i++)
     {
@@ -170,23 +263,16 @@ void SpriteBatch::end_chunk(bool do_sort)
     fm_assert(impl.in_chunk);
     impl.in_chunk = false;
 
-    const auto& A = impl.data;
     const auto first = impl.last_start;
-    const auto last = (uint32_t)A.size();
-    auto& S = impl.sort_indexes;
+    const auto last = (uint32_t)impl.data.size();
 
     if (first == last)
         return;
 
-    fm_debug_assert(S.size() == first);
-    arrayResize(S, NoInit, last);
-
-    for (auto i = first; i < last; i++)
-        S.data()[i] = i;
-
+    // the sorting itself waits for draw(), which sorts the whole frame at
+    // once unless it was told not to.
     if (do_sort)
-        ranges::sort(S.slice(first, last), [&A = std::as_const(impl.data)](auto i, auto j) { return A[i].depth < A[j].depth; });
-
+        arrayAppend(impl.sorted_chunks, (uint32_t)impl.starts.size());
     arrayAppend(impl.starts, first);
     impl.last_start = last;
 }
@@ -198,96 +284,76 @@ template<typename T> void reserve(Array<T>& A, uint32_t size) // todo reuse this
     arrayResize(A, NoInit, size);
 }
 
-void SpriteBatch::sort_vertex_buffer(bool do_sort)
+void SpriteBatch::sort_vertex_buffer(bool do_sort, Vector2i origin)
 {
     auto& impl = *this->impl;
     const auto& D = impl.data;
     const auto size = (uint32_t)D.size();
     auto& V = impl.vertex_buffer;
-    auto& M = impl.merge_output;
-    const auto& S = impl.sort_indexes;
+    auto& K = impl.keys;
     const auto& Starts = impl.starts;
-    auto& runs = impl.m.runs;
-    auto& tree = impl.m.tree;
 
     fm_assert(V.isEmpty());
-    fm_debug_assert(M.isEmpty());
-    fm_debug_assert(runs.isEmpty());
-    fm_debug_assert(tree.isEmpty());
     reserve(V, size);
 
-    const auto k = (uint32_t)Starts.size() - 1; // number of runs
-    if (!do_sort || k <= 1)
+    auto& deltas = impl.deltas;
+    reserve(deltas, (uint32_t)impl.origins.size());
+    for (auto i = 0uz; i < deltas.size(); i++)
+        deltas[i] = (impl.origins[i] - origin) * Quads::position_scale;
+
+    if (!do_sort && impl.sorted_chunks.isEmpty())
     {
-        // sort skipped (depth-buffered opaque pass), single chunk, or empty —
-        // copy vertices in input order.
+        // depth-buffered opaque pass, copy vertices in input order.
         for (auto i = 0u; i < size; i++)
-            V[i] = D[S[i]].vertexes;
+            V[i] = move_to(D[i].vertexes, deltas[D[i].origin]);
         return;
     }
 
-    reserve(M, size);
-    reserve(runs, k);
-    reserve(tree, k);
-
-    // --- k-way merge via loser tree ---
-
-    for (auto i = 0u; i < k; i++)
-        runs[i] = {Starts[i], Starts[i + 1]};
+    reserve(K, size);
+    reserve(impl.keys_tmp, size);
+    for (auto i = 0u; i < size; i++)
+        K[i] = make_sort_key(D[i].depth, i);
 
-    const uint32_t sentinel = k;
-    auto depth_of = [&](uint32_t r) -> float
-    {
-        if (r >= k) return -FLT_MAX; // sentinel always wins
-        if (runs[r].pos >= runs[r].end) return FLT_MAX; // exhausted run always loses
-        return D[S[runs[r].pos]].depth;
-    };
-
-    // build tree: insert runs back to front
-    for (auto i = 0u; i < k; i++)
-        tree[i] = sentinel;
-    for (auto i = k - 1; i != (uint32_t)-1; i--)
-    {
-        uint32_t winner = i;
-        for (uint32_t p = (k + i) / 2; p > 0; p /= 2)
-            if (depth_of(winner) > depth_of(tree[p]))
-                std::swap(winner, tree[p]);
-        tree[0] = winner;
-    }
+    // radix sort is stable, so equal depths keep their emit order, both
+    // within a chunk and across chunks. sorting the whole frame makes the
+    // per-chunk sorts of end_chunk(true) redundant.
+    if (do_sort)
+        radix_sort(K.data(), impl.keys_tmp.data(), size);
+    else
+        for (auto c : impl.sorted_chunks)
+        {
+            const auto first = Starts[c], last = Starts[c + 1];
+            radix_sort(K.data() + first, impl.keys_tmp.data() + first, last - first);
+        }
 
-    // extract in sorted order
     for (auto i = 0u; i < size; i++)
     {
-        auto w = tree[0];
-        fm_debug_assert(w < k && runs[w].pos < runs[w].end);
-        M[i] = S[runs[w].pos];
-        runs[w].pos++;
-
-        // replay from leaf w
-        uint32_t winner = w;
-        for (uint32_t p = (k + w) / 2; p > 0; p /= 2)
-            if (depth_of(winner) > depth_of(tree[p]))
-                std::swap(winner, tree[p]);
-        tree[0] = winner;
+        const auto& item = D[sort_key_index(K[i])];
+        V[i] = move_to(item.vertexes, deltas[item.origin]);
     }
 
-    // write vertices in merged order
-    for (auto i = 0u; i < size; i++)
-        V[i] = D[M[i]].vertexes;
-
-    // swap so draw() reads merged order from sort_indexes
-    std::swap(impl.sort_indexes, impl.merge_output);
-
 #if !defined FM_NO_DEBUG2 && !defined __FAST_MATH__ /* hack */
-    for (auto i = 1u; i < size; i++)
-    {
-        const auto &a = S[i-1], &b = S[i];
-        const auto ad = D[a].depth, bd = D[b].depth;
-        fm_assert(ad <= bd);
-    }
+    if (do_sort)
+        for (auto i = 1u; i < size; i++)
+        {
+            const auto ad = D[sort_key_index(K[i-1])].depth, bd = D[sort_key_index(K[i])].depth;
+            fm_assert(ad <= bd);
+        }
 #endif
 }
 
+ArrayView<const Quads::vertexes> SpriteBatch::sort(bool do_sort, Vector2i origin)
+{
+    auto& impl = *this->impl;
+    fm_assert(!impl.in_chunk);
+    fm_debug_assert(impl.vertex_buffer.isEmpty());
+    fm_debug_assert(!impl.data.size() == impl.starts.isEmpty());
+    fm_debug_assert(impl.last_start == impl.data.size());
+    arrayAppend(impl.starts, impl.last_start);
+    sort_vertex_buffer(do_sort, origin); // modifies V
+    return impl.vertex_buffer;
+}
+
 void SpriteBatch::draw(tile_shader& shader, bool do_sort)
 {
     auto& impl = *this->impl;
@@ -301,51 +367,130 @@ void SpriteBatch::draw(tile_shader& shader, bool do_sort)
     // raise the per-draw cap by widening Quads::index_type in src/quads.hpp.
     fm_assert(size <= Quads::max_quads_per_buffer);
 
-    const auto& S = impl.sort_indexes;
-    auto& V = impl.vertex_buffer;
-    fm_debug_assert(V.isEmpty());
-    fm_debug_assert(size == S.size());
-    fm_debug_assert(!size == impl.starts.isEmpty());
-    fm_debug_assert(impl.last_start == size);
-    fm_debug_assert(impl.merge_output.isEmpty());
-    arrayAppend(impl.starts, impl.last_start);
-
-    sort_vertex_buffer(do_sort); // modifies V
+    // positions get rebased next to the camera, which keeps them in range of
+    // Quads::vertex::position as long as they're anywhere near the screen.
+    const auto camera = shader.camera_offset();
+    const auto origin = -Vector2i{Math::round(camera)};
+    const auto V = sort(do_sort, origin);
     ensure_allocated(size);
 
     auto& slot = impl.slots[impl.slot_idx];
 
     slot.vertex_buffer_handle.setSubData(0, ArrayView{ V.data(), size });
-
-    auto& I = impl.index_buffer;
-    const auto Isz = (uint32_t)I.size();
-    reserve(I, size);
-    for (auto i = Isz; i < size; i++)
-        I[i] = Quads::quad_indexes(i);
-    // quad_indexes(i) depends only on i, so already-uploaded entries never go stale
-    if (size > impl.index_uploaded)
-    {
-        impl.index_buffer_handle.setSubData(impl.index_uploaded * sizeof(Quads::indexes),
-                                            ArrayView{ I.data() + impl.index_uploaded, size - impl.index_uploaded });
-        impl.index_uploaded = size;
-    }
+    impl.stats.bytes_uploaded += size * sizeof(Quads::vertexes);
+    upload_indexes(size);
 
     auto& mesh = slot.mesh;
     if (!mesh.id())
     {
         mesh = GL::Mesh{GL::MeshPrimitive::Triangles};
-        mesh.addVertexBuffer(slot.vertex_buffer_handle, 0, tile_shader::Position{}, tile_shader::TextureCoordinates{}, tile_shader::Depth{});
+        add_vertex_buffer(mesh, slot.vertex_buffer_handle);
         mesh.setIndexBuffer(impl.index_buffer_handle, 0, Quads::index_gl_type);
     }
     mesh.setCount((Int)(Quads::indexes_per_quad * V.size()));
     fm_assert(mesh.isIndexed());
 
+    shader.set_camera_offset(camera + Vector2d(origin));
     shader.draw(loader.atlas().texture(), mesh);
+    shader.set_camera_offset(camera);
+    impl.stats.draw_calls++;
 
     impl.slot_idx = (impl.slot_idx + 1) % slot_count;
     clear();
 }
 
+void SpriteBatch::upload_indexes(uint32_t count)
+{
+    auto& impl = *this->impl;
+    auto& I = impl.index_buffer;
+    const auto Isz = (uint32_t)I.size();
+    if (count > Isz)
+    {
+        reserve(I, count);
+        for (auto i = Isz; i < count; i++)
+            I[i] = Quads::quad_indexes(i);
+    }
+    // quad_indexes(i) depends only on i, so already-uploaded entries never go stale
+    if (count > impl.index_uploaded)
+    {
+        impl.index_buffer_handle.setSubData(impl.index_uploaded * sizeof(Quads::indexes),
+                                            ArrayView{ I.data() + impl.index_uploaded, count - impl.index_uploaded });
+        impl.stats.bytes_uploaded += (count - impl.index_uploaded) * sizeof(Quads::indexes);
+        impl.index_uploaded = count;
+    }
+}
+
+auto SpriteBatch::ensure_static(const SpriteList& list) -> static_mesh&
+{
+    auto& impl = *this->impl;
+    const auto count = list.size();
+    auto& m = impl.static_meshes[&list];
+    m.last_frame = impl.frame;
+    if (m.generation == list.generation)
+        return m;
+    m.generation = list.generation;
+
+    // raise the per-draw cap by widening Quads::index_type in src/quads.hpp.
+    fm_assert(count <= Quads::max_quads_per_buffer);
+    ensure_allocated(count);
+    upload_indexes(count);
+
+    if (count > m.capacity)
+    {
+        if (!m.vertex_buffer.id())
+            m.vertex_buffer = GL::Buffer{};
+        m.vertex_buffer.setData(arrayView(list.Vertexes), GL::BufferUsage::StaticDraw);
+        m.capacity = count;
+    }
+    else if (count > 0)
+        m.vertex_buffer.setSubData(0, arrayView(list.Vertexes));
+
+    if (!m.mesh.id() && m.vertex_buffer.id())
+    {
+        m.mesh = GL::Mesh{GL::MeshPrimitive::Triangles};
+        add_vertex_buffer(m.mesh, m.vertex_buffer);
+        m.mesh.setIndexBuffer(impl.index_buffer_handle, 0, Quads::index_gl_type);
+    }
+    if (m.mesh.id())
+        m.mesh.setCount((Int)(Quads::indexes_per_quad * count));
+
+    impl.stats.bytes_uploaded += count * sizeof(Quads::vertexes);
+    impl.stats.static_uploads++;
+    return m;
+}
+
+void SpriteBatch::upload_static(const SpriteList& list)
+{
+    (void)ensure_static(list);
+}
+
+void SpriteBatch::draw_static(tile_shader& shader, const SpriteList& list, chunk_coords_ c)
+{
+    auto& impl = *this->impl;
+    fm_assert(!impl.in_chunk);
+    if (list.size() == 0)
+        return;
+    auto& m = ensure_static(list);
+    fm_assert(m.mesh.isIndexed());
+    const with_shifted_camera_offset o{shader, c};
+    shader.draw(loader.atlas().texture(), m.mesh);
+    impl.stats.draw_calls++;
+}
+
+void SpriteBatch::begin_frame()
+{
+    auto& impl = *this->impl;
+    impl.frame++;
+    impl.stats = {};
+    for (auto it = impl.static_meshes.begin(); it != impl.static_meshes.end(); )
+        if (impl.frame - it->second.last_frame > static_mesh_max_age)
+            impl.static_meshes.erase(it++);
+        else
+            ++it;
+}
+
+const sprite_batch_stats& SpriteBatch::stats() const { return impl->stats; }
+
 void SpriteBatch::emit_quick(tile_shader& shader, const anim_atlas& atlas, rotation r, size_t frame,
                              const Vector3& center, const Quads::depths& depth)
 {
@@ -355,9 +500,10 @@ void SpriteBatch::emit_quick(tile_shader& shader, const anim_atlas& atlas, rotat
     const auto* sp = g.sprites[frame];
     fm_assert(sp);
     const auto uv3 = loader.atlas().texcoords_for(sprite{sp}, !g.mirror_from.isEmpty());
+    const auto origin = Vector2i{Math::round(tile_shader::project(center))};
     Quads::vertexes vertexes;
     for (auto i = 0uz; i < 4; i++)
-        vertexes[i] = { pos[i], uv3[i], depth[i] };
+        vertexes[i] = Quads::make_vertex(pos[i], uv3[i], depth[i], origin);
     const auto indexes = Quads::quad_indexes(0);
     auto& quick = impl.quick;
     auto& mesh = quick._mesh;
@@ -373,35 +519,15 @@ void SpriteBatch::emit_quick(tile_shader& shader, const anim_atlas& atlas, rotat
     if (!mesh.id())
     {
         mesh = GL::Mesh{GL::MeshPrimitive::Triangles};
-        mesh.addVertexBuffer(quick._vertex_buffer, 0, tile_shader::Position{}, tile_shader::TextureCoordinates{}, tile_shader::Depth{});
+        add_vertex_buffer(mesh, quick._vertex_buffer);
         mesh.setIndexBuffer(quick._index_buffer, 0, Quads::index_gl_type);
         mesh.setCount((Int)Quads::indexes_per_quad);
         fm_assert(mesh.isIndexed());
     }
+    const auto camera = shader.camera_offset();
+    shader.set_camera_offset(camera + Vector2d(origin));
     shader.draw(loader.atlas().texture(), quick._mesh);
-}
-
-void SpriteBatch::add_clickable(object* obj, const tile_shader& shader, Vector2i win_size, Array<clickable>& array)
-{
-    const auto& s = *obj;
-    const auto& a = *s.atlas;
-    const auto& g = a.group(s.r);
-    const auto& f = a.frame(s.r, s.frame);
-    const Vector2i offset((Vector2(shader.camera_offset()) + Vector2(win_size)*.5f)
-                          + shader.project(Vector3(s.position()) + Vector3(g.offset)) - Vector2(f.ground));
-    if (offset < win_size && offset + Vector2i(f.size) >= Vector2i())
-    {
-        arrayAppend(array, NoInit, 1);
-        array.back() =
-            clickable {
-                .src = {f.offset, f.offset + f.size},
-                .dest = {offset, offset + Vector2i(f.size)},
-                .bitmask = a.bitmask(),
-                .e = obj,
-                .stride = a.info().pixel_size[0],
-                .mirrored = !g.mirror_from.isEmpty(),
-            };
-    }
+    shader.set_camera_offset(camera);
 }
 
 } // namespace floormat
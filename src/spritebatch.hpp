@@ -3,35 +3,58 @@
 #include "compat/safe-ptr.hpp"
 #include "src/rotation.hpp"
 #include "src/quads.hpp"
+#include <cr/ArrayView.h>
 
 namespace floormat {
 
 struct point;
 struct tile_shader;
 struct object;
-struct clickable;
 class anim_atlas;
 class chunk;
 struct SpriteList;
+struct chunk_coords_;
+
+struct sprite_batch_stats
+{
+    // since begin_frame()
+    uint64_t bytes_emitted = 0, bytes_uploaded = 0;
+    uint32_t draw_calls = 0, static_uploads = 0;
+};
 
 class SpriteBatch
 {
     struct Impl;
+    struct static_mesh;
 
     void ensure_allocated(uint32_t count);
-    void sort_vertex_buffer(bool do_sort);
+    void upload_indexes(uint32_t count);
+    static_mesh& ensure_static(const SpriteList& list);
+    void sort_vertex_buffer(bool do_sort, Vector2i origin);
 
     safe_ptr<Impl> impl;
 
 public:
-    void begin_chunk();
+    void begin_chunk(chunk_coords_ c);
     void end_chunk(bool do_sort);
     void clear();
     void draw(tile_shader& shader, bool do_sort = true);
+    // what draw() uploads, without drawing; call clear() afterwards.
+    // positions end up relative to `origin`, which draw() puts at the camera.
+    ArrayView<const Quads::vertexes> sort(bool do_sort = true, Vector2i origin = {});
 
-    static void add_clickable(object* obj, const tile_shader& shader, Vector2i win_size, Array<clickable>& array);
     void emit(const Quads::vertexes& vertexes, float depth);
-    void emit(SpriteList& list, bool render_vobjs);
+    void emit(SpriteList& list, chunk_coords_ c, bool render_vobjs);
+
+    // Static opaque quads of a chunk, kept in a vertex buffer of their own
+    // and uploaded again only once `list.generation` changes. Drawn right
+    // away, without going through emit() and the depth sort.
+    void draw_static(tile_shader& shader, const SpriteList& list, chunk_coords_ c);
+    void upload_static(const SpriteList& list);
+
+    // resets the stats, and frees the buffers of lists not drawn for a while
+    void begin_frame();
+    const sprite_batch_stats& stats() const;
 
     void emit_quick(tile_shader& shader, const anim_atlas& atlas, rotation r, size_t frame, const Vector3& center, const Quads::depths& depth);
 
@@ -51,12 +51,15 @@ sweep_result sweep_aabb_vs_aabb(Range2D start, Vector2 displacement, Range2D obs
     const float t_exit  = Math::min(x.t_hi, y.t_hi);
 
     if (t_enter > t_exit || t_enter > 1.0f || t_exit <= 0.0f)
-        return { false, /*0.0f*/ };
+        return { false };
     else
-        return { true, /*Math::max(0.0f, t_enter)*/ };
+        return { true, Math::max(0.0f, t_enter) };
 }
 
-sweep_result find_swept_collider(chunk& c, Range2D start, Vector2 displacement, const Search::pred& p)
+namespace {
+
+template<bool Earliest>
+sweep_result find_swept_collider_(chunk& c, Range2D start, Vector2 displacement, const Search::pred& p)
 {
     const auto end_min = start.min() + displacement;
     const auto end_max = start.max() + displacement;
@@ -72,7 +75,7 @@ sweep_result find_swept_collider(chunk& c, Range2D start, Vector2 displacement,
     constexpr auto chunk_extent = (float)tile_size_xy * (float)TILE_MAX_DIM;
     const auto self_coord = c.coord();
 
-    sweep_result res = { .has_collider = false, /*.pos = limits<float>::max*/ };
+    sweep_result res = { .has_collider = false };
 
     auto cb = [&](chunk& self, collision_data data, Range2D r) {
         if (data.type == (uint64_t)collision_type::none)
@@ -90,8 +93,16 @@ sweep_result find_swept_collider(chunk& c, Range2D start, Vector2 displacement,
         const auto sw = sweep_aabb_vs_aabb(start, displacement, r_in_c);
         if (sw.has_collider)
         {
-            res = sw;
-            return path_search_continue::blocked;
+            if constexpr(Earliest)
+            {
+                if (!res.has_collider || sw.time < res.time)
+                    res = sw;
+            }
+            else
+            {
+                res = sw;
+                return path_search_continue::blocked;
+            }
         }
         return path_search_continue::pass;
     };
@@ -100,4 +111,16 @@ sweep_result find_swept_collider(chunk& c, Range2D start, Vector2 displacement,
     return res;
 }
 
+} // namespace
+
+sweep_result find_swept_collider(chunk& c, Range2D start, Vector2 displacement, const Search::pred& p)
+{
+    return find_swept_collider_<false>(c, start, displacement, p);
+}
+
+sweep_result find_earliest_swept_collider(chunk& c, Range2D start, Vector2 displacement, const Search::pred& p)
+{
+    return find_swept_collider_<true>(c, start, displacement, p);
+}
+
 } // namespace floormat
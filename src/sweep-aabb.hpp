@@ -13,9 +13,14 @@ namespace floormat {
 struct sweep_result
 {
     bool has_collider;
+    // fraction of the displacement at first contact, clamped to [0, 1]
+    float time = 1;
 };
 
 sweep_result sweep_aabb_vs_aabb(Range2D start, Vector2 displacement, Range2D obstacle);
+// stops at the first collider found, so `time` is that collider's
 sweep_result find_swept_collider(chunk& c, Range2D start, Vector2 displacement, const Search::pred& p);
+// visits every collider and reports the earliest contact
+sweep_result find_earliest_swept_collider(chunk& c, Range2D start, Vector2 displacement, const Search::pred& p);
 
 } // namespace floormat
@@ -29,6 +29,8 @@ tile_ref_<Chunk>::tile_ref_(Chunk& c, uint8_t i) noexcept : _chunk{&c}, i{i} {}
 template<typename Chunk>
 tile_image_ref tile_ref_<Chunk>::ground() noexcept requires(!std::is_const_v<Chunk>)
 {
+    // the caller might be clearing it
+    _chunk->mark_maybe_empty();
     _chunk->ensure_alloc_ground();
     return {_chunk->_ground->atlases[i], _chunk->_ground->variants[i]};
 }
@@ -36,6 +38,7 @@ tile_image_ref tile_ref_<Chunk>::ground() noexcept requires(!std::is_const_v<Chu
 template<typename Chunk>
 wall_image_ref tile_ref_<Chunk>::wall_north() noexcept requires(!std::is_const_v<Chunk>)
 {
+    _chunk->mark_maybe_empty();
     _chunk->ensure_alloc_walls();
     return {_chunk->_walls->atlases[i*2+0], _chunk->_walls->variants[i*2+0]};
 }
@@ -43,6 +46,7 @@ wall_image_ref tile_ref_<Chunk>::wall_north() noexcept requires(!std::is_const_v
 template<typename Chunk>
 wall_image_ref tile_ref_<Chunk>::wall_west() noexcept requires(!std::is_const_v<Chunk>)
 {
+    _chunk->mark_maybe_empty();
     _chunk->ensure_alloc_walls();
     return {_chunk->_walls->atlases[i*2+1], _chunk->_walls->variants[i*2+1]};
 }
@@ -0,0 +1,53 @@
+#include "timer-wheel.hpp"
+#include "compat/assert.hpp"
+#include <cr/GrowableArray.h>
+
+namespace floormat {
+
+void timer_wheel::schedule(object_id id, uint64_t due_frame)
+{
+    // a frame that was already expired would wait a whole turn of the wheel
+    if (due_frame <= _last_frame)
+        due_frame = _last_frame + 1;
+    arrayAppend(_slots[due_frame % slot_count], entry{id, due_frame});
+    _size++;
+}
+
+void timer_wheel::expire(uint64_t frame_no, Array<object_id>& out)
+{
+    if (frame_no <= _last_frame)
+        return;
+    // visit each slot at most once, even after skipping a lot of frames
+    const auto first = frame_no - _last_frame > slot_count ? frame_no - slot_count + 1 : _last_frame + 1;
+    _last_frame = frame_no;
+    if (_size == 0)
+        return;
+
+    for (auto f = first; f <= frame_no; f++)
+    {
+        auto& slot = _slots[f % slot_count];
+        for (auto i = 0uz; i < slot.size(); )
+        {
+            if (slot[i].due_frame <= frame_no)
+            {
+                arrayAppend(out, slot[i].id);
+                slot[i] = slot.back();
+                arrayRemoveSuffix(slot);
+                _size--;
+            }
+            else
+                i++;
+        }
+    }
+}
+
+void timer_wheel::clear()
+{
+    for (auto& slot : _slots)
+        arrayClear(slot);
+    _size = 0;
+}
+
+size_t timer_wheel::size() const { return _size; }
+
+} // namespace floormat
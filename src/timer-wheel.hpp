@@ -0,0 +1,33 @@
+#pragma once
+#include "object-id.hpp"
+#include <array>
+#include <cr/Array.h>
+
+namespace floormat {
+
+// Hashed wheel of object ids keyed by frame number. Timers further away than
+// slot_count frames go around the wheel more than once.
+class timer_wheel
+{
+public:
+    static constexpr uint32_t slot_count = 256;
+
+    void schedule(object_id id, uint64_t due_frame);
+    // appends ids due at or before `frame_no` to `out`
+    void expire(uint64_t frame_no, Array<object_id>& out);
+    void clear();
+    size_t size() const;
+
+private:
+    struct entry
+    {
+        object_id id;
+        uint64_t due_frame;
+    };
+
+    std::array<Array<entry>, slot_count> _slots;
+    uint64_t _last_frame = 0;
+    size_t _size = 0;
+};
+
+} // namespace floormat
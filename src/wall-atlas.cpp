@@ -1,4 +1,5 @@
 #include "wall-atlas.hpp"
+#include "sprite-atlas-impl.hpp"
 #include "tile-constants.hpp"
 #include "compat/array-size.hpp"
 #include "compat/exception.hpp"
@@ -98,6 +99,39 @@ Vector2ui wall_atlas::expected_size(unsigned depth, Group_ group)
     fm_assert(false);
 }
 
+void wall_atlas::check_directions(const std::array<bool, Wall::Direction_COUNT>& direction_mask, Vector2ui img_size)
+{
+    const auto frame_count = _frame_array.size();
+    fm_soft_assert(frame_count > 0);
+    bool found = false;
+    for (auto [dir_name, dir] : wall_atlas::directions)
+    {
+        const auto* D = direction((size_t)dir);
+        fm_soft_assert(!!D == direction_mask[(size_t)dir]);
+        if (!D)
+            continue;
+        for (auto [group_name, gmemb, gr] : Direction::groups)
+        {
+            const auto& G = D->*gmemb;
+            fm_soft_assert(G.is_defined == !!G.count);
+            fm_soft_assert(G.is_defined == (G.index != (uint32_t)-1));
+            fm_soft_assert(G.from_rotation == (uint8_t)-1 || G.is_defined);
+            if (!G.is_defined)
+                continue;
+            found = true;
+            fm_soft_assert(G.index < frame_count && G.index + G.count <= frame_count);
+            const auto size = expected_size(_info.depth, gr);
+            for (const auto& frame : ArrayView { &_frame_array[G.index], G.count })
+            {
+                fm_soft_assert(frame.size == size);
+                fm_soft_assert(!img_size.product() || frame.offset + frame.size <= img_size);
+            }
+        }
+    }
+    if (!found) [[unlikely]]
+        fm_throw("wall_atlas '{}' is empty!"_cf, _path);
+}
+
 wall_atlas::wall_atlas(wall_atlas_def def, String path, const ImageView2D& img)
     : _dir_array{move(def.direction_array)},
       _frame_array{move(def.frames)},
@@ -108,37 +142,7 @@ wall_atlas::wall_atlas(wall_atlas_def def, String path, const ImageView2D& img)
     const Vector2ui img_size{(uint32_t)img.size().x(), (uint32_t)img.size().y()};
     fm_soft_assert(img.pixelSize() >= 3 && img.pixelSize() <= 4);
     fm_soft_assert(img_size.product() > 0);
-    {
-        const auto frame_count = _frame_array.size();
-        fm_soft_assert(frame_count > 0);
-        bool found = false;
-        for (auto [dir_name, dir] : wall_atlas::directions)
-        {
-            const auto* D = direction((size_t)dir);
-            fm_soft_assert(!!D == def.direction_mask[(size_t)dir]);
-            if (!D)
-                continue;
-            for (auto [group_name, gmemb, gr] : Direction::groups)
-            {
-                const auto& G = D->*gmemb;
-                fm_soft_assert(G.is_defined == !!G.count);
-                fm_soft_assert(G.is_defined == (G.index != (uint32_t)-1));
-                fm_soft_assert(G.from_rotation == (uint8_t)-1 || G.is_defined);
-                if (!G.is_defined)
-                    continue;
-                found = true;
-                fm_soft_assert(G.index < frame_count && G.index + G.count <= frame_count);
-                const auto size = expected_size(_info.depth, gr);
-                for (const auto& frame : ArrayView { &_frame_array[G.index], G.count })
-                {
-                    fm_soft_assert(frame.size == size);
-                    fm_soft_assert(frame.offset + frame.size <= img_size);
-                }
-            }
-        }
-        if (!found) [[unlikely]]
-            fm_throw("wall_atlas '{}' is empty!"_cf, _path);
-    }
+    check_directions(def.direction_mask, img_size);
 
     {
         Array<bool> top_frame_mask{ValueInit, _frame_array.size()};
@@ -181,6 +185,20 @@ wall_atlas::wall_atlas(wall_atlas_def def, String path, const ImageView2D& img)
     resolve_wall_rotations(_dir_array, _direction_map);
 }
 
+wall_atlas::wall_atlas(wall_atlas_def def, String path, ArrayView<const SpriteAtlas::Sprite> sprites)
+    : _dir_array{move(def.direction_array)},
+      _frame_array{move(def.frames)},
+      _info{move(def.header)}, _path{move(path)},
+      _direction_map{def.direction_map}
+{
+    check_directions(def.direction_mask, {});
+    fm_soft_assert(sprites.size() == _frame_array.size());
+    arrayReserve(_frame_sprites, sprites.size());
+    for (const auto& s : sprites)
+        arrayAppend(_frame_sprites, sprite{&s});
+    resolve_wall_rotations(_dir_array, _direction_map);
+}
+
 auto wall_atlas::get_Direction(Direction_ num) const -> Direction*
 {
     fm_debug_assert(num < Direction_::COUNT);
@@ -116,12 +116,16 @@ class wall_atlas final : public bptr_base
     std::array<DirArrayIndex, Wall::Direction_COUNT> _direction_map;
 
     Direction* get_Direction(Direction_ num) const;
+    // a zero `img_size` skips the frame bounds check
+    void check_directions(const std::array<bool, Wall::Direction_COUNT>& direction_mask, Vector2ui img_size);
 
 public:
     fm_DEFAULT_MOVE_(wall_atlas);
     wall_atlas() noexcept;
     ~wall_atlas() noexcept override;
     wall_atlas(wall_atlas_def def, String path, const ImageView2D& img);
+    // frames that were already packed, e.g. from sprite_atlas_cache
+    wall_atlas(wall_atlas_def def, String path, ArrayView<const SpriteAtlas::Sprite> sprites);
     void serialize(StringView filename) const;
 
     const Group* group(Direction_ dir, Group_ group) const;
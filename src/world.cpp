@@ -11,6 +11,10 @@
 #include "grid-pass-pool.hpp"
 #include "search-constants.hpp"
 #include "tile-defs.hpp"
+#include "timer-wheel.hpp"
+#include "chunk-store.hpp"
+#include "timer.hpp"
+#include "nanosecond.inl"
 #include "compat/array-size.hpp"
 #include "compat/borrowed-ptr.inl"
 #include "compat/hash.hpp"
@@ -34,6 +38,10 @@ struct world::Impl
     Pointer<Pass::PoolRegistry> _pass_registry;
     Pointer<Pass::Pool> _cover_pass_pool;
     Pointer<Pass::Pool> _raycast_pass_pool;
+    timer_wheel _wake_wheel;
+    Array<object_id> _woken;
+    Array<chunk*> _collect_queue;
+    Pointer<class chunk_store> _chunk_store;
 };
 
 Grid::Pass::PoolRegistry& world::pass_pool_registry()
@@ -71,6 +79,7 @@ world::world(world&& w) noexcept :
     _chunk_table{move(w._chunk_table)},
     _head{w._head},
     _tail{w._tail},
+    _chunk_count{w._chunk_count},
     _unique_id{move(w._unique_id)},
     _object_counter{w._object_counter},
     _current_frame{w._current_frame},
@@ -80,6 +89,7 @@ world::world(world&& w) noexcept :
 {
     w._head = nullptr;
     w._tail = nullptr;
+    w._chunk_count = 0;
     w._last_chunk = {};
     w._object_counter = 0;
     for (chunk* c = _head; c; c = c->_next)
@@ -100,6 +110,8 @@ world& world::operator=(world&& w) noexcept
     _last_chunk = {};
     impl._objects = move(w.impl->_objects);
     w.impl->_objects = {};
+    impl._wake_wheel = move(w.impl->_wake_wheel);
+    w.impl->_wake_wheel.clear();
 
     // suppress unregister; _chunk_table is replaced wholesale below
     _teardown = true;
@@ -115,8 +127,16 @@ world& world::operator=(world&& w) noexcept
     _chunk_table = move(w._chunk_table);
     _head = w._head;
     _tail = w._tail;
+    _chunk_count = w._chunk_count;
     w._head = nullptr;
     w._tail = nullptr;
+    w._chunk_count = 0;
+    // ours pointed at the chunks deleted above
+    impl._collect_queue = move(w.impl->_collect_queue);
+    arrayClear(w.impl->_collect_queue);
+    // so did the stubs for our records
+    impl._chunk_store = move(w.impl->_chunk_store);
+    w.impl->_chunk_store = nullptr;
     for (chunk* c = _head; c; c = c->_next)
         c->_world = this;
 
@@ -157,9 +177,11 @@ chunk& world::operator[](chunk_coords_ coord) noexcept
     auto& [c, coord2] = _last_chunk;
     if (coord != coord2)
     {
-        c = _chunk_table->chunk_at(coord);
+        c = _chunk_table->slot_at(coord);
         if (!c)
             c = new chunk(*this, coord);
+        else if (c == detail::chunk_table::stub()) [[unlikely]]
+            c = page_in_(coord, true);
         coord2 = coord;
     }
     return *c;
@@ -167,7 +189,10 @@ chunk& world::operator[](chunk_coords_ coord) noexcept
 
 chunk* world::at(chunk_coords_ c) noexcept
 {
-    return _chunk_table->chunk_at(c);
+    auto* ch = _chunk_table->slot_at(c);
+    if (ch == detail::chunk_table::stub()) [[unlikely]]
+        return page_in_(c, true);
+    return ch;
 }
 
 const chunk* world::at(chunk_coords_ c) const noexcept
@@ -175,9 +200,128 @@ const chunk* world::at(chunk_coords_ c) const noexcept
     return _chunk_table->chunk_at(c);
 }
 
+chunk* world::resident_at(chunk_coords_ c) noexcept
+{
+    return _chunk_table->chunk_at(c);
+}
+
 bool world::contains(chunk_coords_ c) const noexcept
 {
-    return _chunk_table->chunk_at(c) != nullptr;
+    return _chunk_table->slot_at(c) != nullptr;
+}
+
+bool world::can_page_out(const chunk& c) const
+{
+    if (&c.world() != this || c._awake_count)
+        return false;
+    for (const auto& e : c._objects)
+    {
+        // the chunk and the id map hold one reference each
+        if (e->ephemeral || e.use_count() > 2)
+            return false;
+        if (e->type() == object_type::critter && static_cast<const critter&>(*e).playable)
+            return false;
+    }
+    return !c.empty(true);
+}
+
+bool world::page_out(chunk& c)
+{
+    if (!can_page_out(c))
+        return false;
+    c.sort_objects();
+    const auto coord = c.coord();
+    auto& store = chunk_store();
+    // if writing the record throws, the chunk stays resident and nothing is lost
+    store.put(coord, serialize_chunk(c));
+
+    // same as deleting the objects in the editor, except for the reason
+    const bool scripts = _script_initialized && !_script_finalized;
+    while (!c._objects.isEmpty())
+    {
+        auto e = c._objects.back();
+        if (scripts)
+            e->destroy_script_pre(e, script_destroy_reason::unload);
+        c.remove_object(c._objects.size() - 1);
+        if (scripts)
+            e->destroy_script_post();
+        e.destroy();
+    }
+    delete &c;
+    _chunk_table->update_slot(coord, detail::chunk_table::stub());
+    _last_chunk = {};
+    store.stats().page_outs++;
+    return true;
+}
+
+chunk* world::page_in(chunk_coords_ coord) noexcept
+{
+    auto* c = _chunk_table->slot_at(coord);
+    if (c == detail::chunk_table::stub())
+        return page_in_(coord, false);
+    return c;
+}
+
+chunk* world::page_in_(chunk_coords_ coord, bool fault) noexcept
+{
+    auto& store = *impl->_chunk_store;
+    const auto t0 = Time::now();
+    // otherwise deserializing would fault it in again
+    _chunk_table->update_slot(coord, nullptr);
+    chunk* c;
+    try
+    {
+        auto record = store.take(coord);
+        c = &deserialize_chunk(record, loader_policy::warn);
+    }
+    catch (const exception& e)
+    {
+        fm_abort("failed to page in chunk %d:%d:%d: %s", (int)coord.x, (int)coord.y, (int)coord.z, e.what());
+    }
+    if (_script_initialized && !_script_finalized)
+        for (const auto& e : c->_objects)
+            e->init_script(e);
+
+    const auto dt = Time::now() - t0;
+    auto& st = store.stats();
+    st.page_ins++;
+    st.faults += fault;
+    st.page_in_last = dt;
+    if (dt > st.page_in_max)
+        st.page_in_max = dt;
+    st.page_in_total += dt;
+    return c;
+}
+
+void world::page_in_all()
+{
+    auto& store = impl->_chunk_store;
+    if (!store || !store->size())
+        return;
+    Array<chunk_coords_> coords;
+    store->coords(coords);
+    for (auto coord : coords)
+        (void)page_in_(coord, false);
+}
+
+bool world::is_paged_out(chunk_coords_ coord) const noexcept
+{
+    return _chunk_table->slot_at(coord) == detail::chunk_table::stub();
+}
+
+chunk_store& world::chunk_store()
+{
+    auto& store = impl->_chunk_store;
+    if (!store)
+        store = Pointer<class chunk_store>{InPlaceInit};
+    return *store;
+}
+
+void world::set_chunk_store(Pointer<class chunk_store> store)
+{
+    fm_assert(store);
+    fm_assert(!impl->_chunk_store || !impl->_chunk_store->size());
+    impl->_chunk_store = move(store);
 }
 
 void world::clear()
@@ -186,6 +330,17 @@ void world::clear()
     fm_assert(!_teardown);
     // ~object dereferences its chunk; drop the map's refs before chunks are deleted
     impl._objects.clear();
+    if (impl._chunk_store && impl._chunk_store->size())
+    {
+        Array<chunk_coords_> coords;
+        impl._chunk_store->coords(coords);
+        for (auto coord : coords)
+            _chunk_table->update_slot(coord, nullptr);
+        impl._chunk_store->clear();
+    }
+    for (auto* c : impl._collect_queue)
+        c->_collect_queued = false;
+    arrayClear(impl._collect_queue);
     while (_head)
     {
         chunk* next = _head->_next;
@@ -200,31 +355,57 @@ void world::clear()
 
 void world::collect(bool force, bool quiet)
 {
-    size_t len0 = 0, deleted = 0;
-    chunk* c = _head;
-    while (c)
+    auto& queue = impl->_collect_queue;
+    const size_t len0 = _chunk_count;
+    size_t deleted = 0;
+
+    if (force)
     {
-        len0++;
-        chunk* next = c->_next;
-        if (c->empty(force))
+        for (auto* c : queue)
+            c->_collect_queued = false;
+        arrayClear(queue);
+        chunk* c = _head;
+        while (c)
         {
-            delete c;
-            deleted++;
+            chunk* next = c->_next;
+            if (c->empty(true))
+            {
+                delete c;
+                deleted++;
+            }
+            c = next;
         }
-        c = next;
     }
-    _last_chunk = {};
-    chunk_table_prepare_frame();
+    else
+    {
+        // dequeue first so that the destructor doesn't search the queue
+        for (auto i = 0uz; i < queue.size(); i++)
+        {
+            auto* c = queue[i];
+            c->_collect_queued = false;
+            if (c->empty())
+            {
+                delete c;
+                deleted++;
+            }
+        }
+        arrayClear(queue);
+    }
+
+    if (deleted || force)
+    {
+        _last_chunk = {};
+        chunk_table_prepare_frame();
+    }
     if (!quiet && deleted > 1)
         fm_debug("world: collected %zu/%zu chunks", deleted, len0);
 }
 
-size_t world::size() const noexcept
+size_t world::size() const noexcept { return _chunk_count; }
+
+void world::queue_collect(chunk* c) noexcept
 {
-    size_t n = 0;
-    for (const chunk* c = _head; c; c = c->_next)
-        n++;
-    return n;
+    arrayAppend(impl->_collect_queue, c);
 }
 
 template<typename Chunk>
@@ -295,6 +476,13 @@ bptr<object> world::find_object_(object_id id)
     return ret;
 }
 
+const object* world::find_object_ptr(object_id id) const noexcept
+{
+    const auto& impl = *this->impl;
+    auto it = impl._objects.find(id);
+    return it == impl._objects.end() ? nullptr : it->second.get();
+}
+
 void world::set_object_counter(object_id value)
 {
     fm_assert(value >= _object_counter);
@@ -349,12 +537,27 @@ void world::register_chunk(chunk* c) noexcept
     else
         _head = c;
     _tail = c;
+    _chunk_count++;
 }
 
 void world::unregister_chunk(chunk* c) noexcept
 {
     if (_teardown)
         return;
+    if (c->_collect_queued)
+    {
+        auto& queue = impl->_collect_queue;
+        for (auto i = 0uz; i < queue.size(); i++)
+            if (queue[i] == c)
+            {
+                queue[i] = queue.back();
+                arrayRemoveSuffix(queue);
+                break;
+            }
+        c->_collect_queued = false;
+    }
+    fm_debug_assert(_chunk_count > 0);
+    _chunk_count--;
     _chunk_table->update_slot(c->_coord, nullptr);
     if (c->_prev)
         c->_prev->_next = c->_next;
@@ -416,6 +619,23 @@ bptr<critter> world::ensure_player_character(object_id& id)
 
 uint64_t world::frame_no() const { return _current_frame; }
 
+void world::wake_after(object_id id, uint32_t nframes)
+{
+    fm_assert(nframes > 0);
+    // during an update, the current frame is _current_frame-1
+    impl->_wake_wheel.schedule(id, _current_frame - 1 + nframes);
+}
+
+void world::expire_wake_timers(uint64_t frame_no)
+{
+    auto& woken = impl->_woken;
+    arrayClear(woken);
+    impl->_wake_wheel.expire(frame_no, woken);
+    for (auto id : woken)
+        if (auto e = find_object(id))
+            e->wake();
+}
+
 bptr<critter> world::ensure_player_character(object_id& id_, critter_proto p)
 {
     if (id_)
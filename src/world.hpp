@@ -13,6 +13,7 @@ namespace floormat::detail { class chunk_table; }
 
 namespace floormat {
 
+class chunk_store;
 struct object;
 struct critter;
 struct critter_proto;
@@ -46,6 +47,7 @@ private:
     safe_ptr<detail::chunk_table> _chunk_table;
     chunk* _head = nullptr;
     chunk* _tail = nullptr;
+    size_t _chunk_count = 0;
 
     bptr<unique_id> _unique_id;
     object_id _object_counter = object_counter_init;
@@ -61,6 +63,8 @@ private:
 
     void register_chunk(chunk* c) noexcept;
     void unregister_chunk(chunk* c) noexcept;
+    void queue_collect(chunk* c) noexcept;
+    chunk* page_in_(chunk_coords_ coord, bool fault) noexcept;
     /// Allocate the next passability-generation stamp: chunks store it in _pass_gen at
     /// construction and on each change, and grids compare per-chunk stamps for staleness.
     /// Monotonic uint64, so a chunk reused at a recycled address can't collide (ABA).
@@ -77,11 +81,17 @@ public:
     explicit world();
     ~world() noexcept;
 
+    // these page the chunk back in if it's paged out
     chunk& operator[](chunk_coords_ c) noexcept;
     chunk* at(chunk_coords_ c) noexcept;
+    // null for paged-out chunks
     const chunk* at(chunk_coords_ c) const noexcept;
+    chunk* resident_at(chunk_coords_ c) noexcept;
+    // true for paged-out chunks too
     bool contains(chunk_coords_ c) const noexcept;
     void clear();
+    // without `force`, only checks chunks that lost their last object, had a
+    // tile changed, or were created since the last call
     void collect(bool force = false, bool quiet = false);
     size_t size() const noexcept;
 
@@ -111,13 +121,36 @@ public:
     chunks_range<chunk> chunks() noexcept;
     chunks_range<const chunk> chunks() const noexcept;
 
+    // Chunks can be paged out to the chunk store and freed, leaving a stub in
+    // the chunk table. Chunks with objects that are awake, ephemeral, playable
+    // or referenced from outside the world stay in memory.
+    bool can_page_out(const chunk& c) const;
+    // false if the chunk can't be paged out, see can_page_out()
+    bool page_out(chunk& c);
+    // null if the chunk isn't paged out and doesn't exist either
+    chunk* page_in(chunk_coords_ coord) noexcept;
+    void page_in_all();
+    bool is_paged_out(chunk_coords_ coord) const noexcept;
+    // kept in memory unless replaced with set_chunk_store()
+    class chunk_store& chunk_store();
+    void set_chunk_store(Pointer<class chunk_store> store);
+
+    // pages everything back in first
     void serialize(StringView filename);
+    // a savegame with just this one chunk, see page_out()
+    Array<char> serialize_chunk(chunk& c);
+    chunk& deserialize_chunk(ArrayView<const char> record, loader_policy asset_policy) noexcept(false);
     static class world deserialize(StringView filename, loader_policy asset_policy) noexcept(false);
     static void deserialize_old(world& w, ArrayView<const char> buf, uint16_t proto,
                                 loader_policy asset_policy) noexcept(false);
     uint64_t frame_no() const;
     uint64_t increment_frame_no() { return _current_frame++; }
 
+    // wakes the object up `nframes` updates after the current one, see object::sleep_for()
+    void wake_after(object_id id, uint32_t nframes);
+    // called by the update loop once per frame, before updating objects
+    void expire_wake_timers(uint64_t frame_no);
+
     template<typename T, bool sorted = true, typename... Xs>
     requires requires(chunk& c, Xs&&... xs) {
         T{object_id(), c, forward<Xs>(xs)...};
@@ -136,6 +169,8 @@ public:
     template<typename T> requires is_strict_base_of<scenery, T> bptr<T> find_object(object_id id);
     template<typename T = object> bptr<const T> find_object(object_id id) const;
     template<typename T> requires is_strict_base_of<scenery, T> bptr<const T> find_object(object_id id) const;
+    // doesn't touch the reference count, for the chunk_mesh_builder workers
+    const object* find_object_ptr(object_id id) const noexcept;
 
     bptr<critter> ensure_player_character(object_id& id, critter_proto p);
     bptr<critter> ensure_player_character(object_id& id);
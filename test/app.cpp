@@ -70,12 +70,16 @@ int App::exec()
         FM_TEST(test_float),
         FM_TEST(test_texcoords),
         FM_TEST(test_shader),
+        FM_TEST(test_spritebatch),
         // normal
 
         FM_TEST(test_bitmask),
+        FM_TEST(test_clickable),
         FM_TEST(test_json),
         FM_TEST(test_json2),
         FM_TEST(test_json3),
+        FM_TEST(test_light_index),
+        FM_TEST(test_light_occluders),
         FM_TEST(test_loader),
         FM_TEST(test_scenery),
         FM_TEST(test_raycast),
@@ -96,6 +100,7 @@ int App::exec()
         FM_TEST(test_dijkstra),
         FM_TEST(test_loader2),
         FM_TEST(test_loader3),
+        FM_TEST(test_loader4),
         FM_TEST(test_saves),
         FM_TEST(test_sprites),
     };
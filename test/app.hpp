@@ -20,6 +20,7 @@ void test_astar_pool();
 void test_bitmask();
 void test_bptr();
 void test_chunk_iter();
+void test_clickable();
 void test_coords();
 void test_crc64();
 void test_critter();
@@ -32,9 +33,12 @@ void test_hole();
 void test_json();
 void test_json2();
 void test_json3();
+void test_light_index();
+void test_light_occluders();
 void test_loader();
 void test_loader2();
 void test_loader3();
+void test_loader4();
 void test_local();
 void test_magnum_math();
 void test_math();
@@ -50,6 +54,7 @@ void test_shader();
 void test_spinlock();
 void test_sprite_atlas();
 void test_sprites();
+void test_spritebatch();
 void test_sweep_aabb();
 void test_util();
 void test_texcoords();
@@ -3,9 +3,13 @@
 #include "loader/loader.hpp"
 #include "compat/assert.hpp"
 #include "compat/array-size.hpp"
+#include <cstring>
 #include <mg/Functions.h>
 #include <mg/ImageData.h>
 #include <mg/ImageView.h>
+#include <mg/PixelFormat.h>
+#include <cr/BitArray.h>
+#include <cr/Array.h>
 
 namespace floormat {
 
@@ -19,12 +23,9 @@ constexpr auto data_nbytes = array_size(src);
 constexpr auto size = Vector2i{21, 52};
 //static_assert(size_t{size.product()+7}/8 <= data_nbytes);
 
-void bitmask_test()
+void check_fixture(const BitArray& bitmask)
 {
-    auto img = loader.texture("images/", "bitmask-test1"_s);
-    auto bitmask = anim_atlas::make_bitmask(img);
     fm_assert(bitmask.size() >= size_t{size.product()});
-    fm_assert(img.pixelSize() == 4);
 //#define DO_GENERATE
 #ifdef DO_GENERATE
     fputc('\n', stdout);
@@ -47,11 +48,71 @@ void bitmask_test()
     }
 }
 
+void bitmask_test()
+{
+    auto img = loader.texture("images/", "bitmask-test1"_s);
+    fm_assert(img.pixelSize() == 4);
+    check_fixture(anim_atlas::make_bitmask(img));
+
+    for (auto k = 0u; k < (unsigned)bitmask_kernel::COUNT; k++)
+    {
+        const auto kernel = (bitmask_kernel)k;
+        if (!anim_atlas::has_bitmask_kernel(kernel))
+            continue;
+        auto bitmask = anim_atlas::make_bitmask(img);
+        bitmask.setAll();
+        anim_atlas::make_bitmask_(img, bitmask, kernel);
+        check_fixture(bitmask);
+    }
+}
+
+// every kernel against the scalar one, with widths around the vector sizes
+// and the row stride padded so that rows don't start where the last one ended
+void kernels_test()
+{
+    uint32_t state = 0x2545f491;
+    for (auto width = 1; width <= 70; width++)
+        for (auto height : { 1, 3, 8, 13 })
+        {
+            constexpr auto pad = 3;
+            auto pixels = Array<unsigned char>{NoInit, (size_t)((width + pad) * height * 4)};
+            for (auto& x : pixels)
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                // lots of values right around the cutoff
+                x = state & 3 ? (unsigned char)(state >> 8) : (unsigned char)(28 + (state >> 8) % 8);
+            }
+            PixelStorage storage;
+            storage.setRowLength(width + pad);
+            const auto img = ImageView2D{storage, PixelFormat::RGBA8Unorm, {width, height}, pixels};
+
+            auto expected = anim_atlas::make_bitmask(img);
+            anim_atlas::make_bitmask_(img, expected, bitmask_kernel::scalar);
+            for (auto j = 0; j < height; j++)
+                for (auto i = 0; i < width; i++)
+                    fm_assert(expected[(size_t)((height - j - 1)*width + i)] == (pixels[(size_t)((j*(width + pad) + i)*4 + 3)] >= 32));
+
+            for (auto k = 1u; k < (unsigned)bitmask_kernel::COUNT; k++)
+            {
+                const auto kernel = (bitmask_kernel)k;
+                if (!anim_atlas::has_bitmask_kernel(kernel))
+                    continue;
+                auto bitmask = anim_atlas::make_bitmask(img);
+                bitmask.setAll();
+                anim_atlas::make_bitmask_(img, bitmask, kernel);
+                fm_assert(std::memcmp(bitmask.data(), expected.data(), expected.size() / 8) == 0);
+            }
+        }
+}
+
 } // namespace
 
 void Test::test_bitmask()
 {
     bitmask_test();
+    kernels_test();
     //bitmask_benchmark();
 }
 
@@ -0,0 +1,104 @@
+#include "app.hpp"
+#include "src/clickable-index.hpp"
+#include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/object.hpp"
+#include "src/critter.hpp"
+#include "src/scenery.hpp"
+#include "src/scenery-proto.hpp"
+#include "src/depth.hpp"
+#include "loader/loader.hpp"
+
+namespace floormat::Test {
+
+namespace {
+
+// the linear scan the index replaced
+clickable* pick_linear(ArrayView<clickable> array, Vector2i p)
+{
+    clickable* item = nullptr;
+    uint32_t depth = 0;
+    for (clickable& c : array)
+    {
+        const uint32_t d = Depth::value_atʹ(c.e->position());
+        if (d > depth && c.dest.contains(p))
+        {
+            const auto posʹ = p - c.dest.min();
+            const auto posʹʹ = !c.mirrored ? posʹ : Vector2i(int(c.src.sizeX()) - 1 - posʹ[0], posʹ[1]);
+            const auto pos = posʹʹ + Vector2i(c.src.min());
+            size_t idx = unsigned(pos.y()) * c.stride + unsigned(pos.x());
+            if (c.bitmask.isEmpty() || c.bitmask[idx])
+            {
+                depth = d;
+                item = &c;
+            }
+        }
+    }
+    return item;
+}
+
+void draw_frame(clickable_index& index, chunk& c, Vector2i offset, Vector2i win_size)
+{
+    c.build_scenery_mesh();
+    index.begin_frame(offset, win_size, false);
+    index.add_chunk(c);
+    index.end_frame();
+}
+
+} // namespace
+
+void test_clickable()
+{
+    constexpr auto win_size = Vector2i{800, 600};
+    auto w = world();
+    const auto& table = loader.scenery("table0");
+    for (uint8_t i = 0; i < 6; i++)
+        (void)w.make_scenery(w.make_id(), {{}, {(uint8_t)(2 + i), (uint8_t)(2 + i % 3)}}, scenery_proto(table));
+    (void)w.make_object<critter>(w.make_id(), {{}, {4, 4}}, critter_proto{world::make_player_proto()});
+    auto& c = w[chunk_coords_{}];
+    c.sort_objects();
+
+    auto index = clickable_index{};
+    auto offset = Vector2i{400, 200};
+    draw_frame(index, c, offset, win_size);
+    fm_assert(index.stats().rebuilt);
+    fm_assert_equal(6u, index.stats().static_count);
+    fm_assert_equal(1u, index.stats().dynamic_count);
+    fm_assert_equal(7uz, index.items().size());
+
+    // nothing changed
+    draw_frame(index, c, offset, win_size);
+    fm_assert(!index.stats().rebuilt);
+    fm_assert_equal(7uz, index.items().size());
+
+    uint32_t hits = 0;
+    for (int y = 0; y < win_size.y(); y += 2)
+        for (int x = 0; x < win_size.x(); x += 2)
+        {
+            auto* a = index.pick({x, y});
+            fm_assert(a == pick_linear(index.items(), {x, y}));
+            hits += !!a;
+        }
+    fm_assert(hits > 0);
+
+    // camera moved
+    offset += Vector2i{-100, 50};
+    draw_frame(index, c, offset, win_size);
+    fm_assert(index.stats().rebuilt);
+    for (int y = 1; y < win_size.y(); y += 3)
+        for (int x = 1; x < win_size.x(); x += 3)
+            fm_assert(index.pick({x, y}) == pick_linear(index.items(), {x, y}));
+
+    // scenery changed
+    (void)w.make_scenery(w.make_id(), {{}, {10, 10}}, scenery_proto(table));
+    c.sort_objects();
+    draw_frame(index, c, offset, win_size);
+    fm_assert(index.stats().rebuilt);
+    fm_assert_equal(7u, index.stats().static_count);
+
+    index.clear();
+    fm_assert(index.items().isEmpty());
+    fm_assert(!index.pick({400, 300}));
+}
+
+} // namespace floormat::Test
@@ -4,12 +4,19 @@
 #include "src/point.inl"
 #include "src/world.hpp"
 #include "src/critter.hpp"
+#include "src/critter-script.hpp"
+#include "src/search-result.hpp"
+#include "src/sim-lod.hpp"
+#include "src/scenery.hpp"
+#include "src/hole.hpp"
+#include "src/chunk.hpp"
 #include "src/scenery-proto.hpp"
 #include "src/tile-image.hpp"
 #include "compat/borrowed-ptr.inl"
 #include "compat/function2.hpp"
 #include "loader/loader.hpp"
 #include "compat/constantly.hpp"
+#include <cr/GrowableArray.h>
 #include <cinttypes>
 #include <cstdio>
 
@@ -166,6 +173,222 @@ void test_player_character_id_lowest()
     fm_assert(id == a->id);
 }
 
+struct toward_state
+{
+    point pos;
+    uint32_t delta, anim_progress;
+    uint16_t offset_frac, frame;
+    rotation r;
+
+    bool operator==(const toward_state&) const = default;
+};
+
+toward_state state_of(const critter& C)
+{
+    return { C.position(), C.delta, C.anim_progress, C.offset_frac, C.frame, C.r };
+}
+
+void move_toward_both(point from, point dest, Ns dt_per_step, uint32_t max_steps)
+{
+    const auto W = wall_image_proto{ loader.wall_atlas("empty"), 0 };
+    auto make_world = [&] {
+        auto w = world();
+        w[{0,0,0}][{8,3}].wall_north() = W;
+        w[{1,0,0}][{2,8}].wall_west() = W;
+        w[{0,1,0}][{12,2}].wall_north() = W;
+        return w;
+    };
+    auto w1 = make_world(), w2 = make_world();
+
+    object_id id1 = 0, id2 = 0;
+    auto C1 = w1.ensure_player_character(id1, make_proto(1.f));
+    auto C2 = w2.ensure_player_character(id2, make_proto(1.f));
+    auto i1 = C1->index(), i2 = C2->index();
+    C1->teleport_to(i1, from, rotation_COUNT);
+    C2->teleport_to(i2, from, rotation_COUNT);
+    fm_assert(state_of(*C1) == state_of(*C2));
+
+    for (auto i = 0u; i < max_steps; i++)
+    {
+        auto dt1 = dt_per_step, dt2 = dt_per_step;
+        const auto m1 = C1->move_toward(i1, dt1, dest, critter::move_mode::per_step);
+        const auto m2 = C2->move_toward(i2, dt2, dest, critter::move_mode::analytic);
+        fm_assert(dt1 == dt2);
+        fm_assert(m1.blocked == m2.blocked);
+        fm_assert(m1.moved == m2.moved);
+        fm_assert(state_of(*C1) == state_of(*C2));
+        if (m1.blocked || C1->position() == dest)
+            return;
+    }
+    fm_assert(false);
+}
+
+// the coarse tier keeps the same pace as the real thing, diagonals included
+void move_toward_coarse_both(point from, point dest, Ns dt_per_step, uint32_t max_steps)
+{
+    auto w1 = world(), w2 = world();
+    object_id id1 = 0, id2 = 0;
+    auto C1 = w1.ensure_player_character(id1, make_proto(1.f));
+    auto C2 = w2.ensure_player_character(id2, make_proto(1.f));
+    auto i1 = C1->index(), i2 = C2->index();
+    C1->teleport_to(i1, from, rotation_COUNT);
+    C2->teleport_to(i2, from, rotation_COUNT);
+
+    for (auto i = 0u; i < max_steps; i++)
+    {
+        auto dt1 = dt_per_step, dt2 = dt_per_step;
+        const auto m1 = C1->move_toward(i1, dt1, dest);
+        const auto m2 = C2->move_toward_coarse(i2, dt2, dest);
+        fm_assert(dt1 == dt2);
+        fm_assert(!m1.blocked && !m2.blocked);
+        fm_assert(m1.moved == m2.moved);
+        fm_assert(state_of(*C1) == state_of(*C2));
+        if (C1->position() == dest)
+            return;
+    }
+    fm_assert(false);
+}
+
+void test_move_toward_modes()
+{
+    constexpr auto dt60 = Millisecond * 16.667, dt10 = Millisecond * 100.0, dt1 = Millisecond * 1.0;
+    constexpr uint32_t max = Grace::slow_max_steps;
+
+    // cardinal, open
+    move_toward_both({{0,0,0}, {2,12}, {}}, {{0,0,0}, {14,12}, {-3,5}}, dt60, max);
+    // cardinal into the wall at {8,3}
+    move_toward_both({{0,0,0}, {8,12}, {}}, {{0,0,0}, {8,0}, {}}, dt60, max);
+    move_toward_both({{0,0,0}, {8,12}, {}}, {{0,0,0}, {8,0}, {}}, dt10, max);
+    // diagonal, then cardinal across a chunk boundary
+    move_toward_both({{0,0,0}, {3,3}, {}}, {{1,1,0}, {5,9}, {7,-2}}, dt60, max);
+    move_toward_both({{0,0,0}, {3,3}, {}}, {{1,1,0}, {5,9}, {7,-2}}, dt1, max*10);
+    // across the wall on the chunk to the east
+    move_toward_both({{0,0,0}, {10,8}, {}}, {{1,0,0}, {6,8}, {}}, dt60, max);
+    // long leg spanning chunks, ends against the wall at {0,1} {12,2}
+    move_toward_both({{0,-1,0}, {12,4}, {}}, {{0,1,0}, {12,12}, {}}, dt10, max);
+
+    // diagonal, then cardinal, without collision checks
+    move_toward_coarse_both({{0,0,0}, {3,3}, {}}, {{1,1,0}, {5,9}, {7,-2}}, dt60, max);
+    move_toward_coarse_both({{0,0,0}, {3,3}, {}}, {{1,1,0}, {5,9}, {7,-2}}, dt10, max);
+}
+
+void test_sim_lod()
+{
+    Debug quiet{nullptr};
+
+    auto w = world();
+    auto proto = make_proto(1);
+    proto.playable = false;
+
+    // one walker in each tier, going east through the middle of its chunk
+    constexpr int16_t count = 4;
+    bptr<critter> walkers[count];
+    point dests[count];
+    for (int16_t x = 0; x < count; x++)
+    {
+        const auto ch = chunk_coords_{x, 0, 0};
+        const auto from = point{ch, {4, 8}, {}};
+        dests[x] = point{ch, {10, 8}, {}};
+        path_search_result path;
+        arrayAppend(path.raw_path(), point{ch, {7, 8}, {}});
+        arrayAppend(path.raw_path(), dests[x]);
+        walkers[x] = w.make_object<critter>(w.make_id(), from.coord(), critter_proto{proto});
+        walkers[x]->script.do_reassign(critter_script::make_walk_script(move(path)), walkers[x]);
+    }
+    const auto frozen_pos = walkers[3]->position();
+
+    sim_lod lod{{ .reduced_radius = 1, .coarse_radius = 2, .reduced_interval = 4, .coarse_interval = 8, }};
+    const chunk_coords_ full[] = { {0, 0, 0} };
+    lod.update(w, full, Millisecond * 16.667);
+
+    fm_assert(lod.tier_of({0, 0, 0}) == sim_tier::full);
+    fm_assert(lod.tier_of({1, 0, 0}) == sim_tier::reduced);
+    fm_assert(lod.tier_of({2, 0, 0}) == sim_tier::coarse);
+    fm_assert(lod.tier_of({3, 0, 0}) == sim_tier::frozen);
+    fm_assert(lod.tier_of({0, 0, 1}) == sim_tier::frozen);
+    fm_assert(lod.stats().chunks[(size_t)sim_tier::full] == 1);
+    fm_assert(lod.stats().chunks[(size_t)sim_tier::reduced] == 1);
+    fm_assert(lod.stats().chunks[(size_t)sim_tier::coarse] == 1);
+    fm_assert(lod.stats().updates[(size_t)sim_tier::full] == 1);
+
+    // takes about 7 seconds at full rate
+    uint32_t reduced_updates = 0;
+    for (auto i = 0u; i < 900; i++)
+    {
+        lod.update(w, full, Millisecond * 16.667);
+        reduced_updates += lod.stats().updates[(size_t)sim_tier::reduced];
+        fm_assert(lod.stats().updates[(size_t)sim_tier::frozen] == 0);
+    }
+    fm_assert(reduced_updates > 0 && reduced_updates <= 900/4 + 1);
+
+    for (int16_t x = 0; x < 3; x++)
+    {
+        fm_assert(walkers[x]->position() == dests[x]);
+        fm_assert(!walkers[x]->moves.AUTO);
+    }
+    fm_assert(walkers[3]->position() == frozen_pos);
+}
+
+void test_active_set()
+{
+    Debug quiet{nullptr};
+
+    auto w = world();
+    const auto ch = chunk_coords_{0, 0, 0};
+    auto& c = w[ch];
+    sim_lod lod;
+    const chunk_coords_ full[] = { ch };
+    constexpr auto dt = Millisecond * 16.667;
+    auto tick = [&] { lod.update(w, full, dt); return lod.stats().updates[(size_t)sim_tier::full]; };
+
+    // nothing to do from the start
+    auto table = w.make_scenery(w.make_id(), {ch, {2, 2}}, scenery_proto(loader.scenery("table0")));
+    auto h = w.make_object<hole>(w.make_id(), {ch, {3, 3}}, hole_proto{});
+    fm_assert(!table->awake && !h->awake);
+    fm_assert(c.awake_count() == 0);
+    fm_assert(tick() == 0);
+    fm_assert(lod.stats().objects[(size_t)sim_tier::full] == 2);
+
+    // a closed door sleeps until it's activated, and again once it's open
+    auto doorʹ = w.make_scenery(w.make_id(), {ch, {8, 8}}, scenery_proto(loader.scenery("door1")));
+    auto& door = static_cast<door_scenery&>(*doorʹ);
+    fm_assert(!door.awake);
+    door.activate(door.index());
+    fm_assert(door.awake && c.awake_count() == 1);
+    for (auto i = 0u; i < 60*3 && door.awake; i++)
+        fm_assert(tick() == 1);
+    fm_assert(!door.awake && !door.active && door.frame == 0);
+    fm_assert(c.awake_count() == 0);
+
+    // a critter sleeps while it has neither keys nor a script
+    object_id id = 0;
+    auto C = w.ensure_player_character(id, make_proto(1));
+    fm_assert(C->awake);
+    fm_assert(tick() == 1);
+    fm_assert(!C->awake);
+    fm_assert(tick() == 0);
+    const auto pos = C->position();
+    C->set_keys(false, false, true, false);
+    fm_assert(C->awake);
+    for (auto i = 0u; i < 30; i++)
+        fm_assert(tick() == 1);
+    fm_assert(C->position() != pos);
+    C->set_keys(false, false, false, false);
+    fm_assert(tick() == 1);
+    fm_assert(!C->awake && c.awake_count() == 0);
+
+    // delayed wakeup
+    table->sleep_for(3);
+    fm_assert(!table->awake);
+    fm_assert(tick() == 0);
+    fm_assert(tick() == 0);
+    fm_assert(!table->awake);
+    fm_assert(tick() == 1);
+    fm_assert(table->awake);
+    table->sleep();
+    fm_assert(tick() == 0);
+}
+
 } // namespace
 
 } // namespace floormat::Run
@@ -223,6 +446,9 @@ void Test::test_critter()
 
     test_dt_invariance();
     test_player_character_id_lowest();
+    test_move_toward_modes();
+    test_sim_lod();
+    test_active_set();
 
     if (is_noisy)
     {
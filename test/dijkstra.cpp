@@ -1,5 +1,7 @@
 #include "app.hpp"
 #include "src/search-astar.hpp"
+#include "src/search-dstar.hpp"
+#include "src/search-scheduler.hpp"
 #include "src/search-result.hpp"
 #include "src/grid-pass.hpp"
 #include "src/point.hpp"
@@ -10,6 +12,77 @@
 
 namespace floormat {
 
+namespace {
+
+void test_dstar_replan()
+{
+    constexpr auto from = point{{0, 0, 0}, {2, 8}, {}};
+    constexpr auto to = point{{1, 0, 0}, {8, 8}, {}};
+    constexpr auto max_dist = (uint32_t)(TILE_MAX_DIM*iTILE_SIZE2*3).length();
+    constexpr auto own_size = Vector2ui{16, 16};
+
+    auto w = world();
+    auto wall = wall_image_proto{loader.invalid_wall_atlas().atlas, 0};
+    for (int16_t j = -1; j <= 1; j++)
+        for (int16_t i = -1; i <= 2; i++)
+            (void)w[{i, j, 0}];
+
+    auto& c = w[chunk_coords_{0, 0, 0}];
+    const auto set_obstacle = [&](bool value) {
+        for (int y = 5; y <= 11; y++)
+            c[{14, y}].wall_west() = value ? wall : wall_image_proto{};
+        c.mark_passability_modified();
+        c.ensure_passability();
+    };
+
+    const auto fresh = [&] {
+        auto D = dstar_lite{};
+        D.reset(w, from, to, max_dist, own_size, Search::without_critters());
+        return D.plan(w);
+    };
+
+    auto D = dstar_lite{};
+    D.reset(w, from, to, max_dist, own_size, Search::without_critters());
+    auto res0 = D.plan(w);
+    fm_assert(res0.is_found());
+    fm_assert(!D.sync(w));
+
+    set_obstacle(true);
+    fm_assert(D.sync(w));
+    fm_assert(D.stats().cells_changed > 0);
+    fm_assert(D.stats().chunks_invalidated == 0);
+    const auto expanded = D.stats().expanded;
+    auto res1 = D.plan(w);
+    fm_assert(res1.is_found());
+    fm_assert(res1.cost() > res0.cost());
+    fm_assert(res1.cost() == fresh().cost());
+    fm_assert(D.stats().expanded > expanded);
+
+    set_obstacle(false);
+    fm_assert(D.sync(w));
+    auto res2 = D.plan(w);
+    fm_assert(res2.is_found());
+    fm_assert(res2.cost() == res0.cost());
+
+    // walled in from every side
+    for (int y = 5; y <= 11; y++)
+        c[{14, y}].wall_west() = wall;
+    for (int x = 1; x <= 14; x++)
+    {
+        c[{x, 5}].wall_north() = wall;
+        c[{x, 12}].wall_north() = wall;
+    }
+    for (int y = 5; y <= 11; y++)
+        c[{1, y}].wall_west() = wall;
+    c.mark_passability_modified();
+    c.ensure_passability();
+    fm_assert(D.sync(w));
+    fm_assert(!D.plan(w).is_found());
+    fm_assert(!fresh().is_found());
+}
+
+} // namespace
+
 void Test::test_dijkstra()
 {
     [[maybe_unused]] constexpr bool debug = false;
@@ -86,6 +159,56 @@ void Test::test_dijkstra()
         fm_assert(result.cost() < 3000);
         fm_assert(result.distance() == 0);
     }
+
+    {
+        // both frontier policies pop in the same order, so paths are identical
+        auto res_heap = run.operator()<false>();
+        A.set_frontier_policy(astar::frontier_policy::bucket_queue);
+        auto res_buckets = run.operator()<false>();
+        A.set_frontier_policy(astar::frontier_policy::binary_heap);
+        fm_assert(res_heap.is_found() == res_buckets.is_found());
+        fm_assert(res_heap.cost() == res_buckets.cost());
+        fm_assert(res_heap.distance() == res_buckets.distance());
+        fm_assert(res_heap.size() == res_buckets.size());
+        for (auto i = 0uz; i < res_heap.size(); i++)
+            fm_assert(res_heap.path()[i] == res_buckets.path()[i]);
+    }
+
+    {
+        // a search cut into small slices ends up where a single call does
+        constexpr point from = {{0, 0, 0}, {11, 9}}, to = {wpos, {wox, woy}};
+        auto res_full = run.operator()<false>();
+        A.begin(w, from, to, max_dist, {16, 16}, Search::without_critters());
+        while (A.resume(w, {.max_expansions = 7}) == astar::search_status::running)
+            (void)0;
+        fm_assert(A.slice_count() > 1);
+        auto res_sliced = A.take_result();
+        fm_assert(A.status() == astar::search_status::idle);
+        fm_assert(res_full.is_found() == res_sliced.is_found());
+        fm_assert(res_full.cost() == res_sliced.cost());
+        fm_assert(res_full.size() == res_sliced.size());
+        for (auto i = 0uz; i < res_full.size(); i++)
+            fm_assert(res_full.path()[i] == res_sliced.path()[i]);
+
+        auto S = search_scheduler{{.max_expansions = 100}};
+        const auto id1 = S.submit(w, from, to, max_dist, {16, 16}, Search::without_critters());
+        const auto id2 = S.submit(w, to, from, max_dist, {16, 16}, Search::without_critters());
+        fm_assert(S.active_count() == 2);
+        uint32_t frames = 0;
+        while (S.active_count() > 0)
+        {
+            S.update(w);
+            frames++;
+        }
+        fm_assert(frames > 1);
+        fm_assert(S.is_done(id1) && S.is_done(id2));
+        auto res1 = S.take(id1);
+        fm_assert(res1.cost() == res_full.cost());
+        fm_assert(res1.size() == res_full.size());
+        S.cancel(id2);
+    }
+
+    test_dstar_replan();
 }
 
 } // namespace floormat
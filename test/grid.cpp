@@ -1,8 +1,12 @@
 #include "app.hpp"
 #include "src/grid-pass.hpp"
+#include "src/grid-cover.hpp"
+#include "src/grid-fov.hpp"
+#include "src/nanosecond.hpp"
 #include "src/world.hpp"
 #include "src/chunk.hpp"
 #include "src/tile-defs.hpp"
+#include "src/point.hpp"
 #include "loader/loader.hpp"
 
 namespace floormat::Test {
@@ -284,6 +288,37 @@ void test_wall_then_clear_ground_allows_collect(uint32_t div_size)
     tick(w, pool);
 }
 
+void test_incremental_collect(uint32_t div_size)
+{
+    auto w = world();
+    auto& c = w[COORD];
+    add_ground_all(c);
+    add_ground_all(w[COORD_E]);
+    (void)w[COORD_Eʹ];
+    fm_assert(w.size() == 3);
+
+    // only the chunk left empty goes away
+    w.collect(false, true);
+    fm_assert(w.size() == 2);
+    fm_assert(w.at(COORD) == &c);
+
+    Pass::Pool pool{Pass::Params{div_size}};
+    tick(w, pool);
+
+    // nothing's queued; a later clear puts the chunk back in the queue
+    w.collect(false, true);
+    fm_assert(w.size() == 2);
+    clear_ground_all(c);
+    w.collect(false, true);
+    fm_assert(w.at(COORD) == nullptr);
+    fm_assert(w.at(COORD_E) != nullptr);
+    fm_assert(w.size() == 1);
+
+    tick(w, pool);
+    w.collect(true, true);
+    fm_assert(w.size() == 0);
+}
+
 void test_cell_at_wall_is_blocked(uint32_t div_size)
 {
     auto w = world();
@@ -936,6 +971,145 @@ void test_partial_collect_then_collect_survivors(uint32_t div_size)
     fm_assert(pool.pooled_count() == 2);
 }
 
+void add_cover_scene(world& w)
+{
+    for (int16_t j = -1; j <= 1; j++)
+        for (int16_t i = -1; i <= 1; i++)
+            add_ground_all(w[chunk_coords_{i, j, 0}]);
+    auto& ce = w[COORD_E];
+    for (uint8_t k = 2; k <= 12; k++)
+        add_wall_north(ce, {k, 8});
+    for (int16_t j = -1; j <= 1; j++)
+        for (int16_t i = -1; i <= 1; i++)
+            rebuild_passability(w[chunk_coords_{i, j, 0}]);
+}
+
+void test_cover_filler_matches_main_thread(uint32_t thread_count)
+{
+    auto w = world();
+    add_cover_scene(w);
+
+    auto pool = Cover::Pool{{8}}, ref = Cover::Pool{{8}};
+    auto filler = Cover::Filler{pool, thread_count};
+    const chunk_coords_ chunks[] = { COORD };
+    filler.update(w, chunks, Ns{(uint64_t)-1});
+    filler.finish(w);
+    fm_assert(filler.in_flight() == 0);
+    fm_assert(filler.stats().filled == Cover::octant_count - 1);
+    fm_assert(filler.stats().dropped == 0);
+
+    ref.maybe_mark_stale_all(w.frame_no());
+    auto g = pool[w[COORD]], r = ref[w[COORD]];
+    fm_assert(g.built_octants() == (uint32_t)-1);
+    for (auto k = 0u; k < Cover::octant_count; k++)
+        r.ensure_octant(k);
+    const auto dc = g.div_count();
+    for (auto i = 0u; i < dc*dc; i++)
+        for (auto k = 0u; k < Cover::octant_count; k++)
+            fm_assert(g.distance(i, k) == r.distance(i, k));
+}
+
+void test_cover_filler_drops_stale_results()
+{
+    auto w = world();
+    add_cover_scene(w);
+
+    auto pool = Cover::Pool{{8}};
+    auto filler = Cover::Filler{pool, 2};
+    const chunk_coords_ chunks[] = { COORD };
+    filler.update(w, chunks, Ns{(uint64_t)-1});
+    fm_assert(filler.in_flight() == 1);
+
+    // results are applied on this thread, so the edit always lands first
+    add_wall_north(w[COORD], {3, 3});
+    rebuild_passability(w[COORD]);
+    filler.finish(w);
+    fm_assert(filler.stats().filled == 0);
+    fm_assert(filler.stats().dropped == Cover::octant_count - 1);
+
+    filler.update(w, chunks, Ns{(uint64_t)-1});
+    filler.finish(w);
+    fm_assert(filler.stats().filled == Cover::octant_count - 1);
+    fm_assert(pool[w[COORD]].built_octants() == (uint32_t)-1);
+}
+
+// center of a cover pass grid cell of COORD
+point point_of_cell(Vector2i cell)
+{
+    constexpr auto div = 8, per_tile = tile_size_xy / div;
+    const auto tile = cell / per_tile;
+    const auto offset = (cell - tile * per_tile) * div + Vector2i{div/2 - tile_size_xy/2};
+    return point{COORD, local_coords{tile.x(), tile.y()}, Vector2b(offset)};
+}
+
+void test_fov()
+{
+    constexpr uint32_t radius = 40;
+    constexpr auto r = (int32_t)radius;
+    const auto origin = point{COORD, {8, 12}, {}};
+    const auto behind_wall = Vector2i{0, -40}, before_wall = Vector2i{0, -10};
+
+    auto w = world();
+    for (int16_t j = -1; j <= 1; j++)
+        for (int16_t i = -1; i <= 1; i++)
+        {
+            add_ground_all(w[chunk_coords_{i, j, 0}]);
+            rebuild_passability(w[chunk_coords_{i, j, 0}]);
+        }
+
+    auto cache = Fov::Cache{2};
+    {
+        auto v = cache.compute(w, origin, radius);
+        fm_assert(v.origin() == Fov::cell_of(origin, 8));
+        fm_assert(v.visible(behind_wall));
+        uint32_t n = 0;
+        for (auto dy = -r; dy <= r; dy++)
+            for (auto dx = -r; dx <= r; dx++)
+                n += dx*dx + dy*dy <= r*r;
+        fm_assert(v.visible_count() == n);
+        fm_assert(!v.visible({r+1, 0}));
+        (void)cache.compute(w, origin, radius);
+        fm_assert(cache.stats().hits == 1);
+        fm_assert(cache.stats().misses == 1);
+    }
+
+    auto& c = w[COORD];
+    for (uint8_t k = 2; k <= 14; k++)
+        add_wall_north(c, {k, 8});
+    rebuild_passability(c);
+    {
+        auto v = cache.compute(w, origin, radius);
+        fm_assert(cache.stats().invalidated == 1);
+        fm_assert(!v.visible(behind_wall));
+        fm_assert(v.visible(before_wall));
+    }
+
+    // symmetric between clear cells, including ones across the chunk border
+    {
+        auto& pool = w.cover_pass_pool();
+        auto pass = pool[c];
+        const auto A = Fov::cell_of(origin, 8);
+        for (auto dy = -r; dy <= r; dy += 5)
+            for (auto dx = -r; dx <= r; dx += 5)
+            {
+                const auto B = A + Vector2i{dx, dy};
+                if (dx*dx + dy*dy > r*r || B.x() < 0 || B.y() < 0 || B.x() >= 128 || B.y() >= 128)
+                    continue;
+                if (!pass.bit(Pass::Grid::get_bitmask_index((uint32_t)B.x(), (uint32_t)B.y(), 128)))
+                    continue;
+                const bool ab = cache.compute(w, origin, radius).visible_cell(B);
+                const bool ba = cache.compute(w, point_of_cell(B), radius).visible_cell(A);
+                fm_assert(ab == ba);
+            }
+        fm_assert(cache.size() == 2);
+    }
+
+    for (uint8_t k = 2; k <= 14; k++)
+        c[{k, 8}].wall_north() = {};
+    rebuild_passability(c);
+    fm_assert(cache.compute(w, origin, radius).visible(behind_wall));
+}
+
 } // namespace
 
 void test_grid()
@@ -951,6 +1125,7 @@ void test_grid()
         test_neighbor_west_wall_affects_east_edge(ds);
         test_bit_from_tile_center_passable(ds);
         test_wall_then_clear_ground_allows_collect(ds);
+        test_incremental_collect(ds);
         test_cell_at_wall_is_blocked(ds);
         test_cell_south_of_wall_is_passable(ds);
         test_all_chunk_corners_passable(ds);
@@ -981,6 +1156,10 @@ void test_grid()
     }
     test_pool_destruction_with_live_grids();
     test_chunk_pass_gen_unique_after_collect();
+    test_cover_filler_matches_main_thread(0);
+    test_cover_filler_matches_main_thread(2);
+    test_cover_filler_drops_stale_results();
+    test_fov();
 }
 
 } // namespace floormat::Test
@@ -8,7 +8,13 @@
 #include "src/hole.hpp"
 #include "src/hole-cut.hpp"
 #include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/chunk-mesh-builder.hpp"
+#include "src/scenery.hpp"
+#include "src/scenery-proto.hpp"
 #include "loader/loader.hpp"
+#include <cstring>
+#include <cr/GrowableArray.h>
 
 namespace floormat {
 namespace {
@@ -143,6 +149,76 @@ void test_degenerate()
     }
 }
 
+void fill_mesh_world(world& w)
+{
+    const auto W = wall_image_proto{ loader.wall_atlas("test1"), 0 };
+    const auto& table = loader.scenery("table0");
+    for (int16_t y = 0; y < 3; y++)
+        for (int16_t x = 0; x < 3; x++)
+        {
+            const auto ch = chunk_coords_{x, y, 0};
+            auto& c = w[ch];
+            for (auto k = 0u; k < TILE_COUNT; k += 3)
+            {
+                c[k].wall_north() = W;
+                if (k % 2)
+                    c[k].wall_west() = W;
+            }
+            auto h = w.make_object<hole>(w.make_id(), global_coords{ch, {8, 8}}, hole_proto{});
+            h->set_bbox({}, {}, {128, 48}, pass_mode::pass);
+            (void)w.make_scenery(w.make_id(), {ch, {3, 4}}, scenery_proto(table));
+            c.ensure_passability();
+        }
+}
+
+void assert_meshes_equal(const SpriteList& a, const SpriteList& b)
+{
+    const auto size = a.size();
+    fm_assert(size == b.size());
+    fm_assert(!std::memcmp(a.Vertexes.data(), b.Vertexes.data(), size * sizeof(Quads::vertexes)));
+    fm_assert(!std::memcmp(a.Depths.data(), b.Depths.data(), size * sizeof(float)));
+    for (auto i = 0u; i < size; i++)
+        fm_assert(!a.Objects[i] == !b.Objects[i] && (!a.Objects[i] || a.Objects[i]->id == b.Objects[i]->id));
+}
+
+// walls cut by holes come out the same whether built on one thread or several
+void test_parallel_meshes()
+{
+    auto w1 = world(), w2 = world();
+    fill_mesh_world(w1);
+    fill_mesh_world(w2);
+    Array<chunk_coords_> coords;
+    for (int16_t y = 0; y < 3; y++)
+        for (int16_t x = 0; x < 3; x++)
+            arrayAppend(coords, chunk_coords_{x, y, 0});
+
+    chunk_mesh_builder serial{0}, parallel{3};
+    serial.build(w1, coords);
+    parallel.build(w2, coords);
+    fm_assert(serial.stats().built == 9 && parallel.stats().built == 9);
+
+    for (auto ch : coords)
+    {
+        const auto& a = *w1.at(ch);
+        const auto& b = *w2.at(ch);
+        fm_assert(!a.needs_mesh_build() && !b.needs_mesh_build());
+        fm_assert(a.wall_static_mesh.size() > 0 && a.scenery_static_mesh.size() > 0);
+        assert_meshes_equal(a.ground_static_mesh, b.ground_static_mesh);
+        assert_meshes_equal(a.wall_static_mesh, b.wall_static_mesh);
+        assert_meshes_equal(a.scenery_static_mesh, b.scenery_static_mesh);
+    }
+
+    parallel.build(w2, coords);
+    fm_assert(parallel.stats().built == 0);
+    auto& c = w2[{1, 1, 0}];
+    c[{0, 0}].wall_west() = wall_image_proto{ loader.wall_atlas("test1"), 0 };
+    c.mark_walls_modified();
+    c.mark_passability_modified();
+    parallel.build(w2, coords);
+    fm_assert(parallel.stats().built == 1);
+    fm_assert(!c.is_passability_modified());
+}
+
 } // namespace
 } // namespace floormat
 
@@ -227,6 +303,7 @@ void Test::test_hole()
     test2();
     test3();
     test_degenerate();
+    test_parallel_meshes();
 
     using namespace Run;
 
@@ -0,0 +1,143 @@
+#include "app.hpp"
+#include "src/light-index.hpp"
+#include "src/light.hpp"
+#include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/tile-constants.hpp"
+#include "src/tile-image.hpp"
+#include "loader/loader.hpp"
+#include <cr/GrowableArray.h>
+
+namespace floormat::Test {
+
+namespace {
+
+constexpr auto chunk_size = TILE_SIZE2 * TILE_MAX_DIM;
+
+struct xorshift
+{
+    uint32_t state;
+    uint32_t operator()(uint32_t max)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % max;
+    }
+};
+
+float distance_sq(const occluder_segment& s, Vector2 p)
+{
+    const auto ab = s.b - s.a;
+    const auto t = Math::clamp(Math::dot(p - s.a, ab) / ab.dot(), 0.f, 1.f);
+    return (s.a + ab * t - p).dot();
+}
+
+bool contains(ArrayView<const occluder_segment> array, const occluder_segment& s)
+{
+    for (const auto& x : array)
+        if (x.a == s.a && x.b == s.b)
+            return true;
+    return false;
+}
+
+void test_range()
+{
+    constexpr auto tile = (float)tile_size_xy;
+    fm_assert_equal(3 * tile, light_range({.dist = 3, .falloff = light_falloff::linear}));
+    fm_assert_equal(3 * tile, light_range({.dist = 3, .falloff = light_falloff::quadratic}));
+    fm_assert_equal(TILE_MAX_DIM * tile, light_range({.dist = 3, .falloff = light_falloff::constant}));
+    fm_assert_equal(0.f, light_range({.dist = -1, .falloff = light_falloff::linear}));
+}
+
+void test_selection()
+{
+    auto rng = xorshift{0x9e3779b9};
+    auto w = world();
+    const auto wall = wall_image_proto{loader.wall_atlas("test1"), 0};
+    const auto pillar = tile_image_proto{loader.ground_atlas("texel"), 0};
+
+    auto index = light_index{};
+    for (int16_t cy = -1; cy <= 0; cy++)
+        for (int16_t cx = -1; cx <= 0; cx++)
+        {
+            const auto ch = chunk_coords_{cx, cy, 0};
+            auto& c = w[ch];
+            for (auto i = 0u; i < 40; i++)
+            {
+                auto t = c[{(uint8_t)rng(TILE_MAX_DIM), (uint8_t)rng(TILE_MAX_DIM)}];
+                switch (rng(3))
+                {
+                case 0: t.wall_north() = wall; break;
+                case 1: t.wall_west() = wall; break;
+                default: t.ground() = pillar; break;
+                }
+            }
+            c.mark_modified();
+            for (auto i = 0u; i < 30; i++)
+            {
+                auto proto = light_proto{};
+                proto.max_distance = 1 + (float)rng(4);
+                (void)w.make_object<light>(w.make_id(), {ch, {(uint8_t)rng(TILE_MAX_DIM), (uint8_t)rng(TILE_MAX_DIM)}}, proto);
+            }
+            // disabled by distance
+            auto proto = light_proto{};
+            proto.max_distance = 0;
+            (void)w.make_object<light>(w.make_id(), {ch, {0, 0}}, proto);
+
+            index.add_chunk(Vector2(cx, cy), c);
+        }
+
+    // a light far outside the view, and one with a huge range
+    index.add_light({.center = Vector2{20000}, .dist = 1, .falloff = light_falloff::linear});
+    index.add_light({.center = Vector2{-20000}, .dist = 1000, .falloff = light_falloff::linear});
+
+    // everything the chunks had, gathered brute force
+    Array<occluder_segment> all;
+    for (int16_t cy = -1; cy <= 0; cy++)
+        for (int16_t cx = -1; cx <= 0; cx++)
+        {
+            const auto off = Vector2(cx, cy) * chunk_size;
+            for (const auto& s : w[chunk_coords_{cx, cy, 0}].static_occluders())
+                arrayAppend(all, occluder_segment{s.a + off, s.b + off});
+        }
+
+    const auto view = Math::Range2D<float>{-chunk_size, chunk_size};
+    index.build(view);
+    const auto& st = index.stats();
+    fm_assert_equal(4u * 30 + 2, st.lights);
+    fm_assert_equal(4u * 30 + 1, st.visible_lights);
+    fm_assert_equal((uint32_t)all.size(), st.segments);
+    fm_assert(st.selected < st.visible_lights * st.segments);
+
+    const auto segments = index.segments();
+    for (const auto& L : index.lights())
+    {
+        const auto range = light_range(L.light);
+        const auto mine = segments.sliceSize(L.first, L.count);
+        uint32_t expected = 0;
+        for (const auto& s : all)
+            if (distance_sq(s, L.light.center) <= range * range)
+            {
+                expected++;
+                fm_assert(contains(mine, s));
+            }
+        fm_assert_equal(expected, L.count);
+    }
+    fm_assert_equal(st.segments, index.lights().back().count);
+
+    index.clear();
+    index.build(view);
+    fm_assert(index.lights().isEmpty());
+    fm_assert(index.segments().isEmpty());
+}
+
+} // namespace
+
+void test_light_index()
+{
+    test_range();
+    test_selection();
+}
+
+} // namespace floormat::Test
@@ -0,0 +1,107 @@
+#include "app.hpp"
+#include "src/light-occluders.hpp"
+#include "src/world.hpp"
+#include "src/chunk.hpp"
+#include "src/tile-constants.hpp"
+#include "src/tile-image.hpp"
+#include "loader/loader.hpp"
+#include <cr/GrowableArray.h>
+
+namespace floormat::Test {
+
+namespace {
+
+constexpr float edge(int i) { return (float)(i * tile_size_xy - tile_size_xy/2); }
+
+Array<occluder_segment> static_occluders(const chunk& c)
+{
+    Array<occluder_segment> ret;
+    make_static_occluders(c, ret);
+    return ret;
+}
+
+bool has_segment(ArrayView<const occluder_segment> array, Vector2 a, Vector2 b)
+{
+    for (const auto& s : array)
+        if (s.a == a && s.b == b)
+            return true;
+    return false;
+}
+
+void test_ground()
+{
+    auto w = world();
+    auto& c = w[chunk_coords_{}];
+    const auto blocked = tile_image_proto{loader.ground_atlas("texel"), 0};
+    fm_assert(static_occluders(c).isEmpty());
+
+    // a 2x3 block and a lone tile, 7 tiles for 8 segments
+    for (uint8_t y = 4; y < 7; y++)
+        for (uint8_t x = 2; x < 4; x++)
+            c[{x, y}].ground() = blocked;
+    c[{10, 10}].ground() = blocked;
+    c.mark_ground_modified();
+    {
+        const auto s = static_occluders(c);
+        fm_assert_equal(8uz, s.size());
+        fm_assert(has_segment(s, {edge(2), edge(7)}, {edge(4), edge(7)})); // north
+        fm_assert(has_segment(s, {edge(4), edge(7)}, {edge(4), edge(4)})); // east
+        fm_assert(has_segment(s, {edge(4), edge(4)}, {edge(2), edge(4)})); // south
+        fm_assert(has_segment(s, {edge(2), edge(4)}, {edge(2), edge(7)})); // west
+    }
+
+    // an L has six sides
+    auto w2 = world();
+    auto& c2 = w2[chunk_coords_{}];
+    c2[{0, 0}].ground() = blocked;
+    c2[{1, 0}].ground() = blocked;
+    c2[{0, 1}].ground() = blocked;
+    fm_assert_equal(6uz, static_occluders(c2).size());
+}
+
+void test_walls()
+{
+    auto w = world();
+    auto& c = w[chunk_coords_{}];
+    const auto wall = wall_image_proto{loader.wall_atlas("test1"), 0};
+
+    for (uint8_t x = 0; x < 5; x++)
+        c[{x, 8}].wall_north() = wall;
+    for (uint8_t y = 0; y < TILE_MAX_DIM; y++)
+        c[{10, y}].wall_west() = wall;
+    c.mark_walls_modified();
+    const auto s = static_occluders(c);
+    fm_assert_equal(8uz, s.size());
+    fm_assert(has_segment(s, {edge(0), edge(8)}, {edge(5), edge(8)}));
+    fm_assert(has_segment(s, {edge(10), edge(16)}, {edge(10), edge(0)}));
+}
+
+void test_cache()
+{
+    auto w = world();
+    auto& c = w[chunk_coords_{}];
+    c.ensure_passability();
+    fm_assert(c.static_occluders().isEmpty());
+
+    c[{3, 3}].ground() = tile_image_proto{loader.ground_atlas("texel"), 0};
+    c.mark_ground_modified();
+    fm_assert_equal(4uz, c.static_occluders().size());
+    c.ensure_passability();
+    fm_assert_equal(4uz, c.static_occluders().size());
+
+    c[{3, 3}].ground() = tile_image_proto{loader.ground_atlas("tiles"), 0};
+    c.mark_ground_modified();
+    c.ensure_passability();
+    fm_assert(c.static_occluders().isEmpty());
+}
+
+} // namespace
+
+void test_light_occluders()
+{
+    test_ground();
+    test_walls();
+    test_cache();
+}
+
+} // namespace floormat::Test
@@ -9,6 +9,11 @@
 #include "loader/ground-cell.hpp"
 #include "loader/wall-cell.hpp"
 #include "loader/anim-cell.hpp"
+#include "loader/scenery-cell.hpp"
+#include "src/sprite-atlas.hpp"
+#include "src/sprite-atlas-impl.hpp"
+#include <cstring>
+#include <cr/GrowableArray.h>
 
 namespace floormat {
 
@@ -45,6 +50,37 @@ constexpr const char* sceneries[] = {
     "table0",
 };
 
+// where every atlas the editor loads ended up, and the scenery bitmasks
+Array<char> preload_snapshot()
+{
+    Array<char> ret;
+    const auto add = [&](const SpriteAtlas::Sprite* s) {
+        fm_assert(s);
+        arrayAppend(ret, ArrayView<const char>{(const char*)s, sizeof *s});
+    };
+    for (const auto& x : loader.ground_atlas_list())
+        if (x.name != loader.INVALID)
+            for (const auto& s : x.atlas->raw_sprite_array())
+                add(s.raw());
+    for (const auto& x : loader.wall_atlas_list())
+        if (x.name != loader.INVALID)
+            for (const auto& s : x.atlas->raw_sprite_array())
+                add(s.raw());
+    for (const auto& x : loader.scenery_list())
+    {
+        if (x.name == loader.INVALID)
+            continue;
+        fm_assert(x.proto);
+        const auto& atlas = *x.proto->atlas;
+        for (const auto& g : atlas.info().groups)
+            for (const auto* s : g.sprites)
+                add(s);
+        const auto bitmask = atlas.bitmask();
+        arrayAppend(ret, ArrayView<const char>{(const char*)bitmask.data(), (bitmask.size() + 7) / 8});
+    }
+    return ret;
+}
+
 } // namespace
 
 void Test::test_loader()
@@ -137,4 +173,25 @@ void Test::test_loader3()
     // todo scenery_cell
 }
 
+void Test::test_loader4()
+{
+    loader.destroy();
+    loader.preload_atlases(0);
+    const auto serial = preload_snapshot();
+    const auto layers = loader.atlas().used_layers();
+    fm_assert(!serial.isEmpty());
+
+    // same packing no matter which thread decoded what
+    for (auto thread_count : { 1u, 3u })
+    {
+        loader.destroy();
+        loader.preload_atlases(thread_count);
+        const auto parallel = preload_snapshot();
+        fm_assert_equal(serial.size(), parallel.size());
+        fm_assert(std::memcmp(serial.data(), parallel.data(), serial.size()) == 0);
+        fm_assert_equal(layers, loader.atlas().used_layers());
+    }
+    loader.destroy();
+}
+
 } // namespace floormat
@@ -6,7 +6,9 @@
 #include "src/world.hpp"
 #include "src/scenery-proto.hpp"
 #include "src/search-constants.hpp"
+#include "src/search-cache.hpp"
 #include "src/search.hpp"
+#include "src/point.hpp"
 #include <mg/Functions.h>
 #include <mg/Range.h>
 
@@ -341,11 +343,45 @@ void test_bbox()
 #endif
 }
 
+void test_cache_generation()
+{
+    constexpr auto max_dist = (uint32_t)(TILE_MAX_DIM * iTILE_SIZE2).length();
+    constexpr auto a = point{{0, 0, 0}, {3, 4}, {}};
+    constexpr auto b = point{{1, -1, 0}, {5, 6}, {}};
+
+    auto c = Search::cache{(uint32_t)div_size.x()};
+    c.allocate(a, max_dist);
+    const auto a_ch = c.get_chunk_index(Vector2i(a.chunk())), a_t = c.get_tile_index(a.local(), a.offset());
+    const auto b_ch = c.get_chunk_index(Vector2i(b.chunk())), b_t = c.get_tile_index(b.local(), b.offset());
+    fm_assert(c.lookup_index(a_ch, a_t) == (uint32_t)-1);
+    c.add_index(a, 1);
+    c.add_index(b, 2);
+    fm_assert(c.lookup_index(a_ch, a_t) == 1);
+    fm_assert(c.lookup_index(b_ch, b_t) == 2);
+
+    // the next query must not see the previous one's slots
+    c.allocate(a, max_dist);
+    fm_assert(c.lookup_index(a_ch, a_t) == (uint32_t)-1);
+    fm_assert(c.lookup_index(b_ch, b_t) == (uint32_t)-1);
+    c.add_index(a, 3);
+    fm_assert(c.lookup_index(a_ch, a_t) == 3);
+
+    // wrap-around wipes the stamps instead of reusing generation 0
+    c.generation = (uint32_t)-1;
+    c.add_index(b, 4);
+    fm_assert(c.lookup_index(b_ch, b_t) == 4);
+    c.allocate(a, max_dist);
+    fm_assert(c.generation == 1);
+    fm_assert(c.lookup_index(a_ch, a_t) == (uint32_t)-1);
+    fm_assert(c.lookup_index(b_ch, b_t) == (uint32_t)-1);
+}
+
 } // namespace
 
 void Test::test_astar()
 {
     test_bbox();
+    test_cache_generation();
 }
 
 } // namespace floormat
@@ -2,10 +2,20 @@
 #include "compat/borrowed-ptr.inl"
 #include "src/tile-constants.hpp"
 #include "src/raycast-diag.hpp"
+#include "src/raycast-los.hpp"
+#include "src/grid-cover.hpp"
+#include "src/grid-pass.hpp"
+#include "src/scenery.hpp"
+#include "src/scenery-proto.hpp"
+#include "src/hole.hpp"
+#include "src/anim-atlas.hpp"
+#include "src/nanosecond.inl"
+#include "src/point.inl"
 #include "src/world.hpp"
 #include "src/critter.hpp"
 #include "loader/loader.hpp"
 #include "loader/wall-cell.hpp"
+#include <cr/GrowableArray.h>
 #include <mg/Functions.h>
 
 namespace floormat {
@@ -93,11 +103,154 @@ auto run(point from, point to, world& w, bool b, float len)
     return true;
 }
 
+void test_raycast_many(world& w)
+{
+    constexpr point origins[] = {
+        {{ 0, 0, 0}, {11, 12}, {  1, -32}},
+        {{ 0, 1, 0}, { 8,  8}, {  0,   0}},
+        {{ 1, 2, 0}, { 0, 15}, {-17,  9}},
+        {{-5,-5, 0}, { 4,  1}, {  0,  0}},
+    };
+
+    Array<rc::ray> rays;
+    for (auto from : origins)
+    {
+        arrayAppend(rays, rc::ray{from, from, 0});
+        for (int k = 0; k < 48; k++)
+        {
+            const auto angle = Rad{(float)k * 2 * Math::Constants<float>::pi() / 48};
+            const auto len = (float)(1 + k % 7) * 3 * TILE_SIZE2.x();
+            const auto off = Vector2i(Vector2{Math::cos(angle), Math::sin(angle)} * len);
+            arrayAppend(rays, rc::ray{from, point::normalize_coords(from, off), 0});
+        }
+    }
+
+    auto results = Array<rc::raycast_result_s>{ValueInit, rays.size()};
+    raycast_many(w, rays, results);
+
+    uint32_t hits = 0;
+    for (auto i = 0uz; i < rays.size(); i++)
+    {
+        const auto& r = rays[i];
+        const auto a = raycast(w, r.from, r.to, r.self);
+        const auto& b = results[i];
+        fm_assert(b.has_result);
+        fm_assert(a.success == b.success);
+        fm_assert(a.collision == b.collision);
+        fm_assert(a.collider.id == b.collider.id);
+        fm_assert(a.collider.type == b.collider.type);
+        hits += !b.success;
+    }
+    fm_assert(hits > 0);
+    fm_assert(hits < rays.size());
+
+    // the AVX2 lane step against the scalar one, where the CPU has it
+    auto& pool = w.raycast_pass_pool();
+    const auto& pred = Search::never_continue();
+    auto scalar = Array<rc::raycast_result_s>{ValueInit, rays.size()};
+    raycast_many(w, rays, scalar, pool, pred, rc::lane_kernel::scalar);
+    for (auto kernel : { rc::lane_kernel::scalar, rc::lane_kernel::avx2, })
+    {
+        if (!rc::has_lane_kernel(kernel))
+            continue;
+        auto res = Array<rc::raycast_result_s>{ValueInit, rays.size()};
+        raycast_many(w, rays, res, pool, pred, kernel);
+        for (auto i = 0uz; i < rays.size(); i++)
+        {
+            const auto &a = scalar[i], &b = res[i];
+            fm_assert(a.has_result && b.has_result);
+            fm_assert(a.success == b.success);
+            fm_assert(a.to == b.to && a.collision == b.collision);
+            fm_assert(a.collider == b.collider);
+        }
+    }
+}
+
+// after every kind of edit the cache must agree with a fresh raycast
+void test_los_cache()
+{
+    constexpr auto ch = chunk_coords_{0, 0, 0}, ch2 = chunk_coords_{1, 0, 0};
+    constexpr auto off = Vector2b{4, 4}; // cell centers, so snapping moves nothing
+    const point pairs[][2] = {
+        { {ch, { 2,  8}, off}, {ch,  {12, 8}, off} },
+        { {ch, { 8,  2}, off}, {ch,  { 8, 12}, off} },
+        { {ch, { 3,  3}, off}, {ch2, { 2, 9}, off} },
+        { {ch, {12, 12}, off}, {ch,  { 4, 5}, off} },
+    };
+
+    auto w = world{};
+    auto& c = w[ch];
+    auto& c2 = w[ch2];
+    auto& pool = w.cover_pass_pool();
+    const auto& pred = Cover::shoot_through_pred();
+    const auto wall = wall_image_proto{loader.wall_atlas("empty", loader_policy::warn), 0};
+    auto cache = rc::los_cache{64};
+
+    auto check = [&] {
+        for (const auto& [a, b] : pairs)
+            for (int i = 0; i < 2; i++)
+                fm_assert(cache.can_see(w, a, b, 1, pool, pred) == raycast(w, a, b, 0, pool, pred).success);
+    };
+
+    check();
+    fm_assert(cache.stats().hits == 4);
+    fm_assert(cache.stats().misses == 4);
+    fm_assert(cache.size() == 4);
+
+    // wall
+    c[{7, 8}].wall_west() = wall;
+    c.mark_passability_modified();
+    fm_assert(!cache.can_see(w, pairs[0][0], pairs[0][1], 1, pool, pred));
+    fm_assert(cache.stats().stale == 1);
+    check();
+    c[{7, 8}].wall_west() = wall_image_proto{};
+    c.mark_passability_modified();
+    fm_assert(cache.can_see(w, pairs[0][0], pairs[0][1], 1, pool, pred));
+    check();
+
+    // wall in a neighboring chunk
+    c2[{1, 9}].wall_west() = wall;
+    c2.mark_passability_modified();
+    check();
+
+    // door, closed and then opened
+    {
+        auto eʹ = w.make_scenery(w.make_id(), {ch, {8, 7}}, scenery_proto(loader.scenery("door1")));
+        fm_assert(eʹ->scenery_type() == scenery_type::door);
+        check();
+        auto& e = static_cast<door_scenery&>(*eʹ);
+        e.activate(e.index());
+        for (int i = 0; i < 60*3; i++)
+            { auto index = e.index(); e.update(eʹ, index, Second / 60); }
+        fm_assert(e.frame == 0);
+        check();
+    }
+
+    // hole
+    (void)w.make_object<hole>(w.make_id(), {ch, {3, 4}}, hole_proto{});
+    check();
+
+    // another predicate id is another entry
+    const auto misses = cache.stats().misses;
+    (void)cache.can_see(w, pairs[0][0], pairs[0][1], 2, pool, pred);
+    fm_assert(cache.stats().misses == misses + 1);
+
+    {
+        auto small = rc::los_cache{2};
+        for (const auto& [a, b] : pairs)
+            fm_assert(small.can_see(w, a, b, 1, pool, pred) == raycast(w, a, b, 0, pool, pred).success);
+        fm_assert(small.size() == 2);
+        fm_assert(small.stats().evicted == 2);
+    }
+}
+
 } // namespace
 
 void Test::test_raycast()
 {
     auto w = make_world();
+    test_raycast_many(w);
+    test_los_cache();
     { constexpr auto from = point{{0, 0, 0}, {11,12}, {1,-32}};
       fm_assert(run(from, point{{  1,   3, 0}, { 0,  1}, {-21,  23}}, w, false,  2288));
       fm_assert(run(from, point{{  1,   3, 0}, { 8, 10}, {- 9, -13}}, w, true,   3075));
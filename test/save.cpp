@@ -8,11 +8,20 @@
 #include "src/hole.hpp"
 #include "src/ground-atlas.hpp"
 #include "src/anim-atlas.hpp"
+#include "src/chunk-store.hpp"
+#include "src/chunk-stream.hpp"
+#include "src/chunk-prefetch.hpp"
+#include "src/grid-pass.hpp"
+#include "src/search-pred.hpp"
+#include "src/point.hpp"
 #include "src/nanosecond.inl"
 #include "loader/loader.hpp"
 #include "loader/scenery-cell.hpp"
 #include "compat/borrowed-ptr.inl"
+#include "compat/exception.hpp"
+#include <utility>
 #include <cr/Path.h>
+#include <cr/Pointer.h>
 #include <mg/Color.h>
 
 namespace floormat {
@@ -307,12 +316,184 @@ void test_save_objs()
 #endif
 }
 
+chunk& make_pageable_chunk(world& w, chunk_coords_ ch)
+{
+    auto& c = w[ch];
+    auto tiles = loader.ground_atlas("tiles");
+    auto wall = loader.wall_atlas("empty", loader_policy::warn);
+    for (auto k = 0u; k < TILE_COUNT; k++)
+        c[k].ground() = { tiles, variant_t(k % tiles->num_tiles()) };
+    c[{2, 3}].wall_north() = { wall, 0 };
+    w.make_scenery(w.make_id(), {ch, {3, 4}}, scenery_proto(loader.scenery("table1")));
+    w.make_object<light>(w.make_id(), {ch, {4, 1}}, light_proto{});
+    critter_proto cproto;
+    cproto.name = "NPC"_s;
+    auto C = w.make_object<critter>(w.make_id(), global_coords{ch, {5, 6}}, cproto);
+    C->sleep();
+    return c;
+}
+
+void test_page_out()
+{
+    constexpr auto ch = chunk_coords_{2, -3, 0};
+    auto w = world(), ref = world();
+    auto& c = make_pageable_chunk(w, ch);
+    (void)make_pageable_chunk(ref, ch);
+    const auto id = c.objects().back()->id;
+
+    auto nb = w.raycast_pass_pool()[w[ch + Vector2b{1, 0}]];
+    nb.build_if_stale(Search::never_continue());
+    const auto nb_build_no = nb.build_no();
+
+    {   // held from outside the world
+        auto e = w.find_object(id);
+        fm_assert(!w.page_out(c));
+    }
+    fm_assert(w.page_out(c));
+    fm_assert(w.is_paged_out(ch));
+    fm_assert(w.contains(ch));
+    fm_assert(!w.resident_at(ch));
+    fm_assert(!w.find_object(id));
+    fm_assert(w.chunk_store().size() == 1);
+
+    // neither a const lookup nor the neighbor's staleness check pages it in
+    fm_assert(!std::as_const(w).at(ch));
+    w.raycast_pass_pool().maybe_mark_stale_all(w.frame_no());
+    fm_assert(w.is_paged_out(ch));
+    nb.build_if_stale(Search::never_continue());
+    fm_assert(nb.build_no() != nb_build_no);
+    fm_assert(w.chunk_store().stats().faults == 0);
+
+    auto* c2 = w.at(ch);
+    fm_assert(c2 && !w.is_paged_out(ch));
+    fm_assert(w.find_object(id));
+    fm_assert(w.chunk_store().size() == 0);
+    fm_assert(w.chunk_store().stats().faults == 1);
+    assert_chunks_equal(ref.at(ch), c2);
+
+    // saving pages everything in
+    w.find_object(id)->sleep();
+    fm_assert(w.page_out(*c2));
+    auto w2 = reload_from_save(Path::join(loader.TEMP_PATH, "test/test-save-paged.dat"_s), w);
+    fm_assert(!w.is_paged_out(ch));
+    assert_chunks_equal(ref.at(ch), w2.at(ch));
+
+    // records written to disk
+    const auto dir = Path::join(loader.TEMP_PATH, "test/chunk-store"_s);
+    w2.set_chunk_store(Pointer<chunk_store>{InPlaceInit, dir});
+    w2.find_object(id)->sleep();
+    fm_assert(w2.page_out(*w2.at(ch)));
+    fm_assert(w2.chunk_store().bytes() > 0);
+    assert_chunks_equal(ref.at(ch), w2.at(ch));
+    fm_assert(w2.chunk_store().size() == 0);
+
+    // the record can't be written, so the chunk stays where it is
+    fm_assert(Path::remove(dir));
+    w2.find_object(id)->sleep();
+    bool caught = false;
+    try { (void)w2.page_out(*w2.at(ch)); }
+    catch (const floormat::exception&) { caught = true; }
+    fm_assert(caught);
+    fm_assert(!w2.is_paged_out(ch) && w2.find_object(id));
+    fm_assert(w2.chunk_store().size() == 0);
+    assert_chunks_equal(ref.at(ch), w2.at(ch));
+}
+
+void test_chunk_streamer()
+{
+    auto w = world();
+    for (int16_t x = 0; x < 10; x++)
+        (void)make_pageable_chunk(w, {x, 0, 0});
+
+    chunk_streamer s{{ .radius = 0, .max_resident = 4, .max_page_ins = 32, .max_page_outs = 32, }};
+    const chunk_coords_ first[] = {{0, 0, 0}}, last[] = {{9, 0, 0}};
+    s.update(w, first);
+    s.update(w, first);
+    fm_assert(w.size() == 4);
+    fm_assert(s.stats().paged_out == 6 && s.stats().page_outs == 6);
+    fm_assert(w.resident_at({0, 0, 0}));
+    fm_assert(s.stats().resident_bytes > 0);
+
+    s.update(w, last);
+    fm_assert(w.resident_at({9, 0, 0}));
+    fm_assert(w.resident_at({0, 0, 0}) || w.is_paged_out({0, 0, 0}));
+    fm_assert(w.size() + w.chunk_store().size() == 10);
+}
+
+void test_chunk_prefetcher()
+{
+    auto w = world();
+    w.set_chunk_store(Pointer<chunk_store>{InPlaceInit, Path::join(loader.TEMP_PATH, "test/chunk-prefetch"_s)});
+    for (int16_t x = 0; x < 8; x++)
+        (void)make_pageable_chunk(w, {x, 0, 0});
+    for (int16_t x = 1; x < 8; x++)
+        fm_assert(w.page_out(*w.resident_at({x, 0, 0})));
+
+    chunk_prefetcher p{{ .lookahead = 4*Second, .max_distance = 4, .radius = 0, .max_in_flight = 4, .max_page_ins = 2, }, 1};
+    const auto& st = p.stats();
+    // the camera in the middle of chunk x, looking at that chunk alone
+    const auto update = [&](int16_t x, Ns dt) {
+        const chunk_coords_ visible[] = {{x, 0, 0}};
+        const point tracked[] = {{{x, 0, 0}, {7, 7}, {}}};
+        p.update(w, visible, tracked, dt);
+    };
+
+    update(0, Ns{});
+    fm_assert(st.requested == 0 && st.misses == 0);
+
+    // scrolled into a paged-out chunk, the ones ahead get read in the background
+    update(1, Second);
+    fm_assert(st.misses == 1 && st.paged_in == 1);
+    fm_assert(!w.is_paged_out({1, 0, 0}));
+    fm_assert(st.requested == 2);
+    p.finish(w);
+    fm_assert(st.ready == 2 && st.in_flight == 0);
+
+    update(1, Ns{});
+    fm_assert(st.paged_in == 3 && st.ready == 0);
+    fm_assert(w.resident_at({2, 0, 0}) && w.resident_at({3, 0, 0}));
+
+    update(2, Second);
+    fm_assert(st.hits == 1 && st.misses == 1);
+    p.finish(w);
+    fm_assert(st.ready == 2);
+
+    // turned around before they were needed
+    update(0, Second);
+    fm_assert(st.wasted == 2 && st.ready == 0);
+    fm_assert(w.is_paged_out({4, 0, 0}) && w.is_paged_out({5, 0, 0}));
+    fm_assert(w.at({4, 0, 0}));
+    update(0, Ns{});
+    fm_assert(st.misses == 2);
+
+    // faulted in, edited and paged out again while the read was in flight
+    {
+        chunk_prefetcher p2{{ .radius = 1, .max_in_flight = 4, .max_page_ins = 0, }, 1};
+        const chunk_coords_ visible[] = {{4, 0, 0}};
+        const point tracked[] = {{{4, 0, 0}, {7, 7}, {}}};
+        p2.update(w, visible, tracked, Ns{});
+        fm_assert(p2.stats().in_flight == 1);
+        auto& c = *w.at({5, 0, 0});
+        c[{1, 1}].wall_north() = { loader.wall_atlas("empty", loader_policy::warn), 0 };
+        fm_assert(w.page_out(c));
+        p2.finish(w);
+        fm_assert(p2.stats().ready == 0);
+        p2.update(w, visible, tracked, Ns{});
+        p2.finish(w);
+        fm_assert(p2.stats().ready == 1);
+        fm_assert((*w.at({5, 0, 0}))[{1, 1}].wall_north_atlas());
+    }
+}
+
 } // namespace
 
 void Test::test_save()
 {
     fm_assert(Path::exists(Path::join(loader.TEMP_PATH, "CMakeCache.txt")));
     test_save_1();
+    test_page_out();
+    test_chunk_streamer();
+    test_chunk_prefetcher();
 }
 
 void Test::test_saves()
@@ -2,6 +2,11 @@
 #include "src/sprite-atlas.hpp"
 #include "src/sprite-atlas-impl.hpp"
 #include "src/sprite-constants.hpp"
+#include "src/sprite-atlas-cache.hpp"
+#include "loader/loader.hpp"
+#include <cstring>
+#include <cr/Optional.h>
+#include <cr/Path.h>
 #include <algorithm>
 #include <mg/Functions.h>
 #include <mg/Range.h>
@@ -232,6 +237,145 @@ void max_dimension_sprite_stores_without_truncation()
     fm_assert((uint32_t)s->height + 1 == max_texture_xy);
 }
 
+void skyline_sprites_do_not_overlap()
+{
+    Atlas a;
+    a.layer_size = 256;
+    a.packer = sprite_atlas_packer::skyline;
+    constexpr uint32_t N = 200;
+    struct R { uint32_t x, y, layer, w, h; };
+    R rects[N];
+    bool any_rotated = false;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        const uint32_t w = 1 + (i * 37) % 120;
+        const uint32_t h = 1 + (i * 53) % 90;
+        const Sprite* s = alloc_sprite(a, w, h);
+        fm_assert((uint32_t)s->width + 1 == w && (uint32_t)s->height + 1 == h);
+        any_rotated = any_rotated || s->is_rotated;
+        const auto sw = s->is_rotated ? h : w, sh = s->is_rotated ? w : h;
+        fm_assert(s->x + sw <= a.layer_size && s->y + sh <= a.layer_size);
+        rects[i] = R{ (uint32_t)s->x, (uint32_t)s->y, (uint32_t)s->layer, sw, sh };
+    }
+    fm_assert(any_rotated);
+
+    for (uint32_t i = 0; i < N; i++)
+        for (uint32_t j = i + 1; j < N; j++)
+        {
+            const auto& A = rects[i];
+            const auto& B = rects[j];
+            if (A.layer != B.layer)
+                continue;
+            const bool overlap = A.x < B.x + B.w && B.x < A.x + A.w
+                              && A.y < B.y + B.h && B.y < A.y + A.h;
+            fm_assert(!overlap);
+        }
+
+    // the skyline stays a gapless run of nodes across the layer
+    for (const Layer& L : a.layers)
+    {
+        uint32_t x = 0;
+        for (const auto& n : L.skyline)
+        {
+            fm_assert(n.x == x && n.width > 0 && n.y <= a.layer_size);
+            x += n.width;
+        }
+        fm_assert(x == a.layer_size);
+    }
+}
+
+void stats_add_up()
+{
+    for (auto packer : { sprite_atlas_packer::shelf, sprite_atlas_packer::skyline })
+    {
+        Atlas a;
+        a.layer_size = 256;
+        a.packer = packer;
+        auto st = atlas_stats(a);
+        fm_assert(st.sprites == 0 && st.layers == 0 && st.layer_bytes == 0);
+        fm_assert(st.occupancy() == 0 && st.fragmentation() == 0);
+
+        constexpr uint32_t N = 100;
+        uint64_t used = 0;
+        for (uint32_t i = 0; i < N; i++)
+        {
+            const uint32_t w = 3 + (i * 29) % 70, h = 2 + (i * 13) % 50;
+            alloc_sprite(a, w, h);
+            used += w * h * 4;
+        }
+        st = atlas_stats(a);
+        fm_assert(st.sprites == N);
+        fm_assert(st.used_bytes == used);
+        fm_assert(st.layers == a.layers.size() && st.allocated_layers == a.n_layers);
+        fm_assert(st.layer_bytes == st.layers * 256u * 256u * 4u);
+        fm_assert(st.used_bytes + st.free_bytes <= st.layer_bytes);
+        fm_assert(st.layer_bytes <= st.allocated_bytes);
+        fm_assert(st.occupancy() > 0 && st.occupancy() <= 1);
+        fm_assert(st.fragmentation() >= 0 && st.fragmentation() < 1);
+    }
+}
+
+void baked_cache_roundtrip()
+{
+    const auto path = Path::join(loader.TEMP_PATH, "test/test-sprite-atlas.cache"_s);
+    constexpr uint32_t w = 12, h = 5;
+    unsigned char src[w * h * 4];
+    fill_pattern(src, w, h);
+    const Magnum::ImageView2D view{Magnum::PixelFormat::RGBA8Unorm, {(Int)w, (Int)h}, src};
+
+    auto bits = BitArray{ValueInit, 13};
+    bits.set(0);
+    bits.set(12);
+
+    sprite_atlas atlas{256};
+    const Sprite* sprites[] = { atlas.add(view).raw(), atlas.add(view, false).raw() };
+    sprite_atlas_cache cache;
+    cache.add("foo"_s, 42, sprites, bits);
+    fm_assert(cache.is_dirty());
+    fm_assert(cache.save(path, atlas));
+
+    // a matching atlas gets the same layers and sprites back
+    sprite_atlas atlas2{256};
+    sprite_atlas_cache cache2;
+    fm_assert(cache2.load(path, atlas2));
+    fm_assert(!cache2.is_dirty());
+    fm_assert(!cache2.find("foo"_s, 43));
+    fm_assert(!cache2.find("bar"_s, 42));
+    const auto* e = cache2.find("foo"_s, 42);
+    fm_assert(e && e->sprites.size() == 2);
+    for (auto i = 0u; i < 2; i++)
+        fm_assert(!std::memcmp(&e->sprites[i], sprites[i], sizeof(Sprite)));
+    fm_assert(e->bitmask.size() == 13);
+    fm_assert(e->bitmask[0] && e->bitmask[12] && !e->bitmask[1]);
+    fm_assert(atlas2.used_layers() == atlas.used_layers());
+    {
+        const auto a = atlas.read_layers(), b = atlas2.read_layers();
+        fm_assert(a.size() == b.size() && !std::memcmp(a.data(), b.data(), a.size()));
+    }
+
+    // baked layers are never packed into again
+    const auto s = atlas2.add(view);
+    fm_assert(s.layer() >= atlas.used_layers());
+
+    // nor is anything loaded into an atlas of a different size
+    sprite_atlas atlas3{128};
+    sprite_atlas_cache cache3;
+    fm_assert(!cache3.load(path, atlas3));
+    fm_assert(!cache3.size() && !atlas3.used_layers());
+
+    // or from a truncated file
+    {
+        auto file = Path::read(path);
+        fm_assert(file);
+        fm_assert(Path::write(path, file->prefix(file->size() - 1)));
+    }
+    sprite_atlas atlas4{256};
+    fm_assert(!cache3.load(path, atlas4));
+    fm_assert(!cache3.size() && !atlas4.used_layers());
+
+    fm_assert(Path::remove(path));
+}
+
 } // namespace
 } // namespace floormat::SpriteAtlas
 
@@ -251,6 +395,9 @@ void test_sprite_atlas()
     free_atlas_clears_state_and_allows_reuse();
     sprites_do_not_overlap_pairwise();
     max_dimension_sprite_stores_without_truncation();
+    skyline_sprites_do_not_overlap();
+    stats_add_up();
+    baked_cache_roundtrip();
 }
 
 } // namespace floormat::Test
@@ -0,0 +1,175 @@
+#include "app.hpp"
+#include "compat/float.hpp"
+#include "src/spritebatch.hpp"
+#include "src/sprite-list.hpp"
+#include "src/point.inl"
+#include "src/camera-offset.hpp"
+#include "shaders/shader.hpp"
+#include <cr/GrowableArray.h>
+#include <algorithm>
+#include <iterator>
+
+namespace floormat::Test {
+
+namespace {
+
+struct emitted { uint32_t id; float depth; };
+
+struct xorshift
+{
+    uint32_t state;
+    uint32_t operator()(uint32_t max)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % max;
+    }
+};
+
+Quads::vertexes make_vertexes(uint32_t id)
+{
+    Quads::vertexes v{};
+    v[0].texcoords.x() = (UnsignedShort)id;
+    return v;
+}
+
+uint32_t id_of(const Quads::vertexes& v) { return v[0].texcoords.x(); }
+
+void test_order(xorshift& rng, float depth_start, uint32_t chunk_count, uint32_t max_per_chunk, uint32_t depth_range)
+{
+    auto sb = SpriteBatch{};
+
+    for (bool do_sort : { false, true })
+    {
+        Array<emitted> expected;
+        uint32_t id = 0;
+        for (auto c = 0u; c < chunk_count; c++)
+        {
+            // chunks ended with end_chunk(false) come in sorted already
+            const bool chunk_sort = rng(2);
+            const auto count = rng(max_per_chunk + 1);
+            const auto first = (uint32_t)expected.size();
+            for (auto i = 0u; i < count; i++)
+                arrayAppend(expected, emitted{id++, nth_float(depth_start, 7 * (1 + rng(depth_range)))});
+            const auto chunk = arrayView(expected).exceptPrefix(first);
+            if (!chunk_sort)
+                std::stable_sort(chunk.begin(), chunk.end(), [](auto a, auto b) { return a.depth < b.depth; });
+
+            sb.begin_chunk({});
+            for (const auto& x : chunk)
+                sb.emit(make_vertexes(x.id), x.depth);
+            sb.end_chunk(chunk_sort);
+
+            if (!do_sort && chunk_sort)
+                std::stable_sort(chunk.begin(), chunk.end(), [](auto a, auto b) { return a.depth < b.depth; });
+        }
+        if (do_sort)
+            std::stable_sort(expected.begin(), expected.end(), [](auto a, auto b) { return a.depth < b.depth; });
+
+        const auto V = sb.sort(do_sort);
+        fm_assert_equal(expected.size(), V.size());
+        for (auto i = 0uz; i < V.size(); i++)
+            fm_assert_equal(expected[i].id, id_of(V[i]));
+        sb.clear();
+    }
+}
+
+void test_sort_key()
+{
+    const float values[] = { -1.f, -.5f, -FLT_MIN, 0.f, FLT_MIN, .5f, nth_float(.5f, 1), 1.f, 2.f };
+    for (auto i = 1uz; i < std::size(values); i++)
+        fm_assert(float_sort_key(values[i-1]) < float_sort_key(values[i]));
+    fm_assert_equal(float_sort_key(0.f), float_sort_key(-0.f));
+}
+
+void test_static_buffers()
+{
+    constexpr auto V = sizeof(Quads::vertexes), I = sizeof(Quads::indexes);
+    auto sb = SpriteBatch{};
+    auto list = SpriteList{};
+    for (auto i = 0u; i < 10; i++)
+        list.add(make_vertexes(i), 0, nullptr);
+
+    sb.begin_frame();
+    sb.upload_static(list);
+    fm_assert_equal(1u, sb.stats().static_uploads);
+    fm_assert_equal(10 * (V + I), sb.stats().bytes_uploaded);
+    fm_assert_equal(0uz, sb.stats().bytes_emitted);
+
+    // unchanged, nothing to upload
+    sb.begin_frame();
+    sb.upload_static(list);
+    sb.upload_static(list);
+    fm_assert_equal(0u, sb.stats().static_uploads);
+    fm_assert_equal(0uz, sb.stats().bytes_uploaded);
+
+    // rebuilt smaller, the indexes are still there
+    list.clear();
+    for (auto i = 0u; i < 5; i++)
+        list.add(make_vertexes(i), 0, nullptr);
+    sb.begin_frame();
+    sb.upload_static(list);
+    fm_assert_equal(1u, sb.stats().static_uploads);
+    fm_assert_equal(5 * V, sb.stats().bytes_uploaded);
+
+    // not drawn for long enough to lose the buffer
+    for (auto i = 0u; i < 200; i++)
+        sb.begin_frame();
+    sb.upload_static(list);
+    fm_assert_equal(1u, sb.stats().static_uploads);
+
+    sb.begin_chunk({});
+    for (auto i = 0u; i < 3; i++)
+        sb.emit(make_vertexes(i), 0);
+    sb.end_chunk(false);
+    fm_assert_equal(3 * V, sb.stats().bytes_emitted);
+    sb.clear();
+}
+
+void test_vertex_format()
+{
+    static_assert(sizeof(Quads::vertexes) == 64);
+    const auto c = chunk_coords_{3, -2, 1};
+    const auto pos = Vector3(point{c, {5, 7}, {3, -4}});
+    const auto origin = Quads::chunk_origin(c);
+    fm_assert_equal(Vector2i(with_shifted_camera_offset::get_projected_chunk_offset(c)), origin);
+
+    const auto v = Quads::make_vertex(pos, {.25f, 1.f, 3}, .5f, origin);
+    fm_assert_equal(tile_shader::project(pos), Vector2(origin) + Vector2(v.position) / Quads::position_scale);
+    fm_assert_equal(Vector2us(16384, 65535), v.texcoords);
+    fm_assert_equal(3, (int)v.layer);
+    fm_assert_equal(.5f, v.depth);
+
+    // moved next to the camera by SpriteBatch
+    const auto camera = origin + Vector2i{-700, 300};
+    auto sb = SpriteBatch{};
+    sb.begin_chunk(c);
+    sb.emit({v, v, v, v}, v.depth);
+    sb.end_chunk(true);
+    const auto V = sb.sort(true, camera);
+    fm_assert_equal(tile_shader::project(pos), Vector2(camera) + Vector2(V[0][0].position) / Quads::position_scale);
+    sb.clear();
+}
+
+} // namespace
+
+void test_spritebatch()
+{
+    test_sort_key();
+    test_vertex_format();
+    test_static_buffers();
+
+    auto rng = xorshift{0x2545f491};
+    for (auto i = 0u; i < 50; i++)
+    {
+        // few distinct depths for lots of ties, small and large chunks to
+        // get both the insertion sort and the radix passes
+        test_order(rng,  0.f, 1 + rng(8),   40,     8);
+        test_order(rng, -1.f, 1 + rng(8),   40,  1000);
+        test_order(rng,  0.f, 1 + rng(16), 300,    16);
+        test_order(rng, -1.f, 1 + rng(16), 300, 1<<20);
+    }
+}
+
+} // namespace floormat::Test